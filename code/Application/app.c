@@ -12,43 +12,318 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdlib.h>
 #include <ctype.h>
+#include <time.h>
+#include <signal.h>
 #include "../macros.h"
 #include "../Card/card.h"
 #include "../Terminal/terminal.h"
 #include "../Server/server.h"
+#include "../Terminal/offline.h"
+#include "../Terminal/config.h"
+#include "../Server/routing.h"
+#include "../Server/settlement.h"
+#include "../Server/exchange.h"
+#include "../Server/shard.h"
+#include "../Server/replication.h"
+#include "../Server/admission.h"
 #include "state.h"
+#include "pipeline.h"
+#include "../Log/log.h"
+#include "../Log/latency.h"
+#include "../Log/metrics.h"
+#include "../Log/trace.h"
 #include "app.h"
 
 
-int main(void) {
+/********************************************************************************
+ * @brief   ID of this terminal in the terminal configuration file
+ *******************************************************************************/
+#define APP_TERMINAL_ID             1
+
+/********************************************************************************
+ * @brief   Terminal configuration file, the maximum amount is asked for each
+ *          transaction when the terminal is not configured, and the line typed
+ *          at any prompt to reload it
+ *******************************************************************************/
+#define APP_TERMINAL_CONFIG_FILE    "terminals.txt"
+#define APP_TERMINAL_CONFIG_COMMAND "!config"
+
+/********************************************************************************
+ * @brief   Maximum amount approved without calling the server when the 
+ *          terminal is not configured
+ *******************************************************************************/
+#define APP_FLOOR_LIMIT             100
+
+/********************************************************************************
+ * @brief   Files of the terminal offline mode
+ *******************************************************************************/
+#define APP_HOT_CARD_LIST_FILE      "hotcards.txt"
+#define APP_OFFLINE_QUEUE_FILE      "offline.dat"
+
+/********************************************************************************
+ * @brief   BIN routing file, every card goes to the local server without it,
+ *          and the line typed at any prompt to reload it
+ *******************************************************************************/
+#define APP_BIN_RANGES_FILE         "bins.txt"
+#define APP_BIN_RANGES_COMMAND      "!bins"
+
+/********************************************************************************
+ * @brief   Exchange rates file, amounts are only taken in the account currency
+ *          without it, and the line typed at any prompt to reload it
+ *******************************************************************************/
+#define APP_EXCHANGE_RATES_FILE     "rates.txt"
+#define APP_EXCHANGE_RATES_COMMAND  "!rates"
+
+/********************************************************************************
+ * @brief   Sockets of the shard processes, one per line by shard ID, this
+ *          process authorizes the transactions without it. The line typed at
+ *          any prompt to add a shard is followed by its socket.
+ *******************************************************************************/
+#define APP_SHARDS_FILE             "shards.txt"
+#define APP_ADD_SHARD_COMMAND       "!addshard "
+
+/********************************************************************************
+ * @brief   Standby of this process, one line "socket sync" or "socket async",
+ *          there is no standby without it
+ *******************************************************************************/
+#define APP_STANDBY_FILE            "standby.txt"
+
+/********************************************************************************
+ * @brief   Admission limits, one line "globalRate globalBurst terminalRate
+ *          terminalBurst", every transaction is admitted without it
+ *******************************************************************************/
+#define APP_ADMISSION_FILE          "admission.txt"
+
+/********************************************************************************
+ * @brief   Size of a line of input typed at the terminal
+ *******************************************************************************/
+#define APP_INPUT_LINE_SIZE         64
+
+/********************************************************************************
+ * @brief   Binary log of the bulk mode, read it with logDecode
+ *******************************************************************************/
+#define APP_LOG_FILE                "app.log"
+
+/********************************************************************************
+ * @brief   File the latency of the states is appended to every period
+ *******************************************************************************/
+#define APP_LATENCY_FILE            "latency.txt"
+#define APP_LATENCY_PERIOD          60
+
+/********************************************************************************
+ * @brief   Local port of the metrics endpoint, http://127.0.0.1:9464/metrics
+ *******************************************************************************/
+#define APP_METRICS_PORT            9464
+
+/********************************************************************************
+ * @brief   File the flight recorder is dumped to on an internal server error,
+ *          or on kill -USR1 <pid>
+ *******************************************************************************/
+#define APP_TRACE_FILE              "trace.txt"
+#define APP_TRACE_SIGNAL            SIGUSR1
+
+/********************************************************************************
+ * @brief   Line typed at any prompt to print the latency of the states
+ *******************************************************************************/
+#define APP_LATENCY_COMMAND         "!latency"
+
+/********************************************************************************
+ * @brief   Line typed at any prompt to settle a day, followed by DD/MM/YYYY,
+ *          and the file the settlement is written to
+ *******************************************************************************/
+#define APP_SETTLEMENT_COMMAND      "!settle "
+#define APP_SETTLEMENT_FILE         "settlement.txt"
+
+
+int main(int argc, char *argv[]) {
     char tryAgain = 0;
+    uint8_t threadCounts[PIPELINE_MAX_STAGES] = {1, 1, 1, 1};
+    int i = 0;
+
+    startLatencySummary(APP_LATENCY_FILE, APP_LATENCY_PERIOD);
+    startMetricsServer(APP_METRICS_PORT);
+    startTrace(APP_TRACE_FILE, APP_TRACE_SIGNAL);
+    loadTerminalConfig(APP_TERMINAL_CONFIG_FILE);
+    loadBinRangesFile(APP_BIN_RANGES_FILE);
+    loadExchangeRatesFile(APP_EXCHANGE_RATES_FILE);
+    connectShardsFile(APP_SHARDS_FILE);
+    startReplicationFile(APP_STANDBY_FILE);
+    loadAdmissionLimitsFile(APP_ADMISSION_FILE);
+
+    /* Offline mode stays disabled if its files cannot be opened */
+    if( (TERMINAL_OK == loadHotCardList(APP_HOT_CARD_LIST_FILE)) &&
+        (TERMINAL_OK == openOfflineQueue(APP_OFFLINE_QUEUE_FILE)) ) {
+        setFloorLimit(APP_FLOOR_LIMIT);
+    }
+
+    /* "app transactions.csv [threads of each state]" processes a bulk file */
+    if(argc > 1) {
+        for(i = 2; (i < argc) && (i - 2 < PIPELINE_MAX_STAGES); ++i) {
+            threadCounts[i - 2] = (uint8_t)atoi(argv[i]);
+        }
+        appBulk(argv[1], threadCounts);
+        tryAgain = 'N';
+    }
 
-    do {
+    while('N' != tryAgain) {
         appStart();
 
+        /* Uploading the offline approvals once a batch is ready */
+        if(getOfflineQueueCount() >= OFFLINE_BATCH_SIZE) {
+            uploadOfflineQueue();
+        }
+
         printf("\n\n\nStart new entry? (y/n): ");
+        tryAgain = 'N';
         scanf(" %c%*c", &tryAgain);
-        tryAgain = toupper(tryAgain);
-    } while('Y' == tryAgain);
+        tryAgain = ('Y' == toupper(tryAgain)) ? 'Y' : 'N';
+    }
+
+    uploadOfflineQueue();
+    closeOfflineQueue();
+    unloadBinRanges();
+    unloadExchangeRates();
+    disconnectShards(FALSE);
+    stopReplication(FALSE);
+    unloadAdmissionLimits();
+    unloadTerminalConfig();
+    stopMetricsServer();
+    stopLatencySummary();
 
     return 0;
 }
 
 void appStart(void) {
-    uint8_t i = 0;
-    BOOL_t stateSuccess = TRUE;
-    ST_transaction_t transData = {0};
-    
-    for (i = 0; i < countStates; ++i) {
-        if(NULL == stateMachine[i].func) {
+    ST_transactionContext_t context;
+    uint8_t line[APP_INPUT_LINE_SIZE];
+    size_t length = 0;
+    int character = 0;
+    EN_exchangeError_t exchangeError;
+    EN_routingError_t routingError;
+    EN_terminalError_t termError;
+    EN_shardError_t shardError;
+
+    initTransactionContext(&context, APP_TERMINAL_ID);
+
+    /* Event loop of a single terminal, the states never block on stdin */
+    resumeTransaction(&context, NULL);
+    while(CONTEXT_NEEDS_INPUT == context.status) {
+        printf("%s", context.prompt);
+        if(NULL == fgets((char *)line, sizeof(line), stdin)) {
+            line[0] = '\0';
+        }
+
+        /* A line too long for the buffer is flushed and taken as an empty one, its tail is not the next input */
+        length = strcspn((char *)line, "\n");
+        if( ('\0' == line[length]) && (length + 1 == sizeof(line)) ) {
+            do {
+                character = getchar();
+            } while( ('\n' != character) && (EOF != character) );
+            length = 0;
+        }
+        line[length] = '\0';
+
+        if(0 == strcmp((char *)line, APP_LATENCY_COMMAND)) {
+            printLatencyStats(stdout);
             continue;
         }
 
-        stateSuccess = stateMachine[i].func(&transData);
-        if(FALSE == stateSuccess) {
-            printf("Failed to execute state %s\n", stateMachine[i].name);
-            break;
+        /* The authorizations in flight finish on the previous rates */
+        if(0 == strcmp((char *)line, APP_EXCHANGE_RATES_COMMAND)) {
+            exchangeError = loadExchangeRatesFile(APP_EXCHANGE_RATES_FILE);
+            printf("Reloading %s: %s\n", APP_EXCHANGE_RATES_FILE,
+                   (EXCHANGE_OK == exchangeError) ? "done" : "failed, the previous rates are kept");
+            continue;
+        }
+
+        /* The authorizations in flight finish on the previous configuration */
+        if(0 == strcmp((char *)line, APP_TERMINAL_CONFIG_COMMAND)) {
+            termError = loadTerminalConfig(APP_TERMINAL_CONFIG_FILE);
+            printf("Reloading %s: %s\n", APP_TERMINAL_CONFIG_FILE,
+                   (TERMINAL_OK == termError) ? "done" : "failed, the previous configuration is kept");
+            continue;
         }
+
+        /* The lookups in flight finish on the previous routing table */
+        if(0 == strcmp((char *)line, APP_BIN_RANGES_COMMAND)) {
+            routingError = loadBinRangesFile(APP_BIN_RANGES_FILE);
+            printf("Reloading %s: %s\n", APP_BIN_RANGES_FILE,
+                   (ROUTING_OK == routingError) ? "done" : "failed, the previous routes are kept");
+            continue;
+        }
+
+        /* The accounts move to the added shard along with the next transactions */
+        if(0 == strncmp((char *)line, APP_ADD_SHARD_COMMAND, strlen(APP_ADD_SHARD_COMMAND))) {
+            shardError = addShard((char *)line + strlen(APP_ADD_SHARD_COMMAND));
+            printf("Adding shard %u: %s (Shard Error %d)\n", getShardCount(),
+                   (SHARD_MIGRATING == shardError) ? "moving its accounts" : "failed", shardError);
+            continue;
+        }
+
+        if(0 == strncmp((char *)line, APP_SETTLEMENT_COMMAND, strlen(APP_SETTLEMENT_COMMAND))) {
+            appSettle(line + strlen(APP_SETTLEMENT_COMMAND));
+            continue;
+        }
+
+        resumeTransaction(&context, line);
     }
+
+    if(CONTEXT_FAILED == context.status) {
+        printf("Failed to execute state %s\n", stateMachine[context.stateIndex].name);
+    }
+}
+
+void appBulk(const char * const fileName, const uint8_t * const threadCounts) {
+    EN_pipelineError_t pipelineError;
+    struct timespec start, end;
+
+    /* Events go to the binary log only, printing them would serialize the threads */
+    if(LOG_OK == startLogger(APP_LOG_FILE)) {
+        setLogPrinting(FALSE);
+    }
+
+    timespec_get(&start, TIME_UTC);
+    pipelineError = runPipelineFile(fileName, threadCounts, APP_TERMINAL_ID);
+    timespec_get(&end, TIME_UTC);
+
+    stopLogger();
+    setLogPrinting(TRUE);
+
+    if(PIPELINE_OK != pipelineError) {
+        printf("Failed to process %s (Pipeline Error %d)\n", fileName, pipelineError);
+        return;
+    }
+
+    printPipelineStats();
+    printLatencyStats(stdout);
+    printf("Processed %s in %.3f s\n", fileName,
+           (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+void appSettle(const uint8_t * const dateString) {
+    static ST_settlement_t settlement;
+    EN_settlementError_t settlementError;
+    DATE_t businessDay = DATE_INVALID;
+
+    if(TERMINAL_OK != parseDate(dateString, &businessDay)) {
+        printf("Usage: %sDD/MM/YYYY\n", APP_SETTLEMENT_COMMAND);
+        return;
+    }
+
+    settlementError = settleDay(businessDay, 0, &settlement);
+    if(SETTLEMENT_OK == settlementError) {
+        settlementError = writeSettlementFile(APP_SETTLEMENT_FILE, &settlement);
+    }
+
+    if(SETTLEMENT_OK != settlementError) {
+        printf("Failed to settle %s (Settlement Error %d)\n", dateString, settlementError);
+    } else {
+        printf("Settled %llu transactions of %s on %u terminals into %s\n",
+               (unsigned long long)settlement.transactionCount, dateString,
+               settlement.terminalCount, APP_SETTLEMENT_FILE);
+    }
+
+    freeSettlement(&settlement);
 }
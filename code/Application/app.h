@@ -3,5 +3,7 @@
 
 
 void appStart(void);
+void appBulk(const char * const fileName, const uint8_t * const threadCounts);
+void appSettle(const uint8_t * const dateString);
 
 #endif      /* APP_H */
\ No newline at end of file
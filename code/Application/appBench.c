@@ -0,0 +1,1069 @@
+/*********************************************************************************
+ * @file    appBench.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the application benchmark module implementation.
+ * @details This module measures the throughput of the application units.
+ *          It is not part of the application. Build it with optimizations
+ *          enabled (-O2) to get meaningful numbers.
+ *
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Server/server.h"
+#include "../Server/routing.h"
+#include "../Server/fraud.h"
+#include "../Server/settlement.h"
+#include "../Server/analytics.h"
+#include "../Server/replication.h"
+#include "../Server/hold.h"
+#include "../Server/admission.h"
+#include "../Server/vault.h"
+#include "../Log/log.h"
+
+
+/********************************************************************************
+ * @brief   Number of cards used by the PAN benchmarks
+ *******************************************************************************/
+#define BENCH_PAN_COUNT         (1u << 20)
+
+/********************************************************************************
+ * @brief   Number of passes over the cards by the PAN benchmarks
+ *******************************************************************************/
+#define BENCH_PAN_PASSES        8
+
+/********************************************************************************
+ * @brief   Number of dates used by the date benchmarks
+ *******************************************************************************/
+#define BENCH_DATE_COUNT        (1u << 20)
+
+/********************************************************************************
+ * @brief   Number of cards in the card base of the expiry sweep benchmark
+ *******************************************************************************/
+#define BENCH_CARD_BASE_COUNT   (1u << 24)
+
+/********************************************************************************
+ * @brief   Number of BIN ranges and lookups of the routing benchmark
+ *******************************************************************************/
+#define BENCH_BIN_RANGES_COUNT  500000u
+#define BENCH_ROUTE_COUNT       (1u << 22)
+
+/********************************************************************************
+ * @brief   Number of cards and transactions of the fraud scoring benchmark
+ *******************************************************************************/
+#define BENCH_FRAUD_CARD_COUNT  100000u
+#define BENCH_FRAUD_COUNT       (1u << 22)
+
+/********************************************************************************
+ * @brief   Number of authorizations of the logging benchmark, and its log file
+ *******************************************************************************/
+#define BENCH_AUTHORIZATION_COUNT   (1u << 20)
+#define BENCH_LOG_FILE              "bench.log"
+
+/********************************************************************************
+ * @brief   Number of journaled transactions, accounts and terminals of the
+ *          settlement benchmark
+ *******************************************************************************/
+#define BENCH_SETTLEMENT_COUNT      100000000u
+#define BENCH_SETTLEMENT_ACCOUNTS   4000u
+#define BENCH_SETTLEMENT_TERMINALS  10000u
+
+/********************************************************************************
+ * @brief   Number of transactions and days of the analytics benchmark, and
+ *          buckets of its amount histogram
+ *******************************************************************************/
+#define BENCH_ANALYTICS_COUNT       (1u << 22)
+#define BENCH_ANALYTICS_DAYS        28u
+#define BENCH_ANALYTICS_BUCKETS     100u
+
+/********************************************************************************
+ * @brief   Number of authorizations of the replication benchmark, and the
+ *          sockets of its standby
+ *******************************************************************************/
+#define BENCH_REPLICATION_COUNT     (1u << 16)
+#define BENCH_STANDBY_SOCKET        "/tmp/benchStandby"
+#define BENCH_PROMOTED_SOCKET       "/tmp/benchPromoted"
+
+/********************************************************************************
+ * @brief   Number of holds and accounts of the holds benchmark, and the
+ *          longest lifetime of a hold, a week of one second ticks
+ *******************************************************************************/
+#define BENCH_HOLD_COUNT            (1u << 22)
+#define BENCH_HOLD_ACCOUNTS         16u
+#define BENCH_HOLD_LIFETIME         (7u * 24u * 3600u)
+
+/********************************************************************************
+ * @brief   Requests of the flooding terminal in the admission benchmark, one
+ *          every BENCH_FLOOD_INTERVAL nanoseconds, more than the server
+ *          authorizes but fewer than it sheds. A well-behaved terminal sends
+ *          one every BENCH_FLOOD_RATIO of them, the terminals taking turns,
+ *          and each terminal waits BENCH_FLOOD_DEADLINE nanoseconds for its
+ *          answer.
+ *******************************************************************************/
+#define BENCH_FLOOD_COUNT           2000000u
+#define BENCH_FLOOD_INTERVAL        200u
+#define BENCH_FLOOD_RATIO           100u
+#define BENCH_FLOOD_TERMINALS       100u
+#define BENCH_FLOOD_DEADLINE        5000000u
+
+/********************************************************************************
+ * @brief   Cards of the token vault benchmark
+ *******************************************************************************/
+#define BENCH_VAULT_COUNT           50000000u
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                           BENCHMARK FUNCTION PROTOTYPES                     */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static double benchNowSeconds(void);
+static void benchFillPan(uint8_t * const pan, const uint8_t length);
+static void benchIsValidCardPAN(void);
+static void benchIsCardExpired(void);
+static void benchParseDate(void);
+static void benchIsCardExpiredBatch(void);
+static void benchGetCardRoute(void);
+static void benchScoreTransaction(void);
+static void benchRecieveTransactionData(const BOOL_t isLogging);
+static void benchReplication(const EN_replicationMode_t mode);
+static void benchHolds(void);
+static void benchAdmission(const BOOL_t isShedding, const BOOL_t isLimiting);
+static void benchVault(void);
+static void benchSettleDay(void);
+static void benchAnalytics(void);
+static int benchCompareLatencies(const void * const first, const void * const second);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                                     MAIN                                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+int main(void) {
+    srand(0x5EED);
+
+    benchIsValidCardPAN();
+    benchIsCardExpired();
+    benchParseDate();
+    benchIsCardExpiredBatch();
+    benchGetCardRoute();
+    benchScoreTransaction();
+    benchRecieveTransactionData(FALSE);
+    benchRecieveTransactionData(TRUE);
+    benchReplication(REPLICATION_OFF);
+    benchReplication(REPLICATION_ASYNC);
+    benchReplication(REPLICATION_SYNC);
+    benchHolds();
+    benchAdmission(FALSE, FALSE);
+    benchAdmission(TRUE, FALSE);
+    benchAdmission(TRUE, TRUE);
+    benchVault();
+    benchSettleDay();
+    benchAnalytics();
+
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                          BENCHMARK FUNCTION DEFINITIONS                     */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Get a monotonic timestamp in seconds
+ *******************************************************************************/
+static double benchNowSeconds(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/********************************************************************************
+ * @brief   Fill a PAN with random digits and a valid Luhn check digit
+ *******************************************************************************/
+static void benchFillPan(uint8_t * const pan, const uint8_t length) {
+    static const uint8_t doubled[10] = {0, 2, 4, 6, 8, 1, 3, 5, 7, 9};
+    uint16_t sum = 0;
+    uint8_t i = 0, digit = 0;
+
+    /* Digits left of the check digit, doubled every other one from the right */
+    for(i = 0; i < (length - 1); ++i) {
+        digit = (uint8_t)(rand() % 10);
+        pan[i] = '0' + digit;
+        sum += ((length - 2 - i) % 2) ? digit : doubled[digit];
+    }
+
+    pan[length - 1] = '0' + (uint8_t)((10 - (sum % 10)) % 10);
+    pan[length] = '\0';
+}
+
+/********************************************************************************
+ * @brief   Measure validations per second of isValidCardPAN() and
+ *          isValidCardPANBatch()
+ *******************************************************************************/
+static void benchIsValidCardPAN(void) {
+    ST_cardData_t *cards = NULL;
+    EN_terminalError_t *results = NULL;
+    uint32_t i = 0, pass = 0, validCount = 0;
+    double start = 0, singleSeconds = 0, batchSeconds = 0;
+
+    cards   = calloc(BENCH_PAN_COUNT, sizeof(*cards));
+    results = calloc(BENCH_PAN_COUNT, sizeof(*results));
+    if( (NULL == cards) || (NULL == results) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(cards);
+        free(results);
+        return;
+    }
+
+    /* 16 to 19 digits, one card out of 8 with a corrupted check digit */
+    for(i = 0; i < BENCH_PAN_COUNT; ++i) {
+        benchFillPan(cards[i].primaryAccountNumber, (uint8_t)(16 + (i % 4)));
+        if(0 == (i % 8)) {
+            cards[i].primaryAccountNumber[0] = (cards[i].primaryAccountNumber[0] == '9') ? '0' :
+                                               (cards[i].primaryAccountNumber[0] + 1);
+        }
+    }
+
+    start = benchNowSeconds();
+    for(pass = 0; pass < BENCH_PAN_PASSES; ++pass) {
+        for(i = 0; i < BENCH_PAN_COUNT; ++i) {
+            validCount += (TERMINAL_OK == isValidCardPAN(&cards[i]));
+        }
+    }
+    singleSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    for(pass = 0; pass < BENCH_PAN_PASSES; ++pass) {
+        validCount -= isValidCardPANBatch(cards, BENCH_PAN_COUNT, results);
+    }
+    batchSeconds = benchNowSeconds() - start;
+
+    if(0 != validCount) {
+        printf("isValidCardPAN() and isValidCardPANBatch() disagree\n");
+    }
+
+    printf("isValidCardPAN:      %12.0f validations/s\n",
+           (double)BENCH_PAN_COUNT * BENCH_PAN_PASSES / singleSeconds);
+    printf("isValidCardPANBatch: %12.0f validations/s\n",
+           (double)BENCH_PAN_COUNT * BENCH_PAN_PASSES / batchSeconds);
+
+    free(cards);
+    free(results);
+}
+
+/********************************************************************************
+ * @brief   Measure the parse-and-validate cost of isCardExpired() on dates
+ *          entered as strings
+ *******************************************************************************/
+static void benchIsCardExpired(void) {
+    ST_terminalData_t *terms = NULL;
+    ST_cardData_t card = {.cardExpirationDate = "06/25"};
+    uint32_t i = 0, expiredCount = 0;
+    double start = 0, seconds = 0;
+
+    terms = calloc(BENCH_DATE_COUNT, sizeof(*terms));
+    if(NULL == terms) {
+        printf("Failed to allocate benchmark data\n");
+        return;
+    }
+
+    card.expiryMonths = (uint16_t)getCardExpiryMonths(&card);
+    for(i = 0; i < BENCH_DATE_COUNT; ++i) {
+        snprintf((char *)terms[i].transactionDate, sizeof(terms[i].transactionDate), "%02u/%02u/%04u",
+                 1 + ((unsigned)rand() % 28), 1 + ((unsigned)rand() % 12), 2020 + ((unsigned)rand() % 10));
+    }
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_DATE_COUNT; ++i) {
+        expiredCount += (EXPIRED_CARD == isCardExpired(&card, &terms[i]));
+    }
+    seconds = benchNowSeconds() - start;
+
+    printf("isCardExpired:       %12.1f ns/call (%u expired)\n",
+           seconds * 1e9 / BENCH_DATE_COUNT, expiredCount);
+
+    free(terms);
+}
+
+/********************************************************************************
+ * @brief   Measure parseDate() and parseDateBatch() on a bulk input buffer
+ *          of "DD/MM/YYYY\n" lines
+ *******************************************************************************/
+static void benchParseDate(void) {
+    uint8_t *records = NULL;
+    DATE_t *dates = NULL;
+    uint32_t i = 0, validCount = 0;
+    double start = 0, singleSeconds = 0, batchSeconds = 0;
+
+    records = malloc((size_t)BENCH_DATE_COUNT * 11 + 1);
+    dates   = calloc(BENCH_DATE_COUNT, sizeof(*dates));
+    if( (NULL == records) || (NULL == dates) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(records);
+        free(dates);
+        return;
+    }
+
+    for(i = 0; i < BENCH_DATE_COUNT; ++i) {
+        sprintf((char *)records + (size_t)i * 11, "%02d/%02d/%04d\n",
+                1 + (rand() % 31), 1 + (rand() % 12), 2020 + (rand() % 10));
+    }
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_DATE_COUNT; ++i) {
+        validCount += (TERMINAL_OK == parseDate(records + (size_t)i * 11, &dates[i]));
+    }
+    singleSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    validCount -= parseDateBatch(records, BENCH_DATE_COUNT, 11, dates);
+    batchSeconds = benchNowSeconds() - start;
+
+    if(0 != validCount) {
+        printf("parseDate() and parseDateBatch() disagree\n");
+    }
+
+    printf("parseDate:           %12.1f ns/call\n", singleSeconds * 1e9 / BENCH_DATE_COUNT);
+    printf("parseDateBatch:      %12.1f ns/date\n", batchSeconds * 1e9 / BENCH_DATE_COUNT);
+
+    free(records);
+    free(dates);
+}
+
+/********************************************************************************
+ * @brief   Measure a nightly expired-card sweep with isCardExpiredBatch()
+ *          against a scalar isCardExpired() loop over the same cards
+ *******************************************************************************/
+static void benchIsCardExpiredBatch(void) {
+    ST_cardData_t *cards = NULL;
+    uint16_t *expiryMonths = NULL;
+    BOOL_t *isExpired = NULL;
+    ST_terminalData_t term = {.transactionDate = "19/10/2026"};
+    uint32_t i = 0, expiredCount = 0;
+    double start = 0, singleSeconds = 0, batchSeconds = 0;
+
+    cards        = calloc(BENCH_CARD_BASE_COUNT, sizeof(*cards));
+    expiryMonths = calloc(BENCH_CARD_BASE_COUNT, sizeof(*expiryMonths));
+    isExpired    = calloc(BENCH_CARD_BASE_COUNT, sizeof(*isExpired));
+    if( (NULL == cards) || (NULL == expiryMonths) || (NULL == isExpired) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(cards);
+        free(expiryMonths);
+        free(isExpired);
+        return;
+    }
+
+    parseDate(term.transactionDate, &term.transactionDay);
+    for(i = 0; i < BENCH_CARD_BASE_COUNT; ++i) {
+        snprintf((char *)cards[i].cardExpirationDate, sizeof(cards[i].cardExpirationDate), "%02u/%02u",
+                 1 + ((unsigned)rand() % 12), 20 + ((unsigned)rand() % 12));
+        cards[i].expiryMonths = (uint16_t)getCardExpiryMonths(&cards[i]);
+        expiryMonths[i] = cards[i].expiryMonths;
+    }
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_CARD_BASE_COUNT; ++i) {
+        expiredCount += (EXPIRED_CARD == isCardExpired(&cards[i], &term));
+    }
+    singleSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    expiredCount -= isCardExpiredBatch(expiryMonths, BENCH_CARD_BASE_COUNT, term.transactionDay, isExpired);
+    batchSeconds = benchNowSeconds() - start;
+
+    if(0 != expiredCount) {
+        printf("isCardExpired() and isCardExpiredBatch() disagree\n");
+    }
+
+    printf("isCardExpired sweep: %12.2f ns/card\n", singleSeconds * 1e9 / BENCH_CARD_BASE_COUNT);
+    printf("isCardExpiredBatch:  %12.2f ns/card\n", batchSeconds * 1e9 / BENCH_CARD_BASE_COUNT);
+
+    free(cards);
+    free(expiryMonths);
+    free(isExpired);
+}
+
+/********************************************************************************
+ * @brief   Measure getCardRoute() on random PANs against a table of
+ *          500k BIN ranges, and the cost of reloading that table
+ *******************************************************************************/
+static void benchGetCardRoute(void) {
+    ST_binRange_t *ranges = NULL;
+    ST_cardData_t *cards = NULL;
+    uint32_t i = 0, foundCount = 0;
+    double start = 0, loadSeconds = 0, lookupSeconds = 0;
+
+    ranges = calloc(BENCH_BIN_RANGES_COUNT, sizeof(*ranges));
+    cards  = calloc(BENCH_ROUTE_COUNT, sizeof(*cards));
+    if( (NULL == ranges) || (NULL == cards) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(ranges);
+        free(cards);
+        return;
+    }
+
+    /* Ranges of 150 BINs every 200 BINs, so a quarter of the PANs have no route */
+    for(i = 0; i < BENCH_BIN_RANGES_COUNT; ++i) {
+        ranges[i].lowBin  = i * 200;
+        ranges[i].highBin = i * 200 + 149;
+        ranges[i].route   = (uint16_t)(i % 64);
+    }
+
+    for(i = 0; i < BENCH_ROUTE_COUNT; ++i) {
+        benchFillPan(cards[i].primaryAccountNumber, 16);
+    }
+
+    start = benchNowSeconds();
+    if(ROUTING_OK != loadBinRanges(ranges, BENCH_BIN_RANGES_COUNT)) {
+        printf("Failed to load the BIN ranges\n");
+    }
+    loadSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_ROUTE_COUNT; ++i) {
+        foundCount += (ROUTE_NOT_FOUND != getCardRoute(&cards[i]));
+    }
+    lookupSeconds = benchNowSeconds() - start;
+
+    printf("loadBinRanges:       %12.1f ms for %u ranges\n", loadSeconds * 1e3, BENCH_BIN_RANGES_COUNT);
+    printf("getCardRoute:        %12.1f ns/lookup (%.0f%% routed)\n",
+           lookupSeconds * 1e9 / BENCH_ROUTE_COUNT, 100.0 * foundCount / BENCH_ROUTE_COUNT);
+
+    unloadBinRanges();
+    free(ranges);
+    free(cards);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the fraud scoring on a hundred thousand cards, each
+ *          transaction picks a random card, terminal and amount
+ *******************************************************************************/
+static void benchScoreTransaction(void) {
+    ST_transaction_t *transactions = NULL;
+    uint32_t *cardIndexes = NULL;
+    uint32_t i = 0, declinedCount = 0;
+    double start = 0, seconds = 0;
+
+    transactions = calloc(BENCH_FRAUD_CARD_COUNT, sizeof(*transactions));
+    cardIndexes  = calloc(BENCH_FRAUD_COUNT, sizeof(*cardIndexes));
+    if( (NULL == transactions) || (NULL == cardIndexes) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(transactions);
+        free(cardIndexes);
+        return;
+    }
+
+    for(i = 0; i < BENCH_FRAUD_CARD_COUNT; ++i) {
+        benchFillPan(transactions[i].cardHolderData.primaryAccountNumber, 16);
+        transactions[i].terminalData.terminalId = (uint32_t)(rand() % 16);
+        transactions[i].terminalData.transAmount = (float)(10 + rand() % 90);
+    }
+
+    for(i = 0; i < BENCH_FRAUD_COUNT; ++i) {
+        cardIndexes[i] = (uint32_t)rand() % BENCH_FRAUD_CARD_COUNT;
+    }
+
+    resetFraudStats();
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_FRAUD_COUNT; ++i) {
+        declinedCount += (scoreTransaction(&transactions[cardIndexes[i]], (int64_t)(i / 64)) >= FRAUD_DECLINE_SCORE);
+    }
+    seconds = benchNowSeconds() - start;
+
+    printf("scoreTransaction:    %12.1f ns/transaction (%.2f%% declined, %u cards)\n",
+           seconds * 1e9 / BENCH_FRAUD_COUNT, 100.0 * declinedCount / BENCH_FRAUD_COUNT, BENCH_FRAUD_CARD_COUNT);
+
+    free(transactions);
+    free(cardIndexes);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the server authorization, with the binary logger off
+ *          or writing every event to a file. Events are never printed.
+ *******************************************************************************/
+static void benchRecieveTransactionData(const BOOL_t isLogging) {
+    static const char * const pans[] = {
+        "1111222233334444554", "1112223334445556661", "1122334455667788990",
+        "1234567891234567890", "9876543219876543210"
+    };
+    ST_transaction_t transData = {0};
+    uint32_t *latencies = NULL;
+    uint32_t i = 0;
+    uint64_t totalLatency = 0;
+    double start = 0;
+
+    latencies = calloc(BENCH_AUTHORIZATION_COUNT, sizeof(*latencies));
+    if(NULL == latencies) {
+        printf("Failed to allocate benchmark data\n");
+        return;
+    }
+
+    setLogPrinting(FALSE);
+    if( isLogging && (LOG_OK != startLogger(BENCH_LOG_FILE)) ) {
+        printf("Failed to start the logger\n");
+        free(latencies);
+        return;
+    }
+
+    /* A null amount is always approved, so every call logs the balances */
+    transData.terminalData.transAmount = 0;
+
+    for(i = 0; i < BENCH_AUTHORIZATION_COUNT; ++i) {
+        strcpy((char *)transData.cardHolderData.primaryAccountNumber, pans[i % 5]);
+
+        start = benchNowSeconds();
+        recieveTransactionData(&transData);
+        latencies[i] = (uint32_t)((benchNowSeconds() - start) * 1e9);
+        totalLatency += latencies[i];
+    }
+
+    if(isLogging) {
+        stopLogger();
+    }
+    setLogPrinting(TRUE);
+
+    qsort(latencies, BENCH_AUTHORIZATION_COUNT, sizeof(*latencies), benchCompareLatencies);
+
+    printf("recieveTransactionData (logging %-3s): %6.1f ns mean, %6u ns p99, %llu events dropped\n",
+           isLogging ? "on" : "off", (double)totalLatency / BENCH_AUTHORIZATION_COUNT,
+           latencies[BENCH_AUTHORIZATION_COUNT / 100 * 99], (unsigned long long)getLogDroppedCount());
+
+    free(latencies);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the server authorization committed locally only, then
+ *          also shipped to a standby process, without waiting for it or
+ *          waiting for it to apply each change
+ *******************************************************************************/
+static void benchReplication(const EN_replicationMode_t mode) {
+    static const char * const modeNames[] = {
+        [REPLICATION_OFF] = "off", [REPLICATION_ASYNC] = "async", [REPLICATION_SYNC] = "sync"
+    };
+    const struct timespec retryDelay = {0, 10000000};
+    ST_transaction_t transData = {0};
+    EN_replicationError_t replicationError = REPLICATION_OK;
+    uint32_t *latencies = NULL;
+    uint32_t i = 0;
+    uint64_t totalLatency = 0;
+    double start = 0;
+    pid_t standbyId = 0;
+
+    latencies = calloc(BENCH_REPLICATION_COUNT, sizeof(*latencies));
+    if(NULL == latencies) {
+        printf("Failed to allocate benchmark data\n");
+        return;
+    }
+
+    setLogPrinting(FALSE);
+
+    if(REPLICATION_OFF != mode) {
+        fflush(stdout);
+        standbyId = fork();
+        if(0 == standbyId) {
+            _exit(runStandby(BENCH_STANDBY_SOCKET, BENCH_PROMOTED_SOCKET));
+        }
+
+        replicationError = REPLICATION_SOCKET_ERROR;
+        for(i = 0; (standbyId > 0) && (REPLICATION_OK != replicationError) && (i < 100); ++i) {
+            nanosleep(&retryDelay, NULL);
+            replicationError = startReplication(BENCH_STANDBY_SOCKET, mode);
+        }
+    }
+
+    if(REPLICATION_OK != replicationError) {
+        printf("Failed to start the standby\n");
+        setLogPrinting(TRUE);
+        free(latencies);
+        return;
+    }
+
+    /* A null amount is always approved, so every call changes an account */
+    transData.terminalData.transAmount = 0;
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, "9876543219876543210");
+
+    for(i = 0; i < BENCH_REPLICATION_COUNT; ++i) {
+        start = benchNowSeconds();
+        recieveTransactionData(&transData);
+        latencies[i] = (uint32_t)((benchNowSeconds() - start) * 1e9);
+        totalLatency += latencies[i];
+    }
+
+    /* The queue left is sent before the standby stops */
+    if(REPLICATION_OFF != mode) {
+        stopReplication(FALSE);
+        waitpid(standbyId, NULL, 0);
+    }
+    setLogPrinting(TRUE);
+
+    qsort(latencies, BENCH_REPLICATION_COUNT, sizeof(*latencies), benchCompareLatencies);
+
+    printf("recieveTransactionData (replication %-5s): %7.1f ns mean, %7u ns p99\n",
+           modeNames[mode], (double)totalLatency / BENCH_REPLICATION_COUNT,
+           latencies[BENCH_REPLICATION_COUNT / 100 * 99]);
+
+    free(latencies);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the authorization holds: four million holds of up to a
+ *          week, a quarter of them released, the others expired by advancing
+ *          the timing wheel through the week one tick at a time
+ *******************************************************************************/
+static void benchHolds(void) {
+    ST_accountsDB_t account = {.balance = 10000000};
+    ST_transaction_t transData = {0};
+    uint64_t *holdIds = NULL;
+    uint32_t i = 0, heldCount = 0, releasedCount = 0, expiredCount = 0;
+    double start = 0, holdSeconds = 0, releaseSeconds = 0, advanceSeconds = 0;
+
+    holdIds = malloc(BENCH_HOLD_COUNT * sizeof(*holdIds));
+    if( (NULL == holdIds) || (HOLD_OK != startHolds(BENCH_HOLD_COUNT, 0)) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(holdIds);
+        return;
+    }
+
+    for(i = 0; i < BENCH_HOLD_ACCOUNTS; ++i) {
+        sprintf((char *)account.primaryAccountNumber, "7%018u", i);
+        addAccount(&account);
+    }
+
+    setLogPrinting(FALSE);
+    transData.terminalData.transAmount = 1;
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_HOLD_COUNT; ++i) {
+        sprintf((char *)transData.cardHolderData.primaryAccountNumber, "7%018u", i % BENCH_HOLD_ACCOUNTS);
+        authorizeHold(&transData, 1 + (uint32_t)rand() % BENCH_HOLD_LIFETIME, &holdIds[i]);
+        heldCount += (APPROVED == transData.transState);
+    }
+    holdSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_HOLD_COUNT; i += 4) {
+        releasedCount += (HOLD_OK == releaseHold(holdIds[i]));
+    }
+    releaseSeconds = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    for(i = 1; i <= BENCH_HOLD_LIFETIME; ++i) {
+        expiredCount += advanceHolds(i);
+    }
+    advanceSeconds = benchNowSeconds() - start;
+
+    setLogPrinting(TRUE);
+    stopHolds();
+
+    printf("authorizeHold: %6.1f ns per hold, %u of %u held\n",
+           holdSeconds * 1e9 / BENCH_HOLD_COUNT, heldCount, BENCH_HOLD_COUNT);
+    printf("releaseHold  : %6.1f ns per hold, %u released\n",
+           releaseSeconds * 1e9 / (BENCH_HOLD_COUNT / 4), releasedCount);
+    printf("advanceHolds : %6.1f ns per tick over %u ticks, %6.1f ns per hold expired, %u expired\n",
+           advanceSeconds * 1e9 / BENCH_HOLD_LIFETIME, BENCH_HOLD_LIFETIME,
+           advanceSeconds * 1e9 / (expiredCount ? expiredCount : 1), expiredCount);
+
+    free(holdIds);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of one terminal flooding the server: the requests arrive
+ *          on a fixed schedule whatever the server does, and are answered in
+ *          their order of arrival, so the latency of a well-behaved terminal
+ *          includes the time it queued behind the flood. Without admission
+ *          the queue grows, with deadlines only the late requests are shed
+ *          whoever sent them, with the token buckets the flood is cut short.
+ *******************************************************************************/
+static void benchAdmission(const BOOL_t isShedding, const BOOL_t isLimiting) {
+    const ST_admissionLimits_t limits = {.globalRatePerSecond = 2000000, .globalBurst = 1000,
+                                         .terminalRatePerSecond = 10000, .terminalBurst = 100};
+    ST_transaction_t floodData = {0}, transData = {0};
+    uint32_t *latencies = NULL;
+    uint32_t i = 0, requestCount = 0, servedCount = 0, floodServedCount = 0;
+    uint64_t start = 0, arrival = 0, totalLatency = 0;
+
+    latencies = calloc(BENCH_FLOOD_COUNT / BENCH_FLOOD_RATIO, sizeof(*latencies));
+    if( (NULL == latencies) || (isLimiting && (ADMISSION_OK != loadAdmissionLimits(&limits))) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(latencies);
+        return;
+    }
+
+    setLogPrinting(FALSE);
+
+    /* A null amount is always approved, every answer is a full authorization */
+    strcpy((char *)floodData.cardHolderData.primaryAccountNumber, "9876543219876543210");
+    floodData.terminalData.terminalId = 1;
+    transData = floodData;
+
+    start = getAdmissionTime();
+    for(i = 0; i < BENCH_FLOOD_COUNT; ++i) {
+        arrival = start + (uint64_t)i * BENCH_FLOOD_INTERVAL;
+
+        /* An idle server waits for the next request */
+        while(getAdmissionTime() < arrival) {
+        }
+
+        floodData.deadline = isShedding ? arrival + BENCH_FLOOD_DEADLINE : 0;
+        floodServedCount += (APPROVED == recieveTransactionData(&floodData));
+
+        if(0 == i % BENCH_FLOOD_RATIO) {
+            transData.terminalData.terminalId = 2 + requestCount % BENCH_FLOOD_TERMINALS;
+            transData.deadline = isShedding ? arrival + BENCH_FLOOD_DEADLINE : 0;
+            servedCount += (APPROVED == recieveTransactionData(&transData));
+            latencies[requestCount] = (uint32_t)(getAdmissionTime() - arrival);
+            totalLatency += latencies[requestCount];
+            ++requestCount;
+        }
+    }
+
+    setLogPrinting(TRUE);
+    unloadAdmissionLimits();
+
+    qsort(latencies, requestCount, sizeof(*latencies), benchCompareLatencies);
+
+    printf("recieveTransactionData (flood, %-9s): well-behaved %9.1f us mean, %9.1f us p99, %5.1f%% served, "
+           "flood %5.1f%% served\n",
+           isLimiting ? "buckets" : (isShedding ? "deadlines" : "no limit"),
+           (double)totalLatency / requestCount / 1e3, latencies[requestCount / 100 * 99] / 1e3,
+           100.0 * servedCount / requestCount, 100.0 * floodServedCount / BENCH_FLOOD_COUNT);
+
+    free(latencies);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the token vault on fifty million cards: each card is
+ *          tokenized once to add it, once more to find it, and the tokens are
+ *          detokenized in a random order. The PANs are counted up from a BIN,
+ *          so making them costs a few nanoseconds.
+ *******************************************************************************/
+static void benchVault(void) {
+    PAN_TOKEN_t *tokens = NULL;
+    PAN_TOKEN_t token = PAN_TOKEN_NONE;
+    uint8_t pan[VAULT_MAX_PAN_LENGTH + 1];
+    uint32_t i = 0, pass = 0, shuffled = 0, foundCount = 0, detokenizedCount = 0;
+    int8_t digit = 0;
+    double start = 0, seconds[2] = {0}, detokenizeSeconds = 0;
+
+    tokens = malloc(BENCH_VAULT_COUNT * sizeof(*tokens));
+    if( (NULL == tokens) || (VAULT_OK != startVault(BENCH_VAULT_COUNT)) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(tokens);
+        return;
+    }
+
+    for(pass = 0; pass < 2; ++pass) {
+        strcpy((char *)pan, "4000000000000000");
+
+        start = benchNowSeconds();
+        for(i = 0; i < BENCH_VAULT_COUNT; ++i) {
+            for(digit = 15; '9' == pan[digit]; --digit) {
+                pan[digit] = '0';
+            }
+            ++pan[digit];
+
+            if(0 == pass) {
+                tokenizePan(pan, &tokens[i]);
+            } else {
+                tokenizePan(pan, &token);
+                foundCount += (token == tokens[i]);
+            }
+        }
+        seconds[pass] = benchNowSeconds() - start;
+    }
+
+    /* Tokens in the order they were issued would read the vault in order */
+    for(i = BENCH_VAULT_COUNT - 1; i > 0; --i) {
+        shuffled = ((uint32_t)rand() << 15 ^ (uint32_t)rand()) % (i + 1);
+        token = tokens[i];
+        tokens[i] = tokens[shuffled];
+        tokens[shuffled] = token;
+    }
+
+    start = benchNowSeconds();
+    for(i = 0; i < BENCH_VAULT_COUNT; ++i) {
+        detokenizedCount += (VAULT_OK == detokenizePan(tokens[i], pan));
+    }
+    detokenizeSeconds = benchNowSeconds() - start;
+
+    printf("tokenizePan (new)  : %6.1f ns per card, %u cards in the vault\n",
+           seconds[0] * 1e9 / BENCH_VAULT_COUNT, getVaultCount());
+    printf("tokenizePan (known): %6.1f ns per card, %u of %u same tokens\n",
+           seconds[1] * 1e9 / BENCH_VAULT_COUNT, foundCount, BENCH_VAULT_COUNT);
+    printf("detokenizePan      : %6.1f ns per token, %u of %u found\n",
+           detokenizeSeconds * 1e9 / BENCH_VAULT_COUNT, detokenizedCount, BENCH_VAULT_COUNT);
+
+    stopVault();
+    free(tokens);
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the end of day settlement of a hundred million journaled
+ *          transactions, one in ten of another day and one in ten declined,
+ *          with every core then with one thread
+ *******************************************************************************/
+static void benchSettleDay(void) {
+    static ST_settlement_t settlement;
+    ST_transaction_t transData = {0};
+    ST_accountsDB_t account = {0};
+    EN_settlementError_t settlementError = SETTLEMENT_OK;
+    const DATE_t businessDay = DATE_PACK(2026, 10, 19);
+    uint64_t seed = 0x5EED, random = 0;
+    uint32_t i = 0, pass = 0;
+    double start = 0, fillSeconds = 0, seconds = 0;
+
+    /* Settlement totals only need the accounts to exist */
+    account.balance = 1e9f;
+    while(getAccountsCount() < BENCH_SETTLEMENT_ACCOUNTS) {
+        benchFillPan(account.primaryAccountNumber, 16);
+        addAccount(&account);
+    }
+
+    resetJournal();
+
+    start = benchNowSeconds();
+    for(i = 0; (i < BENCH_SETTLEMENT_COUNT) && (SETTLEMENT_OK == settlementError); ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        random = seed >> 16;
+
+        /* The high bits of the generator are the random ones */
+        transData.terminalData.transactionDay = ((seed >> 56) < 26) ? (businessDay - 1) : businessDay;
+        transData.terminalData.terminalId = (uint32_t)(random % BENCH_SETTLEMENT_TERMINALS);
+        transData.terminalData.transAmount = (float)((seed >> 33) % 100000) / 100.0f;
+        transData.transState = (((seed >> 48) & 0xFF) < 26) ? DECLINED_INSUFFICIENT_FUND : APPROVED;
+        settlementError = journalTransaction(&transData, (int16_t)((seed >> 20) % BENCH_SETTLEMENT_ACCOUNTS),
+                                             transData.terminalData.transAmount);
+    }
+    fillSeconds = benchNowSeconds() - start;
+
+    if(SETTLEMENT_OK != settlementError) {
+        printf("Failed to journal the transactions (Settlement Error %d)\n", settlementError);
+        resetJournal();
+        return;
+    }
+
+    printf("journalTransaction:  %12.1f ns/transaction\n", fillSeconds * 1e9 / BENCH_SETTLEMENT_COUNT);
+
+    for(pass = 0; pass < 2; ++pass) {
+        start = benchNowSeconds();
+        settlementError = settleDay(businessDay, (0 == pass) ? 0 : 1, &settlement);
+        seconds = benchNowSeconds() - start;
+
+        if(SETTLEMENT_OK != settlementError) {
+            printf("Failed to settle the day (Settlement Error %d)\n", settlementError);
+            break;
+        }
+
+        printf("settleDay (%-9s): %8.1f ms for %u transactions, %.0f M/s (%llu of the day, %u terminals)\n",
+               (0 == pass) ? "all cores" : "1 thread", seconds * 1e3, BENCH_SETTLEMENT_COUNT,
+               BENCH_SETTLEMENT_COUNT / seconds / 1e6, (unsigned long long)settlement.transactionCount,
+               settlement.terminalCount);
+        freeSettlement(&settlement);
+    }
+
+    resetJournal();
+}
+
+/********************************************************************************
+ * @brief   Benchmark of the analytics queries on the column segments, against
+ *          the same queries scanning the transactions as ST_transaction_t rows
+ *          and as journal records. Four million transactions over four weeks,
+ *          the sum covers the last week.
+ *******************************************************************************/
+static void benchAnalytics(void) {
+    static uint64_t histogram[BENCH_ANALYTICS_BUCKETS];
+    static int64_t accountCents[ACCOUNTS_DB_SIZE];
+    static ST_dayCount_t declines[BENCH_ANALYTICS_DAYS];
+    static ST_spender_t spenders[10];
+    ST_transaction_t *rows = NULL;
+    ST_settlementRecord_t *records = NULL;
+    ST_analyticsSum_t sum = {0};
+    const DATE_t firstDay = DATE_PACK(2026, 9, 1);
+    const DATE_t lastDay = DATE_PACK(2026, 9, BENCH_ANALYTICS_DAYS);
+    const DATE_t weekDay = lastDay - 6;
+    uint64_t seed = 0xA11CE, random = 0, count = 0, bucket = 0;
+    int64_t cents = 0;
+    uint32_t i = 0, dayCount = 0, spenderCount = 0;
+    double start = 0, loadSeconds = 0;
+    double rowSeconds[4] = {0}, recordSeconds[4] = {0}, columnSeconds[4] = {0};
+
+    rows = calloc(BENCH_ANALYTICS_COUNT, sizeof(*rows));
+    if(NULL == rows) {
+        printf("Failed to allocate benchmark data\n");
+        return;
+    }
+
+    resetJournal();
+    resetAnalytics();
+
+    /* Chronological days, amounts up to 1000.00, one in ten declined */
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        random = seed >> 16;
+
+        rows[i].terminalData.transactionDay = firstDay + (DATE_t)((uint64_t)i * BENCH_ANALYTICS_DAYS / BENCH_ANALYTICS_COUNT);
+        rows[i].terminalData.terminalId = (uint32_t)(random % BENCH_SETTLEMENT_TERMINALS);
+        rows[i].terminalData.transAmount = (float)((seed >> 33) % 100000) / 100.0f;
+        rows[i].transState = (((seed >> 48) & 0xFF) < 26) ? DECLINED_INSUFFICIENT_FUND : APPROVED;
+        if(SETTLEMENT_OK != journalTransaction(&rows[i], (int16_t)((seed >> 20) % getAccountsCount()),
+                                               rows[i].terminalData.transAmount)) {
+            printf("Failed to journal the transactions\n");
+            free(rows);
+            resetJournal();
+            return;
+        }
+    }
+
+    records = malloc(BENCH_ANALYTICS_COUNT * sizeof(*records));
+    if( (NULL == records) || (BENCH_ANALYTICS_COUNT != readJournal(0, BENCH_ANALYTICS_COUNT, records)) ) {
+        printf("Failed to allocate benchmark data\n");
+        free(rows);
+        free(records);
+        resetJournal();
+        return;
+    }
+
+    start = benchNowSeconds();
+    if(ANALYTICS_OK != refreshAnalytics()) {
+        printf("Failed to materialize the columns\n");
+    }
+    loadSeconds = benchNowSeconds() - start;
+
+    /* Rows: every query reads whole 96 byte transactions */
+    start = benchNowSeconds();
+    sum.count = 0;
+    sum.cents = 0;
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        if( (rows[i].terminalData.transactionDay >= weekDay) && (rows[i].terminalData.transactionDay <= lastDay) &&
+            (APPROVED == rows[i].transState) ) {
+            ++sum.count;
+            sum.cents += (int64_t)(rows[i].terminalData.transAmount * 100.0 + 0.5);
+        }
+    }
+    rowSeconds[0] = benchNowSeconds() - start;
+    count = sum.count;
+
+    start = benchNowSeconds();
+    memset(declines, 0, sizeof(declines));
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        declines[rows[i].terminalData.transactionDay - firstDay].count += (APPROVED != rows[i].transState);
+    }
+    rowSeconds[1] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    memset(histogram, 0, sizeof(histogram));
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        if(APPROVED == rows[i].transState) {
+            bucket = (uint64_t)(rows[i].terminalData.transAmount * 100.0 + 0.5) / 1000;
+            ++histogram[(bucket < BENCH_ANALYTICS_BUCKETS) ? bucket : (BENCH_ANALYTICS_BUCKETS - 1)];
+        }
+    }
+    rowSeconds[2] = benchNowSeconds() - start;
+
+    /* Journal records: 16 bytes each, the account is known */
+    start = benchNowSeconds();
+    sum.count = 0;
+    sum.cents = 0;
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        if( (records[i].transactionDay >= weekDay) && (records[i].transactionDay <= lastDay) &&
+            (APPROVED == records[i].transState) ) {
+            ++sum.count;
+            sum.cents += records[i].amountCents;
+        }
+    }
+    recordSeconds[0] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    memset(declines, 0, sizeof(declines));
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        declines[records[i].transactionDay - firstDay].count += (APPROVED != records[i].transState);
+    }
+    recordSeconds[1] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    memset(histogram, 0, sizeof(histogram));
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        if(APPROVED == records[i].transState) {
+            bucket = (uint64_t)records[i].amountCents / 1000;
+            ++histogram[(bucket < BENCH_ANALYTICS_BUCKETS) ? bucket : (BENCH_ANALYTICS_BUCKETS - 1)];
+        }
+    }
+    recordSeconds[2] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    memset(accountCents, 0, sizeof(accountCents));
+    for(i = 0; i < BENCH_ANALYTICS_COUNT; ++i) {
+        cents = (APPROVED == records[i].transState) ? records[i].amountCents : 0;
+        accountCents[records[i].accountIndex % ACCOUNTS_DB_SIZE] += cents;
+    }
+    recordSeconds[3] = benchNowSeconds() - start;
+
+    /* Columns */
+    start = benchNowSeconds();
+    sumApproved(weekDay, lastDay, &sum);
+    columnSeconds[0] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    dayCount = getDeclinesPerDay(firstDay, lastDay, declines, BENCH_ANALYTICS_DAYS);
+    columnSeconds[1] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    getAmountHistogram(firstDay, lastDay, 1000, BENCH_ANALYTICS_BUCKETS, histogram);
+    columnSeconds[2] = benchNowSeconds() - start;
+
+    start = benchNowSeconds();
+    spenderCount = getTopSpenders(firstDay, lastDay, spenders, 10);
+    columnSeconds[3] = benchNowSeconds() - start;
+
+    printf("refreshAnalytics:    %12.1f ns/transaction\n", loadSeconds * 1e9 / BENCH_ANALYTICS_COUNT);
+    printf("query (ms)             rows  records  columns\n");
+    printf("sum approved, week %8.2f %8.2f %8.2f  (%llu transactions%s)\n", rowSeconds[0] * 1e3, recordSeconds[0] * 1e3,
+           columnSeconds[0] * 1e3, (unsigned long long)sum.count, (count == sum.count) ? "" : ", MISMATCH");
+    printf("declines per day   %8.2f %8.2f %8.2f  (%u days)\n", rowSeconds[1] * 1e3, recordSeconds[1] * 1e3,
+           columnSeconds[1] * 1e3, dayCount);
+    printf("amount histogram   %8.2f %8.2f %8.2f\n", rowSeconds[2] * 1e3, recordSeconds[2] * 1e3, columnSeconds[2] * 1e3);
+    printf("top 10 spenders         -  %8.2f %8.2f  (%u accounts)\n", recordSeconds[3] * 1e3, columnSeconds[3] * 1e3,
+           spenderCount);
+
+    resetAnalytics();
+    resetJournal();
+    free(records);
+    free(rows);
+}
+
+/********************************************************************************
+ * @brief   Order latencies, for qsort()
+ *******************************************************************************/
+static int benchCompareLatencies(const void * const first, const void * const second) {
+    const uint32_t *firstLatency = first, *secondLatency = second;
+
+    return (*firstLatency > *secondLatency) - (*firstLatency < *secondLatency);
+}
@@ -0,0 +1,766 @@
+/*********************************************************************************
+ * @file    appMicroBench.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the microbenchmark suite of the public card,
+ *          terminal and server functions.
+ * @details It is not part of the application. Build it with optimizations
+ *          enabled (-O2). Every function is run for a warmup, then timed in
+ *          MICRO_SAMPLES samples of many calls each, pinned to one CPU. The
+ *          server functions are measured for several sizes of the accounts
+ *          database, the batch functions for several batch sizes.
+ *          Options:
+ *          * -c: Print CSV instead of a table, to compare commits
+ *          * name: Only run the functions whose name contains it
+ *
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Server/server.h"
+#include "../Server/exchange.h"
+#include "../Server/vault.h"
+#include "../Log/log.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              BENCHMARK SETTINGS                             */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Number of timed samples of each function
+ *******************************************************************************/
+#define MICRO_SAMPLES               31
+
+/********************************************************************************
+ * @brief   Duration of one sample, the calls per sample are chosen to fill it
+ *******************************************************************************/
+#define MICRO_SAMPLE_SECONDS        0.002
+
+/********************************************************************************
+ * @brief   Duration of the warmup of each function
+ *******************************************************************************/
+#define MICRO_WARMUP_SECONDS        0.02
+
+/********************************************************************************
+ * @brief   Batch sizes of the batch functions
+ *******************************************************************************/
+#define MICRO_MAX_BATCH_SIZE        65536
+static const uint32_t batchSizes[] = {16, 1024, MICRO_MAX_BATCH_SIZE};
+
+/********************************************************************************
+ * @brief   Sizes of the accounts database for the server functions
+ *******************************************************************************/
+static const uint32_t accountsSizes[] = {8, 64, 512, ACCOUNTS_DB_SIZE};
+
+/********************************************************************************
+ * @brief   PAN of every card, Luhn valid
+ *******************************************************************************/
+#define MICRO_PAN                   "9876543219876543210"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              BENCHMARK TYPES                                */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Function making a number of calls to the measured function
+ *******************************************************************************/
+typedef void (*MICRO_BODY_t)(const uint32_t iterations);
+
+/********************************************************************************
+ * @brief   Struct for a group of benchmarks, set up together
+ *******************************************************************************/
+typedef struct ST_microGroup_t {
+    const char *name;               /*!< Module of the functions */
+    void (*run)(void);              /*!< Sets up the data and measures the functions */
+} ST_microGroup_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                           BENCHMARK VARIABLES                               */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static BOOL_t isCsv = FALSE;
+static const char *filter = NULL;
+
+/********************************************************************************
+ * @brief   Results go there, stdout only gets the prompts of the get* functions
+ *******************************************************************************/
+static FILE *report = NULL;
+
+/********************************************************************************
+ * @brief   Results are added here so the calls are not optimized away
+ *******************************************************************************/
+static volatile uint32_t sink = 0;
+
+/********************************************************************************
+ * @brief   Data of the functions being measured
+ *******************************************************************************/
+static ST_cardData_t cardData;
+static ST_terminalData_t termData;
+static ST_transaction_t transData;
+static FILE *inputStream = NULL;
+static ST_cardData_t *batchCards = NULL;
+static EN_terminalError_t *batchResults = NULL;
+static uint16_t *batchExpiryMonths = NULL;
+static BOOL_t *batchExpired = NULL;
+static uint8_t *batchDateRecords = NULL;
+static DATE_t *batchDates = NULL;
+static uint32_t batchSize = 0;
+static uint32_t offlineSequenceNumber = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                           BENCHMARK PROTOTYPES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void microMeasure(const char * const name, const uint32_t size, const MICRO_BODY_t body);
+static void microPinCpu(void);
+static double microNowSeconds(void);
+static int microCompareDoubles(const void * const first, const void * const second);
+static void microSetInput(const char * const line);
+static void microCard(void);
+static void microTerminal(void);
+static void microTerminalBatch(void);
+static void microServer(void);
+
+/********************************************************************************
+ * @brief   Groups of benchmarks, run in this order
+ *******************************************************************************/
+static const ST_microGroup_t groups[] = {
+    {"card"             , microCard             },
+    {"terminal"         , microTerminal         },
+    {"terminal batch"   , microTerminalBatch    },
+    {"server"           , microServer           },
+};
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                                     MAIN                                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+    uint32_t i = 0;
+
+    for(i = 1; i < (uint32_t)argc; ++i) {
+        if(0 == strcmp(argv[i], "-c")) {
+            isCsv = TRUE;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    /* The prompts must not reach the report */
+    fflush(stdout);
+    report = fdopen(dup(STDOUT_FILENO), "w");
+    if( (NULL == report) || (NULL == freopen("/dev/null", "w", stdout)) ) {
+        fprintf(stderr, "Failed to redirect the prompts\n");
+        return 1;
+    }
+
+    microPinCpu();
+    srand(0x5EED);
+
+    if(isCsv) {
+        fprintf(report, "function,size,iterations,samples,min_ns,median_ns,mean_ns,stddev_ns\n");
+    } else {
+        fprintf(report, "%-26s %6s %10s %10s %10s %10s %10s\n",
+               "Function", "Size", "Calls", "Min(ns)", "Median(ns)", "Mean(ns)", "StdDev(ns)");
+    }
+
+    for(i = 0; i < sizeof(groups) / sizeof(groups[0]); ++i) {
+        groups[i].run();
+    }
+
+    fclose(report);
+
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                            MEASUREMENT FUNCTIONS                            */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Measure a function and print its statistics, per call
+ *
+ * @param   name: Name of the function
+ * @param   size: Size of its data, 1 for scalar functions
+ * @param   body: Makes the calls
+ *******************************************************************************/
+static void microMeasure(const char * const name, const uint32_t size, const MICRO_BODY_t body) {
+    double samples[MICRO_SAMPLES];
+    double start = 0, elapsed = 0, mean = 0, variance = 0;
+    uint32_t iterations = 1, i = 0;
+
+    if( (NULL != filter) && (NULL == strstr(name, filter)) ) {
+        return;
+    }
+
+    /* Doubling the calls until one sample lasts long enough */
+    do {
+        start = microNowSeconds();
+        body(iterations);
+        elapsed = microNowSeconds() - start;
+        if(elapsed < MICRO_SAMPLE_SECONDS) {
+            iterations *= 2;
+        }
+    } while( (elapsed < MICRO_SAMPLE_SECONDS) && (iterations < (1u << 30)) );
+
+    /* Warming the caches and the branch predictors */
+    start = microNowSeconds();
+    while(microNowSeconds() - start < MICRO_WARMUP_SECONDS) {
+        body(iterations);
+    }
+
+    for(i = 0; i < MICRO_SAMPLES; ++i) {
+        start = microNowSeconds();
+        body(iterations);
+        samples[i] = (microNowSeconds() - start) * 1e9 / iterations;
+        mean += samples[i];
+    }
+    mean /= MICRO_SAMPLES;
+
+    for(i = 0; i < MICRO_SAMPLES; ++i) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    variance /= (MICRO_SAMPLES - 1);
+
+    qsort(samples, MICRO_SAMPLES, sizeof(samples[0]), microCompareDoubles);
+
+    if(isCsv) {
+        fprintf(report, "%s,%u,%u,%u,%.2f,%.2f,%.2f,%.2f\n", name, size, iterations, MICRO_SAMPLES,
+               samples[0], samples[MICRO_SAMPLES / 2], mean, sqrt(variance));
+    } else {
+        fprintf(report, "%-26s %6u %10u %10.1f %10.1f %10.1f %10.1f\n", name, size, iterations,
+               samples[0], samples[MICRO_SAMPLES / 2], mean, sqrt(variance));
+    }
+    fflush(report);
+}
+
+/********************************************************************************
+ * @brief   Keep the benchmark on one CPU, so samples are not split between
+ *          cores with different caches and frequencies
+ *******************************************************************************/
+static void microPinCpu(void) {
+#if defined(__linux__)
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    if(0 == sched_getaffinity(0, sizeof(cpus), &cpus)) {
+        int cpu = 0;
+
+        /* First CPU this process may run on */
+        while( (cpu < CPU_SETSIZE) && !CPU_ISSET(cpu, &cpus) ) {
+            ++cpu;
+        }
+
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if(0 != sched_setaffinity(0, sizeof(cpus), &cpus)) {
+            fprintf(stderr, "Failed to pin to CPU %d, results may be noisy\n", cpu);
+        }
+    }
+#endif
+}
+
+/********************************************************************************
+ * @brief   Get a monotonic timestamp in seconds
+ *******************************************************************************/
+static double microNowSeconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+/********************************************************************************
+ * @brief   Order samples, for qsort()
+ *******************************************************************************/
+static int microCompareDoubles(const void * const first, const void * const second) {
+    const double *firstValue = first, *secondValue = second;
+
+    return (*firstValue > *secondValue) - (*firstValue < *secondValue);
+}
+
+/********************************************************************************
+ * @brief   Make a line the input of the get* functions, they read it again
+ *          after each rewind of the stream
+ *******************************************************************************/
+static void microSetInput(const char * const line) {
+
+    if(NULL != inputStream) {
+        fclose(inputStream);
+    }
+
+    inputStream = tmpfile();
+    if(NULL != inputStream) {
+        fputs(line, inputStream);
+    }
+
+    setCardInputStream(inputStream);
+    setTerminalInputStream(inputStream);
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                               CARD FUNCTIONS                                */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void bodyParseCardHolderName(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseCardHolderName(&cardData, (const uint8_t *)"Mahmoud Karam Emara Ali");
+    }
+}
+
+static void bodyParseCardExpiryDate(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseCardExpiryDate(&cardData, (const uint8_t *)"12/30");
+    }
+}
+
+static void bodyParseCardPAN(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseCardPAN(&cardData, (const uint8_t *)MICRO_PAN);
+    }
+}
+
+static void bodyGetCardExpiryYear(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += (uint32_t)getCardExpiryYear(&cardData);
+    }
+}
+
+static void bodyGetCardExpiryMonth(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += (uint32_t)getCardExpiryMonth(&cardData);
+    }
+}
+
+static void bodyGetCardExpiryMonths(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += (uint32_t)getCardExpiryMonths(&cardData);
+    }
+}
+
+static void bodyGetCardHolderName(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += getCardHolderName(&cardData);
+    }
+}
+
+static void bodyGetCardExpiryDate(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += getCardExpiryDate(&cardData);
+    }
+}
+
+static void bodyGetCardPAN(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += getCardPAN(&cardData);
+    }
+}
+
+/********************************************************************************
+ * @brief   Card functions, the get* ones read a stream rewound before each call
+ *******************************************************************************/
+static void microCard(void) {
+
+    parseCardHolderName(&cardData, (const uint8_t *)"Mahmoud Karam Emara Ali");
+    parseCardExpiryDate(&cardData, (const uint8_t *)"12/30");
+    parseCardPAN(&cardData, (const uint8_t *)MICRO_PAN);
+
+    microMeasure("parseCardHolderName", 1, bodyParseCardHolderName);
+    microMeasure("parseCardExpiryDate", 1, bodyParseCardExpiryDate);
+    microMeasure("parseCardPAN", 1, bodyParseCardPAN);
+    microMeasure("getCardExpiryYear", 1, bodyGetCardExpiryYear);
+    microMeasure("getCardExpiryMonth", 1, bodyGetCardExpiryMonth);
+    microMeasure("getCardExpiryMonths", 1, bodyGetCardExpiryMonths);
+
+    microSetInput("Mahmoud Karam Emara Ali\n");
+    microMeasure("getCardHolderName", 1, bodyGetCardHolderName);
+    microSetInput("12/30\n");
+    microMeasure("getCardExpiryDate", 1, bodyGetCardExpiryDate);
+    microSetInput(MICRO_PAN "\n");
+    microMeasure("getCardPAN", 1, bodyGetCardPAN);
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             TERMINAL FUNCTIONS                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void bodyParseTransactionDate(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseTransactionDate(&termData, (const uint8_t *)"19/10/2026");
+    }
+}
+
+static void bodyParseTransactionAmount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseTransactionAmount(&termData, (const uint8_t *)"100");
+    }
+}
+
+static void bodyParseMaxAmount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseMaxAmount(&termData, (const uint8_t *)"1000");
+    }
+}
+
+static void bodyParseDate(const uint32_t iterations) {
+    DATE_t date = 0;
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseDate((const uint8_t *)"19/10/2026", &date);
+        sink += date;
+    }
+}
+
+static void bodyIsDateInRange(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isDateInRange(termData.transactionDay + (DATE_t)(i & 1), DATE_PACK(2026, 1, 1), DATE_PACK(2026, 12, 31));
+    }
+}
+
+static void bodyIsCardExpired(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isCardExpired(&cardData, &termData);
+    }
+}
+
+static void bodyIsValidCardPAN(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isValidCardPAN(&cardData);
+    }
+}
+
+static void bodyIsBelowMaxAmount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isBelowMaxAmount(&termData);
+    }
+}
+
+static void bodyGetTransactionDate(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += getTransactionDate(&termData);
+    }
+}
+
+static void bodyGetTransactionAmount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += getTransactionAmount(&termData);
+    }
+}
+
+static void bodySetMaxAmount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        rewind(inputStream);
+        sink += setMaxAmount(&termData);
+    }
+}
+
+/********************************************************************************
+ * @brief   Terminal functions of one transaction
+ *******************************************************************************/
+static void microTerminal(void) {
+
+    parseCardExpiryDate(&cardData, (const uint8_t *)"12/30");
+    parseCardPAN(&cardData, (const uint8_t *)MICRO_PAN);
+    parseTransactionDate(&termData, (const uint8_t *)"19/10/2026");
+    parseMaxAmount(&termData, (const uint8_t *)"1000");
+    parseTransactionAmount(&termData, (const uint8_t *)"100");
+
+    microMeasure("parseTransactionDate", 1, bodyParseTransactionDate);
+    microMeasure("parseTransactionAmount", 1, bodyParseTransactionAmount);
+    microMeasure("parseMaxAmount", 1, bodyParseMaxAmount);
+    microMeasure("parseDate", 1, bodyParseDate);
+    microMeasure("isDateInRange", 1, bodyIsDateInRange);
+    microMeasure("isCardExpired", 1, bodyIsCardExpired);
+    microMeasure("isValidCardPAN", 1, bodyIsValidCardPAN);
+    microMeasure("isBelowMaxAmount", 1, bodyIsBelowMaxAmount);
+
+    microSetInput("19/10/2026\n");
+    microMeasure("getTransactionDate", 1, bodyGetTransactionDate);
+    microSetInput("100\n");
+    microMeasure("getTransactionAmount", 1, bodyGetTransactionAmount);
+    microSetInput("1000\n");
+    microMeasure("setMaxAmount", 1, bodySetMaxAmount);
+}
+
+static void bodyIsValidCardPANBatch(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isValidCardPANBatch(batchCards, batchSize, batchResults);
+    }
+}
+
+static void bodyIsCardExpiredBatch(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isCardExpiredBatch(batchExpiryMonths, batchSize, termData.transactionDay, batchExpired);
+    }
+}
+
+static void bodyParseDateBatch(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += parseDateBatch(batchDateRecords, batchSize, 11, batchDates);
+    }
+}
+
+/********************************************************************************
+ * @brief   Terminal functions working on batches, timed per batch
+ *******************************************************************************/
+static void microTerminalBatch(void) {
+    uint32_t i = 0, size = 0;
+
+    batchCards        = calloc(MICRO_MAX_BATCH_SIZE, sizeof(*batchCards));
+    batchResults      = calloc(MICRO_MAX_BATCH_SIZE, sizeof(*batchResults));
+    batchExpiryMonths = calloc(MICRO_MAX_BATCH_SIZE, sizeof(*batchExpiryMonths));
+    batchExpired      = calloc(MICRO_MAX_BATCH_SIZE, sizeof(*batchExpired));
+    batchDateRecords  = calloc(MICRO_MAX_BATCH_SIZE, 11);
+    batchDates        = calloc(MICRO_MAX_BATCH_SIZE, sizeof(*batchDates));
+
+    if( (NULL != batchCards) && (NULL != batchResults) && (NULL != batchExpiryMonths) &&
+        (NULL != batchExpired) && (NULL != batchDateRecords) && (NULL != batchDates) ) {
+
+        for(i = 0; i < MICRO_MAX_BATCH_SIZE; ++i) {
+            strcpy((char *)batchCards[i].primaryAccountNumber, MICRO_PAN);
+            batchExpiryMonths[i] = (uint16_t)(rand() % 480);
+            sprintf((char *)&batchDateRecords[i * 11], "%02d/%02d/%04d", 1 + rand() % 28, 1 + rand() % 12, 2000 + rand() % 100);
+        }
+
+        for(size = 0; size < sizeof(batchSizes) / sizeof(batchSizes[0]); ++size) {
+            batchSize = batchSizes[size];
+            microMeasure("isValidCardPANBatch", batchSize, bodyIsValidCardPANBatch);
+            microMeasure("isCardExpiredBatch", batchSize, bodyIsCardExpiredBatch);
+            microMeasure("parseDateBatch", batchSize, bodyParseDateBatch);
+        }
+    } else {
+        fprintf(stderr, "Failed to allocate benchmark data\n");
+    }
+
+    free(batchCards);
+    free(batchResults);
+    free(batchExpiryMonths);
+    free(batchExpired);
+    free(batchDateRecords);
+    free(batchDates);
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              SERVER FUNCTIONS                               */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void bodyIsValidAccount(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isValidAccount(&(transData.cardHolderData));
+    }
+}
+
+static void bodyIsAmountAvailable(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += isAmountAvailable(&(transData.terminalData));
+    }
+}
+
+static void bodySaveTransaction(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += saveTransaction(&transData);
+    }
+}
+
+static void bodyGetTransaction(const uint32_t iterations) {
+    ST_transactionRecord_t transaction;
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += getTransaction(transData.transactionSequenceNumber, &transaction);
+    }
+}
+
+static void bodyRecieveTransactionData(const uint32_t iterations) {
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += recieveTransactionData(&transData);
+    }
+}
+
+static void bodyTokenizePan(const uint32_t iterations) {
+    PAN_TOKEN_t token = PAN_TOKEN_NONE;
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += tokenizePan((const uint8_t *)MICRO_PAN, &token);
+    }
+    sink += (uint32_t)token;
+}
+
+static void bodyDetokenizePan(const uint32_t iterations) {
+    PAN_TOKEN_t token = PAN_TOKEN_NONE;
+    uint8_t pan[VAULT_MAX_PAN_LENGTH + 1];
+    uint32_t i = 0;
+
+    tokenizePan((const uint8_t *)MICRO_PAN, &token);
+    for(i = 0; i < iterations; ++i) {
+        sink += detokenizePan(token, pan);
+    }
+    sink += pan[0];
+}
+
+static void bodyConvertAmount(const uint32_t iterations) {
+    int64_t convertedCents = 0;
+    uint32_t i = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        sink += convertAmount(i, CURRENCY_PACK('U', 'S', 'D'), CURRENCY_PACK('E', 'G', 'P'), &convertedCents);
+        sink += (uint32_t)convertedCents;
+    }
+}
+
+static void bodyReconcileOfflineBatch(const uint32_t iterations) {
+    uint32_t i = 0, postedCount = 0;
+
+    for(i = 0; i < iterations; ++i) {
+        transData.offlineSequenceNumber = ++offlineSequenceNumber;
+        sink += reconcileOfflineBatch(&transData, 1, &postedCount);
+    }
+}
+
+/********************************************************************************
+ * @brief   Server functions for growing accounts databases. The card is the
+ *          last account added, the worst case of the account search.
+ *******************************************************************************/
+static void microServer(void) {
+    ST_accountsDB_t account = {.balance = 1000};
+    const ST_exchangeQuote_t quote = {CURRENCY_PACK('U', 'S', 'D'), CURRENCY_PACK('E', 'G', 'P'), 4825150000ull};
+    uint32_t size = 0;
+
+    /* Events would be printed on every approval */
+    setLogPrinting(FALSE);
+
+    /* A null amount is always available and keeps the balances */
+    transData.terminalData.transAmount = 0;
+
+    /* The cost of a conversion does not depend on the accounts */
+    if(EXCHANGE_OK == loadExchangeRates(&quote, 1)) {
+        microMeasure("convertAmount", 1, bodyConvertAmount);
+    }
+    unloadExchangeRates();
+
+    /* Neither does a lookup in the vault, the card is tokenized once */
+    microMeasure("tokenizePan", 1, bodyTokenizePan);
+    microMeasure("detokenizePan", 1, bodyDetokenizePan);
+
+    for(size = 0; size < sizeof(accountsSizes) / sizeof(accountsSizes[0]); ++size) {
+        while(getAccountsCount() < accountsSizes[size]) {
+            sprintf((char *)account.primaryAccountNumber, "5%018u", getAccountsCount());
+            if(SERVER_OK != addAccount(&account)) {
+                break;
+            }
+        }
+        strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+
+        microMeasure("isValidAccount", getAccountsCount(), bodyIsValidAccount);
+        isValidAccount(&(transData.cardHolderData));
+        microMeasure("isAmountAvailable", getAccountsCount(), bodyIsAmountAvailable);
+        microMeasure("saveTransaction", getAccountsCount(), bodySaveTransaction);
+        microMeasure("getTransaction", getAccountsCount(), bodyGetTransaction);
+        microMeasure("recieveTransactionData", getAccountsCount(), bodyRecieveTransactionData);
+        microMeasure("reconcileOfflineBatch", getAccountsCount(), bodyReconcileOfflineBatch);
+    }
+
+    setLogPrinting(TRUE);
+}
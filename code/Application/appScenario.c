@@ -0,0 +1,431 @@
+/*********************************************************************************
+ * @file    appScenario.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the scenario replay of the recorded user stories.
+ * @details The five user stories of recordings/3_test_cases (approved, exceeds
+ *          the maximum amount, insufficient fund, expired card and invalid
+ *          card) are replayed as scripted inputs through the states of
+ *          \ref stateMachine, like appStart() does with a user. Many terminals
+ *          run at once on one thread, each starting a new transaction of a
+ *          randomly drawn story when its last one is over.
+ *          Usage: ./a.out [transactions] [approved,exceeds,insufficient,expired,invalid]
+ *          e.g. "./a.out 1000000 60,10,10,10,10" for 60% approvals.
+ *          It is not part of the application. Build it with optimizations
+ *          enabled (-O2).
+ *
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Server/server.h"
+#include "../Log/log.h"
+#include "../Log/latency.h"
+#include "state.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              SCENARIO SETTINGS                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Number of transactions replayed when none is given
+ *******************************************************************************/
+#define SCENARIO_DEFAULT_COUNT      1000000u
+
+/********************************************************************************
+ * @brief   Number of terminals running transactions at once
+ *******************************************************************************/
+#define SCENARIO_TERMINALS_COUNT    256
+
+/********************************************************************************
+ * @brief   Maximum number of input lines of a story
+ *******************************************************************************/
+#define SCENARIO_MAX_LINES          8
+
+/********************************************************************************
+ * @brief   Account of the approved story, added with a balance covering every
+ *          transaction so approvals never run out of fund
+ *******************************************************************************/
+#define SCENARIO_APPROVED_PAN       "4000111122223333448"
+
+/********************************************************************************
+ * @brief   Amount of the approved story
+ *******************************************************************************/
+#define SCENARIO_APPROVED_AMOUNT    1
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                                SCENARIO TYPES                               */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Enum for the outcomes of the user stories
+ *******************************************************************************/
+typedef enum EN_scenarioOutcome_t {
+    OUTCOME_APPROVED,               /*!< Approved by the server */
+    OUTCOME_EXCEEDS_MAX_AMOUNT,     /*!< Failed at the terminal, amount above the maximum */
+    OUTCOME_INSUFFICIENT_FUND,      /*!< Declined by the server, balance too low */
+    OUTCOME_EXPIRED_CARD,           /*!< Failed at the terminal, card expired */
+    OUTCOME_INVALID_CARD,           /*!< Declined by the server, unknown account */
+    OUTCOME_OTHER,                  /*!< Anything else, e.g. a fraud decline */
+    OUTCOME_COUNT
+} EN_scenarioOutcome_t;
+
+/********************************************************************************
+ * @brief   Struct for a recorded user story
+ *******************************************************************************/
+typedef struct ST_scenario_t {
+    const char *name;                               /*!< Name printed in the report */
+    const char *lines[SCENARIO_MAX_LINES];          /*!< Lines the user types, NULL terminated */
+} ST_scenario_t;
+
+/********************************************************************************
+ * @brief   Struct for a terminal replaying stories
+ *******************************************************************************/
+typedef struct ST_scenarioTerminal_t {
+    ST_transactionContext_t context;                /*!< Transaction in progress */
+    uint8_t scenario;                               /*!< Story of the transaction, in \ref scenarios */
+    uint8_t nextLine;                               /*!< Next line of the story to type */
+    uint64_t serviceNanoseconds;                    /*!< Time spent in the states by the transaction */
+} ST_scenarioTerminal_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              SCENARIO VARIABLES                             */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The recorded user stories, in the order of \ref EN_scenarioOutcome_t
+ *******************************************************************************/
+static const ST_scenario_t scenarios[] = {
+    {"approved",            {"Mahmoud Karam Emara Ali", "12/30", SCENARIO_APPROVED_PAN,
+                             "19/10/2026", "1000", "1", NULL}                                   },
+    {"exceeds max amount",  {"Mahmoud Karam Emara Ali", "12/30", SCENARIO_APPROVED_PAN,
+                             "19/10/2026", "1000", "5000", "n", NULL}                           },
+    {"insufficient fund",   {"Mahmoud Karam Emara Ali", "12/30", "1122334455667788990",
+                             "19/10/2026", "10000", "5000", NULL}                               },
+    {"expired card",        {"Mahmoud Karam Emara Ali", "01/20", SCENARIO_APPROVED_PAN,
+                             "19/10/2026", NULL}                                                },
+    {"invalid card",        {"Mahmoud Karam Emara Ali", "12/30", "5555666677778888998",
+                             "19/10/2026", "1000", "100", NULL}                                 },
+};
+
+#define SCENARIO_COUNT      (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const char * const outcomeNames[OUTCOME_COUNT] = {
+    "approved", "exceeds max amount", "insufficient fund", "expired card", "invalid card", "other",
+};
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             SCENARIO PROTOTYPES                             */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static BOOL_t parseMix(const char * const text, uint32_t * const weights);
+static uint8_t drawScenario(const uint32_t * const weights, const uint32_t totalWeight);
+static void startTransaction(ST_scenarioTerminal_t * const terminal, const uint8_t scenario, const uint32_t terminalId);
+static EN_scenarioOutcome_t getOutcome(const ST_transactionContext_t * const context);
+static uint64_t nowNanoseconds(void);
+static int compareLatencies(const void * const first, const void * const second);
+static void printLatencies(uint32_t * const latencies, const uint32_t count);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                                     MAIN                                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+    static ST_scenarioTerminal_t terminals[SCENARIO_TERMINALS_COUNT];
+    ST_accountsDB_t account = {.primaryAccountNumber = SCENARIO_APPROVED_PAN};
+    uint32_t weights[SCENARIO_COUNT] = {60, 10, 10, 10, 10};
+    uint32_t outcomeCounts[OUTCOME_COUNT] = {0};
+    uint32_t mismatchCounts[SCENARIO_COUNT] = {0};
+    uint32_t *latencies = NULL, *outcomeLatencies = NULL;
+    uint8_t *outcomes = NULL;
+    uint32_t transactionCount = SCENARIO_DEFAULT_COUNT, totalWeight = 0;
+    uint32_t startedCount = 0, doneCount = 0, count = 0, i = 0, j = 0;
+    ST_scenarioTerminal_t *terminal = NULL;
+    EN_scenarioOutcome_t outcome;
+    EN_contextStatus_t status;
+    const char *line = NULL;
+    uint64_t start = 0, elapsed = 0, callStart = 0;
+
+    if(argc > 1) {
+        transactionCount = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if( (argc > 2) && !parseMix(argv[2], weights) ) {
+        printf("The mix is 5 weights: approved,exceeds,insufficient,expired,invalid\n");
+        return 1;
+    }
+    for(i = 0; i < SCENARIO_COUNT; ++i) {
+        totalWeight += weights[i];
+    }
+    if( (0 == transactionCount) || (0 == totalWeight) ) {
+        printf("Nothing to replay\n");
+        return 1;
+    }
+
+    latencies        = malloc(transactionCount * sizeof(*latencies));
+    outcomeLatencies = malloc(transactionCount * sizeof(*outcomeLatencies));
+    outcomes         = malloc(transactionCount * sizeof(*outcomes));
+    if( (NULL == latencies) || (NULL == outcomeLatencies) || (NULL == outcomes) ) {
+        printf("Failed to allocate %u transactions\n", transactionCount);
+        return 1;
+    }
+
+    account.balance = (float)transactionCount * SCENARIO_APPROVED_AMOUNT + 1;
+    if(SERVER_OK != addAccount(&account)) {
+        printf("Failed to add the account of the approved story\n");
+        return 1;
+    }
+
+    setLogPrinting(FALSE);
+    srand(0x5EED);
+
+    start = nowNanoseconds();
+
+    for(i = 0; (i < SCENARIO_TERMINALS_COUNT) && (startedCount < transactionCount); ++i, ++startedCount) {
+        startTransaction(&terminals[i], drawScenario(weights, totalWeight), i + 1);
+    }
+
+    /* One thread, every terminal types one line per round, like appStart() with many users */
+    while(doneCount < transactionCount) {
+        for(i = 0; i < SCENARIO_TERMINALS_COUNT; ++i) {
+            terminal = &terminals[i];
+            if(CONTEXT_NEEDS_INPUT != terminal->context.status) {
+                continue;
+            }
+
+            line = scenarios[terminal->scenario].lines[terminal->nextLine];
+            if(NULL != line) {
+                ++(terminal->nextLine);
+            }
+
+            /* A story running out of lines answers no to what is left */
+            callStart = nowNanoseconds();
+            status = resumeTransaction(&(terminal->context), (const uint8_t *)((NULL == line) ? "n" : line));
+            terminal->serviceNanoseconds += nowNanoseconds() - callStart;
+
+            if(CONTEXT_NEEDS_INPUT == status) {
+                continue;
+            }
+
+            outcome = getOutcome(&(terminal->context));
+            latencies[doneCount] = (uint32_t)terminal->serviceNanoseconds;
+            outcomes[doneCount] = (uint8_t)outcome;
+            ++outcomeCounts[outcome];
+            if(outcome != (EN_scenarioOutcome_t)terminal->scenario) {
+                ++mismatchCounts[terminal->scenario];
+            }
+            ++doneCount;
+
+            if(startedCount < transactionCount) {
+                startTransaction(terminal, drawScenario(weights, totalWeight), i + 1);
+                ++startedCount;
+            }
+        }
+    }
+
+    elapsed = nowNanoseconds() - start;
+
+    setLogPrinting(TRUE);
+
+    printf("%u transactions on %u terminals in %.3f s, %.0f transactions/s\n\n",
+           doneCount, SCENARIO_TERMINALS_COUNT, elapsed / 1e9, doneCount / (elapsed / 1e9));
+
+    printf("%-20s %10s %7s %10s %10s %10s %10s\n",
+           "Outcome", "Count", "Share", "Mean(ns)", "p50(ns)", "p99(ns)", "Max(ns)");
+    for(i = 0; i < OUTCOME_COUNT; ++i) {
+        for(count = 0, j = 0; j < doneCount; ++j) {
+            if(i == outcomes[j]) {
+                outcomeLatencies[count++] = latencies[j];
+            }
+        }
+        if(count != outcomeCounts[i]) {
+            printf("Outcome counts do not add up\n");
+        }
+        printf("%-20s %10u %6.2f%%", outcomeNames[i], count, 100.0 * count / doneCount);
+        printLatencies(outcomeLatencies, count);
+    }
+    printf("%-20s %10u %6.2f%%", "all", doneCount, 100.0);
+    printLatencies(latencies, doneCount);
+
+    printf("\nLatency is the time spent in the states by one transaction.\n\n");
+    printLatencyStats(stdout);
+
+    for(i = 0; i < SCENARIO_COUNT; ++i) {
+        if(mismatchCounts[i] > 0) {
+            printf("%u \"%s\" transactions had another outcome\n", mismatchCounts[i], scenarios[i].name);
+        }
+    }
+
+    free(latencies);
+    free(outcomeLatencies);
+    free(outcomes);
+
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              SCENARIO FUNCTIONS                             */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Read the weights of the stories, e.g. "60,10,10,10,10"
+ *
+ * @param   text: Comma separated weights
+ * @param   weights: Array of \ref SCENARIO_COUNT weights
+ * @return  BOOL_t: TRUE, or FALSE if there are not SCENARIO_COUNT weights
+ *******************************************************************************/
+static BOOL_t parseMix(const char * const text, uint32_t * const weights) {
+    const char *cursor = text;
+    char *end = NULL;
+    uint32_t i = 0;
+
+    for(i = 0; i < SCENARIO_COUNT; ++i) {
+        weights[i] = (uint32_t)strtoul(cursor, &end, 10);
+        if(end == cursor) {
+            return FALSE;
+        }
+        cursor = ( (',' == *end) && (i + 1 < SCENARIO_COUNT) ) ? (end + 1) : end;
+    }
+
+    return ('\0' == *cursor);
+}
+
+/********************************************************************************
+ * @brief   Draw the story of a new transaction following the weights
+ *******************************************************************************/
+static uint8_t drawScenario(const uint32_t * const weights, const uint32_t totalWeight) {
+    uint32_t draw = (uint32_t)rand() % totalWeight;
+    uint8_t scenario = 0;
+
+    while(draw >= weights[scenario]) {
+        draw -= weights[scenario];
+        ++scenario;
+    }
+
+    return scenario;
+}
+
+/********************************************************************************
+ * @brief   Start a transaction of a story on a terminal, up to its first input
+ *******************************************************************************/
+static void startTransaction(ST_scenarioTerminal_t * const terminal, const uint8_t scenario, const uint32_t terminalId) {
+    uint64_t callStart = 0;
+
+    initTransactionContext(&(terminal->context), terminalId);
+    terminal->context.isVerbose = FALSE;
+    terminal->scenario = scenario;
+    terminal->nextLine = 0;
+
+    callStart = nowNanoseconds();
+    resumeTransaction(&(terminal->context), NULL);
+    terminal->serviceNanoseconds = nowNanoseconds() - callStart;
+}
+
+/********************************************************************************
+ * @brief   Find the user story a finished transaction ended like, from the
+ *          state it stopped at and its data
+ *******************************************************************************/
+static EN_scenarioOutcome_t getOutcome(const ST_transactionContext_t * const context) {
+    const ST_transaction_t * const transData = &(context->transData);
+
+    if(CONTEXT_DONE == context->status) {
+        return (APPROVED == transData->transState) ? OUTCOME_APPROVED : OUTCOME_OTHER;
+    }
+
+    switch(stateMachine[context->stateIndex].state) {
+        case STATE_MACHINE_TERMINAL:
+            if(EXPIRED_CARD == isCardExpired( &(transData->cardHolderData), &(transData->terminalData) )) {
+                return OUTCOME_EXPIRED_CARD;
+            }
+            if(EXCEED_MAX_AMOUNT == isBelowMaxAmount( &(transData->terminalData) )) {
+                return OUTCOME_EXCEEDS_MAX_AMOUNT;
+            }
+            break;
+
+        case STATE_MACHINE_SERVER:
+            if(DECLINED_INSUFFICIENT_FUND == transData->transState) {
+                return OUTCOME_INSUFFICIENT_FUND;
+            }
+            if(DECLINED_STOLEN_CARD == transData->transState) {
+                return OUTCOME_INVALID_CARD;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return OUTCOME_OTHER;
+}
+
+/********************************************************************************
+ * @brief   Get a monotonic timestamp in nanoseconds
+ *******************************************************************************/
+static uint64_t nowNanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/********************************************************************************
+ * @brief   Order latencies, for qsort()
+ *******************************************************************************/
+static int compareLatencies(const void * const first, const void * const second) {
+    const uint32_t *firstLatency = first, *secondLatency = second;
+
+    return (*firstLatency > *secondLatency) - (*firstLatency < *secondLatency);
+}
+
+/********************************************************************************
+ * @brief   Print the mean, median, 99th percentile and maximum of latencies,
+ *          sorting them
+ *******************************************************************************/
+static void printLatencies(uint32_t * const latencies, const uint32_t count) {
+    uint64_t sum = 0;
+    uint32_t i = 0;
+
+    if(0 == count) {
+        printf("\n");
+        return;
+    }
+
+    for(i = 0; i < count; ++i) {
+        sum += latencies[i];
+    }
+
+    qsort(latencies, count, sizeof(*latencies), compareLatencies);
+
+    printf(" %10.0f %10u %10u %10u\n", (double)sum / count, latencies[count / 2],
+           latencies[(uint32_t)((uint64_t)count * 99 / 100)], latencies[count - 1]);
+}
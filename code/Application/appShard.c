@@ -0,0 +1,96 @@
+/*********************************************************************************
+ * @file    appShard.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the main function of a shard process.
+ * @details A shard serves the accounts it owns to the router of the
+ *          application, see \ref shard.h.
+ *          Usage: ./shard socketPath shardId shardCount [standbySocket sync|async]
+ *          e.g. "./shard /tmp/shard0 0 2" and "./shard /tmp/shard1 1 2" for two
+ *          shards, listed in shards.txt. A third one is started empty with
+ *          "./shard /tmp/shard2 2 2", then added by typing "!addshard
+ *          /tmp/shard2" in the application.
+ *          A shard replicates to a standby process when given its socket and
+ *          mode, e.g. "./shard /tmp/shard0 0 2 /tmp/standby0 sync", see
+ *          appStandby.c. Shards need Linux, they talk over Unix domain
+ *          sockets.
+ *
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Terminal/config.h"
+#include "../Server/server.h"
+#include "../Server/exchange.h"
+#include "../Server/shard.h"
+#include "../Server/replication.h"
+#include "../Server/admission.h"
+#include "../Log/log.h"
+
+
+/********************************************************************************
+ * @brief   Exchange rates file, the amounts are converted by the shards
+ *******************************************************************************/
+#define SHARD_EXCHANGE_RATES_FILE   "rates.txt"
+
+/********************************************************************************
+ * @brief   Terminal configuration and admission limits, every transaction is
+ *          admitted without them
+ *******************************************************************************/
+#define SHARD_TERMINAL_CONFIG_FILE  "terminals.txt"
+#define SHARD_ADMISSION_FILE        "admission.txt"
+
+
+int main(int argc, char *argv[]) {
+    EN_shardError_t shardError;
+    EN_replicationError_t replicationError;
+    unsigned long shardId = 0, shardCount = 0;
+
+    if( (4 != argc) && (6 != argc) ) {
+        printf("Usage: %s socketPath shardId shardCount [standbySocket sync|async]\n", argv[0]);
+        return 1;
+    }
+
+    shardId = strtoul(argv[2], NULL, 10);
+    shardCount = strtoul(argv[3], NULL, 10);
+    /* shardId equal to shardCount starts the shard to add, empty */
+    if( (shardCount > SHARD_MAX_COUNT) || (shardId > shardCount) ) {
+        printf("The shard ID is at most the shard count, which is at most %d\n", SHARD_MAX_COUNT);
+        return 1;
+    }
+
+    /* Events would be printed on every authorization */
+    setLogPrinting(FALSE);
+    loadExchangeRatesFile(SHARD_EXCHANGE_RATES_FILE);
+    loadTerminalConfig(SHARD_TERMINAL_CONFIG_FILE);
+    loadAdmissionLimitsFile(SHARD_ADMISSION_FILE);
+
+    if(6 == argc) {
+        replicationError = startReplication(argv[4], ('s' == argv[5][0]) ? REPLICATION_SYNC : REPLICATION_ASYNC);
+        if(REPLICATION_OK != replicationError) {
+            printf("Failed to replicate to %s (Replication Error %d)\n", argv[4], replicationError);
+            return 1;
+        }
+    }
+
+    shardError = runShard(argv[1], (uint8_t)shardId, (uint8_t)shardCount);
+    stopReplication(FALSE);
+    unloadAdmissionLimits();
+    unloadTerminalConfig();
+    unloadExchangeRates();
+
+    if(SHARD_OK != shardError) {
+        printf("Failed to serve %s (Shard Error %d)\n", argv[1], shardError);
+        return 1;
+    }
+
+    return 0;
+}
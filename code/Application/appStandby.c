@@ -0,0 +1,73 @@
+/*********************************************************************************
+ * @file    appStandby.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the main function of a standby process.
+ * @details A standby applies the changes of a primary server, see
+ *          \ref replication.h, and serves its accounts as a shard once
+ *          promoted.
+ *          Usage: ./standby replicationSocket servingSocket
+ *          e.g. "./standby /tmp/standby /tmp/shard0" as the standby of the
+ *          application, with "/tmp/standby sync" in standby.txt. When the
+ *          application exits the standby stops, when it dies the standby
+ *          serves /tmp/shard0, listed in shards.txt for the next application.
+ *          Standbys need Linux, like the shards.
+ *
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Terminal/config.h"
+#include "../Server/server.h"
+#include "../Server/exchange.h"
+#include "../Server/replication.h"
+#include "../Server/admission.h"
+#include "../Log/log.h"
+
+
+/********************************************************************************
+ * @brief   Exchange rates file, the amounts are converted once promoted
+ *******************************************************************************/
+#define STANDBY_EXCHANGE_RATES_FILE "rates.txt"
+
+/********************************************************************************
+ * @brief   Terminal configuration and admission limits, applied once promoted
+ *******************************************************************************/
+#define STANDBY_TERMINAL_CONFIG_FILE "terminals.txt"
+#define STANDBY_ADMISSION_FILE      "admission.txt"
+
+
+int main(int argc, char *argv[]) {
+    EN_replicationError_t replicationError;
+
+    if(3 != argc) {
+        printf("Usage: %s replicationSocket servingSocket\n", argv[0]);
+        return 1;
+    }
+
+    /* Events would be printed on every change applied */
+    setLogPrinting(FALSE);
+    loadExchangeRatesFile(STANDBY_EXCHANGE_RATES_FILE);
+    loadTerminalConfig(STANDBY_TERMINAL_CONFIG_FILE);
+    loadAdmissionLimitsFile(STANDBY_ADMISSION_FILE);
+
+    replicationError = runStandby(argv[1], argv[2]);
+    unloadAdmissionLimits();
+    unloadTerminalConfig();
+    unloadExchangeRates();
+
+    if(REPLICATION_OK != replicationError) {
+        printf("Failed to stand by on %s (Replication Error %d)\n", argv[1], replicationError);
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,8 +4,12 @@
  * @brief   This file contains the application test module implementation.
  * @details This module is used to test the application module. 
  *          It is not part of the application.
- *          To test application units, uncomment the corresponding line in the
- *          main function. UNCOMMENT ONLY ONE LINE AT A TIME.
+ *          Every test function runs with the lines a user would type fed from
+ *          a script, see testCases[]. The exit code is the number of failed
+ *          test cases. Options:
+ *          * -v: Show the output of the test functions
+ *          * -t: Timing mode, run each test case many times and print its
+ *                cost, e.g. to compare two builds
  * 
  * @version 1.0.0
  * @date    2022-07-29
@@ -14,19 +18,71 @@
  * 
  ********************************************************************************/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/wait.h>
 #include "../macros.h"
 #include "../Card/card.h"
 #include "../Terminal/terminal.h"
 #include "../Server/server.h"
+#include "../Server/settlement.h"
+#include "../Server/analytics.h"
+#include "../Server/routing.h"
+#include "../Server/fraud.h"
+#include "../Server/exchange.h"
+#include "../Server/shard.h"
+#include "../Server/replication.h"
+#include "../Server/hold.h"
+#include "../Server/admission.h"
+#include "../Server/vault.h"
+#include "../Terminal/offline.h"
+#include "../Terminal/config.h"
+#include "../Log/log.h"
+#include "../Log/metrics.h"
+#include "state.h"
+#include "pipeline.h"
 #include "app.h"
 
 
 #define MAX_TIMEOUT   3
 
+/*!< Number of terminals simulated by testManyTerminals() */
+#define SIMULATED_TERMINALS_COUNT   10000
+
+/*!< Accounts spread over the shard processes by testShards() */
+#define SHARDED_ACCOUNTS_COUNT      256
+
+/*!< Transactions replicated to the standby by testReplication() */
+#define REPLICATED_TRANSACTIONS_COUNT   100
+
+/*!< Reloads of the routing table while testGetCardRoute() looks up routes */
+#define ROUTING_RELOADS_COUNT       1000
+
+/*!< Configuration file written by testLoadTerminalConfig() */
+#define TERMINAL_CONFIG_TEST_FILE   "/tmp/appTestConfig.txt"
+
+/*!< Terminals 10, 20 and 30 of testGetTerminalConfig(), out of order, with a maximum amount of 400 + 10 * ID */
+#define TERMINAL_CONFIG_TEST_LINES  "30 700 0 EGP\n10 500 0 EGP\n20 600 50 USD\n"
+
+/*!< Transactions file of testPipelineFile(), and its approved and mistyped lines */
+#define PIPELINE_TEST_FILE          "/tmp/appTestPipeline.csv"
+#define PIPELINE_APPROVED_COUNT     64
+#define PIPELINE_MISTYPED_COUNT     16
+
+/*!< Threads started one after the other by testExitedThreads(), past METRICS_MAX_THREADS */
+#define EXITED_THREADS_COUNT        (3 * METRICS_MAX_THREADS)
+
+/*!< Runs of each test case in timing mode, unless the case says otherwise */
+#define TIMING_RUNS                 1000
+
 
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
@@ -39,13 +95,167 @@ BOOL_t testGetCardExpiryDate(ST_cardData_t * const cardData);
 BOOL_t testGetCardPan(ST_cardData_t * const cardData);
 BOOL_t testGetTransactionDate(ST_terminalData_t * const termData);
 BOOL_t testIsExpiredCard(ST_cardData_t * const cardData, ST_terminalData_t * const termData);
+BOOL_t testIsValidCardPAN(ST_cardData_t * const cardData);
 BOOL_t testGetTransactionAmount(ST_terminalData_t * const termData);
 BOOL_t testSetMaxAmount(ST_terminalData_t * const termData);
 BOOL_t testIsBelowMaxAmount(ST_terminalData_t * const termData);
+BOOL_t testLoadTerminalConfig(const char * const lines);
+BOOL_t testGetTerminalConfig(const uint32_t terminalId);
+BOOL_t testDuplicateTerminals(void);
+BOOL_t testConfiguredMaxAmount(ST_terminalData_t * const termData);
 BOOL_t testIsValidAccount(ST_transaction_t * const transData);
 BOOL_t testIsAmountAvailable(ST_transaction_t * const transData);
+BOOL_t testConvertAmount(ST_transaction_t * const transData);
+BOOL_t testGetCardRoute(ST_transaction_t * const transData);
+BOOL_t testFraudAverage(void);
+BOOL_t testFraudTerminals(void);
+BOOL_t testFraudEviction(void);
+BOOL_t testFraudDecline(void);
 BOOL_t testSaveTransaction(ST_transaction_t * const transData);
 BOOL_t testRecieveTransactionData(ST_transaction_t * const transData);
+BOOL_t testReconcileOfflineBatch(ST_transaction_t * const transData);
+BOOL_t testOfflineTerminals(void);
+BOOL_t testSettleDay(ST_transaction_t * const transData);
+BOOL_t testSumApproved(ST_transaction_t * const transData);
+BOOL_t testJournalCurrency(void);
+BOOL_t testExceededAmountTries(void);
+BOOL_t testManyTerminals(void);
+BOOL_t testPipelineFile(void);
+BOOL_t testShards(void);
+BOOL_t testReplication(const EN_replicationMode_t mode);
+BOOL_t testHolds(void);
+BOOL_t testAdmission(void);
+BOOL_t testVault(void);
+BOOL_t testExitedThreads(void);
+
+static void *lookUpRoutes(void * const cardData);
+static void *countThreadMetric(void * const argument);
+
+/*!< Set by testGetCardRoute() once its reloads are done, stops lookUpRoutes() */
+static BOOL_t isRoutingReloaded = FALSE;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                                TEST CASES                                   */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Struct for a test case, a test function given scripted input
+ *******************************************************************************/
+typedef struct ST_testCase_t {
+    const char *name;                                           /*!< Name printed in the report */
+    BOOL_t (*run)(ST_transaction_t * const transData);          /*!< Adapter calling the test function */
+    const char *input;                                          /*!< Lines the user would type */
+    BOOL_t isPassExpected;                                      /*!< Result expected from the test function */
+    uint32_t timingRuns;                                        /*!< Runs in timing mode, 0 for TIMING_RUNS */
+} ST_testCase_t;
+
+/* Adapters giving every test function the same signature */
+static BOOL_t runGetCardHolderName(ST_transaction_t * const transData)   { return testGetCardHolderName( &(transData->cardHolderData) ); }
+static BOOL_t runGetCardExpiryDate(ST_transaction_t * const transData)   { return testGetCardExpiryDate( &(transData->cardHolderData) ); }
+static BOOL_t runGetCardPan(ST_transaction_t * const transData)          { return testGetCardPan( &(transData->cardHolderData) ); }
+static BOOL_t runGetTransactionDate(ST_transaction_t * const transData)  { return testGetTransactionDate( &(transData->terminalData) ); }
+static BOOL_t runIsExpiredCard(ST_transaction_t * const transData)       { return testIsExpiredCard( &(transData->cardHolderData), &(transData->terminalData) ); }
+static BOOL_t runIsValidCardPAN(ST_transaction_t * const transData)      { return testIsValidCardPAN( &(transData->cardHolderData) ); }
+static BOOL_t runGetTransactionAmount(ST_transaction_t * const transData){ return testGetTransactionAmount( &(transData->terminalData) ); }
+static BOOL_t runSetMaxAmount(ST_transaction_t * const transData)        { return testSetMaxAmount( &(transData->terminalData) ); }
+static BOOL_t runIsBelowMaxAmount(ST_transaction_t * const transData)    { return testIsBelowMaxAmount( &(transData->terminalData) ); }
+static BOOL_t runGetTerminalConfig(ST_transaction_t * const transData)   { (void)transData; return testGetTerminalConfig(20); }
+static BOOL_t runGetTerminalConfigMissing(ST_transaction_t * const transData) { (void)transData; return testGetTerminalConfig(25); }
+static BOOL_t runDuplicateTerminals(ST_transaction_t * const transData)  { (void)transData; return testDuplicateTerminals(); }
+static BOOL_t runConfiguredMaxAmount(ST_transaction_t * const transData) { return testConfiguredMaxAmount( &(transData->terminalData) ); }
+static BOOL_t runFraudAverage(ST_transaction_t * const transData)        { (void)transData; return testFraudAverage(); }
+static BOOL_t runFraudTerminals(ST_transaction_t * const transData)      { (void)transData; return testFraudTerminals(); }
+static BOOL_t runFraudEviction(ST_transaction_t * const transData)       { (void)transData; return testFraudEviction(); }
+static BOOL_t runFraudDecline(ST_transaction_t * const transData)        { (void)transData; return testFraudDecline(); }
+static BOOL_t runOfflineTerminals(ST_transaction_t * const transData)    { (void)transData; return testOfflineTerminals(); }
+static BOOL_t runJournalCurrency(ST_transaction_t * const transData)     { (void)transData; return testJournalCurrency(); }
+static BOOL_t runExceededAmountTries(ST_transaction_t * const transData) { (void)transData; return testExceededAmountTries(); }
+static BOOL_t runManyTerminals(ST_transaction_t * const transData)       { (void)transData; return testManyTerminals(); }
+static BOOL_t runPipeline(ST_transaction_t * const transData)            { (void)transData; return testPipelineFile(); }
+static BOOL_t runShards(ST_transaction_t * const transData)              { (void)transData; return testShards(); }
+static BOOL_t runReplicationSync(ST_transaction_t * const transData)     { (void)transData; return testReplication(REPLICATION_SYNC); }
+static BOOL_t runReplicationAsync(ST_transaction_t * const transData)    { (void)transData; return testReplication(REPLICATION_ASYNC); }
+static BOOL_t runHolds(ST_transaction_t * const transData)               { (void)transData; return testHolds(); }
+static BOOL_t runAdmission(ST_transaction_t * const transData)           { (void)transData; return testAdmission(); }
+static BOOL_t runVault(ST_transaction_t * const transData)               { (void)transData; return testVault(); }
+static BOOL_t runExitedThreads(ST_transaction_t * const transData)       { (void)transData; return testExitedThreads(); }
+
+/********************************************************************************
+ * @brief   Every test case, run in this order. Server cases use the account
+ *          9876543219876543210 which has the largest balance.
+ *******************************************************************************/
+static const ST_testCase_t testCases[] = {
+    {"getCardHolderName",           runGetCardHolderName,       "Mahmoud Karam Emara Ali\n",                 TRUE,   0 },
+    {"getCardHolderName short",     runGetCardHolderName,       "Mahmoud\n",                                 FALSE,  0 },
+    {"getCardExpiryDate",           runGetCardExpiryDate,       "12/30\n",                                   TRUE,   0 },
+    {"getCardExpiryDate month",     runGetCardExpiryDate,       "13/30\n",                                   FALSE,  0 },
+    {"getCardPAN",                  runGetCardPan,              "9876543219876543210\n",                     TRUE,   0 },
+    {"getCardPAN short",            runGetCardPan,              "98765432\n",                                FALSE,  0 },
+    {"getTransactionDate",          runGetTransactionDate,      "19/10/2026\n",                              TRUE,   0 },
+    {"getTransactionDate format",   runGetTransactionDate,      "2026-10-19\n",                              FALSE,  0 },
+    {"isCardExpired",               runIsExpiredCard,           "12/30\n19/10/2026\n",                       TRUE,   0 },
+    {"isCardExpired expired",       runIsExpiredCard,           "01/20\n19/10/2026\n",                       FALSE,  0 },
+    {"isValidCardPAN",              runIsValidCardPAN,          "9876543219876543210\n",                     TRUE,   0 },
+    {"isValidCardPAN Luhn",         runIsValidCardPAN,          "9876543219876543211\n",                     FALSE,  0 },
+    {"getTransactionAmount",        runGetTransactionAmount,    "100\n",                                     TRUE,   0 },
+    {"getTransactionAmount zero",   runGetTransactionAmount,    "0\n",                                       FALSE,  0 },
+    {"setMaxAmount",                runSetMaxAmount,            "1000\n",                                    TRUE,   0 },
+    {"setMaxAmount negative",       runSetMaxAmount,            "-5\n",                                      FALSE,  0 },
+    {"isBelowMaxAmount",            runIsBelowMaxAmount,        "100\n1000\n",                               TRUE,   0 },
+    {"isBelowMaxAmount exceeds",    runIsBelowMaxAmount,        "5000\n1000\n",                              FALSE,  0 },
+    {"getTerminalConfig",           runGetTerminalConfig,       "",                                          TRUE,   0 },
+    {"getTerminalConfig unknown",   runGetTerminalConfigMissing, "",                                         FALSE,  0 },
+    {"loadTerminalConfig duplicate", runDuplicateTerminals,     "",                                          TRUE,   0 },
+    {"isBelowMaxAmount configured", runConfiguredMaxAmount,     "500\n1000\n",                              FALSE,  0 },
+    {"isBelowMaxAmount configured higher", runConfiguredMaxAmount, "50\n10\n",                              TRUE,   0 },
+    {"isValidAccount",              testIsValidAccount,         "9876543219876543210\n",                     TRUE,   0 },
+    {"isValidAccount unknown",      testIsValidAccount,         "1111222233334444555\n",                     FALSE,  0 },
+    {"isAmountAvailable",           testIsAmountAvailable,      "9876543219876543210\n1\n1000\n",            TRUE,   0 },
+    {"isAmountAvailable low",       testIsAmountAvailable,      "1122334455667788990\n5000\n10000\n",        FALSE,  0 },
+    {"isAmountAvailable USD",       testConvertAmount,          "9876543219876543210\n100\n1000\n",           TRUE,   0 },
+    {"isAmountAvailable USD low",   testConvertAmount,          "9876543219876543210\n2000\n5000\n",          FALSE,  0 },
+    {"getCardRoute",                testGetCardRoute,           "9876543219876543210\n",                     TRUE,   0 },
+    {"getCardRoute unknown BIN",    testGetCardRoute,           "1111222233334444555\n",                     FALSE,  0 },
+    {"scoreTransaction average",    runFraudAverage,            "",                                          TRUE,   0 },
+    {"scoreTransaction terminals",  runFraudTerminals,          "",                                          TRUE,   0 },
+    {"scoreTransaction eviction",   runFraudEviction,           "",                                          TRUE,  10 },
+    {"scoreTransaction decline",    runFraudDecline,            "",                                          TRUE,   0 },
+    {"saveTransaction",             testSaveTransaction,        "Mahmoud Karam Emara Ali\n12/30\n19/10/2026\n"
+                                                                "9876543219876543210\n1\n1000\n",            TRUE,   0 },
+    {"recieveTransactionData",      testRecieveTransactionData, "Mahmoud Karam Emara Ali\n9876543219876543210\n"
+                                                                "12/30\n19/10/2026\n1\n1000\n",             TRUE,   0 },
+    {"reconcileOfflineBatch",       testReconcileOfflineBatch,  "9876543219876543210\n1\n",                  TRUE,   0 },
+    {"reconcileOfflineBatch terminals", runOfflineTerminals,     "",                                          TRUE,   0 },
+    {"settleDay",                   testSettleDay,              "9876543219876543210\n19/10/2026\n1\n",      TRUE,  10 },
+    {"sumApproved",                 testSumApproved,            "9876543219876543210\n19/10/2026\n1\n",      TRUE,   0 },
+    {"journalTransaction currency", runJournalCurrency,         "",                                          TRUE,  10 },
+    {"exceeded amount tries",       runExceededAmountTries,     "",                                          TRUE,   0 },
+    {"manyTerminals",               runManyTerminals,           "",                                          TRUE,   1 },
+    {"runPipelineFile",             runPipeline,                "",                                          TRUE,  10 },
+    {"shards",                      runShards,                  "",                                          TRUE,   1 },
+    {"replication sync",            runReplicationSync,         "",                                          TRUE,   1 },
+    {"replication async",           runReplicationAsync,        "",                                          TRUE,   1 },
+    {"holds",                       runHolds,                   "",                                          TRUE,  10 },
+    {"admission",                   runAdmission,               "",                                          TRUE,  10 },
+    {"vault",                       runVault,                   "",                                          TRUE,  10 },
+    {"exited threads",              runExitedThreads,           "",                                          TRUE,  10 },
+};
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                           RUNNER FUNCTION PROTOTYPES                        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static BOOL_t runTestCase(const ST_testCase_t * const testCase, const uint32_t runs, double * const seconds);
+static int silenceStdout(void);
+static void restoreStdout(const int savedStdout);
+static double testNowSeconds(void);
+
 
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
@@ -53,30 +263,138 @@ BOOL_t testRecieveTransactionData(ST_transaction_t * const transData);
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
-int main(void) {
-    ST_transaction_t transData = {0};
-    uint8_t tryAgain = 0;
+int main(int argc, char *argv[]) {
+    const uint32_t casesCount = sizeof(testCases) / sizeof(testCases[0]);
+    BOOL_t isVerbose = FALSE, isTiming = FALSE, isPassed = FALSE;
+    uint32_t i = 0, runs = 1, failedCount = 0;
+    double seconds = 0;
+    int savedStdout = -1;
 
-    do {
-        // printf("Test: %s\n", testGetCardHolderName( &(transData.cardHolderData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testGetCardExpiryDate( &(transData.cardHolderData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testGetCardPan( &(transData.cardHolderData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testGetTransactionDate( &(transData.terminalData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testIsExpiredCard( &(transData.cardHolderData), &(transData.terminalData) )? "Passed" : "Failed");
-        // printf("Test: %s\n", testGetTransactionAmount( &(transData.terminalData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testSetMaxAmount( &(transData.terminalData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testIsBelowMaxAmount( &(transData.terminalData) ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testRecieveTransactionData( &transData ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testIsValidAccount( &transData ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testIsAmountAvailable( &transData ) ? "Passed" : "Failed");
-        // printf("Test: %s\n", testSaveTransaction( &transData ) ? "Passed" : "Failed");
+    for(i = 1; i < (uint32_t)argc; ++i) {
+        isVerbose |= (0 == strcmp(argv[i], "-v"));
+        isTiming  |= (0 == strcmp(argv[i], "-t"));
+    }
+
+    for(i = 0; i < casesCount; ++i) {
+        runs = isTiming ? ((0 != testCases[i].timingRuns) ? testCases[i].timingRuns : TIMING_RUNS) : 1;
+
+        /* The test functions print a lot, only the report is shown */
+        savedStdout = isVerbose ? -1 : silenceStdout();
+        isPassed = runTestCase(&testCases[i], runs, &seconds);
+        restoreStdout(savedStdout);
+
+        failedCount += !isPassed;
+
+        if(isTiming) {
+            printf("%s  %-28s %12.0f ns/run (%u runs)\n", isPassed ? "PASS" : "FAIL", testCases[i].name,
+                   seconds * 1e9 / runs, runs);
+        } else {
+            printf("%s  %s\n", isPassed ? "PASS" : "FAIL", testCases[i].name);
+        }
+    }
+
+    printf("%u of %u test cases passed\n", casesCount - failedCount, casesCount);
+
+    return (int)failedCount;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                           RUNNER FUNCTION DEFINITIONS                       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Run a test case with its script as the card and terminal input
+ * 
+ * @param   testCase: Test case to run
+ * @param   runs: Number of runs, each one reads the whole script again
+ * @param   seconds: Time taken by all the runs
+ * @return  TRUE if every run gave the expected result
+ *******************************************************************************/
+static BOOL_t runTestCase(const ST_testCase_t * const testCase, const uint32_t runs, double * const seconds) {
+    ST_transaction_t transData;
+    const ST_transaction_t emptyTransData = {0};
+    FILE *input = NULL;
+    BOOL_t isPassed = TRUE;
+    uint32_t run = 0;
+    double start = 0;
+
+    *seconds = 0;
+
+    input = tmpfile();
+    if(NULL == input) {
+        return FALSE;
+    }
 
-        printf("Try again? (y/n): ");
-        scanf(" %c%*c", &tryAgain);
-        tryAgain = toupper(tryAgain);
-    } while('Y' == tryAgain);
+    fputs(testCase->input, input);
+    setCardInputStream(input);
+    setTerminalInputStream(input);
 
-    return 0;
+    for(run = 0; (run < runs) && isPassed; ++run) {
+        rewind(input);
+        transData = emptyTransData;
+
+        start = testNowSeconds();
+        isPassed = (testCase->isPassExpected == testCase->run(&transData));
+        *seconds += testNowSeconds() - start;
+    }
+
+    setCardInputStream(NULL);
+    setTerminalInputStream(NULL);
+    fclose(input);
+
+    return isPassed;
+}
+
+/********************************************************************************
+ * @brief   Send stdout to the null device
+ * 
+ * @return  The descriptor to give to restoreStdout(), -1 on failure
+ *******************************************************************************/
+static int silenceStdout(void) {
+    int savedStdout = -1, nullDevice = -1;
+
+    fflush(stdout);
+
+    nullDevice = open("/dev/null", O_WRONLY);
+    if(-1 == nullDevice) {
+        return -1;
+    }
+
+    savedStdout = dup(STDOUT_FILENO);
+    if(-1 != savedStdout) {
+        dup2(nullDevice, STDOUT_FILENO);
+    }
+    close(nullDevice);
+
+    return savedStdout;
+}
+
+/********************************************************************************
+ * @brief   Undo silenceStdout()
+ *******************************************************************************/
+static void restoreStdout(const int savedStdout) {
+
+    if(-1 == savedStdout) {
+        return;
+    }
+
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+}
+
+/********************************************************************************
+ * @brief   Get a monotonic timestamp in seconds
+ *******************************************************************************/
+static double testNowSeconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
 }
 
 
@@ -159,7 +477,7 @@ BOOL_t testIsExpiredCard(ST_cardData_t * const cardData, ST_terminalData_t * con
     BOOL_t result = FALSE;
 
     if(testGetCardExpiryDate(cardData) && testGetTransactionDate(termData)) {
-        termError = isCardExpired(*cardData, *termData);
+        termError = isCardExpired(cardData, termData);
         if(TERMINAL_OK == termError) {
             printf("Card is not expired\n");
             result = TRUE;
@@ -174,6 +492,26 @@ BOOL_t testIsExpiredCard(ST_cardData_t * const cardData, ST_terminalData_t * con
     return result;
 }
 
+BOOL_t testIsValidCardPAN(ST_cardData_t * const cardData) {
+    EN_terminalError_t termError;
+    BOOL_t result = FALSE;
+
+    if(testGetCardPan(cardData)) {
+        termError = isValidCardPAN(cardData);
+        if(TERMINAL_OK == termError) {
+            printf("Card number passes the Luhn check\n");
+            result = TRUE;
+        } else {
+            printf("Card number fails the Luhn check. (Terminal Error: %d)\n", termError);
+            result = FALSE;
+        }
+    } else {
+        return FALSE;
+    }
+
+    return result;
+}
+
 BOOL_t testGetTransactionAmount(ST_terminalData_t * const termData) {
     EN_terminalError_t termError;
     BOOL_t result = FALSE;
@@ -229,6 +567,88 @@ BOOL_t testIsBelowMaxAmount(ST_terminalData_t * const termData) {
     return result;
 }
 
+BOOL_t testLoadTerminalConfig(const char * const lines) {
+    FILE *file = NULL;
+    EN_terminalError_t termError;
+
+    file = fopen(TERMINAL_CONFIG_TEST_FILE, "w");
+    if(NULL == file) {
+        return FALSE;
+    }
+    fputs(lines, file);
+    fclose(file);
+
+    termError = loadTerminalConfig(TERMINAL_CONFIG_TEST_FILE);
+    remove(TERMINAL_CONFIG_TEST_FILE);
+
+    if(TERMINAL_OK != termError) {
+        printf("Configuration rejected. (Terminal Error %d)\n", termError);
+        return FALSE;
+    }
+
+    printf("Configuration loaded.\n");
+
+    return TRUE;
+}
+
+BOOL_t testGetTerminalConfig(const uint32_t terminalId) {
+    ST_terminalConfig_t config;
+    EN_terminalError_t termError = CONFIG_ERROR;
+    BOOL_t result = FALSE;
+
+    if(testLoadTerminalConfig(TERMINAL_CONFIG_TEST_LINES)) {
+        termError = getTerminalConfig(terminalId, &config);
+        unloadTerminalConfig();
+    }
+
+    if(TERMINAL_OK == termError) {
+        printf("Terminal %u: maximum amount %.0f, floor limit %.0f\n", config.terminalId,
+               config.maxTransAmount, config.floorLimit);
+        result = (BOOL_t)( (terminalId == config.terminalId) && (400.0f + 10 * terminalId == config.maxTransAmount) );
+    } else {
+        printf("Terminal %u not configured. (Terminal Error %d)\n", terminalId, termError);
+        result = FALSE;
+    }
+
+    return result;
+}
+
+BOOL_t testDuplicateTerminals(void) {
+    ST_terminalConfig_t config;
+    BOOL_t isRejected = FALSE, isPreviousKept = FALSE;
+
+    if( !testLoadTerminalConfig(TERMINAL_CONFIG_TEST_LINES) ) {
+        return FALSE;
+    }
+
+    /* Terminal 10 twice: the whole file is rejected and the loaded registry stays */
+    isRejected = !testLoadTerminalConfig("10 500 0 EGP\n20 600 0 EGP\n10 800 0 EGP\n");
+    isPreviousKept = (TERMINAL_OK == getTerminalConfig(30, &config)) && (700.0f == config.maxTransAmount);
+
+    unloadTerminalConfig();
+
+    printf("Duplicate terminal %s, previous configuration %s.\n", isRejected ? "rejected" : "accepted",
+           isPreviousKept ? "kept" : "lost");
+
+    return (BOOL_t)( isRejected && isPreviousKept );
+}
+
+BOOL_t testConfiguredMaxAmount(ST_terminalData_t * const termData) {
+    BOOL_t result = FALSE;
+
+    /* Terminal 40 is configured for 100, whatever maximum amount is entered */
+    if( !testLoadTerminalConfig("40 100 0 EGP\n") ) {
+        return FALSE;
+    }
+
+    termData->terminalId = 40;
+    result = testIsBelowMaxAmount(termData);
+
+    unloadTerminalConfig();
+
+    return result;
+}
+
 BOOL_t testIsValidAccount(ST_transaction_t * const transData) {
     EN_serverError_t serverError;
     BOOL_t result = FALSE;
@@ -271,6 +691,254 @@ BOOL_t testIsAmountAvailable(ST_transaction_t * const transData) {
     return result;
 }
 
+BOOL_t testConvertAmount(ST_transaction_t * const transData) {
+    const CURRENCY_t usd = CURRENCY_PACK('U', 'S', 'D'), egp = CURRENCY_PACK('E', 'G', 'P');
+    const ST_exchangeQuote_t quote = {usd, egp, 4825150000ull};     /* 1 USD = 48.2515 EGP */
+    EN_exchangeError_t exchangeError, inverseError;
+    int64_t convertedCents = 0, inverseCents = 0;
+    BOOL_t result = FALSE;
+
+    /* 123.45 USD are 5956.647675 EGP, rounded half up to the cent */
+    exchangeError = loadExchangeRates(&quote, 1);
+    if(EXCHANGE_OK == exchangeError) {
+        exchangeError = convertAmount(12345, usd, egp, &convertedCents);
+    }
+    inverseError = convertAmount(12345, egp, usd, &inverseCents);
+
+    if( (EXCHANGE_OK == exchangeError) && (595665 == convertedCents) && (EXCHANGE_NO_RATE == inverseError) ) {
+        /* The account is in EGP, the terminal in USD */
+        transData->terminalData.currency = usd;
+        result = testIsAmountAvailable(transData);
+    } else {
+        printf("Conversion failed. (Exchange Error %d, %lld cents, inverse Error %d)\n",
+               exchangeError, (long long)convertedCents, inverseError);
+        result = FALSE;
+    }
+
+    unloadExchangeRates();
+
+    return result;
+}
+
+BOOL_t testGetCardRoute(ST_transaction_t * const transData) {
+    /* The BIN 98765432 alone goes to route 7 or 8, the rest of 9876 to route 3 */
+    const ST_binRange_t ranges[2][2] = {
+        { {98765432, 98765432, 7}, {98760000, 98765431, 3} },
+        { {98765432, 98765432, 8}, {98760000, 98765431, 3} },
+    };
+    pthread_t thread;
+    void *wrongCount = NULL;
+    uint32_t i = 0;
+    uint16_t route = ROUTE_NOT_FOUND;
+    BOOL_t isReloadSafe = TRUE, isInvalidRejected = FALSE, isDefaultRouted = FALSE;
+
+    if( !testGetCardPan( &(transData->cardHolderData) ) || (ROUTING_OK != loadBinRanges(ranges[0], 2)) ) {
+        return FALSE;
+    }
+
+    route = getCardRoute( &(transData->cardHolderData) );
+    isInvalidRejected = (ROUTE_NOT_FOUND == getCardRoute(NULL));
+
+    /* Lookups running while the table is reloaded see the old or the new route, never a freed table */
+    __atomic_store_n(&isRoutingReloaded, FALSE, __ATOMIC_RELAXED);
+    if(0 != pthread_create(&thread, NULL, lookUpRoutes, &(transData->cardHolderData))) {
+        unloadBinRanges();
+        return FALSE;
+    }
+    for(i = 0; i < ROUTING_RELOADS_COUNT; ++i) {
+        isReloadSafe = (ROUTING_OK == loadBinRanges(ranges[i & 1], 2)) && isReloadSafe;
+    }
+    __atomic_store_n(&isRoutingReloaded, TRUE, __ATOMIC_RELEASE);
+    pthread_join(thread, &wrongCount);
+    isReloadSafe = isReloadSafe && (0 == (uintptr_t)wrongCount);
+
+    /* Without a table every card goes to the local server */
+    unloadBinRanges();
+    isDefaultRouted = (ROUTE_DEFAULT == getCardRoute( &(transData->cardHolderData) ));
+
+    if(ROUTE_NOT_FOUND != route) {
+        printf("Route: %u\n", route);
+    } else {
+        printf("No route for the BIN.\n");
+    }
+    printf("Invalid card %s, reloads %s, unloaded table %s.\n", isInvalidRejected ? "rejected" : "routed",
+           isReloadSafe ? "safe" : "not safe", isDefaultRouted ? "routed to the default" : "not routed to the default");
+
+    return (BOOL_t)( (7 == route) && isInvalidRejected && isReloadSafe && isDefaultRouted );
+}
+
+/********************************************************************************
+ * @brief       Look up the route of a card until testGetCardRoute() is done
+ *              reloading the routing table
+ *
+ * @param[in]   cardData: The card
+ * @return      void *: Number of routes which are neither of the reloaded
+ *              tables, as a uintptr_t
+ *******************************************************************************/
+static void *lookUpRoutes(void * const cardData) {
+    uintptr_t wrongCount = 0;
+    uint16_t route = ROUTE_NOT_FOUND;
+
+    while( !__atomic_load_n(&isRoutingReloaded, __ATOMIC_ACQUIRE) ) {
+        route = getCardRoute(cardData);
+        wrongCount += (7 != route) && (8 != route) && (ROUTE_NOT_FOUND != route);
+    }
+
+    return (void *)wrongCount;
+}
+
+BOOL_t testFraudAverage(void) {
+    ST_transaction_t transData = {0};
+    ST_cardStats_t stats;
+    uint8_t quickScore = 0, fourTimesScore = 0, tenTimesScore = 0;
+    BOOL_t isAveraged = FALSE;
+
+    resetFraudStats();
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, "4000000000000002");
+    transData.terminalData.terminalId = 1;
+
+    /* 100, 100 then 200 a while apart: the average moves by a fifth of the difference, to 120 */
+    transData.terminalData.transAmount = 100;
+    scoreTransaction(&transData, 0);
+    quickScore = scoreTransaction(&transData, 5);
+    transData.terminalData.transAmount = 200;
+    scoreTransaction(&transData, 1000);
+    isAveraged = getCardStats(transData.cardHolderData.primaryAccountNumber, &stats)     &&
+                 (stats.averageAmount > 119.99f) && (stats.averageAmount < 120.01f)        &&
+                 (3 == stats.transactionCount) && (1000 == stats.lastTime);
+
+    /* 4 times the average of 120 then 10 times the average of 196 */
+    transData.terminalData.transAmount = 500;
+    fourTimesScore = scoreTransaction(&transData, 2000);
+    transData.terminalData.transAmount = 2000;
+    tenTimesScore = scoreTransaction(&transData, 3000);
+
+    resetFraudStats();
+
+    printf("Average %.2f, scores: 5 s after the last %u, 4 times the average %u, 10 times the average %u\n",
+           stats.averageAmount, quickScore, fourTimesScore, tenTimesScore);
+
+    return (BOOL_t)( isAveraged && (30 == quickScore) && (25 == fourTimesScore) && (50 == tenTimesScore) );
+}
+
+BOOL_t testFraudTerminals(void) {
+    ST_transaction_t transData = {0};
+    ST_cardStats_t stats;
+    uint8_t scores[9];
+    uint32_t i = 0;
+
+    resetFraudStats();
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, "4000000000000010");
+    transData.terminalData.transAmount = 100;
+
+    /* The same amount an hour apart at terminals 1 to 8, then at terminal 1 again */
+    for(i = 0; i < 9; ++i) {
+        transData.terminalData.terminalId = (i % 8) + 1;
+        scores[i] = scoreTransaction(&transData, 3600 * i);
+        printf("Terminal %u: score %u\n", transData.terminalData.terminalId, scores[i]);
+    }
+    getCardStats(transData.cardHolderData.primaryAccountNumber, &stats);
+
+    resetFraudStats();
+
+    return (BOOL_t)( (0 == scores[2]) && (10 == scores[3]) && (10 == scores[6]) && (20 == scores[7]) &&
+                     (20 == scores[8]) && (8 == __builtin_popcountll(stats.terminalsSeen)) );
+}
+
+BOOL_t testFraudEviction(void) {
+    ST_transaction_t transData = {0};
+    ST_cardStats_t stats;
+    uint8_t pans[9][20];
+    uint64_t hash = 0;
+    uint32_t i = 0, found = 0, target = 0, candidate = 0, trackedCount = 0;
+
+    /* Cards of the same neighbourhood, found with the FNV-1a hash of fraud.c */
+    for(candidate = 0, found = 0; found < 9; ++candidate) {
+        sprintf((char *)pans[found], "5%018u", candidate);
+        hash = 0xCBF29CE484222325ull;
+        for(i = 0; '\0' != pans[found][i]; ++i) {
+            hash = (hash ^ pans[found][i]) * 0x100000001B3ull;
+        }
+        if(0 == found) {
+            target = (uint32_t)hash & (FRAUD_TABLE_SIZE - 1);
+        }
+        found += (target == ((uint32_t)hash & (FRAUD_TABLE_SIZE - 1)));
+    }
+
+    resetFraudStats();
+    transData.terminalData.terminalId = 1;
+    transData.terminalData.transAmount = 100;
+
+    /* 8 cards fill the neighbourhood, the 9th takes the place of the least recently seen, the 2nd */
+    for(i = 0; i < 9; ++i) {
+        strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)pans[i]);
+        scoreTransaction(&transData, (1 == i) ? 10 : 100 + i);
+    }
+
+    for(i = 0; i < 9; ++i) {
+        trackedCount += getCardStats(pans[i], &stats);
+    }
+
+    printf("%u of 9 cards tracked, the least recently seen one %s.\n", trackedCount,
+           getCardStats(pans[1], &stats) ? "kept" : "forgotten");
+
+    resetFraudStats();
+
+    return (BOOL_t)( (8 == trackedCount) && !getCardStats(pans[1], &stats) );
+}
+
+BOOL_t testFraudDecline(void) {
+    static uint32_t runCount = 0;
+    ST_accountsDB_t account = {.balance = 1000};
+    ST_transactionContext_t context;
+    ST_transactionRecord_t record;
+    ST_transaction_t transData = {0};
+    ST_cardStats_t stats;
+    const int64_t now = (int64_t)time(NULL);
+    uint8_t belowScore = 0;
+    BOOL_t isSaved = FALSE;
+
+    resetFraudStats();
+
+    /* 10 three times an hour apart, then 10 times the average 30 s after the last one: 50 + 15 */
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, "4000000000000028");
+    transData.terminalData.terminalId = 1;
+    transData.terminalData.transAmount = 10;
+    scoreTransaction(&transData, now - 7200);
+    scoreTransaction(&transData, now - 3600);
+    scoreTransaction(&transData, now - 30);
+    transData.terminalData.transAmount = 100;
+    belowScore = scoreTransaction(&transData, now);
+
+    /* A new account each run with the same history, its 100 comes at once: 50 + 30 */
+    sprintf((char *)account.primaryAccountNumber, "3%018u", runCount++);
+    addAccount(&account);
+    initTransactionContext(&context, 1);
+    context.isVerbose = FALSE;
+    strcpy((char *)context.transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    context.transData.terminalData.transAmount = 10;
+    scoreTransaction(&(context.transData), now - 7200);
+    scoreTransaction(&(context.transData), now - 3600);
+    scoreTransaction(&(context.transData), now);
+    context.transData.terminalData.transAmount = 100;
+
+    /* Declined by the fraud state, saved by the server state, the average stays at 10 */
+    setLogPrinting(FALSE);
+    isSaved = (STATE_DONE == appFraud(&context))                                                       &&
+              (DECLINED_SUSPECTED_FRAUD == context.transData.transState)                               &&
+              (STATE_FAILED == appServer(&context))                                                    &&
+              (SERVER_OK == getTransaction(context.transData.transactionSequenceNumber, &record))      &&
+              (DECLINED_SUSPECTED_FRAUD == record.transState)                                          &&
+              getCardStats(account.primaryAccountNumber, &stats) && (10.0f == stats.averageAmount);
+    setLogPrinting(TRUE);
+
+    resetFraudStats();
+
+    printf("Score below the threshold %u, declined transaction %s.\n", belowScore, isSaved ? "saved" : "not saved");
+
+    return (BOOL_t)( (65 == belowScore) && isSaved );
+}
+
 BOOL_t testSaveTransaction(ST_transaction_t * const transData) {
     EN_serverError_t serverError;
     BOOL_t result = FALSE;
@@ -322,4 +990,766 @@ BOOL_t testRecieveTransactionData(ST_transaction_t * const transData) {
     return result;
 }
 
+BOOL_t testReconcileOfflineBatch(ST_transaction_t * const transData) {
+    EN_serverError_t serverError;
+    uint32_t firstPostedCount = 0, secondPostedCount = 0;
+    static uint32_t offlineSequenceNumber = 0;
+    BOOL_t result = FALSE;
+
+    if( testGetCardPan( &(transData->cardHolderData) ) && testGetTransactionAmount( &(transData->terminalData) ) ) {
+
+        transData->transState = APPROVED;
+        transData->offlineSequenceNumber = ++offlineSequenceNumber;
+
+        /* Uploading the same batch twice must post it once */
+        serverError = reconcileOfflineBatch(transData, 1, &firstPostedCount);
+        if(SERVER_OK == serverError) {
+            serverError = reconcileOfflineBatch(transData, 1, &secondPostedCount);
+        }
 
+        if( (SERVER_OK == serverError) && (1 == firstPostedCount) && (0 == secondPostedCount) ) {
+            printf("Offline transaction posted once.\n");
+            result = TRUE;
+        } else {
+            printf("Offline reconciliation failed. (Server Error %d, posted %u then %u)\n",
+                   serverError, firstPostedCount, secondPostedCount);
+            result = FALSE;
+        }
+    } else {
+        result = FALSE;
+    }
+
+    return result;
+}
+
+BOOL_t testOfflineTerminals(void) {
+    static uint32_t runCount = 0;
+    const char * const queuePath = "/tmp/appTestOffline.dat";
+    const char * const hotCardsPath = "/tmp/appTestHotCards.txt";
+    static ST_transaction_t batches[2][3];
+    ST_transaction_t transData = {0};
+    FILE *file = NULL;
+    uint32_t i = 0, j = 0, postedCount = 0, firstPostedCount = 0, againPostedCount = 0, firstNumber = 0;
+    BOOL_t isRenumbered = FALSE;
+
+    /* Two terminals new to the server each run, both numbering their queue from 1 */
+    for(i = 0; i < 2; ++i) {
+        for(j = 0; j < 3; ++j) {
+            strcpy((char *)batches[i][j].cardHolderData.primaryAccountNumber, "9876543219876543210");
+            batches[i][j].terminalData.terminalId = 900000 + 2 * runCount + i;
+            batches[i][j].terminalData.transAmount = 1;
+            batches[i][j].transState = APPROVED;
+            batches[i][j].offlineSequenceNumber = j + 1;
+        }
+    }
+    ++runCount;
+
+    setLogPrinting(FALSE);
+    for(i = 0; i < 2; ++i) {
+        if(SERVER_OK == reconcileOfflineBatch(batches[i], 3, &postedCount)) {
+            firstPostedCount += postedCount;
+        }
+    }
+    for(i = 0; i < 2; ++i) {
+        if(SERVER_OK == reconcileOfflineBatch(batches[i], 3, &postedCount)) {
+            againPostedCount += postedCount;
+        }
+    }
+
+    /* A queue file created again numbers past every transaction already posted */
+    remove(queuePath);
+    file = fopen(hotCardsPath, "w");
+    if(NULL != file) {
+        fclose(file);
+    }
+    setFloorLimit(10);
+    transData = batches[0][0];
+    if( (TERMINAL_OK == loadHotCardList(hotCardsPath)) && (TERMINAL_OK == openOfflineQueue(queuePath)) &&
+        (TERMINAL_OK == approveOffline(&transData)) && (TERMINAL_OK == uploadOfflineQueue()) ) {
+        firstNumber = transData.offlineSequenceNumber;
+        closeOfflineQueue();
+        remove(queuePath);
+        isRenumbered = (firstNumber > 3) && (TERMINAL_OK == openOfflineQueue(queuePath)) &&
+                       (TERMINAL_OK == approveOffline(&transData))                        &&
+                       (transData.offlineSequenceNumber > firstNumber)                    &&
+                       (TERMINAL_OK == uploadOfflineQueue())                              &&
+                       (transData.offlineSequenceNumber == getLastOfflineSequenceNumber());
+    }
+    closeOfflineQueue();
+    setFloorLimit(0);
+    loadHotCardList(NULL);
+    remove(queuePath);
+    remove(hotCardsPath);
+    setLogPrinting(TRUE);
+
+    printf("Overlapping offline batches of 2 terminals: %u of 6 posted, %u posted again, queue %s.\n",
+           firstPostedCount, againPostedCount, isRenumbered ? "renumbered" : "not renumbered");
+
+    return (BOOL_t)( (6 == firstPostedCount) && (0 == againPostedCount) && isRenumbered );
+}
+
+BOOL_t testSettleDay(ST_transaction_t * const transData) {
+    static ST_settlement_t before, after;
+    EN_settlementError_t settlementError = SETTLEMENT_OK;
+    EN_transState_t transError = APPROVED;
+    const uint8_t *pan = NULL;
+    uint16_t accountIndex = 0;
+    BOOL_t result = FALSE;
+
+    if( testGetCardPan( &(transData->cardHolderData) )        &&
+        testGetTransactionDate( &(transData->terminalData) )  &&
+        testGetTransactionAmount( &(transData->terminalData) ) ) {
+
+        /* The day is settled before and after one more approval */
+        settlementError = settleDay(transData->terminalData.transactionDay, 2, &before);
+        transError = recieveTransactionData(transData);
+        if(SETTLEMENT_OK == settlementError) {
+            settlementError = settleDay(transData->terminalData.transactionDay, 2, &after);
+        }
+
+        for(accountIndex = 0; accountIndex < after.accountCount; ++accountIndex) {
+            pan = getAccountPan(accountIndex);
+            if( (NULL != pan) && (0 == strcmp((const char *)pan, (const char *)transData->cardHolderData.primaryAccountNumber)) ) {
+                break;
+            }
+        }
+
+        if( (SETTLEMENT_OK == settlementError) && (APPROVED == transError) && (accountIndex < after.accountCount) &&
+            (after.transactionCount == before.transactionCount + 1) &&
+            (after.accounts[accountIndex].approvedCount == before.accounts[accountIndex].approvedCount + 1) &&
+            (after.accounts[accountIndex].approvedCents == before.accounts[accountIndex].approvedCents +
+                                                           (int64_t)(transData->terminalData.transAmount * 100)) ) {
+            printf("Settled %llu transactions on %u terminals.\n",
+                   (unsigned long long)after.transactionCount, after.terminalCount);
+            result = TRUE;
+        } else {
+            printf("Settlement failed. (Settlement Error %d, Transaction Error %d)\n", settlementError, transError);
+            result = FALSE;
+        }
+
+        freeSettlement(&before);
+        freeSettlement(&after);
+    } else {
+        result = FALSE;
+    }
+
+    return result;
+}
+
+BOOL_t testSumApproved(ST_transaction_t * const transData) {
+    ST_analyticsSum_t before = {0}, after = {0};
+    EN_analyticsError_t analyticsError = ANALYTICS_OK;
+    EN_transState_t transError = APPROVED;
+    DATE_t day = DATE_INVALID;
+    BOOL_t result = FALSE;
+
+    if( testGetCardPan( &(transData->cardHolderData) )        &&
+        testGetTransactionDate( &(transData->terminalData) )  &&
+        testGetTransactionAmount( &(transData->terminalData) ) ) {
+
+        /* The day is queried before and after one more approval */
+        day = transData->terminalData.transactionDay;
+        analyticsError = refreshAnalytics();
+        if(ANALYTICS_OK == analyticsError) {
+            analyticsError = sumApproved(day, day, &before);
+        }
+        transError = recieveTransactionData(transData);
+        if(ANALYTICS_OK == analyticsError) {
+            analyticsError = refreshAnalytics();
+        }
+        if(ANALYTICS_OK == analyticsError) {
+            analyticsError = sumApproved(day, day, &after);
+        }
+
+        if( (ANALYTICS_OK == analyticsError) && (APPROVED == transError) &&
+            (after.count == before.count + 1) &&
+            (after.cents == before.cents + (int64_t)(transData->terminalData.transAmount * 100)) ) {
+            printf("%llu approved transactions on the day.\n", (unsigned long long)after.count);
+            result = TRUE;
+        } else {
+            printf("Analytics failed. (Analytics Error %d, Transaction Error %d)\n", analyticsError, transError);
+            result = FALSE;
+        }
+    } else {
+        result = FALSE;
+    }
+
+    return result;
+}
+
+BOOL_t testJournalCurrency(void) {
+    const CURRENCY_t usd = CURRENCY_PACK('U', 'S', 'D'), egp = CURRENCY_PACK('E', 'G', 'P');
+    const ST_exchangeQuote_t quote = {usd, egp, 4825150000ull};     /* 1 USD = 48.2515 EGP */
+    static uint32_t runCount = 0;
+    ST_accountsDB_t account = {.balance = 100, .currency = egp};
+    ST_transaction_t transData = {0};
+    ST_settlementRecord_t approved = {0}, declined = {0};
+    EN_transState_t approvedState = INTERNAL_SERVER_ERROR, declinedState = INTERNAL_SERVER_ERROR;
+
+    /* A new EGP account each run, paying at a USD terminal */
+    sprintf((char *)account.primaryAccountNumber, "2%018u", runCount++);
+    if( (SERVER_OK != addAccount(&account)) || (EXCHANGE_OK != loadExchangeRates(&quote, 1)) ) {
+        return FALSE;
+    }
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    transData.terminalData.currency = usd;
+
+    /* 1 USD is debited as 48.25 EGP, 10 USD are more than the balance and declined as 482.52 EGP */
+    setLogPrinting(FALSE);
+    transData.terminalData.transAmount = 1;
+    approvedState = recieveTransactionData(&transData);
+    readJournal(getJournalCount() - 1, 1, &approved);
+    transData.terminalData.transAmount = 10;
+    declinedState = recieveTransactionData(&transData);
+    readJournal(getJournalCount() - 1, 1, &declined);
+    setLogPrinting(TRUE);
+
+    unloadExchangeRates();
+
+    printf("Journaled %d and %d EGP cents.\n", (int)approved.amountCents, (int)declined.amountCents);
+
+    return (BOOL_t)( (APPROVED == approvedState) && (4825 == approved.amountCents) &&
+                     (DECLINED_INSUFFICIENT_FUND == declinedState) && (48252 == declined.amountCents) );
+}
+
+BOOL_t testExceededAmountTries(void) {
+    ST_transactionContext_t context;
+    /* More amounts above the maximum than MAX_TIMEOUT, each one answered by a new amount */
+    const char * const script[] = { "Mahmoud Karam Emara Ali", "12/30", "9876543219876543210", "19/10/2026",
+                                     "1000", "5000", "y", "5000", "y", "5000", "y", "5000", "y", "1" };
+    uint32_t i = 0;
+
+    setLogPrinting(FALSE);
+
+    initTransactionContext(&context, 1);
+    context.isVerbose = FALSE;
+    resumeTransaction(&context, NULL);
+    for(i = 0; (i < sizeof(script) / sizeof(script[0])) && (CONTEXT_NEEDS_INPUT == context.status); ++i) {
+        resumeTransaction(&context, (const uint8_t *)script[i]);
+    }
+
+    setLogPrinting(TRUE);
+
+    printf("Transaction %s after %u lines. (Transaction State %d)\n",
+           (CONTEXT_DONE == context.status) ? "done" : "failed", i, context.transData.transState);
+
+    return (BOOL_t)( (CONTEXT_DONE == context.status) && (APPROVED == context.transData.transState) );
+}
+
+BOOL_t testManyTerminals(void) {
+    static ST_transactionContext_t contexts[SIMULATED_TERMINALS_COUNT];
+    static uint8_t nextLine[SIMULATED_TERMINALS_COUNT];
+    /* Odd terminals mistype their PAN and their amount once */
+    const char * const scripts[2][10] = {
+        { "Mahmoud Karam Emara Ali", "12/30", "9876543219876543210",
+          "19/10/2026", "1000", "1" },
+        { "Mahmoud Karam Emara Ali", "12/30", "98765432", "y", "9876543219876543210",
+          "19/10/2026", "1000", "5000", "y", "1" },
+    };
+    uint32_t i = 0, waitingCount = 0, doneCount = 0, round = 0;
+    const char *line = NULL;
+
+    setLogPrinting(FALSE);
+
+    for(i = 0; i < SIMULATED_TERMINALS_COUNT; ++i) {
+        initTransactionContext(&contexts[i], i + 1);
+        contexts[i].isVerbose = FALSE;
+        nextLine[i] = 0;
+        resumeTransaction(&contexts[i], NULL);
+    }
+
+    /* One thread, every terminal gets one line per round */
+    do {
+        waitingCount = 0;
+        for(i = 0; i < SIMULATED_TERMINALS_COUNT; ++i) {
+            if(CONTEXT_NEEDS_INPUT != contexts[i].status) {
+                continue;
+            }
+
+            line = scripts[i % 2][nextLine[i]++];
+            if(CONTEXT_NEEDS_INPUT == resumeTransaction(&contexts[i], (const uint8_t *)line)) {
+                ++waitingCount;
+            }
+        }
+        ++round;
+    } while( (waitingCount > 0) && (round < 10) );
+
+    for(i = 0; i < SIMULATED_TERMINALS_COUNT; ++i) {
+        if( (CONTEXT_DONE == contexts[i].status) && (APPROVED == contexts[i].transData.transState) ) {
+            ++doneCount;
+        }
+    }
+
+    setLogPrinting(TRUE);
+
+    printf("%u of %u terminals approved in %u rounds.\n", doneCount, SIMULATED_TERMINALS_COUNT, round);
+
+    return (SIMULATED_TERMINALS_COUNT == doneCount);
+}
+
+BOOL_t testPipelineFile(void) {
+    const char * const approvedLine = "Mahmoud Karam Emara Ali,12/30,9876543219876543210,19/10/2026,1000,1\n";
+    const uint8_t threadCounts[PIPELINE_MAX_STAGES] = {2, 2, 2, 2};
+    const uint8_t invalidThreadCounts[PIPELINE_MAX_STAGES] = {2, 0, 2, 2};
+    ST_pipelineStats_t cardStats, serverStats;
+    EN_pipelineError_t pipelineError;
+    FILE *file = NULL;
+    uint32_t i = 0;
+    BOOL_t isCounted = FALSE, isRejected = FALSE;
+
+    /* Approved lines, mistyped names, and a line whose tail past 127 characters reads as an approved one */
+    file = fopen(PIPELINE_TEST_FILE, "w");
+    if(NULL == file) {
+        return FALSE;
+    }
+    for(i = 0; i < PIPELINE_APPROVED_COUNT; ++i) {
+        fputs(approvedLine, file);
+        if(0 == i % (PIPELINE_APPROVED_COUNT / PIPELINE_MISTYPED_COUNT)) {
+            fputs("Mahmoud,12/30,9876543219876543210,19/10/2026,1000,1\n\n", file);
+        }
+    }
+    fprintf(file, "%0127d%s", 0, approvedLine);
+    fclose(file);
+
+    setLogPrinting(FALSE);
+    pipelineError = runPipelineFile(PIPELINE_TEST_FILE, threadCounts, 1);
+    getPipelineStats(0, &cardStats);
+    getPipelineStats(countStates - 1, &serverStats);
+
+    isRejected = (PIPELINE_INVALID_THREADS == runPipelineFile(PIPELINE_TEST_FILE, invalidThreadCounts, 1)) &&
+                 (PIPELINE_FILE_ERROR == runPipelineFile("/tmp/appTestNoSuchFile.csv", threadCounts, 1));
+    setLogPrinting(TRUE);
+    remove(PIPELINE_TEST_FILE);
+
+    /* The empty lines are skipped, the mistyped and overlong ones fail in the card state */
+    isCounted = (PIPELINE_OK == pipelineError)                                                  &&
+                (PIPELINE_APPROVED_COUNT + PIPELINE_MISTYPED_COUNT + 1 == cardStats.processedCount) &&
+                (PIPELINE_MISTYPED_COUNT + 1 == cardStats.failedCount)                           &&
+                (PIPELINE_APPROVED_COUNT == serverStats.processedCount) && (0 == serverStats.failedCount);
+
+    printf("Card state: %llu processed, %llu failed. Server state: %llu processed, %llu failed. (Pipeline Error %d)\n",
+           (unsigned long long)cardStats.processedCount, (unsigned long long)cardStats.failedCount,
+           (unsigned long long)serverStats.processedCount, (unsigned long long)serverStats.failedCount,
+           pipelineError);
+    printf("Invalid runs %s.\n", isRejected ? "rejected" : "accepted");
+
+    return (BOOL_t)( isCounted && isRejected );
+}
+
+BOOL_t testShards(void) {
+    const char * const socketPaths[3] = {"/tmp/appTestShard0", "/tmp/appTestShard1", "/tmp/appTestShard2"};
+    const struct timespec retryDelay = {0, 10000000};
+    static uint32_t debitedCounts[SHARDED_ACCOUNTS_COUNT];
+    static ST_shardRing_t ring;
+    ST_accountsDB_t account = {.balance = 1000};
+    ST_transaction_t transData = {0};
+    EN_shardError_t shardError = SHARD_SOCKET_ERROR;
+    uint32_t i = 0, round = 0, approvedCount = 0, migratingCount = 0, movedCount = 0, fullCount = 0;
+    pid_t shardIds[3];
+    uint8_t shardCount = 0;
+
+    /* Added once in timing mode, the shards fork a copy of them */
+    for(i = 0; i < SHARDED_ACCOUNTS_COUNT; ++i) {
+        sprintf((char *)account.primaryAccountNumber, "4%018u", i);
+        addAccount(&account);
+        debitedCounts[i] = 0;
+    }
+
+    /* Shards 0 and 1 keep their accounts. Shard 2 keeps copies of the accounts it is to own, as
+       if a migration had imported them without removing them: the balances moved replace them. */
+    fflush(stdout);
+    for(i = 0; i < 3; ++i) {
+        shardIds[i] = fork();
+        if(0 == shardIds[i]) {
+            setLogPrinting(FALSE);
+            _exit(runShard(socketPaths[i], (uint8_t)i, (2 == i) ? 3 : 2));
+        }
+    }
+
+    for(round = 0; (SHARD_OK != shardError) && (round < 100); ++round) {
+        nanosleep(&retryDelay, NULL);
+        shardError = connectShards(socketPaths, 2);
+    }
+    for(round = 0; (SHARD_OK == shardError) && (round < 100); ++round) {
+        if(SHARD_MIGRATING == addShard(socketPaths[2])) {
+            break;
+        }
+        nanosleep(&retryDelay, NULL);
+    }
+
+    parseTransactionDate(&(transData.terminalData), (const uint8_t *)"19/10/2026");
+    transData.terminalData.transAmount = 1;
+
+    /* The transactions go on while the accounts move a batch at a time, more of them in timing mode */
+    for(round = 0; (SHARD_OK == shardError) && (2 == getShardCount()) && (round < 8u * getAccountsCount()); ++round) {
+        i = (round * 7) % SHARDED_ACCOUNTS_COUNT;
+        sprintf((char *)transData.cardHolderData.primaryAccountNumber, "4%018u", i);
+        if(APPROVED == routeTransaction(&transData)) {
+            ++debitedCounts[i];
+            ++approvedCount;
+        }
+    }
+    migratingCount = round;
+    shardCount = getShardCount();
+
+    /* Every balance moved whole: its remainder is approved, then nothing more */
+    for(i = 0; i < SHARDED_ACCOUNTS_COUNT; ++i) {
+        sprintf((char *)transData.cardHolderData.primaryAccountNumber, "4%018u", i);
+        transData.terminalData.transAmount = (float)(1000 - debitedCounts[i]);
+        if(APPROVED == routeTransaction(&transData)) {
+            transData.terminalData.transAmount = 1;
+            fullCount += (DECLINED_INSUFFICIENT_FUND == routeTransaction(&transData));
+        }
+    }
+
+    /* The accounts the ring of 3 shards gives to shard 2 */
+    if(SHARD_OK == buildShardRing(&ring, 3)) {
+        for(i = 0; i < SHARDED_ACCOUNTS_COUNT; ++i) {
+            sprintf((char *)account.primaryAccountNumber, "4%018u", i);
+            movedCount += (2 == getHashShard(&ring, hashPan(account.primaryAccountNumber)));
+        }
+    }
+
+    disconnectShards(TRUE);
+    for(i = 0; i < 3; ++i) {
+        if(shardIds[i] > 0) {
+            waitpid(shardIds[i], NULL, 0);
+        }
+    }
+
+    printf("%u of %u transactions approved while %u accounts moved, %u of %u balances whole on %u shards.\n",
+           approvedCount, migratingCount, movedCount, fullCount, SHARDED_ACCOUNTS_COUNT, shardCount);
+
+    return (BOOL_t)( (SHARD_OK == shardError) && (3 == shardCount) && (approvedCount == migratingCount) &&
+                     (movedCount > 0) && (SHARDED_ACCOUNTS_COUNT == fullCount) );
+}
+
+BOOL_t testReplication(const EN_replicationMode_t mode) {
+    const char * const standbyPath = "/tmp/appTestStandby", * const promotedPath = "/tmp/appTestPromoted";
+    const struct timespec retryDelay = {0, 10000000};
+    static uint32_t runCount = 0;
+    struct timespec start, end;
+    ST_accountsDB_t account = {.balance = 1000};
+    ST_transaction_t transData = {0};
+    EN_replicationError_t replicationError = REPLICATION_SOCKET_ERROR;
+    EN_shardError_t shardError = SHARD_SOCKET_ERROR;
+    uint32_t i = 0, round = 0, approvedCount = 0;
+    uint64_t holdIds[2] = {0};
+    double promotionSeconds = 0;
+    BOOL_t isBalanceWhole = FALSE, isHoldReplicated = FALSE;
+    pid_t standbyId = 0;
+    int standbyStatus = -1;
+
+    fflush(stdout);
+    standbyId = fork();
+    if(0 == standbyId) {
+        setLogPrinting(FALSE);
+        _exit(runStandby(standbyPath, promotedPath));
+    }
+
+    for(round = 0; (REPLICATION_OK != replicationError) && (round < 100); ++round) {
+        nanosleep(&retryDelay, NULL);
+        replicationError = startReplication(standbyPath, mode);
+    }
+
+    /* A new account each run, debited, and a card unknown every tenth transaction */
+    sprintf((char *)account.primaryAccountNumber, "5%08u%010u", (unsigned)mode, runCount++);
+    addAccount(&account);
+    parseTransactionDate(&(transData.terminalData), (const uint8_t *)"19/10/2026");
+    transData.terminalData.transAmount = 7;
+
+    setLogPrinting(FALSE);
+    for(i = 0; (REPLICATION_OK == replicationError) && (i < REPLICATED_TRANSACTIONS_COUNT); ++i) {
+        strcpy((char *)transData.cardHolderData.primaryAccountNumber,
+               (9 == i % 10) ? "5999999999999999999" : (char *)account.primaryAccountNumber);
+        approvedCount += (APPROVED == recieveTransactionData(&transData));
+    }
+
+    /* 50 held then released, and 100 of the balance left held */
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    transData.terminalData.transAmount = 50;
+    isHoldReplicated = (HOLD_OK == startHolds(2, 0)) && (HOLD_OK == authorizeHold(&transData, 1000, &holdIds[0])) &&
+                       (HOLD_OK == releaseHold(holdIds[0]));
+    transData.terminalData.transAmount = 100;
+    isHoldReplicated = isHoldReplicated && (HOLD_OK == authorizeHold(&transData, 1000, &holdIds[1])) &&
+                       (APPROVED == transData.transState);
+    setLogPrinting(TRUE);
+
+    /* Switching over: the standby has every change and serves its accounts */
+    timespec_get(&start, TIME_UTC);
+    if(REPLICATION_OK == replicationError) {
+        replicationError = stopReplication(TRUE);
+    }
+    for(round = 0; (REPLICATION_OK == replicationError) && (SHARD_OK != shardError) && (round < 1000); ++round) {
+        shardError = connectShards(&promotedPath, 1);
+        if(SHARD_OK != shardError) {
+            nanosleep(&retryDelay, NULL);
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    promotionSeconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    /* The promoted standby still holds the 100: the balance left is declined, the rest approved, then nothing more */
+    if(SHARD_OK == shardError) {
+        transData.terminalData.transAmount = account.balance - 7.0f * (float)approvedCount;
+        strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+        isHoldReplicated = isHoldReplicated && (DECLINED_INSUFFICIENT_FUND == routeTransaction(&transData));
+        transData.terminalData.transAmount -= 100;
+        if(APPROVED == routeTransaction(&transData)) {
+            transData.terminalData.transAmount = 1;
+            isBalanceWhole = (DECLINED_INSUFFICIENT_FUND == routeTransaction(&transData));
+        }
+        disconnectShards(TRUE);
+    }
+    stopHolds();
+
+    if(standbyId > 0) {
+        waitpid(standbyId, &standbyStatus, 0);
+    }
+
+    printf("%u of %u transactions approved and replicated %s, standby promoted in %.1f ms, balance %s, hold %s.\n",
+           approvedCount, REPLICATED_TRANSACTIONS_COUNT, (REPLICATION_SYNC == mode) ? "synchronously" : "asynchronously",
+           promotionSeconds * 1e3, isBalanceWhole ? "whole" : "wrong", isHoldReplicated ? "kept" : "lost");
+
+    return (BOOL_t)( (REPLICATION_OK == replicationError) && (SHARD_OK == shardError) &&
+                     (REPLICATED_TRANSACTIONS_COUNT / 10 * 9 == approvedCount) && isBalanceWhole && isHoldReplicated &&
+                     (promotionSeconds < 1.0) && (0 == standbyStatus) );
+}
+
+BOOL_t testHolds(void) {
+    static const uint32_t lifetimes[] = {1, 255, 256, 257, 65535, 65536, 65537, 16777217};
+    static uint32_t runCount = 0;
+    const uint64_t start = 123456789;
+    ST_accountsDB_t account = {.balance = 100};
+    ST_transaction_t transData = {0};
+    EN_holdError_t holdError = HOLD_OK;
+    uint64_t holdIds[3] = {0}, base = 0;
+    uint32_t i = 0, onTimeCount = 0;
+    BOOL_t isHoldingOk = FALSE;
+    int16_t accountIndex = -1;
+
+    /* A new account each run, with 100 available */
+    sprintf((char *)account.primaryAccountNumber, "6%018u", runCount++);
+    addAccount(&account);
+    accountIndex = (int16_t)(getAccountsCount() - 1);
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    holdError = startHolds(16, start);
+
+    setLogPrinting(FALSE);
+
+    /* 60 held: 40 left available, so a sale of 50 is declined and a hold of 30 is not */
+    transData.terminalData.transAmount = 60;
+    isHoldingOk = (HOLD_OK == holdError) && (HOLD_OK == authorizeHold(&transData, 10, &holdIds[0])) &&
+                  (APPROVED == transData.transState);
+    transData.terminalData.transAmount = 50;
+    isHoldingOk = isHoldingOk && (DECLINED_INSUFFICIENT_FUND == recieveTransactionData(&transData));
+    transData.terminalData.transAmount = 30;
+    isHoldingOk = isHoldingOk && (HOLD_OK == authorizeHold(&transData, 100, &holdIds[1])) &&
+                  (APPROVED == transData.transState);
+
+    /* The first captured for 45 then gone: 55 left, 30 of them held */
+    transData.terminalData.transAmount = 45;
+    isHoldingOk = isHoldingOk && (HOLD_OK == captureHold(holdIds[0], &transData)) &&
+                  (APPROVED == transData.transState) && (HOLD_NOT_FOUND == captureHold(holdIds[0], &transData));
+    transData.terminalData.transAmount = 26;
+    isHoldingOk = isHoldingOk && (DECLINED_INSUFFICIENT_FUND == recieveTransactionData(&transData));
+
+    /* A hold released at once, and the second one expiring on its tick, never more than the 50 held */
+    transData.terminalData.transAmount = 20;
+    isHoldingOk = isHoldingOk && (HOLD_OK == authorizeHold(&transData, 1000, &holdIds[2])) &&
+                  (HELD_AMOUNT_ERROR == releaseHeldAmount(accountIndex, 5001)) &&
+                  (HOLD_OK == releaseHold(holdIds[2])) && (1 == getHoldsCount());
+    isHoldingOk = isHoldingOk && (0 == advanceHolds(start + 99)) && (1 == advanceHolds(start + 100)) &&
+                  (HOLD_NOT_FOUND == releaseHold(holdIds[1])) && (HELD_AMOUNT_ERROR == releaseHeldAmount(accountIndex, 1));
+    transData.terminalData.transAmount = 55;
+    isHoldingOk = isHoldingOk && (APPROVED == recieveTransactionData(&transData));
+    transData.terminalData.transAmount = 1;
+    isHoldingOk = isHoldingOk && (DECLINED_INSUFFICIENT_FUND == recieveTransactionData(&transData));
+
+    /* Null holds expiring across every level of the wheel, each on its own tick */
+    base = start + 100;
+    transData.terminalData.transAmount = 0;
+    for(i = 0; i < sizeof(lifetimes) / sizeof(lifetimes[0]); ++i) {
+        authorizeHold(&transData, lifetimes[i], &holdIds[0]);
+    }
+    for(i = 0; i < sizeof(lifetimes) / sizeof(lifetimes[0]); ++i) {
+        onTimeCount += (0 == advanceHolds(base + lifetimes[i] - 1)) && (1 == advanceHolds(base + lifetimes[i]));
+    }
+
+    setLogPrinting(TRUE);
+    stopHolds();
+
+    printf("Holds %s the available balance, %u of %u holds expired on their tick.\n",
+           isHoldingOk ? "reduce" : "do not reduce", onTimeCount, (uint32_t)(sizeof(lifetimes) / sizeof(lifetimes[0])));
+
+    return (BOOL_t)( isHoldingOk && (sizeof(lifetimes) / sizeof(lifetimes[0]) == onTimeCount) );
+}
+
+BOOL_t testAdmission(void) {
+    static uint32_t runCount = 0;
+    const char * const configPath = "/tmp/appTestTerminals.txt";
+    const ST_admissionLimits_t limits = {.globalRatePerSecond = 0.001f, .globalBurst = 8,
+                                         .terminalRatePerSecond = 0.001f, .terminalBurst = 4};
+    const ST_admissionLimits_t terminalLimits = {.terminalRatePerSecond = 0.001f, .terminalBurst = 4};
+    ST_accountsDB_t account = {.balance = 1000};
+    ST_transaction_t transData = {0};
+    FILE *file = NULL;
+    uint64_t now = 0;
+    uint32_t i = 0, floodApprovedCount = 0;
+    BOOL_t isFloodLimited = FALSE, isOtherServed = FALSE, isShedding = FALSE, isGlobalLimited = FALSE;
+
+    /* A new account each run, terminal 70 configured for a burst of 3 and a token every 1000 s */
+    sprintf((char *)account.primaryAccountNumber, "7%018u", runCount++);
+    addAccount(&account);
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    transData.terminalData.transAmount = 1;
+
+    file = fopen(configPath, "w");
+    if(NULL != file) {
+        fprintf(file, "70 1000 0 EGP 0.001 3\n");
+        fclose(file);
+    }
+
+    if( (TERMINAL_OK != loadTerminalConfig(configPath)) || (ADMISSION_OK != loadAdmissionLimits(&limits)) ) {
+        remove(configPath);
+        return FALSE;
+    }
+
+    setLogPrinting(FALSE);
+
+    /* Terminal 70 floods: its burst goes through, the rest is asked to try later */
+    transData.terminalData.terminalId = 70;
+    for(i = 0; i < 10; ++i) {
+        floodApprovedCount += (APPROVED == recieveTransactionData(&transData));
+    }
+    isFloodLimited = (3 == floodApprovedCount) && (DECLINED_TRY_LATER == transData.transState);
+
+    /* Terminal 71 has the default limit and is still served, but not once its terminal gave up */
+    transData.terminalData.terminalId = 71;
+    isOtherServed = (APPROVED == recieveTransactionData(&transData));
+    now = getAdmissionTime();
+    transData.deadline = now;
+    isShedding = (DECLINED_TRY_LATER == recieveTransactionData(&transData)) &&
+                 (ADMISSION_DEADLINE_PASSED == admitTransaction(&transData, now));
+    transData.deadline = now + 1000000000ull;
+    isOtherServed = isOtherServed && (APPROVED == recieveTransactionData(&transData));
+    transData.deadline = 0;
+
+    /* 5 global tokens taken, terminal 72 gets the last 3 */
+    transData.terminalData.terminalId = 72;
+    for(i = 0; i < 3; ++i) {
+        isGlobalLimited = (ADMISSION_OK == admitTransaction(&transData, now));
+    }
+    isGlobalLimited = isGlobalLimited && (ADMISSION_GLOBAL_LIMIT == admitTransaction(&transData, now));
+
+    /* Without the global limit, terminal 72 still has the token of the transaction not admitted */
+    isGlobalLimited = isGlobalLimited && (ADMISSION_OK == loadAdmissionLimits(&terminalLimits)) &&
+                      (ADMISSION_OK == admitTransaction(&transData, now)) &&
+                      (ADMISSION_TERMINAL_LIMIT == admitTransaction(&transData, now));
+
+    /* 2000 s later both buckets of terminal 70 have 2 tokens again */
+    transData.terminalData.terminalId = 70;
+    isFloodLimited = isFloodLimited && (ADMISSION_TERMINAL_LIMIT == admitTransaction(&transData, now)) &&
+                     (ADMISSION_OK == admitTransaction(&transData, now + 2000000000000ull));
+
+    setLogPrinting(TRUE);
+    unloadAdmissionLimits();
+    unloadTerminalConfig();
+    remove(configPath);
+
+    printf("Flooding terminal %s, other terminal %s, expired transaction %s, global limit %s.\n",
+           isFloodLimited ? "limited" : "not limited", isOtherServed ? "served" : "not served",
+           isShedding ? "shed" : "not shed", isGlobalLimited ? "applied" : "not applied");
+
+    return (BOOL_t)( isFloodLimited && isOtherServed && isShedding && isGlobalLimited );
+}
+
+BOOL_t testVault(void) {
+    static uint32_t runCount = 0;
+    ST_accountsDB_t account = {.balance = 1000};
+    ST_transaction_t transData = {0};
+    ST_transactionRecord_t record;
+    PAN_TOKEN_t token = PAN_TOKEN_NONE, otherToken = PAN_TOKEN_NONE;
+    uint8_t pan[VAULT_MAX_PAN_LENGTH + 1], expectedPan[VAULT_MAX_PAN_LENGTH + 1];
+    uint32_t i = 0, vaultCount = 0;
+    BOOL_t isStable = FALSE, isReversible = FALSE, isGrowing = TRUE, isHistoryTokenized = FALSE;
+
+    /* The same PAN has the same token, the PAN with a leading zero another one */
+    isStable = (VAULT_OK == tokenizePan((const uint8_t *)"4111111111111111", &token))       &&
+               (VAULT_OK == tokenizePan((const uint8_t *)"4111111111111111", &otherToken))  &&
+               (token == otherToken) && (PAN_TOKEN_NONE != token)                           &&
+               (VAULT_OK == tokenizePan((const uint8_t *)"04111111111111111", &otherToken)) &&
+               (token != otherToken);
+
+    isReversible = (VAULT_OK == detokenizePan(token, pan)) && (0 == strcmp((char *)pan, "4111111111111111")) &&
+                   (VAULT_OK == detokenizePan(otherToken, pan)) && (0 == strcmp((char *)pan, "04111111111111111")) &&
+                   (VAULT_TOKEN_NOT_FOUND == detokenizePan(PAN_TOKEN_NONE, pan))                     &&
+                   (VAULT_INVALID_PAN == tokenizePan((const uint8_t *)"4111-1111", &token))          &&
+                   (VAULT_INVALID_PAN == tokenizePan((const uint8_t *)"41111111111111111111", &token));
+
+    /* Past its initial capacity the vault grows and keeps every card */
+    for(i = 0; (i < 2 * VAULT_INITIAL_CAPACITY) && isGrowing; ++i) {
+        sprintf((char *)expectedPan, "6%018u", i);
+        isGrowing = (VAULT_OK == tokenizePan(expectedPan, &token)) && (VAULT_OK == detokenizePan(token, pan)) &&
+                    (0 == strcmp((char *)pan, (char *)expectedPan));
+    }
+    isGrowing = isGrowing && (getVaultCount() > 2 * VAULT_INITIAL_CAPACITY);
+
+    /* A new account each run, its transaction is saved with the token of its PAN */
+    sprintf((char *)account.primaryAccountNumber, "8%018u", runCount++);
+    addAccount(&account);
+    strcpy((char *)transData.cardHolderData.cardHolderName, "Mahmoud Karam Emara Ali");
+    strcpy((char *)transData.cardHolderData.primaryAccountNumber, (char *)account.primaryAccountNumber);
+    transData.terminalData.transAmount = 1;
+
+    setLogPrinting(FALSE);
+    isHistoryTokenized = (APPROVED == recieveTransactionData(&transData))                                   &&
+                         (SERVER_OK == getTransaction(transData.transactionSequenceNumber, &record))        &&
+                         (VAULT_OK == tokenizePan(account.primaryAccountNumber, &token))                    &&
+                         (token == record.panToken) && (VAULT_OK == detokenizePan(record.panToken, pan))    &&
+                         (0 == strcmp((char *)pan, (char *)account.primaryAccountNumber))                   &&
+                         (TRANSACTION_NOT_FOUND == getTransaction(UINT32_MAX, &record));
+
+    /* A card of no account is declined and saved without taking room in the vault */
+    sprintf((char *)transData.cardHolderData.primaryAccountNumber, "9%018u", runCount);
+    vaultCount = getVaultCount();
+    isHistoryTokenized = isHistoryTokenized && (DECLINED_STOLEN_CARD == recieveTransactionData(&transData)) &&
+                         (SERVER_OK == getTransaction(transData.transactionSequenceNumber, &record))        &&
+                         (PAN_TOKEN_NONE == record.panToken) && (vaultCount == getVaultCount());
+    setLogPrinting(TRUE);
+
+    printf("Tokens %s, %s, vault %s, history %s.\n", isStable ? "stable" : "not stable",
+           isReversible ? "reversible" : "not reversible", isGrowing ? "growing" : "not growing",
+           isHistoryTokenized ? "tokenized" : "not tokenized");
+
+    return (BOOL_t)( isStable && isReversible && isGrowing && isHistoryTokenized );
+}
+
+BOOL_t testExitedThreads(void) {
+    const uint64_t startCount = getMetricCount(METRIC_TRANSACTION_STARTED, 0);
+    pthread_t thread;
+    uint32_t i = 0, joinedCount = 0;
+
+    /* Each thread counts once and exits, the next one takes its counters with the count */
+    for(i = 0; i < EXITED_THREADS_COUNT; ++i) {
+        if(0 == pthread_create(&thread, NULL, countThreadMetric, NULL)) {
+            joinedCount += (0 == pthread_join(thread, NULL));
+        }
+    }
+
+    printf("%u threads counted %llu times.\n", joinedCount,
+           (unsigned long long)(getMetricCount(METRIC_TRANSACTION_STARTED, 0) - startCount));
+
+    return (BOOL_t)( (EXITED_THREADS_COUNT == joinedCount) &&
+                     (startCount + EXITED_THREADS_COUNT == getMetricCount(METRIC_TRANSACTION_STARTED, 0)) );
+}
+
+/********************************************************************************
+ * @brief       Count one started transaction from a new thread, for
+ *              testExitedThreads()
+ *******************************************************************************/
+static void *countThreadMetric(void * const argument) {
+    (void)argument;
+    countMetric(METRIC_TRANSACTION_STARTED, 0);
+    return NULL;
+}
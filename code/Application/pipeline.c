@@ -0,0 +1,530 @@
+/********************************************************************************
+ * @file    pipeline.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the pipelined execution of the state machine.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Server/server.h"
+#include "../Server/admission.h"
+#include "state.h"
+#include "pipeline.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Size of a line of the transactions file
+ *******************************************************************************/
+#define PIPELINE_LINE_SIZE          128
+
+/********************************************************************************
+ * @brief   Maximum number of inputs in a line of the transactions file
+ *******************************************************************************/
+#define PIPELINE_MAX_FIELDS         8
+
+/********************************************************************************
+ * @brief   Size of a cache line, to keep data written by different threads apart
+ *******************************************************************************/
+#define CACHE_LINE_SIZE             64
+
+/********************************************************************************
+ * @brief   Struct for a transaction going through the pipeline
+ *******************************************************************************/
+typedef struct ST_pipelineRecord_t {
+    ST_transactionContext_t context;                /*!< Transaction and its progress */
+    uint8_t line[PIPELINE_LINE_SIZE];               /*!< Line of the file, commas replaced by null chars */
+    const uint8_t *fields[PIPELINE_MAX_FIELDS];     /*!< Inputs of the transaction, inside line */
+    uint8_t fieldCount;                             /*!< Number of inputs */
+    uint8_t nextField;                              /*!< Next input to give to the states */
+} ST_pipelineRecord_t;
+
+/********************************************************************************
+ * @brief   Struct for a cell of a queue, its sequence tells whether it is
+ *          free or holds a record for the current lap of the ring
+ *******************************************************************************/
+typedef struct ST_queueCell_t {
+    size_t sequence;
+    ST_pipelineRecord_t *record;
+} ST_queueCell_t;
+
+/********************************************************************************
+ * @brief   Struct for a bounded lock free queue of many producers and many
+ *          consumers, the head and tail are on their own cache lines
+ *******************************************************************************/
+typedef struct ST_pipelineQueue_t {
+    ST_queueCell_t cells[PIPELINE_QUEUE_SIZE];
+    size_t head __attribute__((aligned(CACHE_LINE_SIZE)));     /*!< Next cell to pop */
+    size_t tail __attribute__((aligned(CACHE_LINE_SIZE)));     /*!< Next cell to push */
+} ST_pipelineQueue_t;
+
+/********************************************************************************
+ * @brief   Struct for a stage of the pipeline, one per state
+ *******************************************************************************/
+typedef struct ST_pipelineStage_t {
+    ST_pipelineQueue_t queue;                       /*!< Transactions waiting for the state */
+    ST_pipelineStats_t stats __attribute__((aligned(CACHE_LINE_SIZE)));
+    pthread_mutex_t lock;                           /*!< Taken around states that are not reentrant */
+    pthread_t threads[PIPELINE_MAX_THREADS];        /*!< Worker threads */
+} ST_pipelineStage_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Stages of the pipeline
+ *******************************************************************************/
+static ST_pipelineStage_t stages[PIPELINE_MAX_STAGES];
+
+/********************************************************************************
+ * @brief   Records not in flight, every record goes back here once its
+ *          transaction is over
+ *******************************************************************************/
+static ST_pipelineQueue_t freeRecords;
+
+/********************************************************************************
+ * @brief   Records of the pipeline
+ *******************************************************************************/
+static ST_pipelineRecord_t records[PIPELINE_QUEUE_SIZE];
+
+/********************************************************************************
+ * @brief   Set once every record is back, the worker threads then exit
+ *******************************************************************************/
+static BOOL_t isStopping = FALSE;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void initQueue(ST_pipelineQueue_t * const queue);
+static BOOL_t pushQueue(ST_pipelineQueue_t * const queue, ST_pipelineRecord_t * const record);
+static ST_pipelineRecord_t *popQueue(ST_pipelineQueue_t * const queue);
+static uint32_t getQueueDepth(const ST_pipelineQueue_t * const queue);
+static void pushStage(const uint8_t stage, ST_pipelineRecord_t * const record);
+static ST_pipelineRecord_t *waitFreeRecord(void);
+static void runStage(ST_pipelineRecord_t * const record, const uint8_t stage);
+static void *stageWorker(void *argument);
+static BOOL_t readRecord(FILE * const file, ST_pipelineRecord_t * const record);
+static uint64_t nowNanoseconds(void);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_pipelineError_t runPipelineFile(const char * const fileName, const uint8_t * const threadCounts,
+                                   const uint32_t terminalId) {
+    ST_pipelineStats_t emptyStats = {0};
+    ST_pipelineRecord_t *record = NULL;
+    EN_pipelineError_t pipelineError = PIPELINE_OK;
+    FILE *file = NULL;
+    uint8_t stage = 0, thread = 0, startedCount[PIPELINE_MAX_STAGES] = {0};
+    uint32_t i = 0, returnedCount = 0;
+
+    if( (NULL == fileName) || (NULL == threadCounts) || (countStates > PIPELINE_MAX_STAGES) ) {
+        return PIPELINE_INVALID_THREADS;
+    }
+
+    for(stage = 0; stage < countStates; ++stage) {
+        if( (0 == threadCounts[stage]) || (threadCounts[stage] > PIPELINE_MAX_THREADS) ) {
+            return PIPELINE_INVALID_THREADS;
+        }
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return PIPELINE_FILE_ERROR;
+    }
+
+    initQueue(&freeRecords);
+    for(i = 0; i < PIPELINE_QUEUE_SIZE; ++i) {
+        pushQueue(&freeRecords, &records[i]);
+    }
+
+    __atomic_store_n(&isStopping, FALSE, __ATOMIC_RELEASE);
+
+    for(stage = 0; stage < countStates; ++stage) {
+        initQueue(&(stages[stage].queue));
+        stages[stage].stats = emptyStats;
+        stages[stage].stats.threadCount = threadCounts[stage];
+        pthread_mutex_init(&(stages[stage].lock), NULL);
+
+        for(thread = 0; thread < threadCounts[stage]; ++thread) {
+            if(0 != pthread_create(&(stages[stage].threads[thread]), NULL, stageWorker, (void *)(uintptr_t)stage)) {
+                pipelineError = PIPELINE_THREAD_ERROR;
+                break;
+            }
+            ++startedCount[stage];
+        }
+    }
+
+    /* Feeding the first state while the records come back from the last ones */
+    while(PIPELINE_OK == pipelineError) {
+        record = waitFreeRecord();
+        if( !readRecord(file, record) ) {
+            pushQueue(&freeRecords, record);
+            break;
+        }
+
+        initTransactionContext(&(record->context), terminalId);
+        record->context.isVerbose = FALSE;
+        record->context.transData.deadline = getAdmissionTime() + PIPELINE_DEADLINE_MS * 1000000ull;
+        pushStage(0, record);
+    }
+
+    fclose(file);
+
+    /* Every record back in the free queue means every transaction is over */
+    for(returnedCount = 0; returnedCount < PIPELINE_QUEUE_SIZE; ++returnedCount) {
+        waitFreeRecord();
+    }
+
+    __atomic_store_n(&isStopping, TRUE, __ATOMIC_RELEASE);
+
+    for(stage = 0; stage < countStates; ++stage) {
+        for(thread = 0; thread < startedCount[stage]; ++thread) {
+            pthread_join(stages[stage].threads[thread], NULL);
+        }
+        pthread_mutex_destroy(&(stages[stage].lock));
+    }
+
+    return pipelineError;
+}
+
+void getPipelineStats(const uint8_t stage, ST_pipelineStats_t * const stats) {
+    ST_pipelineStats_t emptyStats = {0};
+    const ST_pipelineStage_t *pipelineStage = NULL;
+
+    if(NULL == stats) {
+        return;
+    }
+
+    if(stage >= countStates) {
+        *stats = emptyStats;
+        return;
+    }
+
+    pipelineStage = &(stages[stage]);
+
+    stats->processedCount     = __atomic_load_n(&(pipelineStage->stats.processedCount), __ATOMIC_RELAXED);
+    stats->failedCount        = __atomic_load_n(&(pipelineStage->stats.failedCount), __ATOMIC_RELAXED);
+    stats->serviceNanoseconds = __atomic_load_n(&(pipelineStage->stats.serviceNanoseconds), __ATOMIC_RELAXED);
+    stats->queueDepthSum      = __atomic_load_n(&(pipelineStage->stats.queueDepthSum), __ATOMIC_RELAXED);
+    stats->maxQueueDepth      = __atomic_load_n(&(pipelineStage->stats.maxQueueDepth), __ATOMIC_RELAXED);
+    stats->threadCount        = pipelineStage->stats.threadCount;
+    stats->queueDepth         = getQueueDepth(&(pipelineStage->queue));
+}
+
+void printPipelineStats(void) {
+    ST_pipelineStats_t stats;
+    uint8_t stage = 0;
+    double serviceTime = 0, averageDepth = 0;
+
+    printf("%-24s %7s %10s %10s %12s %10s %10s\n",
+           "State", "Threads", "Processed", "Failed", "Service(ns)", "AvgQueue", "MaxQueue");
+
+    for(stage = 0; stage < countStates; ++stage) {
+        getPipelineStats(stage, &stats);
+
+        serviceTime  = (stats.processedCount > 0) ? ((double)stats.serviceNanoseconds / stats.processedCount) : 0;
+        averageDepth = (stats.processedCount > 0) ? ((double)stats.queueDepthSum / stats.processedCount) : 0;
+
+        printf("%-24s %7u %10llu %10llu %12.0f %10.1f %10u\n",
+               stateMachine[stage].name, stats.threadCount,
+               (unsigned long long)stats.processedCount, (unsigned long long)stats.failedCount,
+               serviceTime, averageDepth, stats.maxQueueDepth);
+    }
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Empty a queue, cell i is free for the push number i
+ *******************************************************************************/
+static void initQueue(ST_pipelineQueue_t * const queue) {
+    size_t i = 0;
+
+    for(i = 0; i < PIPELINE_QUEUE_SIZE; ++i) {
+        queue->cells[i].sequence = i;
+        queue->cells[i].record = NULL;
+    }
+
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+/********************************************************************************
+ * @brief       Push a record at the tail of a queue
+ *
+ * @return      BOOL_t: TRUE, or FALSE if the queue is full
+ *******************************************************************************/
+static BOOL_t pushQueue(ST_pipelineQueue_t * const queue, ST_pipelineRecord_t * const record) {
+    ST_queueCell_t *cell = NULL;
+    size_t position = __atomic_load_n(&(queue->tail), __ATOMIC_RELAXED);
+    intptr_t difference = 0;
+
+    for(;;) {
+        cell = &(queue->cells[position & (PIPELINE_QUEUE_SIZE - 1)]);
+        difference = (intptr_t)__atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE) - (intptr_t)position;
+
+        if(0 == difference) {
+            /* The cell is free, claiming it */
+            if(__atomic_compare_exchange_n(&(queue->tail), &position, position + 1, TRUE,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if(difference < 0) {
+            /* The cell still holds the record of the previous lap */
+            return FALSE;
+        } else {
+            position = __atomic_load_n(&(queue->tail), __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->record = record;
+    __atomic_store_n(&(cell->sequence), position + 1, __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+/********************************************************************************
+ * @brief       Pop the record at the head of a queue
+ *
+ * @return      ST_pipelineRecord_t*: The record, or NULL if the queue is empty
+ *******************************************************************************/
+static ST_pipelineRecord_t *popQueue(ST_pipelineQueue_t * const queue) {
+    ST_queueCell_t *cell = NULL;
+    ST_pipelineRecord_t *record = NULL;
+    size_t position = __atomic_load_n(&(queue->head), __ATOMIC_RELAXED);
+    intptr_t difference = 0;
+
+    for(;;) {
+        cell = &(queue->cells[position & (PIPELINE_QUEUE_SIZE - 1)]);
+        difference = (intptr_t)__atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE) - (intptr_t)(position + 1);
+
+        if(0 == difference) {
+            /* The cell holds a record, claiming it */
+            if(__atomic_compare_exchange_n(&(queue->head), &position, position + 1, TRUE,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if(difference < 0) {
+            return NULL;
+        } else {
+            position = __atomic_load_n(&(queue->head), __ATOMIC_RELAXED);
+        }
+    }
+
+    record = cell->record;
+    __atomic_store_n(&(cell->sequence), position + PIPELINE_QUEUE_SIZE, __ATOMIC_RELEASE);
+
+    return record;
+}
+
+/********************************************************************************
+ * @brief       Get the number of records in a queue, the head is read first so
+ *              a pop between the two reads cannot make it negative
+ *******************************************************************************/
+static uint32_t getQueueDepth(const ST_pipelineQueue_t * const queue) {
+    size_t head = __atomic_load_n(&(queue->head), __ATOMIC_ACQUIRE);
+
+    return (uint32_t)(__atomic_load_n(&(queue->tail), __ATOMIC_ACQUIRE) - head);
+}
+
+/********************************************************************************
+ * @brief       Hand a record to a stage, recording the depth of its queue
+ *******************************************************************************/
+static void pushStage(const uint8_t stage, ST_pipelineRecord_t * const record) {
+    ST_pipelineStage_t * const pipelineStage = &(stages[stage]);
+    uint32_t depth = 0, maxDepth = 0;
+
+    while( !pushQueue(&(pipelineStage->queue), record) ) {
+        sched_yield();
+    }
+
+    depth = getQueueDepth(&(pipelineStage->queue));
+    __atomic_fetch_add(&(pipelineStage->stats.queueDepthSum), depth, __ATOMIC_RELAXED);
+
+    maxDepth = __atomic_load_n(&(pipelineStage->stats.maxQueueDepth), __ATOMIC_RELAXED);
+    while( (depth > maxDepth) &&
+           !__atomic_compare_exchange_n(&(pipelineStage->stats.maxQueueDepth), &maxDepth, depth, TRUE,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED) );
+}
+
+/********************************************************************************
+ * @brief       Wait for a record to come back to the free queue
+ *******************************************************************************/
+static ST_pipelineRecord_t *waitFreeRecord(void) {
+    ST_pipelineRecord_t *record = NULL;
+
+    while(NULL == (record = popQueue(&freeRecords))) {
+        sched_yield();
+    }
+
+    return record;
+}
+
+/********************************************************************************
+ * @brief       Run the state of a stage for a record, giving it the inputs of
+ *              the record as it asks for them
+ *******************************************************************************/
+static void runStage(ST_pipelineRecord_t * const record, const uint8_t stage) {
+    ST_transactionContext_t * const context = &(record->context);
+
+    do {
+        advanceTransaction(context);
+
+        if(CONTEXT_NEEDS_INPUT == context->status) {
+            /* Nobody answers "Try again?" in a file */
+            if( context->isAskingTryAgain || (record->nextField >= record->fieldCount) ) {
+                context->status = CONTEXT_FAILED;
+            } else {
+                context->input = record->fields[(record->nextField)++];
+                context->status = CONTEXT_RUNNING;
+            }
+        }
+    } while( (CONTEXT_RUNNING == context->status) && (stage == context->stateIndex) );
+
+    context->input = NULL;
+}
+
+/********************************************************************************
+ * @brief       Worker thread of a stage, passes each record of its queue to the
+ *              next stage, or back to the free queue once it is over
+ *
+ * @param[in]   argument: Index of the stage
+ *******************************************************************************/
+static void *stageWorker(void *argument) {
+    const uint8_t stage = (uint8_t)(uintptr_t)argument;
+    ST_pipelineStage_t * const pipelineStage = &(stages[stage]);
+    ST_pipelineRecord_t *record = NULL;
+    uint64_t start = 0;
+
+    for(;;) {
+        record = popQueue(&(pipelineStage->queue));
+        if(NULL == record) {
+            if(__atomic_load_n(&isStopping, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        start = nowNanoseconds();
+
+        if( !stateMachine[stage].isReentrant ) {
+            pthread_mutex_lock(&(pipelineStage->lock));
+        }
+
+        runStage(record, stage);
+
+        if( !stateMachine[stage].isReentrant ) {
+            pthread_mutex_unlock(&(pipelineStage->lock));
+        }
+
+        __atomic_fetch_add(&(pipelineStage->stats.serviceNanoseconds), nowNanoseconds() - start, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&(pipelineStage->stats.processedCount), 1, __ATOMIC_RELAXED);
+
+        if(CONTEXT_RUNNING == record->context.status) {
+            pushStage(record->context.stateIndex, record);
+        } else {
+            if(CONTEXT_FAILED == record->context.status) {
+                __atomic_fetch_add(&(pipelineStage->stats.failedCount), 1, __ATOMIC_RELAXED);
+            }
+            pushQueue(&freeRecords, record);
+        }
+    }
+
+    return NULL;
+}
+
+/********************************************************************************
+ * @brief       Read the next transaction of the file into a record. A line
+ *              too long for the record is flushed and gives a transaction
+ *              with no input, which fails in the first state.
+ *
+ * @return      BOOL_t: TRUE, or FALSE at the end of the file
+ *******************************************************************************/
+static BOOL_t readRecord(FILE * const file, ST_pipelineRecord_t * const record) {
+    uint8_t *field = NULL;
+    size_t length = 0;
+    int character = 0;
+
+    record->fieldCount = 0;
+    record->nextField = 0;
+
+    do {
+        if(NULL == fgets((char *)record->line, sizeof(record->line), file)) {
+            return FALSE;
+        }
+
+        /* A full buffer without its newline is the head of a longer line, its tail is not another transaction */
+        length = strlen((char *)record->line);
+        if( (length + 1 == sizeof(record->line)) && ('\n' != record->line[length - 1]) ) {
+            character = getc(file);
+            if( ('\n' != character) && (EOF != character) ) {
+                do {
+                    character = getc(file);
+                } while( ('\n' != character) && (EOF != character) );
+                return TRUE;
+            }
+        }
+
+        record->line[strcspn((char *)record->line, "\r\n")] = '\0';
+    } while('\0' == record->line[0]);       /* Skipping empty lines */
+
+    for(field = record->line; (NULL != field) && (record->fieldCount < PIPELINE_MAX_FIELDS); ) {
+        record->fields[(record->fieldCount)++] = field;
+
+        field = (uint8_t *)strchr((char *)field, ',');
+        if(NULL != field) {
+            *(field++) = '\0';
+        }
+    }
+
+    return TRUE;
+}
+
+/********************************************************************************
+ * @brief       Get a monotonic time in nanoseconds
+ *******************************************************************************/
+static uint64_t nowNanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
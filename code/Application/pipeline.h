@@ -0,0 +1,116 @@
+/********************************************************************************
+ * @file    pipeline.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the pipelined execution of
+ *          the state machine \ref pipeline.c
+ * @details Every state of \ref stateMachine runs on its own worker threads.
+ *          Transactions move from one state to the next through bounded lock
+ *          free queues, so the card state of a transaction overlaps the server
+ *          state of an older one. It is meant for bulk files of transactions.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              TYPE DEFINITIONS                               */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Maximum number of states run by the pipeline
+ *******************************************************************************/
+#define PIPELINE_MAX_STAGES         4
+
+/********************************************************************************
+ * @brief   Maximum number of worker threads per state
+ *******************************************************************************/
+#define PIPELINE_MAX_THREADS        16
+
+/********************************************************************************
+ * @brief   Capacity of the queue in front of each state, a power of 2. It is
+ *          also the number of transactions in flight.
+ *******************************************************************************/
+#define PIPELINE_QUEUE_SIZE         1024
+
+/********************************************************************************
+ * @brief   Time a terminal waits for its answer from the moment its line is
+ *          read, in milliseconds. The server sheds the transactions still
+ *          queued past it.
+ *******************************************************************************/
+#define PIPELINE_DEADLINE_MS        2000
+
+/********************************************************************************
+ * @brief   Enum for the different errors of the <b>pipeline</b> module
+ *******************************************************************************/
+typedef enum EN_pipelineError_t {
+    PIPELINE_OK,                    /*!< Every line of the file went through the pipeline */
+    PIPELINE_INVALID_THREADS,       /*!< A state has no thread or more than PIPELINE_MAX_THREADS */
+    PIPELINE_FILE_ERROR,            /*!< The file cannot be read */
+    PIPELINE_THREAD_ERROR           /*!< A worker thread cannot be started */
+} EN_pipelineError_t;
+
+/********************************************************************************
+ * @brief   Struct for the statistics of one state of the pipeline
+ *******************************************************************************/
+typedef struct ST_pipelineStats_t {
+    uint64_t processedCount;        /*!< Transactions that went through the state */
+    uint64_t failedCount;           /*!< Transactions that failed in the state */
+    uint64_t serviceNanoseconds;    /*!< Time spent by all the threads in the state */
+    uint64_t queueDepthSum;         /*!< Sum of the queue depths seen by each push */
+    uint32_t queueDepth;            /*!< Transactions waiting for the state now */
+    uint32_t maxQueueDepth;         /*!< Most transactions seen waiting for the state */
+    uint8_t threadCount;            /*!< Worker threads of the state */
+} ST_pipelineStats_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                          PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Run every transaction of a file through the pipeline and wait
+ *              for the last one.
+ *
+ * @details     Each line holds the inputs of one transaction separated by
+ *              commas, in the order the states ask for them, e.g.
+ *              "name,MM/YY,PAN,DD/MM/YYYY,maxAmount,amount". The maximum amount
+ *              is left out for configured terminals. A transaction with an
+ *              invalid input fails, it is not given another try, and so does
+ *              a line longer than 127 characters. States that
+ *              are not reentrant run one thread at a time.
+ * @param[in]   fileName: Path of the transactions file
+ * @param[in]   threadCounts: Number of worker threads of each state of
+ *              \ref stateMachine
+ * @param[in]   terminalId: ID of the terminal running the transactions
+ * @return      EN_pipelineError_t: PIPELINE_OK or the error
+ *******************************************************************************/
+EN_pipelineError_t runPipelineFile(const char * const fileName, const uint8_t * const threadCounts,
+                                   const uint32_t terminalId);
+
+/********************************************************************************
+ * @brief       Get the statistics of a state of the pipeline, they can be read
+ *              while the pipeline runs and are kept until the next run.
+ *
+ * @param[in]   stage: Index of the state in \ref stateMachine
+ * @param[out]  stats: Statistics of the state, zero if there is no such state
+ *******************************************************************************/
+void getPipelineStats(const uint8_t stage, ST_pipelineStats_t * const stats);
+
+/********************************************************************************
+ * @brief       Print the statistics of every state of the pipeline, the state
+ *              with the highest service time per thread limits the throughput.
+ *******************************************************************************/
+void printPipelineStats(void);
+
+
+#endif      /* PIPELINE_H */
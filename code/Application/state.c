@@ -12,10 +12,20 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <time.h>
 #include "../macros.h"
 #include "../Card/card.h"
 #include "../Terminal/terminal.h"
 #include "../Server/server.h"
+#include "../Terminal/offline.h"
+#include "../Terminal/config.h"
+#include "../Server/routing.h"
+#include "../Server/shard.h"
+#include "../Server/fraud.h"
+#include "../Log/log.h"
+#include "../Log/latency.h"
+#include "../Log/metrics.h"
+#include "../Log/trace.h"
 #include "state.h"
 
 
@@ -25,13 +35,37 @@
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
+/********************************************************************************
+ * @brief   Take the pending line of input of the context.
+ * 
+ * @param   context: Pointer to the transaction context.
+ * @param   prompt: What is expected, kept in context->prompt while waiting.
+ * @return  The line of input, or NULL if there is none yet.
+ *******************************************************************************/
+static const uint8_t *takeInput(ST_transactionContext_t * const context, const char * const prompt);
+
 /********************************************************************************
  * @brief   This function is used to give the user another try to enter the
- *          correct data. It uses a timeout to limit the number of tries.
+ *          correct data. It uses the tries of the context to limit them.
  * 
- * @return  TRUE if the user wants to try again, FALSE otherwise.
+ * @param   context: Pointer to the transaction context.
+ * @return  STATE_NEEDS_INPUT to ask the user, STATE_FAILED if no tries are left.
+ *******************************************************************************/
+static EN_stateResult_t giveAnotherTry(ST_transactionContext_t * const context);
+
+/********************************************************************************
+ * @brief   Handle the answer to "Try again? (y/n)" if one is expected.
+ * 
+ * @param   context: Pointer to the transaction context.
+ * @return  STATE_DONE to carry on with the current step, STATE_NEEDS_INPUT 
+ *          while waiting for the answer, STATE_FAILED if the user said no.
+ *******************************************************************************/
+static EN_stateResult_t checkAnotherTry(ST_transactionContext_t * const context);
+
+/********************************************************************************
+ * @brief   Go to the next step of the current state with fresh tries.
  *******************************************************************************/
-static BOOL_t giveAnotherTry(void);
+static void nextStep(ST_transactionContext_t * const context);
 
 
 /*-----------------------------------------------------------------------------*/
@@ -41,14 +75,35 @@ static BOOL_t giveAnotherTry(void);
 /*-----------------------------------------------------------------------------*/
 
 /********************************************************************************
- * @brief   Timeout for the user to enter the correct data.
+ * @brief   Maximum number of tries for the user to enter the correct data.
  *******************************************************************************/
-static uint8_t timeout = 0;
+#define MAX_TIMEOUT  3
 
 /********************************************************************************
- * @brief   Maximum number of tries for the user to enter the correct data.
+ * @brief   Print the progress of a transaction if its context is verbose.
  *******************************************************************************/
-#define MAX_TIMEOUT  3
+#define STATE_PRINT(context, ...)   do { if((context)->isVerbose) { printf(__VA_ARGS__); } } while(0)
+
+/********************************************************************************
+ * @brief   Steps of the card state.
+ *******************************************************************************/
+enum {
+    CARD_STEP_NAME,
+    CARD_STEP_EXPIRY_DATE,
+    CARD_STEP_PAN,
+    CARD_STEP_DONE
+};
+
+/********************************************************************************
+ * @brief   Steps of the terminal state.
+ *******************************************************************************/
+enum {
+    TERMINAL_STEP_DATE,
+    TERMINAL_STEP_CHECK_CARD,
+    TERMINAL_STEP_MAX_AMOUNT,
+    TERMINAL_STEP_AMOUNT,
+    TERMINAL_STEP_DONE
+};
 
 
 /*-----------------------------------------------------------------------------*/
@@ -58,9 +113,10 @@ static uint8_t timeout = 0;
 /*-----------------------------------------------------------------------------*/
 
 STATE_MACHINE_t stateMachine[]= {
-    {.state = STATE_MACHINE_CARD    , .name = "STATE_MACHINE_CARD"      , .func = appCard       },
-    {.state = STATE_MACHINE_TERMINAL, .name = "STATE_MACHINE_TERMINAL"  , .func = appTerminal   },
-    {.state = STATE_MACHINE_SERVER  , .name = "STATE_MACHINE_SERVER"    , .func = appServer     },
+    {.state = STATE_MACHINE_CARD    , .name = "STATE_MACHINE_CARD"      , .func = appCard       , .isReentrant = TRUE   },
+    {.state = STATE_MACHINE_TERMINAL, .name = "STATE_MACHINE_TERMINAL"  , .func = appTerminal   , .isReentrant = TRUE   },
+    {.state = STATE_MACHINE_FRAUD   , .name = "STATE_MACHINE_FRAUD"     , .func = appFraud      , .isReentrant = FALSE  },
+    {.state = STATE_MACHINE_SERVER  , .name = "STATE_MACHINE_SERVER"    , .func = appServer     , .isReentrant = FALSE  },
 };
 
 uint8_t countStates = sizeof(stateMachine) / sizeof(stateMachine[0]);
@@ -71,145 +127,350 @@ uint8_t countStates = sizeof(stateMachine) / sizeof(stateMachine[0]);
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
-BOOL_t appCard(ST_transaction_t * const transData) {
-    EN_cardError_t cardError;
+void initTransactionContext(ST_transactionContext_t * const context, const uint32_t terminalId) {
+    ST_transactionContext_t emptyContext = {0};
 
-    /*!< Getting Card Holder Name */
-    timeout = 0;
-    while(1) {
-        cardError = getCardHolderName( &(transData->cardHolderData) );
+    if(NULL == context) {
+        return;
+    }
 
-        if(WRONG_NAME != cardError){
-            printf("Name: %s\n", transData->cardHolderData.cardHolderName);
-            break;
-        }
+    *context = emptyContext;
+    context->transData.terminalData.terminalId = terminalId;
+    context->isVerbose = TRUE;
+    context->status = CONTEXT_RUNNING;
+    context->startTime = time(NULL);
+    context->stateTime = context->startTime;
+    context->isLatencySampled = sampleLatency();
+    context->traceId = newTraceId();
+    countMetric(METRIC_TRANSACTION_STARTED, 0);
+    setTraceId(context->traceId);
+    traceEvent(TRACE_TRANSACTION_START, terminalId);
+}
 
-        printf("Invalid name. (Card Error: %d)\n", cardError);
-        if(FALSE == giveAnotherTry()) {
-            return FALSE;
-        }
+EN_contextStatus_t advanceTransaction(ST_transactionContext_t * const context) {
+    EN_stateResult_t stateResult = STATE_DONE;
+    uint64_t stateTime = 0;
+
+    if(NULL == context) {
+        return CONTEXT_FAILED;
     }
 
+    if( (CONTEXT_DONE == context->status) || (CONTEXT_FAILED == context->status) ) {
+        return context->status;
+    }
 
-    /*!< Getting Card Expiry Date */
-    timeout = 0;
-    while(1) {
-        cardError = getCardExpiryDate( &(transData->cardHolderData) );
-        if(WRONG_EXP_DATE != cardError) {
-            printf("Expiry date: %s\n", transData->cardHolderData.cardExpirationDate);
-            break;
-        }
+    /* Skipping the empty states */
+    while( (context->stateIndex < countStates) && (NULL == stateMachine[context->stateIndex].func) ) {
+        ++(context->stateIndex);
+    }
 
-        printf("Invalid expiry date. (Card Error: %d)\n", cardError);
-        if(FALSE == giveAnotherTry()) {
-            return FALSE;
-        }
+    if(context->stateIndex >= countStates) {
+        context->status = CONTEXT_DONE;
+        countMetric(METRIC_TRANSACTION_FINISHED, 0);
+        return context->status;
     }
 
-    /*!< Getting Card PAN */
-    timeout = 0;
-    while(1) {
-        cardError = getCardPAN( &(transData->cardHolderData) );
-        if(WRONG_PAN != cardError) {
-            printf("PAN: %s\n", transData->cardHolderData.primaryAccountNumber);
+    setLatencySampled(context->isLatencySampled);
+    setTraceId(context->traceId);
+    stateTime = LATENCY_TIME();
+    stateResult = stateMachine[context->stateIndex].func(context);
+    context->stateNanoseconds += LATENCY_TIME() - stateTime;
+
+    /* A state is timed once it is over, across the calls waiting for input */
+    if(STATE_NEEDS_INPUT != stateResult) {
+        LATENCY_RECORD((EN_latencyProbe_t)(LATENCY_STATE_CARD + stateMachine[context->stateIndex].state), context->stateNanoseconds);
+        context->stateNanoseconds = 0;
+    }
+
+    switch(stateResult) {
+        case STATE_NEEDS_INPUT:
+            traceEvent(TRACE_STATE_NEEDS_INPUT, context->stateIndex);
+            context->status = CONTEXT_NEEDS_INPUT;
             break;
-        }
 
-        printf("Invalid PAN. (Card Error: %d)\n", cardError);
-        if(FALSE == giveAnotherTry()) {
-            return FALSE;
-        }
-    } 
+        case STATE_DONE:
+            traceEvent(TRACE_STATE_DONE, context->stateIndex);
+            context->stateTime = time(NULL);
+            context->step = 0;
+            context->tries = 0;
+            ++(context->stateIndex);
+            context->status = (context->stateIndex >= countStates) ? CONTEXT_DONE : CONTEXT_RUNNING;
+            break;
+
+        default:
+            traceEvent(TRACE_STATE_FAILED, context->stateIndex);
+            context->stateTime = time(NULL);
+            context->status = CONTEXT_FAILED;
+            break;
+    }
 
-    return TRUE;
+    if( (CONTEXT_DONE == context->status) || (CONTEXT_FAILED == context->status) ) {
+        countMetric(METRIC_TRANSACTION_FINISHED, 0);
+    }
+
+    return context->status;
 }
 
-BOOL_t appTerminal(ST_transaction_t * const transData) {
-    EN_terminalError_t termError;
+EN_contextStatus_t resumeTransaction(ST_transactionContext_t * const context, const uint8_t * const input) {
 
-    /*!< Getting Transaction Date */
-    timeout = 0;
-    while(1) {
-        termError = getTransactionDate( &(transData->terminalData) );
-        if(WRONG_DATE != termError) {
-            printf("Date: %s\n", transData->terminalData.transactionDate);
-            break;
-        }
+    if(NULL == context) {
+        return CONTEXT_FAILED;
+    }
 
-        printf("Invalid date. (Terminal Error: %d)\n", termError);
-        if(FALSE == giveAnotherTry()) {
-            return FALSE;
-        }
-    } 
+    context->input = input;
+    if(CONTEXT_NEEDS_INPUT == context->status) {
+        context->status = CONTEXT_RUNNING;
+    }
 
-    /*!< Checking if the card is expired */
-    termError = isCardExpired(transData->cardHolderData, transData->terminalData);
-    if(EXPIRED_CARD == termError) {
-        printf("Expired card (Terminal Error: %d)\n", termError);
-        return FALSE;
-    } else {
-        printf("Card is not expired\n");
+    while(CONTEXT_RUNNING == advanceTransaction(context));
+
+    /* The input is only valid during this call */
+    context->input = NULL;
+
+    return context->status;
+}
+
+EN_stateResult_t appCard(ST_transactionContext_t * const context) {
+    ST_transaction_t * const transData = &(context->transData);
+    EN_cardError_t cardError;
+    EN_stateResult_t stateResult;
+    const uint8_t *input = NULL;
+
+    stateResult = checkAnotherTry(context);
+    if(STATE_DONE != stateResult) {
+        return stateResult;
     }
 
-    /*!< Getting Maximum Transaction Amount */
-    timeout = 0;
-    while(1) {
-        termError = setMaxAmount( &(transData->terminalData) );
-        if(INVALID_MAX_AMOUNT != termError) {
-            printf("Maximum amount: %.0f\n", transData->terminalData.maxTransAmount);
-            break;
-        }
+    while(CARD_STEP_DONE != context->step) {
+        switch(context->step) {
+            case CARD_STEP_NAME:        /*!< Getting Card Holder Name */
+                input = takeInput(context, "\nEnter your name (between 20 & 24 characters): ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
+
+                cardError = parseCardHolderName( &(transData->cardHolderData), input );
+                countMetric(METRIC_CARD_RESULT, cardError);
+                if(WRONG_NAME == cardError) {
+                    STATE_PRINT(context, "Invalid name. (Card Error: %d)\n", cardError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "Name: %s\n", transData->cardHolderData.cardHolderName);
+                break;
+
+            case CARD_STEP_EXPIRY_DATE: /*!< Getting Card Expiry Date */
+                input = takeInput(context, "\nEnter card expiry date (5 characters): ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
+
+                cardError = parseCardExpiryDate( &(transData->cardHolderData), input );
+                countMetric(METRIC_CARD_RESULT, cardError);
+                if(WRONG_EXP_DATE == cardError) {
+                    STATE_PRINT(context, "Invalid expiry date. (Card Error: %d)\n", cardError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "Expiry date: %s\n", transData->cardHolderData.cardExpirationDate);
+                break;
+
+            default:                    /*!< Getting Card PAN */
+                input = takeInput(context, "\nEnter your PAN (between 16 & 19 digits): ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
 
-        printf("Invalid maximum amount. (Terminal Error: %d)\n", termError);
-        if(FALSE == giveAnotherTry()) {
-            return FALSE;
+                cardError = parseCardPAN( &(transData->cardHolderData), input );
+                countMetric(METRIC_CARD_RESULT, cardError);
+                if(WRONG_PAN == cardError) {
+                    STATE_PRINT(context, "Invalid PAN. (Card Error: %d)\n", cardError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "PAN: %s\n", transData->cardHolderData.primaryAccountNumber);
+                break;
         }
+
+        nextStep(context);
     }
 
-    /*!< Getting Transaction Amount */
-    timeout = 0;
-    while(1) {
-        termError = getTransactionAmount( &(transData->terminalData) );
-        if(INVALID_AMOUNT != termError) {
-            printf("Amount: %.0f\n", transData->terminalData.transAmount);
+    return STATE_DONE;
+}
+
+EN_stateResult_t appTerminal(ST_transactionContext_t * const context) {
+    ST_transaction_t * const transData = &(context->transData);
+    EN_terminalError_t termError, panError;
+    uint64_t checkTime = 0;
+    EN_stateResult_t stateResult;
+    ST_terminalConfig_t config;
+    const uint8_t *input = NULL;
+
+    stateResult = checkAnotherTry(context);
+    if(STATE_DONE != stateResult) {
+        return stateResult;
+    }
+
+    while(TERMINAL_STEP_DONE != context->step) {
+        switch(context->step) {
+            case TERMINAL_STEP_DATE:        /*!< Getting Transaction Date */
+                input = takeInput(context, "\nEnter Current Date (10 characters): ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
+
+                termError = parseTransactionDate( &(transData->terminalData), input );
+                countMetric(METRIC_TERMINAL_RESULT, termError);
+                if(WRONG_DATE == termError) {
+                    STATE_PRINT(context, "Invalid date. (Terminal Error: %d)\n", termError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "Date: %s\n", transData->terminalData.transactionDate);
+                break;
 
-            /* Validating the required amount   */
-            termError = isBelowMaxAmount( &(transData->terminalData) );
-            if(EXCEED_MAX_AMOUNT == termError) {
-                printf("Exceeds maximum amount. (termError %d)\n", termError);
-                if(FALSE == giveAnotherTry()) {
-                    return FALSE;
+            case TERMINAL_STEP_CHECK_CARD:
+                /*!< Checking if the card is expired, then its PAN (Luhn) before any server work */
+                checkTime = LATENCY_TIME();
+                termError = isCardExpired( &(transData->cardHolderData), &(transData->terminalData) );
+                panError = (EXPIRED_CARD == termError) ? TERMINAL_OK : isValidCardPAN( &(transData->cardHolderData) );
+                LATENCY_RECORD(LATENCY_TERMINAL_CHECK_CARD, LATENCY_TIME() - checkTime);
+                countMetric(METRIC_TERMINAL_RESULT, termError);
+                if(EXPIRED_CARD != termError) {
+                    countMetric(METRIC_TERMINAL_RESULT, panError);
+                }
+
+                if(EXPIRED_CARD == termError) {
+                    STATE_PRINT(context, "Expired card (Terminal Error: %d)\n", termError);
+                    return STATE_FAILED;
                 } else {
-                    timeout = 0;
-                    continue;
+                    STATE_PRINT(context, "Card is not expired\n");
+                }
+
+                termError = panError;
+                if(INVALID_CARD == termError) {
+                    STATE_PRINT(context, "Invalid card number (Terminal Error: %d)\n", termError);
+                    return STATE_FAILED;
                 }
-            } else {                
-                printf("Below max amount\n");
                 break;
-            }
-        } else {    /* Invalid amount */
-            printf("Invalid amount. (Terminal Error: %d)\n", termError);
-            if(FALSE == giveAnotherTry()) {
-                return FALSE;
-            }
+
+            case TERMINAL_STEP_MAX_AMOUNT:  /*!< Getting Maximum Transaction Amount */
+                /* Configured terminals are not asked, their amounts are in their currency */
+                if(TERMINAL_OK == getTerminalConfig(transData->terminalData.terminalId, &config)) {
+                    transData->terminalData.maxTransAmount = config.maxTransAmount;
+                    transData->terminalData.currency = config.currency;
+                    break;
+                }
+
+                input = takeInput(context, "\nEnter the maximum amount: ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
+
+                termError = parseMaxAmount( &(transData->terminalData), input );
+                countMetric(METRIC_TERMINAL_RESULT, termError);
+                if(INVALID_MAX_AMOUNT == termError) {
+                    STATE_PRINT(context, "Invalid maximum amount. (Terminal Error: %d)\n", termError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "Maximum amount: %.0f\n", transData->terminalData.maxTransAmount);
+                break;
+
+            default:                        /*!< Getting Transaction Amount */
+                input = takeInput(context, "\nEnter the required amount: ");
+                if(NULL == input) {
+                    return STATE_NEEDS_INPUT;
+                }
+
+                checkTime = LATENCY_TIME();
+                termError = parseTransactionAmount( &(transData->terminalData), input );
+                if(TERMINAL_OK == termError) {
+                    termError = isBelowMaxAmount( &(transData->terminalData) );
+                }
+                LATENCY_RECORD(LATENCY_TERMINAL_CHECK_AMOUNT, LATENCY_TIME() - checkTime);
+                countMetric(METRIC_TERMINAL_RESULT, termError);
+
+                if(INVALID_AMOUNT == termError) {
+                    STATE_PRINT(context, "Invalid amount. (Terminal Error: %d)\n", termError);
+                    return giveAnotherTry(context);
+                }
+
+                STATE_PRINT(context, "Amount: %.0f\n", transData->terminalData.transAmount);
+
+                /* Validating the required amount, a lower amount may be tried any number of times */
+                if(EXCEED_MAX_AMOUNT == termError) {
+                    STATE_PRINT(context, "Exceeds maximum amount. (termError %d)\n", termError);
+                    stateResult = giveAnotherTry(context);
+                    if(STATE_FAILED != stateResult) {
+                        context->tries = 0;
+                    }
+                    return stateResult;
+                }
+
+                STATE_PRINT(context, "Below max amount\n");
+                break;
         }
-    } 
 
-    return TRUE;
+        nextStep(context);
+    }
+
+    return STATE_DONE;
 }
 
-BOOL_t appServer(ST_transaction_t * const transData) {
+EN_stateResult_t appFraud(ST_transactionContext_t * const context) {
+    ST_transaction_t * const transData = &(context->transData);
+    uint8_t score = 0;
+
+    score = scoreTransaction(transData, (int64_t)time(NULL));
+    traceEvent(TRACE_FRAUD_SCORE, score);
+
+    /* Declined, the server state saves it: the server module runs in one state at a time */
+    if(score >= FRAUD_DECLINE_SCORE) {
+        transData->transState = DECLINED_SUSPECTED_FRAUD;
+        logEvent(LOG_DECLINED_FRAUD, score, 0);
+    }
+
+    return STATE_DONE;
+}
+
+EN_stateResult_t appServer(ST_transactionContext_t * const context) {
+    ST_transaction_t * const transData = &(context->transData);
     EN_transState_t transactionError;
+    EN_terminalError_t termError;
+
+    /*!< Transactions declined by the fraud scoring are saved like the server declines */
+    if(DECLINED_SUSPECTED_FRAUD == transData->transState) {
+        saveDeclinedTransaction(transData);
+        return STATE_FAILED;
+    }
 
-    transactionError = recieveTransactionData(transData);
+    /*!< Cards of no known issuer are declined before any server work */
+    if(ROUTE_NOT_FOUND == getCardRoute( &(transData->cardHolderData) )) {
+        logEvent(LOG_NO_ROUTE, 0, 0);
+        return STATE_FAILED;
+    }
+
+    /*!< Small amounts are approved by the terminal, the server gets them later */
+    termError = approveOffline(transData);
+    countMetric(METRIC_TERMINAL_RESULT, termError);
+    traceEvent(TRACE_OFFLINE_RESULT, termError);
+    if(TERMINAL_OK == termError) {
+        countMetric(METRIC_TRANS_STATE, APPROVED);
+        logEvent(LOG_APPROVED_OFFLINE, transData->terminalData.transAmount, 0);
+        return STATE_DONE;
+    }
+
+    /*!< The shard owning the account authorizes it, this process without shards */
+    transactionError = routeTransaction(transData);
     if(APPROVED == transactionError) {
-        printf("Approved Transaction of: %.0f\n", transData->terminalData.transAmount);
+        logEvent(LOG_APPROVED, transData->terminalData.transAmount, 0);
     } else {
-        printf("Disapproved transsaction. (Transaction Error %d)\n", transactionError);
-        return FALSE;
+        logEvent(LOG_DECLINED, transactionError, 0);
+        return STATE_FAILED;
     }
 
-    return TRUE;
+    return STATE_DONE;
 }
 
 /*-----------------------------------------------------------------------------*/
@@ -218,20 +479,47 @@ BOOL_t appServer(ST_transaction_t * const transData) {
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
-static BOOL_t giveAnotherTry(void) {
-    char tryAgain = 1;
+static const uint8_t *takeInput(ST_transactionContext_t * const context, const char * const prompt) {
+    const uint8_t *input = context->input;
+
+    context->input = NULL;
+    context->prompt = (NULL == input) ? prompt : NULL;
 
-    ++timeout;
-    if(timeout >= MAX_TIMEOUT) {
-        printf("Exceeded number of tries\n");
-        timeout = 0;
-        return FALSE;
+    return input;
+}
+
+static EN_stateResult_t giveAnotherTry(ST_transactionContext_t * const context) {
+
+    ++(context->tries);
+    if(context->tries >= MAX_TIMEOUT) {
+        STATE_PRINT(context, "Exceeded number of tries\n");
+        context->tries = 0;
+        return STATE_FAILED;
     }    
 
-    printf("\nTry again? (y/n): ");
-    scanf(" %c%*c", &tryAgain);
-    tryAgain = toupper(tryAgain);
+    context->isAskingTryAgain = TRUE;
 
-    return ('Y' == tryAgain) ? TRUE : FALSE;
+    return checkAnotherTry(context);
 }
 
+static EN_stateResult_t checkAnotherTry(ST_transactionContext_t * const context) {
+    const uint8_t *input = NULL;
+
+    if( !context->isAskingTryAgain ) {
+        return STATE_DONE;
+    }
+
+    input = takeInput(context, "\nTry again? (y/n): ");
+    if(NULL == input) {
+        return STATE_NEEDS_INPUT;
+    }
+
+    context->isAskingTryAgain = FALSE;
+
+    return ('Y' == toupper(input[0])) ? STATE_DONE : STATE_FAILED;
+}
+
+static void nextStep(ST_transactionContext_t * const context) {
+    ++(context->step);
+    context->tries = 0;
+}
@@ -25,16 +25,61 @@
 typedef enum SYSTEM_STATE_t {
     STATE_MACHINE_CARD,             /*!< State to get the card data. */
     STATE_MACHINE_TERMINAL,         /*!< State to get the terminal data and process it */  
+    STATE_MACHINE_FRAUD,            /*!< State to score the transaction against the card history */
     STATE_MACHINE_SERVER,           /*!< State to get the server data and process it */
 } SYSTEM_STATE_t;
 
+/********************************************************************************
+ * @brief   Enum for the result of one call to a state function.
+ *******************************************************************************/
+typedef enum EN_stateResult_t {
+    STATE_DONE,                     /*!< The state executed successfully. */
+    STATE_NEEDS_INPUT,              /*!< The state waits for a line of input, see context->prompt. */
+    STATE_FAILED                    /*!< The state failed, the transaction is over. */
+} EN_stateResult_t;
+
+/********************************************************************************
+ * @brief   Enum for the progress of a transaction in the state machine.
+ *******************************************************************************/
+typedef enum EN_contextStatus_t {
+    CONTEXT_RUNNING,                /*!< States are left to execute. */
+    CONTEXT_NEEDS_INPUT,            /*!< The current state waits for a line of input. */
+    CONTEXT_DONE,                   /*!< All the states executed successfully. */
+    CONTEXT_FAILED                  /*!< A state failed, the transaction is over. */
+} EN_contextStatus_t;
+
+/********************************************************************************
+ * @brief   Struct holding everything a transaction needs to go through the
+ *          state machine, so many transactions can advance independently.
+ * @details A state needing input returns STATE_NEEDS_INPUT and records in
+ *          \p step where to continue, it is called again with the input once
+ *          it arrives.
+ *******************************************************************************/
+typedef struct ST_transactionContext_t {
+    ST_transaction_t transData;     /*!< Data of the transaction. */
+    uint8_t stateIndex;             /*!< Index in stateMachine[] of the next state to execute. */
+    uint8_t step;                   /*!< Step to continue from inside the current state. */
+    uint8_t tries;                  /*!< Tries already used to enter the current input. */
+    BOOL_t isAskingTryAgain;        /*!< The pending input answers "Try again? (y/n)". */
+    BOOL_t isVerbose;               /*!< The states print their progress to stdout. */
+    EN_contextStatus_t status;      /*!< Progress of the transaction. */
+    const uint8_t *input;           /*!< Line of input not consumed yet, NULL if none. */
+    const char *prompt;             /*!< What the current state waits for. */
+    time_t startTime;               /*!< Time the transaction started. */
+    time_t stateTime;               /*!< Time the last state finished executing. */
+    BOOL_t isLatencySampled;        /*!< The states of the transaction are timed. */
+    uint64_t stateNanoseconds;      /*!< Time spent executing the current state, without waiting for input. */
+    uint64_t traceId;               /*!< ID tagging the events of the transaction in the flight recorder. */
+} ST_transactionContext_t;
+
 /********************************************************************************
  * @brief   Struct for the state machine.
  *******************************************************************************/
 typedef struct STATE_MACHINE_t {
     char *name;                     /*!< Name of the state. */
     SYSTEM_STATE_t state;           /*!< State of the state machine. */
-    BOOL_t (*func)(ST_transaction_t * const transData);    /*!< Function pointer to the state function. */
+    EN_stateResult_t (*func)(ST_transactionContext_t * const context);    /*!< Function pointer to the state function. */
+    BOOL_t isReentrant;             /*!< The state may run for many transactions at once (no global data). */
 } STATE_MACHINE_t;
 
 /*-----------------------------------------------------------------------------*/
@@ -61,39 +106,81 @@ extern uint8_t countStates;
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
+/********************************************************************************
+ * @brief       Prepare a context for a new transaction on a terminal.
+ * 
+ * @param[out]  context: Pointer to the transaction context.
+ * @param[in]   terminalId: ID of the terminal running the transaction.
+ *******************************************************************************/
+void initTransactionContext(ST_transactionContext_t * const context, const uint32_t terminalId);
+
+/********************************************************************************
+ * @brief       Execute the next state of a transaction, or continue the current
+ *              one if it waits for input.
+ * 
+ * @param[in,out] context: Pointer to the transaction context.
+ * @return      EN_contextStatus_t: Progress of the transaction after the state.
+ *              On failure, context->stateIndex is the failed state.
+ *******************************************************************************/
+EN_contextStatus_t advanceTransaction(ST_transactionContext_t * const context);
+
+/********************************************************************************
+ * @brief       Give a line of input to a transaction and run it until it needs
+ *              more input, or is over. Never blocks.
+ * 
+ * @param[in,out] context: Pointer to the transaction context.
+ * @param[in]   input: Null terminated line without newline, or NULL to run the
+ *              transaction until its first input. Must stay valid until the
+ *              call returns.
+ * @return      EN_contextStatus_t: CONTEXT_NEEDS_INPUT (context->prompt tells
+ *              what is expected), CONTEXT_DONE or CONTEXT_FAILED.
+ *******************************************************************************/
+EN_contextStatus_t resumeTransaction(ST_transactionContext_t * const context, const uint8_t * const input);
+
 /********************************************************************************
  * @brief       Function used in state machine to process the card data.
  * 
- * @param[out]  transData: Pointer to the transaction data.
- * @return      BOOL_t: TRUE if the state was executed successfully, 
- *                      FALSE otherwise.
+ * @param[in,out] context: Pointer to the transaction context.
+ * @return      EN_stateResult_t: STATE_DONE, STATE_NEEDS_INPUT or STATE_FAILED.
  * @warning     This function must be called from the state machine only.
  *******************************************************************************/
-BOOL_t appCard(ST_transaction_t * const transData);
+EN_stateResult_t appCard(ST_transactionContext_t * const context);
 
 /********************************************************************************
  * @brief       Function used in state machine to process the terminal data.
  * 
- * @param[out]  transData: Pointer to the transaction data.
- * @return      BOOL_t: TRUE if the state was executed successfully, 
- *                      FALSE otherwise.
+ * @param[in,out] context: Pointer to the transaction context.
+ * @return      EN_stateResult_t: STATE_DONE, STATE_NEEDS_INPUT or STATE_FAILED.
  * @warning     This function must be called only after the card data has been
  *              processed.
  * @warning     This function must be called from the state machine only.
  *******************************************************************************/
-BOOL_t appTerminal(ST_transaction_t * const transData);
+EN_stateResult_t appTerminal(ST_transactionContext_t * const context);
+
+/********************************************************************************
+ * @brief       Function used in state machine to decline transactions that do
+ *              not look like the usual ones of their card.
+ * 
+ * @details     A declined transaction goes on to the server state, which saves
+ *              it and fails.
+ * @param[in,out] context: Pointer to the transaction context.
+ * @return      EN_stateResult_t: STATE_DONE.
+ * @warning     This function must be called only after the card and terminal
+ *              states have been executed.
+ * @warning     This function must be called from the state machine only.
+ *******************************************************************************/
+EN_stateResult_t appFraud(ST_transactionContext_t * const context);
 
 /********************************************************************************
  * @brief       Function used in state machine to process the server data.
  * 
- * @param[out]  transData: Pointer to the transaction data.
- * @return      BOOL_t: TRUE if the state was executed successfully, 
- *                      FALSE otherwise.
+ * @param[in,out] context: Pointer to the transaction context.
+ * @return      EN_stateResult_t: STATE_DONE, STATE_NEEDS_INPUT or STATE_FAILED.
  * @warning     This function must be called only after the card and terminal
  *              states have been executed.
  * @warning     This function must be called from the state machine only.
  *******************************************************************************/
-BOOL_t appServer(ST_transaction_t * const transData);
+EN_stateResult_t appServer(ST_transactionContext_t * const context);
 
 
 #endif      /* STATE_H */
\ No newline at end of file
@@ -17,6 +17,16 @@
 #include "../macros.h"
 #include "card.h"
 
+/********************************************************************************
+ * @brief   Size of the buffer used to read a line typed by the user
+ ********************************************************************************/
+#define CARD_INPUT_LINE_SIZE    64
+
+/********************************************************************************
+ * @brief   Stream the user input is read from, NULL for stdin
+ ********************************************************************************/
+static FILE *inputStream = NULL;
+
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
 /*                      PRIVATE FUNCTION DECLARATIONS                          */
@@ -26,6 +36,7 @@
 static BOOL_t isPanValid(const ST_cardData_t * const cardData);
 static BOOL_t isValidExpirationFormat(const ST_cardData_t * const cardData);
 static BOOL_t isValidExpirationDate(const ST_cardData_t * const cardData);
+static BOOL_t readInputLine(uint8_t * const line, const uint8_t size);
 
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
@@ -33,10 +44,12 @@ static BOOL_t isValidExpirationDate(const ST_cardData_t * const cardData);
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
+void setCardInputStream(FILE * const stream) {
+    inputStream = stream;
+}
 
 EN_cardError_t getCardHolderName(ST_cardData_t * const cardData) {
-    uint8_t length = 0;
-    BOOL_t  isValidLength = TRUE;
+    uint8_t line[CARD_INPUT_LINE_SIZE];
 
     if(NULL == cardData) {
         return WRONG_NAME;
@@ -44,26 +57,59 @@ EN_cardError_t getCardHolderName(ST_cardData_t * const cardData) {
 
     /* Getting Name  */
     printf("\nEnter your name (between 20 & 24 characters): ");
-    fgets((char *) (cardData->cardHolderName), sizeof(cardData->cardHolderName), stdin);
+    if( !readInputLine(line, sizeof(line)) ) {
+        cardData->cardHolderName[0] = '\0';
+        return WRONG_NAME;
+    }
 
-    length = strlen((char *) (cardData->cardHolderName) );
-    if( length && ('\n' == cardData->cardHolderName[length - 1]) ) {
-        length--;
-        cardData->cardHolderName[length] = '\0';
-    } else if(length && ('\n' != getchar()) ) {
-        /* Flush stdin */
-        while('\n' != getchar());   
+    return parseCardHolderName(cardData, line);
+}
 
-        /* Setting the first character to '\0' */
-        cardData->cardHolderName[0] = '\0';
+EN_cardError_t getCardExpiryDate(ST_cardData_t * const cardData) {
+    uint8_t line[CARD_INPUT_LINE_SIZE];
+
+    if(NULL == cardData) {
+        return WRONG_EXP_DATE;
+    }
 
-        /* Returning error */
+    /* Getting Expiration date  */
+    printf("\nEnter card expiry date (5 characters): ");
+    if( !readInputLine(line, sizeof(line)) ) {
+        cardData->cardExpirationDate[0] = '\0';
+        cardData->expiryMonths = 0;
+        return WRONG_EXP_DATE;
+    }
+
+    return parseCardExpiryDate(cardData, line);
+}
+
+EN_cardError_t getCardPAN(ST_cardData_t * const cardData) {
+    uint8_t line[CARD_INPUT_LINE_SIZE];
+
+    if(NULL == cardData) {
+        return WRONG_PAN;
+    }
+
+    /* Getting PAN  */
+    printf("\nEnter your PAN (between 16 & 19 digits): ");
+    if( !readInputLine(line, sizeof(line)) ) {
+        cardData->primaryAccountNumber[0] = '\0';
+        return WRONG_PAN;
+    }
+
+    return parseCardPAN(cardData, line);
+}
+
+EN_cardError_t parseCardHolderName(ST_cardData_t * const cardData, const uint8_t * const input) {
+    size_t length = 0;
+    BOOL_t isValidLength = TRUE;
+
+    if( (NULL == cardData) || (NULL == input) ) {
         return WRONG_NAME;
-    } else {
-        /* Do nothing */
     }
 
     /* Checking the length */
+    length = strlen((const char *)input);
     isValidLength = (length >= 20) && (length <= 24);
     if(!isValidLength) {
         /* Setting the first character to '\0' */
@@ -71,6 +117,8 @@ EN_cardError_t getCardHolderName(ST_cardData_t * const cardData) {
         return WRONG_NAME;
     }
 
+    memcpy(cardData->cardHolderName, input, length + 1);
+
     /* Checking if the name is all alphabetic */
     while(length) {
         if( (!isalpha(cardData->cardHolderName[length - 1])) && (!isspace(cardData->cardHolderName[length - 1])) ) {
@@ -84,81 +132,51 @@ EN_cardError_t getCardHolderName(ST_cardData_t * const cardData) {
     return CARD_OK;
 }
 
-EN_cardError_t getCardExpiryDate(ST_cardData_t * const cardData) {
-    uint8_t length = 0;
-    BOOL_t isValidLength = TRUE;
+EN_cardError_t parseCardExpiryDate(ST_cardData_t * const cardData, const uint8_t * const input) {
 
-    if(NULL == cardData) {
+    if( (NULL == cardData) || (NULL == input) ) {
         return WRONG_EXP_DATE;
     }
 
-    /* Getting Expiration date  */
-    printf("\nEnter card expiry date (5 characters): ");
-    fgets((char *) (cardData->cardExpirationDate), sizeof(cardData->cardExpirationDate), stdin);    
-    length = strlen((char *) (cardData->cardExpirationDate) );
-    isValidLength = ( (sizeof(cardData->cardExpirationDate) - 1) == length);
-
-    if(length && ('\n' == cardData->cardExpirationDate[length - 1]) ) {
-        isValidLength = FALSE;
-    } else {
-        if(isValidLength && ('\n' == getchar()) ) {
-            isValidLength = TRUE;
-        } else {
-            isValidLength = FALSE;
-
-            /* Flush stdin */
-            while('\n' != getchar());  
-
-            /* Setting the first character to '\0' */
-            cardData->cardExpirationDate[0] = '\0';
-        }
-    }
-
-    if( !isValidLength ) {
+    /* Checking the length */
+    if( (sizeof(cardData->cardExpirationDate) - 1) != strlen((const char *)input) ) {
+        /* Setting the first character to '\0' */
+        cardData->cardExpirationDate[0] = '\0';
+        cardData->expiryMonths = 0;
         return WRONG_EXP_DATE;
     }
-    
+
+    memcpy(cardData->cardExpirationDate, input, sizeof(cardData->cardExpirationDate));
+    cardData->expiryMonths = 0;
+
     /* Validate the format */
     if( !isValidExpirationDate(cardData) ) {
         printf("InValid Expiry Date\n");
         return WRONG_EXP_DATE;
     }
 
+    /* Encoding the date once for the later expiry checks */
+    cardData->expiryMonths = (uint16_t)getCardExpiryMonths(cardData);
+
     return CARD_OK;
 }
 
-EN_cardError_t getCardPAN(ST_cardData_t * const cardData) {
-    uint8_t length = 0;
+EN_cardError_t parseCardPAN(ST_cardData_t * const cardData, const uint8_t * const input) {
+    size_t length = 0;
 
-    if(NULL == cardData) {
+    if( (NULL == cardData) || (NULL == input) ) {
         return WRONG_PAN;
     }
 
-    /* Getting Name  */
-    printf("\nEnter your PAN (between 16 & 19 digits): ");
-    fgets((char *) (cardData->primaryAccountNumber), sizeof(cardData->primaryAccountNumber), stdin);    
-    
-    length = strlen((char *) (cardData->primaryAccountNumber) );
-    if(length) {
-        /* Removing Newline */
-        if('\n' == cardData->primaryAccountNumber[length - 1]) {
-            length--;
-            cardData->primaryAccountNumber[length] = '\0';
-        } else if('\n' != getchar()) {
-            /* Flush stdin */
-            while('\n' != getchar());   
-
-            /* Setting the first character to '\0' */
-            cardData->primaryAccountNumber[0] = '\0';
-
-            /* Returning error */
-            return WRONG_PAN;
-        } else {
-            /* Do nothing   */
-        }
-        
+    length = strlen((const char *)input);
+    if(length >= sizeof(cardData->primaryAccountNumber)) {
+        /* Setting the first character to '\0' */
+        cardData->primaryAccountNumber[0] = '\0';
+        return WRONG_PAN;
     }
 
+    memcpy(cardData->primaryAccountNumber, input, length + 1);
+
     if(!isPanValid(cardData)) {
         return WRONG_PAN;
     }
@@ -206,6 +224,22 @@ int8_t getCardExpiryMonth(const ST_cardData_t * const cardData) {
     return month;
 }
 
+int16_t getCardExpiryMonths(const ST_cardData_t * const cardData) {
+    int8_t month = 0, year = 0;
+
+    if(NULL == cardData) {
+        return -1;
+    }
+
+    month = getCardExpiryMonth(cardData);
+    year = getCardExpiryYear(cardData);
+    if( (-1 == month) || (-1 == year) ) {
+        return -1;
+    }
+
+    return (int16_t)(year * 12 + month - 1);
+}
+
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
 /*                             PRIVATE FUNCTION DEFINITIONS                    */
@@ -310,3 +344,36 @@ static BOOL_t isPanValid(const ST_cardData_t * const cardData) {
     return TRUE;
 }
 
+/********************************************************************************
+ * @brief       Read a line from the input stream without its newline
+ * 
+ * @param[out]  line: Buffer receiving the null terminated line
+ * @param[in]   size: Size of the buffer
+ * @return      BOOL_t: TRUE if a whole line was read, FALSE on end of input or
+ *              if the line was too long (the rest of it is then flushed)
+ *******************************************************************************/
+static BOOL_t readInputLine(uint8_t * const line, const uint8_t size) {
+    FILE * const stream = (NULL == inputStream) ? stdin : inputStream;
+    size_t length = 0;
+    int character = 0;
+
+    if(NULL == fgets((char *)line, size, stream)) {
+        line[0] = '\0';
+        return FALSE;
+    }
+
+    length = strlen((char *)line);
+    if( length && ('\n' == line[length - 1]) ) {
+        line[length - 1] = '\0';
+        return TRUE;
+    }
+
+    /* Flush the rest of the line */
+    do {
+        character = getc(stream);
+    } while( ('\n' != character) && (EOF != character) );
+
+    line[0] = '\0';
+
+    return FALSE;
+}
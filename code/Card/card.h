@@ -20,13 +20,22 @@
 /*                                                                             */
 /*-----------------------------------------------------------------------------*/
 
+/********************************************************************************
+ * @brief   Base year of the card expiry encoding, MM/YY means 20YY.
+ ********************************************************************************/
+#define CARD_EXPIRY_BASE_YEAR   2000
+
 /********************************************************************************
  * @brief   This struct contains the card data.
+ * @details expiryMonths caches cardExpirationDate, it is kept by the card
+ *          setters. Code writing cardExpirationDate directly must reset it to
+ *          0 or encode it again, \ref isCardExpired trusts it when not 0.
  ********************************************************************************/
 typedef struct ST_cardData_t {
     uint8_t cardHolderName[25];
     uint8_t primaryAccountNumber[20];
     uint8_t cardExpirationDate[6];
+    uint16_t expiryMonths;          /*!< Expiry date as months since 01/2000, see \ref getCardExpiryMonths */
 } ST_cardData_t;
 
 /********************************************************************************
@@ -46,10 +55,48 @@ typedef enum EN_cardError_t {
 /*                                                                              */
 /*------------------------------------------------------------------------------*/
 
+/********************************************************************************
+ * @brief       Set the stream the get* functions read the user input from.
+ *
+ * @param[in]   stream: Input stream, NULL for stdin
+ *******************************************************************************/
+void setCardInputStream(FILE * const stream);
+
 EN_cardError_t getCardHolderName(ST_cardData_t * const cardData);
 EN_cardError_t getCardExpiryDate(ST_cardData_t * const cardData);
 EN_cardError_t getCardPAN(ST_cardData_t * const cardData);
 
+/********************************************************************************
+ * @brief       Validate and store a card holder name already read from the user.
+ * 
+ * @details     \ref getCardHolderName reads the name from stdin then calls this
+ *              function, callers getting their input elsewhere call it directly.
+ * @param[out]  cardData: Pointer to the cardData structure
+ * @param[in]   input: Null terminated name, without newline
+ * @return      EN_cardError_t: CARD_OK or WRONG_NAME
+ *******************************************************************************/
+EN_cardError_t parseCardHolderName(ST_cardData_t * const cardData, const uint8_t * const input);
+
+/********************************************************************************
+ * @brief       Validate and store a card expiry date (MM/YY) already read from 
+ *              the user, see \ref parseCardHolderName.
+ * 
+ * @param[out]  cardData: Pointer to the cardData structure
+ * @param[in]   input: Null terminated expiry date, without newline
+ * @return      EN_cardError_t: CARD_OK or WRONG_EXP_DATE
+ *******************************************************************************/
+EN_cardError_t parseCardExpiryDate(ST_cardData_t * const cardData, const uint8_t * const input);
+
+/********************************************************************************
+ * @brief       Validate and store a PAN already read from the user, see 
+ *              \ref parseCardHolderName.
+ * 
+ * @param[out]  cardData: Pointer to the cardData structure
+ * @param[in]   input: Null terminated PAN, without newline
+ * @return      EN_cardError_t: CARD_OK or WRONG_PAN
+ *******************************************************************************/
+EN_cardError_t parseCardPAN(ST_cardData_t * const cardData, const uint8_t * const input);
+
 /********************************************************************************
  * @brief       Get the Card Expiry Year object in the cardData
  * 
@@ -70,4 +117,17 @@ int8_t getCardExpiryYear(const ST_cardData_t * const cardData);
  *******************************************************************************/
 int8_t getCardExpiryMonth(const ST_cardData_t * const cardData);
 
+/********************************************************************************
+ * @brief       Get the Card Expiry date encoded as months since 01/2000
+ * 
+ * @details     This is the encoding stored in cardData->expiryMonths by
+ *              \ref getCardExpiryDate. Cards filled by other means can store
+ *              it themselves once.
+ * @param[in]   cardData: Pointer to the cardData structure
+ * @return      int16_t: Encoded expiry date:
+ *              -1: Error
+ *              YY * 12 + MM - 1
+ *******************************************************************************/
+int16_t getCardExpiryMonths(const ST_cardData_t * const cardData);
+
 #endif      /* CARD_H */
\ No newline at end of file
@@ -0,0 +1,387 @@
+/********************************************************************************
+ * @file    latency.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the implementation of the latency histograms
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../macros.h"
+#include "slots.h"
+#include "latency.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#define CACHE_LINE_SIZE             64
+
+/*!< Buckets per power of 2, latencies below twice this are exact */
+#define LATENCY_SUB_BUCKET_BITS     5
+#define LATENCY_SUB_BUCKET_COUNT    (1u << LATENCY_SUB_BUCKET_BITS)
+
+/*!< Latencies from 2^LATENCY_MAX_BITS ns (about 18 minutes) go to the last bucket */
+#define LATENCY_MAX_BITS            40
+#define LATENCY_BUCKET_COUNT        ((LATENCY_MAX_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKET_COUNT)
+
+/*!< Time the summary thread sleeps between two checks of the stop request */
+#define LATENCY_SUMMARY_TICK_NS     100000000
+
+/*!< Histograms of one thread, only written by it, padded to whole cache lines */
+typedef struct ST_latencyHistograms_t {
+    uint64_t counts[LATENCY_PROBE_COUNT][LATENCY_BUCKET_COUNT];
+    uint64_t sums[LATENCY_PROBE_COUNT];
+    uint64_t maxima[LATENCY_PROBE_COUNT];
+} __attribute__((aligned(CACHE_LINE_SIZE))) ST_latencyHistograms_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static const char * const probeNames[LATENCY_PROBE_COUNT] = {
+    [LATENCY_STATE_CARD]            = "state card",
+    [LATENCY_STATE_TERMINAL]        = "state terminal",
+    [LATENCY_STATE_FRAUD]           = "state fraud",
+    [LATENCY_STATE_SERVER]          = "state server",
+    [LATENCY_TERMINAL_CHECK_CARD]   = "terminal check card",
+    [LATENCY_TERMINAL_CHECK_AMOUNT] = "terminal check amount",
+    [LATENCY_SERVER_ACCOUNT_LOOKUP] = "server account lookup",
+    [LATENCY_SERVER_BALANCE_CHECK]  = "server balance check",
+    [LATENCY_SERVER_SAVE]           = "server save",
+    [LATENCY_SERVER_BALANCE_UPDATE] = "server balance update",
+    [LATENCY_SERVER_REPLICATION]    = "server replication",
+};
+
+static ST_threadSlots_t histograms = {.name = "latency", .maxCount = LATENCY_MAX_THREADS};
+
+__thread BOOL_t isLatencySampled = FALSE;
+
+static __thread ST_latencyHistograms_t *threadHistograms = NULL;
+static __thread BOOL_t isThreadHistogramsTaken = FALSE;
+static __thread uint32_t transactionsCount = 0;
+
+static BOOL_t isSummaryRunning = FALSE;
+static FILE *summaryFile = NULL;
+static uint32_t summaryPeriodSeconds = 0;
+static pthread_t summaryThread;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_latencyHistograms_t *getThreadHistograms(void);
+static uint32_t getBucketIndex(const uint64_t nanoseconds);
+static uint64_t getBucketValue(const uint32_t index);
+static void writeSummary(void);
+static void *summaryWorker(void *argument);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+uint64_t getLatencyTime(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void recordLatency(const EN_latencyProbe_t probe, const uint64_t nanoseconds) {
+    ST_latencyHistograms_t *threadData = NULL;
+    uint64_t *count = NULL;
+
+    if((uint32_t)probe >= LATENCY_PROBE_COUNT) {
+        return;
+    }
+
+    threadData = getThreadHistograms();
+    if(NULL == threadData) {
+        return;
+    }
+
+    /* Only this thread writes, atomic stores are enough for the readers */
+    count = &(threadData->counts[probe][getBucketIndex(nanoseconds)]);
+    __atomic_store_n(count, *count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&(threadData->sums[probe]), threadData->sums[probe] + nanoseconds, __ATOMIC_RELAXED);
+    if(nanoseconds > threadData->maxima[probe]) {
+        __atomic_store_n(&(threadData->maxima[probe]), nanoseconds, __ATOMIC_RELAXED);
+    }
+}
+
+uint64_t recordLatencySince(const EN_latencyProbe_t probe, const uint64_t startTime) {
+    uint64_t now = getLatencyTime();
+
+    recordLatency(probe, now - startTime);
+
+    return now;
+}
+
+BOOL_t sampleLatency(void) {
+
+    if(!LATENCY_ENABLED) {
+        return FALSE;
+    }
+
+    return (0 == (transactionsCount++ % LATENCY_SAMPLE_PERIOD));
+}
+
+void setLatencySampled(const BOOL_t isSampled) {
+    isLatencySampled = isSampled;
+}
+
+void getLatencyStats(const EN_latencyProbe_t probe, ST_latencyStats_t * const stats) {
+    static const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t counts[LATENCY_BUCKET_COUNT] = {0};
+    uint64_t *percentiles[4];
+    ST_latencyHistograms_t *threadData = NULL;
+    uint64_t sum = 0, max = 0, total = 0, seen = 0;
+    uint32_t i = 0, bucket = 0, quantile = 0, threadCount = 0;
+
+    if(NULL == stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if((uint32_t)probe >= LATENCY_PROBE_COUNT) {
+        return;
+    }
+
+    threadCount = getThreadSlotsCount(&histograms);
+
+    /* Adding up the histograms of every thread */
+    for(i = 0; i < threadCount; ++i) {
+        threadData = getThreadSlot(&histograms, i);
+        if(NULL == threadData) {
+            continue;
+        }
+
+        for(bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket) {
+            counts[bucket] += __atomic_load_n(&(threadData->counts[probe][bucket]), __ATOMIC_RELAXED);
+        }
+        sum += __atomic_load_n(&(threadData->sums[probe]), __ATOMIC_RELAXED);
+        if(__atomic_load_n(&(threadData->maxima[probe]), __ATOMIC_RELAXED) > max) {
+            max = __atomic_load_n(&(threadData->maxima[probe]), __ATOMIC_RELAXED);
+        }
+    }
+
+    for(bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket) {
+        total += counts[bucket];
+    }
+    if(0 == total) {
+        return;
+    }
+
+    stats->count = total;
+    stats->mean  = (double)sum / total;
+    stats->max   = max;
+
+    percentiles[0] = &(stats->p50);
+    percentiles[1] = &(stats->p90);
+    percentiles[2] = &(stats->p99);
+    percentiles[3] = &(stats->p999);
+
+    /* One pass over the buckets for every percentile */
+    for(bucket = 0; (bucket < LATENCY_BUCKET_COUNT) && (quantile < 4); ++bucket) {
+        seen += counts[bucket];
+        while( (quantile < 4) && ((double)seen >= quantiles[quantile] * total) ) {
+            *percentiles[quantile] = (getBucketValue(bucket) < max) ? getBucketValue(bucket) : max;
+            ++quantile;
+        }
+    }
+}
+
+void printLatencyStats(FILE * const stream) {
+    ST_latencyStats_t stats;
+    uint32_t probe = 0;
+
+    if(NULL == stream) {
+        return;
+    }
+
+    fprintf(stream, "%-22s %10s %10s %10s %10s %10s %10s %10s\n",
+            "Probe", "Count", "Mean(ns)", "p50(ns)", "p90(ns)", "p99(ns)", "p99.9(ns)", "Max(ns)");
+
+    for(probe = 0; probe < LATENCY_PROBE_COUNT; ++probe) {
+        getLatencyStats((EN_latencyProbe_t)probe, &stats);
+        if(0 == stats.count) {
+            continue;
+        }
+
+        fprintf(stream, "%-22s %10llu %10.0f %10llu %10llu %10llu %10llu %10llu\n", probeNames[probe],
+                (unsigned long long)stats.count, stats.mean, (unsigned long long)stats.p50,
+                (unsigned long long)stats.p90, (unsigned long long)stats.p99,
+                (unsigned long long)stats.p999, (unsigned long long)stats.max);
+    }
+}
+
+void resetLatencyStats(void) {
+    ST_latencyHistograms_t *threadData = NULL;
+    uint32_t i = 0, threadCount = 0;
+
+    threadCount = getThreadSlotsCount(&histograms);
+    for(i = 0; i < threadCount; ++i) {
+        threadData = getThreadSlot(&histograms, i);
+        if(NULL != threadData) {
+            memset(threadData, 0, sizeof(*threadData));
+        }
+    }
+}
+
+EN_latencyError_t startLatencySummary(const char * const fileName, const uint32_t periodSeconds) {
+
+    if( (NULL == fileName) || (0 == periodSeconds) || (NULL != summaryFile) ) {
+        return LATENCY_FILE_ERROR;
+    }
+
+    summaryFile = fopen(fileName, "a");
+    if(NULL == summaryFile) {
+        return LATENCY_FILE_ERROR;
+    }
+
+    summaryPeriodSeconds = periodSeconds;
+    __atomic_store_n(&isSummaryRunning, TRUE, __ATOMIC_RELEASE);
+
+    if(0 != pthread_create(&summaryThread, NULL, summaryWorker, NULL)) {
+        __atomic_store_n(&isSummaryRunning, FALSE, __ATOMIC_RELEASE);
+        fclose(summaryFile);
+        summaryFile = NULL;
+        return LATENCY_THREAD_ERROR;
+    }
+
+    return LATENCY_OK;
+}
+
+void stopLatencySummary(void) {
+
+    if(NULL == summaryFile) {
+        return;
+    }
+
+    __atomic_store_n(&isSummaryRunning, FALSE, __ATOMIC_RELEASE);
+    pthread_join(summaryThread, NULL);
+
+    writeSummary();
+
+    fclose(summaryFile);
+    summaryFile = NULL;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Get the histograms of the calling thread, taking them on its
+ *              first latency
+ *******************************************************************************/
+static ST_latencyHistograms_t *getThreadHistograms(void) {
+    uint32_t index = 0;
+
+    if( !isThreadHistogramsTaken ) {
+        isThreadHistogramsTaken = TRUE;
+        threadHistograms = takeThreadSlot(&histograms, sizeof(ST_latencyHistograms_t), &index);
+    }
+
+    return threadHistograms;
+}
+
+/********************************************************************************
+ * @brief       Get the bucket of a latency: exact below 2 * LATENCY_SUB_BUCKET_COUNT,
+ *              then the LATENCY_SUB_BUCKET_BITS bits after the highest set bit
+ *******************************************************************************/
+static uint32_t getBucketIndex(const uint64_t nanoseconds) {
+    uint32_t highestBit = 0, shift = 0;
+
+    if(nanoseconds < 2 * LATENCY_SUB_BUCKET_COUNT) {
+        return (uint32_t)nanoseconds;
+    }
+
+    highestBit = 63 - (uint32_t)__builtin_clzll(nanoseconds);
+    if(highestBit >= LATENCY_MAX_BITS) {
+        return LATENCY_BUCKET_COUNT - 1;
+    }
+
+    shift = highestBit - LATENCY_SUB_BUCKET_BITS;
+
+    return (shift + 1) * LATENCY_SUB_BUCKET_COUNT + (uint32_t)(nanoseconds >> shift) - LATENCY_SUB_BUCKET_COUNT;
+}
+
+/********************************************************************************
+ * @brief       Get the highest latency of a bucket
+ *******************************************************************************/
+static uint64_t getBucketValue(const uint32_t index) {
+    uint32_t shift = 0;
+
+    if(index < 2 * LATENCY_SUB_BUCKET_COUNT) {
+        return index;
+    }
+
+    shift = index / LATENCY_SUB_BUCKET_COUNT - 1;
+
+    return ( ((uint64_t)(LATENCY_SUB_BUCKET_COUNT + index % LATENCY_SUB_BUCKET_COUNT) + 1) << shift ) - 1;
+}
+
+/********************************************************************************
+ * @brief       Append the statistics to the summary file
+ *******************************************************************************/
+static void writeSummary(void) {
+    time_t now = time(NULL);
+    struct tm localTime;
+    char timeText[32];
+
+    localtime_r(&now, &localTime);
+    strftime(timeText, sizeof(timeText), "%Y-%m-%d %H:%M:%S", &localTime);
+    fprintf(summaryFile, "Latency summary at %s\n", timeText);
+    printLatencyStats(summaryFile);
+    fprintf(summaryFile, "\n");
+    fflush(summaryFile);
+}
+
+/********************************************************************************
+ * @brief       Summary thread, wakes up regularly to stop promptly
+ *******************************************************************************/
+static void *summaryWorker(void *argument) {
+    const struct timespec sleepTime = {0, LATENCY_SUMMARY_TICK_NS};
+    uint64_t ticks = 0;
+
+    (void)argument;
+
+    while(__atomic_load_n(&isSummaryRunning, __ATOMIC_ACQUIRE)) {
+        nanosleep(&sleepTime, NULL);
+
+        ++ticks;
+        if(ticks * LATENCY_SUMMARY_TICK_NS >= (uint64_t)summaryPeriodSeconds * 1000000000u) {
+            writeSummary();
+            ticks = 0;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,198 @@
+/********************************************************************************
+ * @file    latency.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the latency histograms
+ *          \ref latency.c
+ * @details Each probe (a state of the state machine, or a step inside one) has
+ *          a high dynamic range histogram: buckets are exact up to 64 ns, then
+ *          32 per power of 2, so any latency from 1 ns to minutes is kept
+ *          within about 3%. Every thread records into its own histograms, they
+ *          are only added up when read, so recording is a timestamp and two
+ *          increments. A timestamp costs more than most steps, so only one
+ *          transaction of every \ref LATENCY_SAMPLE_PERIOD is timed. Build with
+ *          -DLATENCY_ENABLED=0 to remove the probes.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Probes are compiled in unless built with -DLATENCY_ENABLED=0
+ ********************************************************************************/
+#ifndef LATENCY_ENABLED
+#define LATENCY_ENABLED             1
+#endif
+
+/*********************************************************************************
+ * @brief   One transaction of this many is timed on each thread, build with
+ *          -DLATENCY_SAMPLE_PERIOD=1 to time them all
+ ********************************************************************************/
+#ifndef LATENCY_SAMPLE_PERIOD
+#define LATENCY_SAMPLE_PERIOD       16
+#endif
+
+/*********************************************************************************
+ * @brief   Maximum number of threads recording at once, latencies of other
+ *          threads are dropped, the histograms of an exited thread are reused
+ ********************************************************************************/
+#define LATENCY_MAX_THREADS         64
+
+/*********************************************************************************
+ * @brief   Enum for the probes. The states come first, in the order of
+ *          SYSTEM_STATE_t.
+ ********************************************************************************/
+typedef enum EN_latencyProbe_t {
+    LATENCY_STATE_CARD,             /*!< Card state, without the time waiting for input */
+    LATENCY_STATE_TERMINAL,         /*!< Terminal state, without the time waiting for input */
+    LATENCY_STATE_FRAUD,            /*!< Fraud state */
+    LATENCY_STATE_SERVER,           /*!< Server state */
+    LATENCY_TERMINAL_CHECK_CARD,    /*!< Expiry and PAN checks of the terminal */
+    LATENCY_TERMINAL_CHECK_AMOUNT,  /*!< Parsing and checking the amount at the terminal */
+    LATENCY_SERVER_ACCOUNT_LOOKUP,  /*!< Finding the account of the card */
+    LATENCY_SERVER_BALANCE_CHECK,   /*!< Checking the balance covers the amount */
+    LATENCY_SERVER_SAVE,            /*!< Saving the transaction */
+    LATENCY_SERVER_BALANCE_UPDATE,  /*!< Updating the balance of an approval */
+    LATENCY_SERVER_REPLICATION,     /*!< Shipping the change to the standby */
+    LATENCY_PROBE_COUNT
+} EN_latencyProbe_t;
+
+/*********************************************************************************
+ * @brief   Struct for the statistics of a probe over the sampled transactions,
+ *          in nanoseconds
+ ********************************************************************************/
+typedef struct ST_latencyStats_t {
+    uint64_t count;                 /*!< Latencies recorded */
+    double mean;                    /*!< Exact mean */
+    uint64_t p50;                   /*!< Median */
+    uint64_t p90;                   /*!< 90th percentile */
+    uint64_t p99;                   /*!< 99th percentile */
+    uint64_t p999;                  /*!< 99.9th percentile */
+    uint64_t max;                   /*!< Exact maximum */
+} ST_latencyStats_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>latency</b> module
+ ********************************************************************************/
+typedef enum EN_latencyError_t {
+    LATENCY_OK,                     /*!< Summary thread running */
+    LATENCY_FILE_ERROR,             /*!< The summary file cannot be opened */
+    LATENCY_THREAD_ERROR            /*!< The summary thread cannot be started */
+} EN_latencyError_t;
+
+/*********************************************************************************
+ * @brief   The transaction executing on this thread is timed, see
+ *          \ref setLatencySampled
+ ********************************************************************************/
+extern __thread BOOL_t isLatencySampled;
+
+/*********************************************************************************
+ * @brief   Probes used by the instrumented code, they only take timestamps for
+ *          sampled transactions and cost nothing when compiled out
+ ********************************************************************************/
+#if LATENCY_ENABLED
+#define LATENCY_TIME()                      (isLatencySampled ? getLatencyTime() : 0)
+#define LATENCY_RECORD(probe, nanoseconds)  do { if(isLatencySampled) { recordLatency((probe), (nanoseconds)); } } while(0)
+#define LATENCY_SINCE(probe, startTime)     (isLatencySampled ? recordLatencySince((probe), (startTime)) : (startTime))
+#else
+#define LATENCY_TIME()                      ((uint64_t)0)
+#define LATENCY_RECORD(probe, nanoseconds)  ((void)(nanoseconds))
+#define LATENCY_SINCE(probe, startTime)     (startTime)
+#endif
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Get a monotonic timestamp in nanoseconds.
+ ********************************************************************************/
+uint64_t getLatencyTime(void);
+
+/*********************************************************************************
+ * @brief       Record a latency in the histogram of a probe.
+ *
+ * @param[in]   probe: Probe ID
+ * @param[in]   nanoseconds: Latency
+ ********************************************************************************/
+void recordLatency(const EN_latencyProbe_t probe, const uint64_t nanoseconds);
+
+/*********************************************************************************
+ * @brief       Record the time elapsed since a timestamp, to time consecutive
+ *              steps with one timestamp each.
+ *
+ * @param[in]   probe: Probe ID
+ * @param[in]   startTime: Timestamp of \ref getLatencyTime at the start
+ * @return      uint64_t: The timestamp now, start of the next step
+ ********************************************************************************/
+uint64_t recordLatencySince(const EN_latencyProbe_t probe, const uint64_t startTime);
+
+/*********************************************************************************
+ * @brief       Choose whether a new transaction is timed, one of every
+ *              \ref LATENCY_SAMPLE_PERIOD on the calling thread.
+ *
+ * @return      BOOL_t: TRUE if the transaction is timed
+ ********************************************************************************/
+BOOL_t sampleLatency(void);
+
+/*********************************************************************************
+ * @brief       Tell the probes of the calling thread whether the transaction it
+ *              executes now is timed.
+ *
+ * @param[in]   isSampled: Result of \ref sampleLatency for the transaction
+ ********************************************************************************/
+void setLatencySampled(const BOOL_t isSampled);
+
+/*********************************************************************************
+ * @brief       Get the statistics of a probe, over every thread.
+ *
+ * @param[in]   probe: Probe ID
+ * @param[out]  stats: Statistics, zero if nothing was recorded
+ ********************************************************************************/
+void getLatencyStats(const EN_latencyProbe_t probe, ST_latencyStats_t * const stats);
+
+/*********************************************************************************
+ * @brief       Print the statistics of every probe that recorded something.
+ *
+ * @param[in]   stream: Where to print, e.g. stdout
+ ********************************************************************************/
+void printLatencyStats(FILE * const stream);
+
+/*********************************************************************************
+ * @brief       Forget every recorded latency.
+ *
+ * @details     No thread may be recording.
+ ********************************************************************************/
+void resetLatencyStats(void);
+
+/*********************************************************************************
+ * @brief       Append the statistics to a file periodically, from a background
+ *              thread.
+ *
+ * @param[in]   fileName: Path of the summary file, it is appended to
+ * @param[in]   periodSeconds: Time between two summaries
+ * @return      EN_latencyError_t: LATENCY_OK or the error
+ ********************************************************************************/
+EN_latencyError_t startLatencySummary(const char * const fileName, const uint32_t periodSeconds);
+
+/*********************************************************************************
+ * @brief       Append a last summary and stop the summary thread.
+ ********************************************************************************/
+void stopLatencySummary(void);
+
+
+#endif      /* LATENCY_H */
@@ -0,0 +1,278 @@
+/********************************************************************************
+ * @file    log.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the binary logger implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../macros.h"
+#include "slots.h"
+#include "log.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Size of a cache line, to keep data written by different threads apart
+ *******************************************************************************/
+#define CACHE_LINE_SIZE             64
+
+/********************************************************************************
+ * @brief   Sleep of the drain thread when every ring is empty
+ *******************************************************************************/
+#define LOG_DRAIN_SLEEP_NS          100000
+
+/********************************************************************************
+ * @brief   Struct for the ring of one thread, written by the thread only and
+ *          read by the drain thread only
+ *******************************************************************************/
+typedef struct ST_logRing_t {
+    ST_logRecord_t records[LOG_RING_SIZE];
+    uint64_t head __attribute__((aligned(CACHE_LINE_SIZE)));   /*!< Events written by the thread */
+    uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE)));   /*!< Events written to the file */
+    uint16_t index;                                             /*!< Index of the ring in rings[] */
+} ST_logRing_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Format of each event
+ *******************************************************************************/
+static const char * const logFormats[LOG_EVENT_COUNT] = {
+    [LOG_ACCOUNT_BALANCE]   = "Account balance: %.0f\n",
+    [LOG_NEW_BALANCE]       = "Your new balance: %.0f\n",
+    [LOG_APPROVED]          = "Approved Transaction of: %.0f\n",
+    [LOG_APPROVED_OFFLINE]  = "Approved offline Transaction of: %.0f\n",
+    [LOG_DECLINED]          = "Disapproved transsaction. (Transaction Error %.0f)\n",
+    [LOG_DECLINED_FRAUD]    = "Declined, unusual transaction for this card (score %.0f)\n",
+    [LOG_NO_ROUTE]          = "No issuer for this card\n",
+};
+
+/********************************************************************************
+ * @brief   Rings of the threads, the ring of an exited thread is taken by the
+ *          next one with the events left to write
+ *******************************************************************************/
+static ST_threadSlots_t rings = {.name = "log", .maxCount = LOG_MAX_THREADS};
+
+/********************************************************************************
+ * @brief   Ring of the calling thread, NULL until its first event or if every
+ *          ring is taken
+ *******************************************************************************/
+static __thread ST_logRing_t *threadRing = NULL;
+static __thread BOOL_t isThreadRingTaken = FALSE;
+
+static BOOL_t isPrintingEvents = TRUE;
+static BOOL_t isRunning = FALSE;
+static uint64_t droppedCount = 0;
+static FILE *logFile = NULL;
+static pthread_t drainThread;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_logRing_t *getThreadRing(void);
+static uint32_t drainRings(void);
+static void *drainWorker(void *argument);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_logError_t startLogger(const char * const fileName) {
+
+    if( (NULL == fileName) || (NULL != logFile) ) {
+        return LOG_FILE_ERROR;
+    }
+
+    logFile = fopen(fileName, "wb");
+    if(NULL == logFile) {
+        return LOG_FILE_ERROR;
+    }
+
+    __atomic_store_n(&isRunning, TRUE, __ATOMIC_RELEASE);
+
+    if(0 != pthread_create(&drainThread, NULL, drainWorker, NULL)) {
+        __atomic_store_n(&isRunning, FALSE, __ATOMIC_RELEASE);
+        fclose(logFile);
+        logFile = NULL;
+        return LOG_THREAD_ERROR;
+    }
+
+    return LOG_OK;
+}
+
+void stopLogger(void) {
+
+    if(NULL == logFile) {
+        return;
+    }
+
+    __atomic_store_n(&isRunning, FALSE, __ATOMIC_RELEASE);
+    pthread_join(drainThread, NULL);
+
+    /* Events logged while the drain thread was stopping */
+    drainRings();
+
+    fclose(logFile);
+    logFile = NULL;
+}
+
+void setLogPrinting(const BOOL_t isPrinting) {
+    __atomic_store_n(&isPrintingEvents, isPrinting, __ATOMIC_RELAXED);
+}
+
+void logEvent(const EN_logEvent_t event, const double firstValue, const double secondValue) {
+    ST_logRing_t *ring = NULL;
+    ST_logRecord_t *record = NULL;
+    struct timespec now;
+    uint64_t head = 0;
+
+    if( (uint32_t)event >= LOG_EVENT_COUNT ) {
+        return;
+    }
+
+    if(__atomic_load_n(&isPrintingEvents, __ATOMIC_RELAXED)) {
+        printf(logFormats[event], firstValue, secondValue);
+    }
+
+    if( !__atomic_load_n(&isRunning, __ATOMIC_ACQUIRE) ) {
+        return;
+    }
+
+    ring = getThreadRing();
+    head = (NULL == ring) ? 0 : ring->head;
+    if( (NULL == ring) || (head - __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) ) {
+        __atomic_fetch_add(&droppedCount, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    record = &(ring->records[head & (LOG_RING_SIZE - 1)]);
+    record->time      = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    record->event     = (uint16_t)event;
+    record->thread    = ring->index;
+    record->reserved  = 0;
+    record->values[0] = firstValue;
+    record->values[1] = secondValue;
+
+    __atomic_store_n(&(ring->head), head + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t getLogDroppedCount(void) {
+    return __atomic_load_n(&droppedCount, __ATOMIC_RELAXED);
+}
+
+const char *getLogFormat(const uint16_t event) {
+    return (event < LOG_EVENT_COUNT) ? logFormats[event] : NULL;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Get the ring of the calling thread, taking one on its first event
+ *******************************************************************************/
+static ST_logRing_t *getThreadRing(void) {
+    uint32_t index = 0;
+
+    if( !isThreadRingTaken ) {
+        isThreadRingTaken = TRUE;
+
+        threadRing = takeThreadSlot(&rings, sizeof(ST_logRing_t), &index);
+        if(NULL != threadRing) {
+            threadRing->index = (uint16_t)index;
+        }
+    }
+
+    return threadRing;
+}
+
+/********************************************************************************
+ * @brief       Write the events of every ring to the log file
+ *
+ * @return      uint32_t: Number of events written
+ *******************************************************************************/
+static uint32_t drainRings(void) {
+    ST_logRing_t *ring = NULL;
+    uint64_t head = 0, tail = 0, count = 0;
+    uint32_t i = 0, ringTotal = 0, writtenCount = 0;
+
+    ringTotal = getThreadSlotsCount(&rings);
+    for(i = 0; i < ringTotal; ++i) {
+        /* NULL while the thread taking it is setting it up */
+        ring = getThreadSlot(&rings, i);
+        if(NULL == ring) {
+            continue;
+        }
+
+        head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+        tail = ring->tail;
+
+        /* Up to two contiguous runs, before and after the end of the ring */
+        while(tail < head) {
+            count = LOG_RING_SIZE - (tail & (LOG_RING_SIZE - 1));
+            if(count > head - tail) {
+                count = head - tail;
+            }
+
+            fwrite(&(ring->records[tail & (LOG_RING_SIZE - 1)]), sizeof(ST_logRecord_t), count, logFile);
+            tail += count;
+            writtenCount += (uint32_t)count;
+        }
+
+        __atomic_store_n(&(ring->tail), tail, __ATOMIC_RELEASE);
+    }
+
+    return writtenCount;
+}
+
+/********************************************************************************
+ * @brief       Drain thread, sleeps while there is nothing to write
+ *******************************************************************************/
+static void *drainWorker(void *argument) {
+    const struct timespec sleepTime = {0, LOG_DRAIN_SLEEP_NS};
+
+    (void)argument;
+
+    while(__atomic_load_n(&isRunning, __ATOMIC_ACQUIRE)) {
+        if(0 == drainRings()) {
+            fflush(logFile);
+            nanosleep(&sleepTime, NULL);
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,121 @@
+/********************************************************************************
+ * @file    log.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the binary logger \ref log.c
+ * @details An event is an ID from \ref EN_logEvent_t and two numbers, written
+ *          without formatting to a ring of the calling thread. A background
+ *          thread drains the rings into a file that \ref logDecode.c renders
+ *          as text. Printing the events to stdout as well is optional.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef LOG_H
+#define LOG_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of threads logging at once, events of other threads
+ *          are dropped, the ring of an exited thread is reused
+ ********************************************************************************/
+#define LOG_MAX_THREADS             64
+
+/*********************************************************************************
+ * @brief   Number of events in the ring of each thread, a power of 2. Events
+ *          logged while the ring is full are dropped and counted.
+ ********************************************************************************/
+#define LOG_RING_SIZE               16384
+
+/*********************************************************************************
+ * @brief   Enum for the events, \ref getLogFormat gives the text of each one
+ ********************************************************************************/
+typedef enum EN_logEvent_t {
+    LOG_ACCOUNT_BALANCE,            /*!< Balance before an approval */
+    LOG_NEW_BALANCE,                /*!< Balance after an approval */
+    LOG_APPROVED,                   /*!< Transaction approved by the server */
+    LOG_APPROVED_OFFLINE,           /*!< Transaction approved by the terminal */
+    LOG_DECLINED,                   /*!< Transaction declined by the server */
+    LOG_DECLINED_FRAUD,             /*!< Transaction declined by the fraud score */
+    LOG_NO_ROUTE,                   /*!< Card of no known issuer */
+    LOG_EVENT_COUNT
+} EN_logEvent_t;
+
+/*********************************************************************************
+ * @brief   Struct for an event as written in the log file
+ ********************************************************************************/
+typedef struct ST_logRecord_t {
+    uint64_t time;                  /*!< Nanoseconds since 1970 */
+    uint16_t event;                 /*!< EN_logEvent_t */
+    uint16_t thread;                /*!< Index of the ring of the thread */
+    uint32_t reserved;              /*!< Zero */
+    double values[2];               /*!< Values of the event format */
+} ST_logRecord_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>log</b> module
+ ********************************************************************************/
+typedef enum EN_logError_t {
+    LOG_OK,                         /*!< Logger running */
+    LOG_FILE_ERROR,                 /*!< The log file cannot be opened */
+    LOG_THREAD_ERROR                /*!< The drain thread cannot be started */
+} EN_logError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Start writing the events to a file from a background thread.
+ *
+ * @param[in]   fileName: Path of the log file, it is overwritten
+ * @return      EN_logError_t: LOG_OK or the error, events are then only printed
+ ********************************************************************************/
+EN_logError_t startLogger(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Write the events left in the rings and close the log file.
+ *
+ * @details     Threads must have stopped logging.
+ ********************************************************************************/
+void stopLogger(void);
+
+/*********************************************************************************
+ * @brief       Choose whether the events are printed to stdout, on by default.
+ ********************************************************************************/
+void setLogPrinting(const BOOL_t isPrinting);
+
+/*********************************************************************************
+ * @brief       Log an event, never blocks on I/O while only writing to the file.
+ *
+ * @param[in]   event: Event ID
+ * @param[in]   firstValue: First value of the event format
+ * @param[in]   secondValue: Second value of the event format, if any
+ ********************************************************************************/
+void logEvent(const EN_logEvent_t event, const double firstValue, const double secondValue);
+
+/*********************************************************************************
+ * @brief       Get the number of events dropped because a ring was full.
+ ********************************************************************************/
+uint64_t getLogDroppedCount(void);
+
+/*********************************************************************************
+ * @brief       Get the printf() format of an event, its values are doubles.
+ *
+ * @return      const char*: The format, or NULL for an unknown event
+ ********************************************************************************/
+const char *getLogFormat(const uint16_t event);
+
+
+#endif      /* LOG_H */
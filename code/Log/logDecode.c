@@ -0,0 +1,67 @@
+/********************************************************************************
+ * @file    logDecode.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the decoder of the binary log files.
+ * @details It is not part of the application. It prints every event of a log
+ *          written by \ref log.c as text, with its time and thread:
+ *          "./logDecode app.log".
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "../macros.h"
+#include "log.h"
+
+
+int main(int argc, char *argv[]) {
+    FILE *file = NULL;
+    ST_logRecord_t record;
+    const char *format = NULL;
+    time_t seconds = 0;
+    struct tm *date = NULL;
+    char dateText[32];
+    uint64_t count = 0, unknownCount = 0;
+
+    if(argc < 2) {
+        printf("Usage: %s <log file>\n", argv[0]);
+        return 1;
+    }
+
+    file = fopen(argv[1], "rb");
+    if(NULL == file) {
+        printf("Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    while(1 == fread(&record, sizeof(record), 1, file)) {
+        format = getLogFormat(record.event);
+        if(NULL == format) {
+            ++unknownCount;
+            continue;
+        }
+
+        seconds = (time_t)(record.time / 1000000000u);
+        date = localtime(&seconds);
+        if( (NULL == date) || (0 == strftime(dateText, sizeof(dateText), "%Y-%m-%d %H:%M:%S", date)) ) {
+            dateText[0] = '\0';
+        }
+
+        printf("%s.%06u [%2u] ", dateText, (unsigned int)((record.time % 1000000000u) / 1000u), record.thread);
+        printf(format, record.values[0], record.values[1]);
+        ++count;
+    }
+
+    fclose(file);
+
+    if(unknownCount > 0) {
+        printf("%llu unknown events skipped\n", (unsigned long long)unknownCount);
+    }
+
+    return (0 == count) && (0 != unknownCount);
+}
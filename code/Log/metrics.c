@@ -0,0 +1,368 @@
+/********************************************************************************
+ * @file    metrics.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the implementation of the operational counters
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Server/server.h"
+#include "slots.h"
+#include "metrics.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#define CACHE_LINE_SIZE             64
+
+/*!< Time the endpoint waits for a connection before checking the stop request */
+#define METRICS_POLL_MS             100
+
+/*!< Size of the request read, only its first line matters */
+#define METRICS_REQUEST_SIZE        1024
+
+/*!< Counters of one thread, only written by it, padded to whole cache lines */
+typedef struct ST_metricsCounters_t {
+    uint64_t counts[METRIC_COUNT][METRICS_MAX_CODES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) ST_metricsCounters_t;
+
+/*!< How a metric is exposed */
+typedef struct ST_metricInfo_t {
+    const char *name;               /*!< Prometheus name */
+    const char *help;               /*!< Description */
+    const char *label;              /*!< Label of the code, NULL for a single series */
+    const char * const *codeNames;  /*!< Value of the label for each code */
+    uint32_t codeCount;             /*!< Codes exposed */
+} ST_metricInfo_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static const char * const transStateNames[] = {
+    [APPROVED]                      = "APPROVED",
+    [DECLINED_INSUFFICIENT_FUND]    = "DECLINED_INSUFFICIENT_FUND",
+    [DECLINED_STOLEN_CARD]          = "DECLINED_STOLEN_CARD",
+    [INTERNAL_SERVER_ERROR]         = "INTERNAL_SERVER_ERROR",
+    [DECLINED_SUSPECTED_FRAUD]      = "DECLINED_SUSPECTED_FRAUD",
+    [DECLINED_NO_EXCHANGE_RATE]     = "DECLINED_NO_EXCHANGE_RATE",
+    [DECLINED_TRY_LATER]            = "DECLINED_TRY_LATER",
+};
+
+static const char * const serverErrorNames[] = {
+    [SERVER_OK]                     = "SERVER_OK",
+    [SAVING_FAILED]                 = "SAVING_FAILED",
+    [TRANSACTION_NOT_FOUND]         = "TRANSACTION_NOT_FOUND",
+    [ACCOUNT_NOT_FOUND]             = "ACCOUNT_NOT_FOUND",
+    [LOW_BALANCE]                   = "LOW_BALANCE",
+    [NO_EXCHANGE_RATE]              = "NO_EXCHANGE_RATE",
+    [HELD_AMOUNT_ERROR]             = "HELD_AMOUNT_ERROR",
+};
+
+static const char * const terminalErrorNames[] = {
+    [TERMINAL_OK]                   = "TERMINAL_OK",
+    [WRONG_DATE]                    = "WRONG_DATE",
+    [EXPIRED_CARD]                  = "EXPIRED_CARD",
+    [INVALID_CARD]                  = "INVALID_CARD",
+    [INVALID_AMOUNT]                = "INVALID_AMOUNT",
+    [EXCEED_MAX_AMOUNT]             = "EXCEED_MAX_AMOUNT",
+    [INVALID_MAX_AMOUNT]            = "INVALID_MAX_AMOUNT",
+    [EXCEED_FLOOR_LIMIT]            = "EXCEED_FLOOR_LIMIT",
+    [HOT_CARD]                      = "HOT_CARD",
+    [OFFLINE_QUEUE_ERROR]           = "OFFLINE_QUEUE_ERROR",
+    [CONFIG_ERROR]                  = "CONFIG_ERROR",
+};
+
+static const char * const cardErrorNames[] = {
+    [CARD_OK]                       = "CARD_OK",
+    [WRONG_NAME]                    = "WRONG_NAME",
+    [WRONG_EXP_DATE]                = "WRONG_EXP_DATE",
+    [WRONG_PAN]                     = "WRONG_PAN",
+};
+
+#define NAMES_COUNT(names)          (sizeof(names) / sizeof(names[0]))
+
+static const ST_metricInfo_t metricInfos[METRIC_COUNT] = {
+    [METRIC_TRANS_STATE]            = {"payment_authorizations_total", "Authorizations by outcome.",
+                                       "state", transStateNames, NAMES_COUNT(transStateNames)},
+    [METRIC_SERVER_RESULT]          = {"payment_server_results_total", "Results of the server checks.",
+                                       "result", serverErrorNames, NAMES_COUNT(serverErrorNames)},
+    [METRIC_TERMINAL_RESULT]        = {"payment_terminal_results_total", "Results of the terminal checks.",
+                                       "result", terminalErrorNames, NAMES_COUNT(terminalErrorNames)},
+    [METRIC_CARD_RESULT]            = {"payment_card_results_total", "Results of the card checks.",
+                                       "result", cardErrorNames, NAMES_COUNT(cardErrorNames)},
+    [METRIC_TRANSACTION_STARTED]    = {"payment_transactions_started_total", "Transactions started.",
+                                       NULL, NULL, 1},
+    [METRIC_TRANSACTION_FINISHED]   = {"payment_transactions_finished_total", "Transactions over, approved or not.",
+                                       NULL, NULL, 1},
+};
+
+static ST_threadSlots_t counters = {.name = "metrics", .maxCount = METRICS_MAX_THREADS};
+
+static __thread ST_metricsCounters_t *threadCounters = NULL;
+static __thread BOOL_t isThreadCountersTaken = FALSE;
+
+static BOOL_t isServerRunning = FALSE;
+static int serverSocket = -1;
+static pthread_t serverThread;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_metricsCounters_t *getThreadCounters(void);
+static void answerRequest(const int connection);
+static void *serverWorker(void *argument);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+void countMetric(const EN_metric_t metric, const uint32_t code) {
+    ST_metricsCounters_t *threadData = NULL;
+    uint64_t *count = NULL;
+
+    if( ((uint32_t)metric >= METRIC_COUNT) || (code >= METRICS_MAX_CODES) ) {
+        return;
+    }
+
+    threadData = getThreadCounters();
+    if(NULL == threadData) {
+        return;
+    }
+
+    /* Only this thread writes, an atomic store is enough for the scrapes */
+    count = &(threadData->counts[metric][code]);
+    __atomic_store_n(count, *count + 1, __ATOMIC_RELAXED);
+}
+
+uint64_t getMetricCount(const EN_metric_t metric, const uint32_t code) {
+    ST_metricsCounters_t *threadData = NULL;
+    uint32_t i = 0, threadCount = 0;
+    uint64_t total = 0;
+
+    if( ((uint32_t)metric >= METRIC_COUNT) || (code >= METRICS_MAX_CODES) ) {
+        return 0;
+    }
+
+    threadCount = getThreadSlotsCount(&counters);
+    for(i = 0; i < threadCount; ++i) {
+        threadData = getThreadSlot(&counters, i);
+        if(NULL != threadData) {
+            total += __atomic_load_n(&(threadData->counts[metric][code]), __ATOMIC_RELAXED);
+        }
+    }
+
+    return total;
+}
+
+void writeMetrics(FILE * const stream) {
+    const ST_metricInfo_t *info = NULL;
+    uint64_t started = 0, finished = 0;
+    uint32_t metric = 0, code = 0;
+
+    if(NULL == stream) {
+        return;
+    }
+
+    for(metric = 0; metric < METRIC_COUNT; ++metric) {
+        info = &metricInfos[metric];
+        fprintf(stream, "# HELP %s %s\n# TYPE %s counter\n", info->name, info->help, info->name);
+
+        for(code = 0; code < info->codeCount; ++code) {
+            if(NULL == info->label) {
+                fprintf(stream, "%s %llu\n", info->name,
+                        (unsigned long long)getMetricCount((EN_metric_t)metric, code));
+            } else {
+                fprintf(stream, "%s{%s=\"%s\"} %llu\n", info->name, info->label, info->codeNames[code],
+                        (unsigned long long)getMetricCount((EN_metric_t)metric, code));
+            }
+        }
+    }
+
+    /* Finished is read first so the gauge never goes below 0 */
+    finished = getMetricCount(METRIC_TRANSACTION_FINISHED, 0);
+    started  = getMetricCount(METRIC_TRANSACTION_STARTED, 0);
+    fprintf(stream, "# HELP payment_transactions_in_flight Transactions started and not over yet.\n"
+                    "# TYPE payment_transactions_in_flight gauge\n"
+                    "payment_transactions_in_flight %llu\n",
+            (unsigned long long)((started > finished) ? (started - finished) : 0));
+}
+
+EN_metricsError_t startMetricsServer(const uint16_t port) {
+    struct sockaddr_in address;
+    int isReused = 1;
+
+    if(-1 != serverSocket) {
+        return METRICS_SOCKET_ERROR;
+    }
+
+    serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if(-1 == serverSocket) {
+        return METRICS_SOCKET_ERROR;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &isReused, sizeof(isReused));
+    if( (0 != bind(serverSocket, (struct sockaddr *)&address, sizeof(address))) ||
+        (0 != listen(serverSocket, 16)) ) {
+        close(serverSocket);
+        serverSocket = -1;
+        return METRICS_SOCKET_ERROR;
+    }
+
+    __atomic_store_n(&isServerRunning, TRUE, __ATOMIC_RELEASE);
+
+    if(0 != pthread_create(&serverThread, NULL, serverWorker, NULL)) {
+        __atomic_store_n(&isServerRunning, FALSE, __ATOMIC_RELEASE);
+        close(serverSocket);
+        serverSocket = -1;
+        return METRICS_THREAD_ERROR;
+    }
+
+    return METRICS_OK;
+}
+
+void stopMetricsServer(void) {
+
+    if(-1 == serverSocket) {
+        return;
+    }
+
+    __atomic_store_n(&isServerRunning, FALSE, __ATOMIC_RELEASE);
+    pthread_join(serverThread, NULL);
+
+    close(serverSocket);
+    serverSocket = -1;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Get the counters of the calling thread, taking them on its
+ *              first count
+ *******************************************************************************/
+static ST_metricsCounters_t *getThreadCounters(void) {
+    uint32_t index = 0;
+
+    if( !isThreadCountersTaken ) {
+        isThreadCountersTaken = TRUE;
+        threadCounters = takeThreadSlot(&counters, sizeof(ST_metricsCounters_t), &index);
+    }
+
+    return threadCounters;
+}
+
+/********************************************************************************
+ * @brief       Answer one HTTP request, only GET /metrics is served
+ *******************************************************************************/
+static void answerRequest(const int connection) {
+    char request[METRICS_REQUEST_SIZE];
+    char header[128];
+    char *body = NULL;
+    size_t bodySize = 0;
+    FILE *bodyStream = NULL;
+    ssize_t received = 0;
+    int headerSize = 0;
+
+    received = recv(connection, request, sizeof(request) - 1, 0);
+    if(received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+
+    if( (0 != strncmp(request, "GET /metrics ", 13)) && (0 != strncmp(request, "GET /metrics?", 13)) ) {
+        headerSize = snprintf(header, sizeof(header),
+                              "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        send(connection, header, (size_t)headerSize, MSG_NOSIGNAL);
+        return;
+    }
+
+    bodyStream = open_memstream(&body, &bodySize);
+    if(NULL == bodyStream) {
+        return;
+    }
+    writeMetrics(bodyStream);
+    fclose(bodyStream);
+
+    headerSize = snprintf(header, sizeof(header),
+                          "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: %zu\r\nConnection: close\r\n\r\n", bodySize);
+    send(connection, header, (size_t)headerSize, MSG_NOSIGNAL);
+    send(connection, body, bodySize, MSG_NOSIGNAL);
+
+    free(body);
+}
+
+/********************************************************************************
+ * @brief       Endpoint thread, one connection at a time, wakes up regularly to
+ *              stop promptly
+ *******************************************************************************/
+static void *serverWorker(void *argument) {
+    struct pollfd listener = {.fd = serverSocket, .events = POLLIN};
+    const struct timeval receiveTimeout = {1, 0};
+    int connection = -1;
+
+    (void)argument;
+
+    while(__atomic_load_n(&isServerRunning, __ATOMIC_ACQUIRE)) {
+        if(poll(&listener, 1, METRICS_POLL_MS) <= 0) {
+            continue;
+        }
+
+        connection = accept(serverSocket, NULL, NULL);
+        if(-1 == connection) {
+            continue;
+        }
+
+        /* A client sending nothing must not block the endpoint */
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+
+        answerRequest(connection);
+        close(connection);
+    }
+
+    return NULL;
+}
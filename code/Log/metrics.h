@@ -0,0 +1,104 @@
+/********************************************************************************
+ * @file    metrics.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the operational counters
+ *          \ref metrics.c
+ * @details Counters of the authorization outcomes, of the results of the
+ *          server, terminal and card checks, and of the transactions in flight.
+ *          Every thread counts into its own cache lines, the counters are only
+ *          added up when scraped from the local HTTP endpoint, in the
+ *          Prometheus text format.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of threads counting at once, counts of other threads
+ *          are lost, the counters of an exited thread are reused with its counts
+ ********************************************************************************/
+#define METRICS_MAX_THREADS         64
+
+/*********************************************************************************
+ * @brief   Maximum number of codes of a metric, e.g. values of EN_terminalError_t
+ ********************************************************************************/
+#define METRICS_MAX_CODES           16
+
+/*********************************************************************************
+ * @brief   Enum for the metrics, each one counted by code
+ ********************************************************************************/
+typedef enum EN_metric_t {
+    METRIC_TRANS_STATE,             /*!< Authorizations by EN_transState_t */
+    METRIC_SERVER_RESULT,           /*!< Server checks by EN_serverError_t */
+    METRIC_TERMINAL_RESULT,         /*!< Terminal checks by EN_terminalError_t */
+    METRIC_CARD_RESULT,             /*!< Card checks by EN_cardError_t */
+    METRIC_TRANSACTION_STARTED,     /*!< Transactions started, code 0 */
+    METRIC_TRANSACTION_FINISHED,    /*!< Transactions over, code 0 */
+    METRIC_COUNT
+} EN_metric_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>metrics</b> module
+ ********************************************************************************/
+typedef enum EN_metricsError_t {
+    METRICS_OK,                     /*!< Endpoint listening */
+    METRICS_SOCKET_ERROR,           /*!< The port cannot be listened on */
+    METRICS_THREAD_ERROR            /*!< The endpoint thread cannot be started */
+} EN_metricsError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Count one occurrence of a code of a metric, on the counters of
+ *              the calling thread.
+ *
+ * @param[in]   metric: Metric ID
+ * @param[in]   code: Code counted, below \ref METRICS_MAX_CODES
+ ********************************************************************************/
+void countMetric(const EN_metric_t metric, const uint32_t code);
+
+/*********************************************************************************
+ * @brief       Get the count of a code of a metric, over every thread.
+ ********************************************************************************/
+uint64_t getMetricCount(const EN_metric_t metric, const uint32_t code);
+
+/*********************************************************************************
+ * @brief       Write every metric in the Prometheus text format.
+ *
+ * @param[in]   stream: Where to write
+ ********************************************************************************/
+void writeMetrics(FILE * const stream);
+
+/*********************************************************************************
+ * @brief       Serve the metrics on http://127.0.0.1:port/metrics from a
+ *              background thread.
+ *
+ * @param[in]   port: TCP port to listen on
+ * @return      EN_metricsError_t: METRICS_OK or the error
+ ********************************************************************************/
+EN_metricsError_t startMetricsServer(const uint16_t port);
+
+/*********************************************************************************
+ * @brief       Stop serving the metrics.
+ ********************************************************************************/
+void stopMetricsServer(void);
+
+
+#endif      /* METRICS_H */
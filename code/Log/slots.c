@@ -0,0 +1,158 @@
+/********************************************************************************
+ * @file    slots.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the per thread slots implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include "../macros.h"
+#include "slots.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Size of a cache line, the data of each slot starts on its own
+ *******************************************************************************/
+#define CACHE_LINE_SIZE             64
+
+/********************************************************************************
+ * @brief   States of the key of a set of slots
+ *******************************************************************************/
+#define SLOTS_KEY_NONE              0
+#define SLOTS_KEY_CREATING          1
+#define SLOTS_KEY_CREATED           2
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static BOOL_t createSlotsKey(ST_threadSlots_t * const threadSlots);
+static void giveBackThreadSlot(void *slot);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+void *takeThreadSlot(ST_threadSlots_t * const threadSlots, const size_t size, uint32_t * const index) {
+    const uint32_t maxCount = (threadSlots->maxCount < THREAD_SLOTS_MAX) ? threadSlots->maxCount : THREAD_SLOTS_MAX;
+    ST_threadSlot_t *slot = NULL;
+    void *data = NULL;
+    uint32_t i = 0, count = 0, isTaken = 0;
+
+    if( !createSlotsKey(threadSlots) ) {
+        return NULL;
+    }
+
+    /* A slot given back by an exited thread, its data is set up */
+    count = __atomic_load_n(&(threadSlots->count), __ATOMIC_ACQUIRE);
+    for(i = 0; (i < count) && (i < maxCount) && (NULL == slot); ++i) {
+        isTaken = 0;
+        if( (NULL != __atomic_load_n(&(threadSlots->slots[i].data), __ATOMIC_ACQUIRE)) &&
+            __atomic_compare_exchange_n(&(threadSlots->slots[i].isTaken), &isTaken, 1, FALSE,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ) {
+            slot = &(threadSlots->slots[i]);
+            *index = i;
+        }
+    }
+
+    /* Else a new slot */
+    if(NULL == slot) {
+        i = __atomic_fetch_add(&(threadSlots->count), 1, __ATOMIC_RELAXED);
+        data = (i < maxCount) ? aligned_alloc(CACHE_LINE_SIZE, (size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1)) :
+                                NULL;
+        if(NULL == data) {
+            /* The count is not given back, the other threads would read an index with no data yet */
+            if(0 == __atomic_exchange_n(&(threadSlots->isFullReported), 1, __ATOMIC_RELAXED)) {
+                fprintf(stderr, "%s: no slot left for a thread, more than %u threads at once\n",
+                        threadSlots->name, maxCount);
+            }
+            return NULL;
+        }
+
+        memset(data, 0, size);
+        slot = &(threadSlots->slots[i]);
+        __atomic_store_n(&(slot->isTaken), 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&(slot->data), data, __ATOMIC_RELEASE);
+        *index = i;
+    }
+
+    pthread_setspecific(threadSlots->key, slot);
+
+    return slot->data;
+}
+
+uint32_t getThreadSlotsCount(const ST_threadSlots_t * const threadSlots) {
+    const uint32_t count = __atomic_load_n(&(threadSlots->count), __ATOMIC_ACQUIRE);
+    const uint32_t maxCount = (threadSlots->maxCount < THREAD_SLOTS_MAX) ? threadSlots->maxCount : THREAD_SLOTS_MAX;
+
+    return (count < maxCount) ? count : maxCount;
+}
+
+void *getThreadSlot(const ST_threadSlots_t * const threadSlots, const uint32_t index) {
+    return (index < THREAD_SLOTS_MAX) ? __atomic_load_n(&(threadSlots->slots[index].data), __ATOMIC_ACQUIRE) : NULL;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Create the key of a set of slots on its first use, the threads
+ *              arriving meanwhile wait for it
+ *
+ * @return      BOOL_t: TRUE once the key exists
+ *******************************************************************************/
+static BOOL_t createSlotsKey(ST_threadSlots_t * const threadSlots) {
+    uint32_t keyState = SLOTS_KEY_NONE;
+
+    if(SLOTS_KEY_CREATED == __atomic_load_n(&(threadSlots->keyState), __ATOMIC_ACQUIRE)) {
+        return TRUE;
+    }
+
+    if(__atomic_compare_exchange_n(&(threadSlots->keyState), &keyState, SLOTS_KEY_CREATING, FALSE,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        keyState = (0 == pthread_key_create(&(threadSlots->key), giveBackThreadSlot)) ? SLOTS_KEY_CREATED : SLOTS_KEY_NONE;
+        __atomic_store_n(&(threadSlots->keyState), keyState, __ATOMIC_RELEASE);
+        return (BOOL_t)(SLOTS_KEY_CREATED == keyState);
+    }
+
+    while(SLOTS_KEY_CREATING == __atomic_load_n(&(threadSlots->keyState), __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    return (BOOL_t)(SLOTS_KEY_CREATED == __atomic_load_n(&(threadSlots->keyState), __ATOMIC_ACQUIRE));
+}
+
+/********************************************************************************
+ * @brief       Destructor of the key, gives the slot of an exiting thread back,
+ *              after everything the thread wrote to its data
+ *******************************************************************************/
+static void giveBackThreadSlot(void *slot) {
+    __atomic_store_n(&(((ST_threadSlot_t *)slot)->isTaken), 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,99 @@
+/********************************************************************************
+ * @file    slots.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the per thread slots
+ *          \ref slots.c
+ * @details The logger, the latency histograms, the metrics and the flight
+ *          recorder give each thread its own data, written by that thread only
+ *          and read by the others. A thread takes a slot on its first use and
+ *          gives it back when it exits, through a thread specific data
+ *          destructor. The next thread takes the slot again with its data as
+ *          it was left, so the counts and events of exited threads are kept
+ *          and the slots last as long as the threads alive at once.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef SLOTS_H
+#define SLOTS_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of slots of a set
+ ********************************************************************************/
+#define THREAD_SLOTS_MAX            64
+
+/*********************************************************************************
+ * @brief   Struct for one slot, its data is allocated the first time it is taken
+ *          and never freed
+ ********************************************************************************/
+typedef struct ST_threadSlot_t {
+    void *data;                     /*!< Data of the slot, NULL until first taken */
+    uint32_t isTaken;               /*!< 1 while a live thread owns the slot */
+} ST_threadSlot_t;
+
+/*********************************************************************************
+ * @brief   Struct for a set of slots, a static one is zeroed except its name
+ *          and maximum count, e.g. {.name = "log", .maxCount = LOG_MAX_THREADS}
+ ********************************************************************************/
+typedef struct ST_threadSlots_t {
+    const char *name;               /*!< Name in the message printed when the slots run out */
+    uint32_t maxCount;              /*!< Slots of the set, at most THREAD_SLOTS_MAX */
+    ST_threadSlot_t slots[THREAD_SLOTS_MAX];
+    uint32_t count;                 /*!< Slots taken at least once */
+    uint32_t keyState;              /*!< 0, 1 while the key is created, 2 once created */
+    pthread_key_t key;              /*!< Key whose destructor gives the slot back */
+    uint32_t isFullReported;        /*!< The slots ran out and it was printed */
+} ST_threadSlots_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Take a slot for the calling thread, a slot given back by an
+ *              exited thread or else a new one.
+ *
+ * @details     The slot is given back when the thread exits, its data must not
+ *              be used by the thread after that, e.g. from another thread
+ *              specific data destructor. When every slot is owned by a live
+ *              thread, a message is printed to stderr once per set.
+ * @param[in]   threadSlots: The set of slots
+ * @param[in]   size: Size of the data of a slot, zeroed on its first use
+ * @param[out]  index: Index of the slot
+ * @return      void *: Data of the slot, aligned on a cache line, or NULL if
+ *              there is no slot left or no memory
+ ********************************************************************************/
+void *takeThreadSlot(ST_threadSlots_t * const threadSlots, const size_t size, uint32_t * const index);
+
+/*********************************************************************************
+ * @brief       Get the number of slots taken at least once, the slots to read
+ *
+ * @param[in]   threadSlots: The set of slots
+ * @return      uint32_t: Number of slots
+ ********************************************************************************/
+uint32_t getThreadSlotsCount(const ST_threadSlots_t * const threadSlots);
+
+/*********************************************************************************
+ * @brief       Get the data of a slot to read it from any thread, whether its
+ *              thread is alive or not. Safe in a signal handler.
+ *
+ * @param[in]   threadSlots: The set of slots
+ * @param[in]   index: Index of the slot, below \ref getThreadSlotsCount
+ * @return      void *: Data of the slot, NULL while it is being set up
+ ********************************************************************************/
+void *getThreadSlot(const ST_threadSlots_t * const threadSlots, const uint32_t index);
+
+#endif
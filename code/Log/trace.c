@@ -0,0 +1,337 @@
+/********************************************************************************
+ * @file    trace.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the implementation of the flight recorder
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include "../macros.h"
+#include "slots.h"
+#include "trace.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#define CACHE_LINE_SIZE             64
+
+/*!< Size of the buffer the dump is formatted into before each write */
+#define TRACE_DUMP_BUFFER_SIZE      4096
+
+/*!< Events of one thread, only written by it, padded to whole cache lines */
+typedef struct ST_traceRing_t {
+    ST_traceRecord_t records[TRACE_RING_SIZE];
+    uint64_t head;                  /*!< Events recorded so far, the next one goes at head % size */
+} __attribute__((aligned(CACHE_LINE_SIZE))) ST_traceRing_t;
+
+/*!< Dump being written, only uses the stack so it can run in a signal handler */
+typedef struct ST_traceDump_t {
+    int file;
+    size_t length;
+    char data[TRACE_DUMP_BUFFER_SIZE];
+} ST_traceDump_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static const char * const eventNames[TRACE_EVENT_COUNT] = {
+    [TRACE_TRANSACTION_START]       = "TRANSACTION_START",
+    [TRACE_STATE_DONE]              = "STATE_DONE",
+    [TRACE_STATE_NEEDS_INPUT]       = "STATE_NEEDS_INPUT",
+    [TRACE_STATE_FAILED]            = "STATE_FAILED",
+    [TRACE_FRAUD_SCORE]             = "FRAUD_SCORE",
+    [TRACE_OFFLINE_RESULT]          = "OFFLINE_RESULT",
+    [TRACE_ACCOUNT_LOOKUP]          = "ACCOUNT_LOOKUP",
+    [TRACE_BALANCE_CHECK]           = "BALANCE_CHECK",
+    [TRACE_SAVE]                    = "SAVE",
+    [TRACE_AUTHORIZATION]           = "AUTHORIZATION",
+};
+
+static ST_threadSlots_t rings = {.name = "trace", .maxCount = TRACE_MAX_THREADS};
+
+static __thread ST_traceRing_t *threadRing = NULL;
+static __thread BOOL_t isThreadRingTaken = FALSE;
+static __thread uint64_t threadTraceId = 0;
+
+static uint64_t lastTraceId = 0;
+
+static const char *dumpFileName = NULL;
+static BOOL_t isDumping = FALSE;
+
+/*!< Clocks when the dumps were enabled, to turn ticks into nanoseconds */
+static uint64_t startTicks = 0;
+static uint64_t startNanoseconds = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_traceRing_t *getThreadRing(void);
+static inline uint64_t getTicks(void);
+static uint64_t getNanoseconds(void);
+static void dumpSignalHandler(int signalNumber);
+static void flushDump(ST_traceDump_t * const dump);
+static void appendText(ST_traceDump_t * const dump, const char *text);
+static void appendNumber(ST_traceDump_t * const dump, uint64_t number);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_traceError_t startTrace(const char * const fileName, const int signalNumber) {
+    struct sigaction action;
+
+    if(NULL == fileName) {
+        return TRACE_FILE_ERROR;
+    }
+
+    startTicks = getTicks();
+    startNanoseconds = getNanoseconds();
+    __atomic_store_n(&dumpFileName, fileName, __ATOMIC_RELEASE);
+
+    if(0 != signalNumber) {
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = dumpSignalHandler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if(0 != sigaction(signalNumber, &action, NULL)) {
+            return TRACE_SIGNAL_ERROR;
+        }
+    }
+
+    return TRACE_OK;
+}
+
+uint64_t newTraceId(void) {
+    return __atomic_add_fetch(&lastTraceId, 1, __ATOMIC_RELAXED);
+}
+
+void setTraceId(const uint64_t traceId) {
+    threadTraceId = traceId;
+}
+
+void traceEvent(const EN_traceEvent_t event, const uint32_t value) {
+    ST_traceRing_t *ring = NULL;
+    ST_traceRecord_t *record = NULL;
+    uint64_t head = 0;
+
+    ring = getThreadRing();
+    if(NULL == ring) {
+        return;
+    }
+
+    /* Only this thread writes, relaxed stores keep a dump from reading torn fields */
+    head = ring->head;
+    record = &(ring->records[head & (TRACE_RING_SIZE - 1)]);
+    __atomic_store_n(&(record->time), getTicks(), __ATOMIC_RELAXED);
+    __atomic_store_n(&(record->traceId), threadTraceId, __ATOMIC_RELAXED);
+    __atomic_store_n(&(record->event), (uint16_t)event, __ATOMIC_RELAXED);
+    __atomic_store_n(&(record->value), value, __ATOMIC_RELAXED);
+    __atomic_store_n(&(ring->head), head + 1, __ATOMIC_RELEASE);
+}
+
+void dumpTrace(const char * const reason) {
+    ST_traceDump_t dump;
+    ST_traceRing_t *ring = NULL;
+    ST_traceRecord_t record;
+    const char *fileName = NULL;
+    uint64_t nowTicks = 0, nowNanoseconds = 0, head = 0, first = 0, i = 0;
+    uint32_t thread = 0, threadCount = 0;
+    double nanosecondsPerTick = 1.0;
+
+    fileName = __atomic_load_n(&dumpFileName, __ATOMIC_ACQUIRE);
+    if(NULL == fileName) {
+        return;
+    }
+
+    /* A dump from a signal handler may interrupt another one, skip it */
+    if(__atomic_exchange_n(&isDumping, TRUE, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    dump.file = open(fileName, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(dump.file < 0) {
+        __atomic_store_n(&isDumping, FALSE, __ATOMIC_RELEASE);
+        return;
+    }
+    dump.length = 0;
+
+    nowTicks = getTicks();
+    nowNanoseconds = getNanoseconds();
+    if( (nowTicks > startTicks) && (nowNanoseconds > startNanoseconds) ) {
+        nanosecondsPerTick = (double)(nowNanoseconds - startNanoseconds) / (double)(nowTicks - startTicks);
+    }
+
+    threadCount = getThreadSlotsCount(&rings);
+
+    appendText(&dump, "# flight recorder dump: ");
+    appendText(&dump, (NULL == reason) ? "requested" : reason);
+    appendText(&dump, ", ");
+    appendNumber(&dump, threadCount);
+    appendText(&dump, " threads\n# thread ns_before_dump trace_id event value\n");
+
+    for(thread = 0; thread < threadCount; ++thread) {
+        ring = getThreadSlot(&rings, thread);
+        if(NULL == ring) {
+            continue;
+        }
+
+        head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+        first = (head > TRACE_RING_SIZE) ? (head - TRACE_RING_SIZE) : 0;
+        for(i = first; i < head; ++i) {
+            record.time = __atomic_load_n(&(ring->records[i & (TRACE_RING_SIZE - 1)].time), __ATOMIC_RELAXED);
+            record.traceId = __atomic_load_n(&(ring->records[i & (TRACE_RING_SIZE - 1)].traceId), __ATOMIC_RELAXED);
+            record.event = __atomic_load_n(&(ring->records[i & (TRACE_RING_SIZE - 1)].event), __ATOMIC_RELAXED);
+            record.value = __atomic_load_n(&(ring->records[i & (TRACE_RING_SIZE - 1)].value), __ATOMIC_RELAXED);
+
+            appendNumber(&dump, thread);
+            appendText(&dump, " ");
+            appendNumber(&dump, (nowTicks > record.time) ? (uint64_t)((double)(nowTicks - record.time) * nanosecondsPerTick) : 0);
+            appendText(&dump, " ");
+            appendNumber(&dump, record.traceId);
+            appendText(&dump, " ");
+            appendText(&dump, (record.event < TRACE_EVENT_COUNT) ? eventNames[record.event] : "UNKNOWN");
+            appendText(&dump, " ");
+            appendNumber(&dump, record.value);
+            appendText(&dump, "\n");
+        }
+    }
+
+    flushDump(&dump);
+    close(dump.file);
+    __atomic_store_n(&isDumping, FALSE, __ATOMIC_RELEASE);
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PRIVATE FUNCTION DEFINITIONS                        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Get the ring of the calling thread, allocated on its first event
+ *******************************************************************************/
+static ST_traceRing_t *getThreadRing(void) {
+    uint32_t index = 0;
+
+    if( !isThreadRingTaken ) {
+        isThreadRingTaken = TRUE;
+        threadRing = takeThreadSlot(&rings, sizeof(ST_traceRing_t), &index);
+    }
+
+    return threadRing;
+}
+
+/********************************************************************************
+ * @brief       Get a timestamp for an event, the cycle counter where there is
+ *              one since it is several times cheaper than a clock call
+ *******************************************************************************/
+static inline uint64_t getTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return getNanoseconds();
+#endif
+}
+
+/********************************************************************************
+ * @brief       Get a monotonic timestamp in nanoseconds, async signal safe
+ *******************************************************************************/
+static uint64_t getNanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+/********************************************************************************
+ * @brief       Dump the rings when the signal given to startTrace is received
+ *******************************************************************************/
+static void dumpSignalHandler(int signalNumber) {
+    int savedErrno = errno;
+
+    (void)signalNumber;
+    dumpTrace("signal");
+
+    errno = savedErrno;
+}
+
+/********************************************************************************
+ * @brief       Write the formatted part of a dump to its file
+ *******************************************************************************/
+static void flushDump(ST_traceDump_t * const dump) {
+    size_t written = 0;
+    ssize_t result = 0;
+
+    while(written < dump->length) {
+        result = write(dump->file, dump->data + written, dump->length - written);
+        if(result < 0) {
+            if(EINTR == errno) {
+                continue;
+            }
+            break;
+        }
+        written += (size_t)result;
+    }
+
+    dump->length = 0;
+}
+
+/********************************************************************************
+ * @brief       Append a string to a dump
+ *******************************************************************************/
+static void appendText(ST_traceDump_t * const dump, const char *text) {
+    for(; '\0' != *text; ++text) {
+        if(dump->length >= TRACE_DUMP_BUFFER_SIZE) {
+            flushDump(dump);
+        }
+        dump->data[dump->length++] = *text;
+    }
+}
+
+/********************************************************************************
+ * @brief       Append a number in decimal to a dump, without snprintf which is
+ *              not async signal safe
+ *******************************************************************************/
+static void appendNumber(ST_traceDump_t * const dump, uint64_t number) {
+    char digits[24];
+    size_t i = sizeof(digits) - 1;
+
+    digits[i] = '\0';
+    do {
+        digits[--i] = (char)('0' + (number % 10));
+        number /= 10;
+    } while(0 != number);
+
+    appendText(dump, &digits[i]);
+}
@@ -0,0 +1,122 @@
+/********************************************************************************
+ * @file    trace.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the flight recorder
+ *          \ref trace.c
+ * @details Every transaction has a trace ID. The states and the server record
+ *          compact events tagged with it into a fixed ring of the calling
+ *          thread, overwriting the oldest ones, so recording never allocates,
+ *          locks or does I/O. The rings are written to a file when the server
+ *          returns INTERNAL_SERVER_ERROR, or when the process gets a signal.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of threads recording at once, events of other threads
+ *          are lost, the ring of an exited thread is reused
+ ********************************************************************************/
+#define TRACE_MAX_THREADS           64
+
+/*********************************************************************************
+ * @brief   Number of events kept per thread, a power of 2
+ ********************************************************************************/
+#define TRACE_RING_SIZE             4096
+
+/*********************************************************************************
+ * @brief   Enum for the events, the meaning of the value is given for each one
+ ********************************************************************************/
+typedef enum EN_traceEvent_t {
+    TRACE_TRANSACTION_START,        /*!< Transaction started, value: terminal ID */
+    TRACE_STATE_DONE,               /*!< State over, value: state index */
+    TRACE_STATE_NEEDS_INPUT,        /*!< State waiting for input, value: state index */
+    TRACE_STATE_FAILED,             /*!< State failed, value: state index */
+    TRACE_FRAUD_SCORE,              /*!< Fraud score, value: score */
+    TRACE_OFFLINE_RESULT,           /*!< Offline approval, value: EN_terminalError_t */
+    TRACE_ACCOUNT_LOOKUP,           /*!< Account search, value: EN_serverError_t */
+    TRACE_BALANCE_CHECK,            /*!< Balance check, value: EN_serverError_t */
+    TRACE_SAVE,                     /*!< Transaction saved, value: EN_serverError_t */
+    TRACE_AUTHORIZATION,            /*!< Server answer, value: EN_transState_t */
+    TRACE_EVENT_COUNT
+} EN_traceEvent_t;
+
+/*********************************************************************************
+ * @brief   Struct for an event in a ring
+ ********************************************************************************/
+typedef struct ST_traceRecord_t {
+    uint64_t time;                  /*!< Timestamp in ticks of the trace clock */
+    uint64_t traceId;               /*!< Transaction of the event, 0 if none */
+    uint16_t event;                 /*!< EN_traceEvent_t */
+    uint16_t reserved;              /*!< Zero */
+    uint32_t value;                 /*!< Value of the event */
+} ST_traceRecord_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>trace</b> module
+ ********************************************************************************/
+typedef enum EN_traceError_t {
+    TRACE_OK,                       /*!< Dumps enabled */
+    TRACE_FILE_ERROR,               /*!< No dump file given */
+    TRACE_SIGNAL_ERROR              /*!< The signal handler cannot be installed */
+} EN_traceError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Enable the dumps of the rings, events are recorded without it.
+ *
+ * @param[in]   fileName: Path of the dump file, dumps are appended to it. It
+ *              must stay valid while dumps are enabled.
+ * @param[in]   signalNumber: Signal dumping the rings, e.g. SIGUSR1, 0 for none
+ * @return      EN_traceError_t: TRACE_OK or the error
+ ********************************************************************************/
+EN_traceError_t startTrace(const char * const fileName, const int signalNumber);
+
+/*********************************************************************************
+ * @brief       Get a new trace ID, never 0.
+ ********************************************************************************/
+uint64_t newTraceId(void);
+
+/*********************************************************************************
+ * @brief       Set the trace ID the events of the calling thread are tagged
+ *              with, i.e. the transaction it executes now.
+ ********************************************************************************/
+void setTraceId(const uint64_t traceId);
+
+/*********************************************************************************
+ * @brief       Record an event in the ring of the calling thread.
+ *
+ * @param[in]   event: Event ID
+ * @param[in]   value: Value of the event
+ ********************************************************************************/
+void traceEvent(const EN_traceEvent_t event, const uint32_t value);
+
+/*********************************************************************************
+ * @brief       Append every ring, oldest events first, to the dump file.
+ *
+ * @details     Async signal safe. Events recorded meanwhile by other threads
+ *              may show up torn. Does nothing until \ref startTrace is called.
+ * @param[in]   reason: Why the rings are dumped, printed in the dump header
+ ********************************************************************************/
+void dumpTrace(const char * const reason);
+
+
+#endif      /* TRACE_H */
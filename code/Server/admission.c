@@ -0,0 +1,348 @@
+/********************************************************************************
+ * @file    admission.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the admission control implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "../Terminal/config.h"
+#include "server.h"
+#include "reload.h"
+#include "admission.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Size of a cache line, the global bucket is alone on its own
+ ********************************************************************************/
+#define CACHE_LINE_SIZE             64
+
+/********************************************************************************
+ * @brief   Slots of the bucket table, twice the terminals so probes stay short
+ ********************************************************************************/
+#define ADMISSION_TERMINAL_SLOTS    (2 * ADMISSION_MAX_TERMINALS)
+
+/********************************************************************************
+ * @brief   Longest a bucket can take to fill, in nanoseconds, so the slowest
+ *          rates and largest bursts never overflow the time it is full again
+ ********************************************************************************/
+#define ADMISSION_MAX_FILL_TIME     (1ull << 62)
+
+/********************************************************************************
+ * @brief   Struct for the bucket of a terminal
+ ********************************************************************************/
+typedef struct ST_admissionBucket_t {
+    uint64_t key;                   /*!< Terminal ID + 1, 0 while the slot is free */
+    uint64_t fullTime;              /*!< Time the bucket is full again, each token taken pushes it by a refill interval */
+} ST_admissionBucket_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The limits read by the checks, none when not loaded
+ ********************************************************************************/
+static ST_reloadTable_t limitsTable = RELOAD_TABLE_INITIALIZER;
+
+/********************************************************************************
+ * @brief   Buckets of the terminals, added on their first transaction, and
+ *          their number
+ ********************************************************************************/
+static ST_admissionBucket_t terminalBuckets[ADMISSION_TERMINAL_SLOTS];
+static uint32_t terminalBucketsCount = 0;
+
+/********************************************************************************
+ * @brief   Time the global bucket is full again, every check updates it
+ ********************************************************************************/
+static uint64_t globalFullTime __attribute__((aligned(CACHE_LINE_SIZE))) = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Find or add the bucket of a terminal, without locks.
+ *
+ * @return      uint64_t *: The time the bucket is full again, NULL if
+ *              \ref ADMISSION_MAX_TERMINALS terminals already have one
+ ********************************************************************************/
+static uint64_t *getTerminalBucket(const uint32_t terminalId);
+
+/********************************************************************************
+ * @brief       Take a token from a bucket, without locks.
+ *
+ * @param[in,out] fullTime: Time the bucket is full again
+ * @param[in]   ratePerSecond: Tokens added per second, 0 for no limit
+ * @param[in]   burst: Tokens the bucket holds
+ * @param[in]   now: Current time
+ * @return      BOOL_t: TRUE if a token was taken, FALSE if the bucket is empty
+ ********************************************************************************/
+static BOOL_t takeToken(uint64_t * const fullTime, const float ratePerSecond, const uint32_t burst,
+                        const uint64_t now);
+
+/********************************************************************************
+ * @brief       Give back a token taken from a bucket, without locks.
+ *
+ * @param[in,out] fullTime: Time the bucket is full again
+ * @param[in]   ratePerSecond: Tokens added per second, 0 for no limit
+ * @param[in]   now: Current time
+ ********************************************************************************/
+static void giveBackToken(uint64_t * const fullTime, const float ratePerSecond, const uint64_t now);
+
+/********************************************************************************
+ * @brief       Get the time a bucket takes to get one token back, in ns.
+ ********************************************************************************/
+static uint64_t getTokenInterval(const float ratePerSecond);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_admissionError_t loadAdmissionLimits(const ST_admissionLimits_t * const limits) {
+    ST_admissionLimits_t *newLimits = NULL;
+
+    if( (NULL == limits) ||
+        !(limits->globalRatePerSecond >= 0) || !(limits->terminalRatePerSecond >= 0) ||
+        ( (limits->globalRatePerSecond > 0) && (0 == limits->globalBurst) )           ||
+        ( (limits->terminalRatePerSecond > 0) && (0 == limits->terminalBurst) ) ) {
+        return INVALID_ADMISSION_LIMITS;
+    }
+
+    newLimits = malloc(sizeof(*newLimits));
+    if(NULL == newLimits) {
+        return ADMISSION_NO_MEMORY;
+    }
+    *newLimits = *limits;
+
+    /* Publishing the new limits, the old ones are freed once the checks in flight are done */
+    swapReloadTable(&limitsTable, newLimits);
+
+    return ADMISSION_OK;
+}
+
+EN_admissionError_t loadAdmissionLimitsFile(const char * const fileName) {
+    FILE *file = NULL;
+    ST_admissionLimits_t limits;
+    unsigned long globalBurst = 0, terminalBurst = 0;
+    char line[96];
+    BOOL_t isRead = FALSE;
+
+    if(NULL == fileName) {
+        return ADMISSION_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return ADMISSION_FILE_ERROR;
+    }
+
+    isRead = (NULL != fgets(line, sizeof(line), file))                                                &&
+             (4 == sscanf(line, "%f %lu %f %lu", &(limits.globalRatePerSecond), &globalBurst,
+                          &(limits.terminalRatePerSecond), &terminalBurst))                           &&
+             (globalBurst <= UINT32_MAX) && (terminalBurst <= UINT32_MAX);
+    fclose(file);
+
+    if( !isRead ) {
+        return ADMISSION_FILE_ERROR;
+    }
+
+    limits.globalBurst = (uint32_t)globalBurst;
+    limits.terminalBurst = (uint32_t)terminalBurst;
+
+    return loadAdmissionLimits(&limits);
+}
+
+void unloadAdmissionLimits(void) {
+    uint32_t i = 0;
+
+    swapReloadTable(&limitsTable, NULL);
+
+    for(i = 0; i < ADMISSION_TERMINAL_SLOTS; ++i) {
+        __atomic_store_n(&(terminalBuckets[i].fullTime), 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&(terminalBuckets[i].key), 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&terminalBucketsCount, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&globalFullTime, 0, __ATOMIC_RELAXED);
+}
+
+EN_admissionError_t admitTransaction(const ST_transaction_t * const transData, const uint64_t now) {
+    const ST_admissionLimits_t *loadedLimits = NULL;
+    ST_admissionLimits_t limits;
+    ST_terminalConfig_t config;
+    uint64_t *terminalFullTime = NULL;
+    float ratePerSecond = 0;
+    uint32_t burst = 0, epoch = 0;
+
+    if(NULL == transData) {
+        return ADMISSION_OK;
+    }
+
+    /* Answering a terminal that gave up is wasted work, and takes no token */
+    if( (0 != transData->deadline) && (now >= transData->deadline) ) {
+        return ADMISSION_DEADLINE_PASSED;
+    }
+
+    /* A copy of the limits, the checks below do not hold the table */
+    loadedLimits = enterReloadTable(&limitsTable, &epoch);
+    if(NULL != loadedLimits) {
+        limits = *loadedLimits;
+    }
+    leaveReloadTable(&limitsTable, epoch);
+
+    if(NULL == loadedLimits) {
+        return ADMISSION_OK;
+    }
+
+    ratePerSecond = limits.terminalRatePerSecond;
+    burst = limits.terminalBurst;
+    if( (TERMINAL_OK == getTerminalConfig(transData->terminalData.terminalId, &config)) &&
+        (config.ratePerSecond > 0) ) {
+        ratePerSecond = config.ratePerSecond;
+        burst = config.burst;
+    }
+
+    /* The terminal bucket first, a flooding terminal must not drain the global one */
+    if(ratePerSecond > 0) {
+        terminalFullTime = getTerminalBucket(transData->terminalData.terminalId);
+        if( (NULL != terminalFullTime) && !takeToken(terminalFullTime, ratePerSecond, burst, now) ) {
+            return ADMISSION_TERMINAL_LIMIT;
+        }
+    }
+
+    /* Not admitted, the token of the terminal goes back */
+    if( !takeToken(&globalFullTime, limits.globalRatePerSecond, limits.globalBurst, now) ) {
+        if(NULL != terminalFullTime) {
+            giveBackToken(terminalFullTime, ratePerSecond, now);
+        }
+        return ADMISSION_GLOBAL_LIMIT;
+    }
+
+    return ADMISSION_OK;
+}
+
+uint64_t getAdmissionTime(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint64_t *getTerminalBucket(const uint32_t terminalId) {
+    const uint64_t key = (uint64_t)terminalId + 1;
+    uint32_t slot = (uint32_t)((terminalId * 0x9E3779B97F4A7C15ull) >> 32) & (ADMISSION_TERMINAL_SLOTS - 1);
+    uint64_t slotKey = 0;
+
+    for(;;) {
+        slotKey = __atomic_load_n(&(terminalBuckets[slot].key), __ATOMIC_ACQUIRE);
+        if(key == slotKey) {
+            return &(terminalBuckets[slot].fullTime);
+        }
+
+        if(0 == slotKey) {
+            /* Reserving a bucket first, so the table never fills past half */
+            if(__atomic_fetch_add(&terminalBucketsCount, 1, __ATOMIC_RELAXED) >= ADMISSION_MAX_TERMINALS) {
+                __atomic_fetch_sub(&terminalBucketsCount, 1, __ATOMIC_RELAXED);
+                return NULL;
+            }
+
+            if(__atomic_compare_exchange_n(&(terminalBuckets[slot].key), &slotKey, key, FALSE,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return &(terminalBuckets[slot].fullTime);
+            }
+
+            /* Another thread took the slot meanwhile, maybe for this terminal */
+            __atomic_fetch_sub(&terminalBucketsCount, 1, __ATOMIC_RELAXED);
+            if(key == slotKey) {
+                return &(terminalBuckets[slot].fullTime);
+            }
+        }
+
+        slot = (slot + 1) & (ADMISSION_TERMINAL_SLOTS - 1);
+    }
+}
+
+static BOOL_t takeToken(uint64_t * const fullTime, const float ratePerSecond, const uint32_t burst,
+                        const uint64_t now) {
+    uint64_t intervalTime = 0, fillTime = 0, current = 0, next = 0;
+
+    if( !(ratePerSecond > 0) ) {
+        return TRUE;
+    }
+
+    intervalTime = getTokenInterval(ratePerSecond);
+    fillTime = (burst > ADMISSION_MAX_FILL_TIME / intervalTime) ? ADMISSION_MAX_FILL_TIME : intervalTime * burst;
+
+    /* A full bucket is full from now on, a token taken leaves it one interval further */
+    current = __atomic_load_n(fullTime, __ATOMIC_RELAXED);
+    do {
+        next = ((current > now) ? current : now) + intervalTime;
+        if(next - now > fillTime) {
+            return FALSE;
+        }
+    } while( !__atomic_compare_exchange_n(fullTime, &current, next, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED) );
+
+    return TRUE;
+}
+
+static void giveBackToken(uint64_t * const fullTime, const float ratePerSecond, const uint64_t now) {
+    uint64_t intervalTime = 0, current = 0, next = 0;
+
+    if( !(ratePerSecond > 0) ) {
+        return;
+    }
+
+    intervalTime = getTokenInterval(ratePerSecond);
+
+    /* One interval earlier, a bucket full meanwhile stays as it is */
+    current = __atomic_load_n(fullTime, __ATOMIC_RELAXED);
+    do {
+        if(current <= now) {
+            return;
+        }
+        next = (current - now > intervalTime) ? (current - intervalTime) : now;
+    } while( !__atomic_compare_exchange_n(fullTime, &current, next, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED) );
+}
+
+static uint64_t getTokenInterval(const float ratePerSecond) {
+    const double interval = 1e9 / (double)ratePerSecond;
+
+    return (interval < 1) ? 1 :
+           (interval > (double)ADMISSION_MAX_FILL_TIME) ? ADMISSION_MAX_FILL_TIME : (uint64_t)interval;
+}
@@ -0,0 +1,125 @@
+/********************************************************************************
+ * @file    admission.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the admission control
+ *          \ref admission.c
+ * @details Every transaction reaching the server is admitted before any
+ *          authorization work, so a terminal flooding the server cannot starve
+ *          the others. Each terminal has a token bucket, refilled at the rate
+ *          of its configuration (see \ref config.h) or at the default terminal
+ *          rate, and the server has a global one. A transaction takes a token
+ *          from both, or is asked to try later.
+ *          A bucket is a single word, the time it is full again, updated with
+ *          a compare and swap, so the check takes no lock and terminals
+ *          checked from many threads do not wait for each other.
+ *          Under overload the transactions wait in the queues of the server:
+ *          those whose deadline passed meanwhile are shed without taking a
+ *          token, their terminal no longer waits for the answer.
+ *          With shards, each shard admits the transactions it serves.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Terminals with a bucket. The terminals beyond are only limited by
+ *          the global bucket.
+ ********************************************************************************/
+#define ADMISSION_MAX_TERMINALS     65536
+
+/*********************************************************************************
+ * @brief   Struct for the limits of the admission control, a rate of 0 lets
+ *          everything through
+ ********************************************************************************/
+typedef struct ST_admissionLimits_t {
+    float globalRatePerSecond;      /*!< Authorizations per second of the whole server */
+    uint32_t globalBurst;           /*!< Authorizations of the whole server at once after an idle time */
+    float terminalRatePerSecond;    /*!< Authorizations per second of a terminal with no rate configured */
+    uint32_t terminalBurst;         /*!< Authorizations of such a terminal at once after an idle time */
+} ST_admissionLimits_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different results of the <b>admission</b> module
+ ********************************************************************************/
+typedef enum EN_admissionError_t {
+    ADMISSION_OK,                   /*!< Admitted, or done */
+    ADMISSION_DEADLINE_PASSED,      /*!< Shed, the terminal no longer waits for the answer */
+    ADMISSION_TERMINAL_LIMIT,       /*!< The terminal is over its rate */
+    ADMISSION_GLOBAL_LIMIT,         /*!< The server is over its rate */
+    INVALID_ADMISSION_LIMITS,       /*!< Negative rate, or null burst with a rate */
+    ADMISSION_NO_MEMORY,            /*!< No memory for the new limits */
+    ADMISSION_FILE_ERROR            /*!< Limits file cannot be read or is invalid */
+} EN_admissionError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Make limits the active ones.
+ *
+ * @details     The limits are swapped in like the exchange rates, checks
+ *              running meanwhile finish on the previous ones. The buckets keep
+ *              their level. The previous limits are freed once those checks
+ *              are done, see \ref reload.h.
+ * @param[in]   limits: Pointer to the limits
+ * @return      EN_admissionError_t: ADMISSION_OK, INVALID_ADMISSION_LIMITS or
+ *              ADMISSION_NO_MEMORY. The active limits are unchanged on error.
+ ********************************************************************************/
+EN_admissionError_t loadAdmissionLimits(const ST_admissionLimits_t * const limits);
+
+/*********************************************************************************
+ * @brief       Load the limits from a text file, see \ref loadAdmissionLimits.
+ *
+ * @details     The file holds one line "globalRate globalBurst terminalRate
+ *              terminalBurst", e.g. "20000 2000 50 10".
+ * @param[in]   fileName: Path of the limits file
+ * @return      EN_admissionError_t: ADMISSION_OK, ADMISSION_FILE_ERROR or the
+ *              error of the load
+ ********************************************************************************/
+EN_admissionError_t loadAdmissionLimitsFile(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Free the limits and empty the buckets, every transaction is
+ *              admitted then, but those past their deadline.
+ ********************************************************************************/
+void unloadAdmissionLimits(void);
+
+/*********************************************************************************
+ * @brief       Admit a transaction, called by the server before authorizing it.
+ *
+ * @details     A transaction past its deadline takes no token. The token taken
+ *              from its terminal bucket is given back when the global bucket is
+ *              empty, only admitted transactions count against their terminal.
+ *              Safe from any number of threads.
+ * @param[in]   transData: Pointer to the transaction, its terminal ID and
+ *              deadline are read
+ * @param[in]   now: Current time, see \ref getAdmissionTime
+ * @return      EN_admissionError_t: ADMISSION_OK, ADMISSION_DEADLINE_PASSED,
+ *              ADMISSION_TERMINAL_LIMIT or ADMISSION_GLOBAL_LIMIT
+ ********************************************************************************/
+EN_admissionError_t admitTransaction(const ST_transaction_t * const transData, const uint64_t now);
+
+/*********************************************************************************
+ * @brief       Get the time of the clock of the deadlines, in nanoseconds of
+ *              the monotonic clock, shared by the processes of the machine.
+ ********************************************************************************/
+uint64_t getAdmissionTime(void);
+
+
+#endif      /* ADMISSION_H */
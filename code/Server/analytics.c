@@ -0,0 +1,628 @@
+/********************************************************************************
+ * @file    analytics.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the implementation of the transaction analytics
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "settlement.h"
+#include "analytics.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/*!< Rows filtered and totaled at once, a constant trip count lets the loops vectorize */
+#define ANALYTICS_BLOCK_ROWS        256
+
+/*!< Slots of the table giving the dictionary code of a terminal while encoding */
+#define ANALYTICS_TERMINAL_SLOTS    (2u * ANALYTICS_SEGMENT_ROWS)
+
+/*!< Days of a segment from which the declines are counted in one scattered pass */
+#define ANALYTICS_SCATTER_DAYS      4
+
+/*!< Transactions of a segment, one array per column */
+typedef struct ST_analyticsSegment_t {
+    uint32_t rowCount;
+    BOOL_t isSealed;                                /*!< Full, later transactions go to a new segment */
+    DATE_t minDay;                                  /*!< Zone map of the day column */
+    DATE_t maxDay;
+    uint32_t dayCount;
+    DATE_t days[ANALYTICS_SEGMENT_DAYS];            /*!< Day of each code, ascending */
+    uint32_t terminalCount;
+    uint32_t *terminals;                            /*!< Terminal ID of each code */
+    int32_t minCents;                               /*!< Amounts are stored as deltas from it */
+    uint8_t *dayCodes;
+    uint8_t *states;
+    uint16_t *accounts;
+    uint16_t *terminalCodes;
+    uint16_t *amounts16;                            /*!< Amount deltas, if they all fit on 16 bits */
+    uint32_t *amounts32;                            /*!< Amount deltas otherwise */
+} ST_analyticsSegment_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_analyticsSegment_t *segments[ANALYTICS_MAX_SEGMENTS];
+static uint32_t segmentCount = 0;
+
+/*!< Journal records in the segments */
+static uint64_t materializedCount = 0;
+
+/*!< Records being encoded */
+static ST_settlementRecord_t records[ANALYTICS_SEGMENT_ROWS];
+
+/*!< Terminal ID and code + 1 of each slot, 0 for a free slot */
+static uint32_t terminalSlotIds[ANALYTICS_TERMINAL_SLOTS];
+static uint32_t terminalSlotCodes[ANALYTICS_TERMINAL_SLOTS];
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_analyticsSegment_t *encodeSegment(const uint32_t recordCount);
+static void freeSegment(ST_analyticsSegment_t * const segment);
+static uint32_t findDay(const DATE_t * const days, const uint32_t dayCount, const DATE_t day);
+static BOOL_t getDayCodes(const ST_analyticsSegment_t * const segment, const DATE_t firstDay, const DATE_t lastDay,
+                          uint8_t * const firstCode, uint8_t * const codeSpan);
+static inline void sumBlock16(const ST_analyticsSegment_t * const segment, const uint32_t first, const uint32_t rows,
+                              const uint8_t firstCode, const uint8_t codeSpan, ST_analyticsSum_t * const sum);
+static inline void sumBlock32(const ST_analyticsSegment_t * const segment, const uint32_t first, const uint32_t rows,
+                              const uint8_t firstCode, const uint8_t codeSpan, ST_analyticsSum_t * const sum);
+static inline uint32_t countDeclinesBlock(const uint8_t * const dayCodes, const uint8_t * const states,
+                                          const uint32_t rows, const uint8_t code);
+static inline uint32_t selectBlock(const ST_analyticsSegment_t * const segment, const uint32_t first,
+                                   const uint8_t firstCode, const uint8_t codeSpan,
+                                   uint8_t * const isSelected, int32_t * const cents);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_analyticsError_t refreshAnalytics(void) {
+    ST_analyticsSegment_t *segment = NULL;
+    uint64_t journalCount = 0, recordCount = 0;
+
+    /* The last segment is encoded again with the transactions that joined it */
+    if( (segmentCount > 0) && !segments[segmentCount - 1]->isSealed ) {
+        --segmentCount;
+        materializedCount -= segments[segmentCount]->rowCount;
+        freeSegment(segments[segmentCount]);
+        segments[segmentCount] = NULL;
+    }
+
+    journalCount = getJournalCount();
+    while(materializedCount < journalCount) {
+        if(segmentCount >= ANALYTICS_MAX_SEGMENTS) {
+            return ANALYTICS_STORE_FULL;
+        }
+
+        recordCount = readJournal(materializedCount, ANALYTICS_SEGMENT_ROWS, records);
+        if(0 == recordCount) {
+            break;
+        }
+
+        segment = encodeSegment((uint32_t)recordCount);
+        if(NULL == segment) {
+            return ANALYTICS_MEMORY_ERROR;
+        }
+
+        segments[segmentCount] = segment;
+        ++segmentCount;
+        materializedCount += segment->rowCount;
+    }
+
+    return ANALYTICS_OK;
+}
+
+uint64_t getAnalyticsCount(void) {
+    return materializedCount;
+}
+
+void resetAnalytics(void) {
+    uint32_t i = 0;
+
+    for(i = 0; i < segmentCount; ++i) {
+        freeSegment(segments[i]);
+        segments[i] = NULL;
+    }
+
+    segmentCount = 0;
+    materializedCount = 0;
+}
+
+EN_analyticsError_t sumApproved(const DATE_t firstDay, const DATE_t lastDay, ST_analyticsSum_t * const sum) {
+    const ST_analyticsSegment_t *segment = NULL;
+    uint32_t i = 0, row = 0, rows = 0;
+    uint8_t firstCode = 0, codeSpan = 0;
+
+    if( (NULL == sum) || (firstDay > lastDay) ) {
+        return ANALYTICS_QUERY_ERROR;
+    }
+
+    sum->count = 0;
+    sum->cents = 0;
+
+    for(i = 0; i < segmentCount; ++i) {
+        segment = segments[i];
+        if( !getDayCodes(segment, firstDay, lastDay, &firstCode, &codeSpan) ) {
+            continue;
+        }
+
+        for(row = 0; row < segment->rowCount; row += rows) {
+            rows = segment->rowCount - row;
+            if(rows >= ANALYTICS_BLOCK_ROWS) {
+                rows = ANALYTICS_BLOCK_ROWS;
+                if(NULL != segment->amounts16) {
+                    sumBlock16(segment, row, ANALYTICS_BLOCK_ROWS, firstCode, codeSpan, sum);
+                } else {
+                    sumBlock32(segment, row, ANALYTICS_BLOCK_ROWS, firstCode, codeSpan, sum);
+                }
+            } else if(NULL != segment->amounts16) {
+                sumBlock16(segment, row, rows, firstCode, codeSpan, sum);
+            } else {
+                sumBlock32(segment, row, rows, firstCode, codeSpan, sum);
+            }
+        }
+    }
+
+    return ANALYTICS_OK;
+}
+
+uint32_t getDeclinesPerDay(const DATE_t firstDay, const DATE_t lastDay, ST_dayCount_t * const days,
+                           const uint32_t maxDays) {
+    const ST_analyticsSegment_t *segment = NULL;
+    uint32_t codeCounts[ANALYTICS_SEGMENT_DAYS];
+    uint32_t i = 0, row = 0, rows = 0, code = 0, index = 0, dayCount = 0;
+    uint8_t firstCode = 0, codeSpan = 0;
+
+    if( (NULL == days) || (firstDay > lastDay) ) {
+        return 0;
+    }
+
+    for(i = 0; i < segmentCount; ++i) {
+        segment = segments[i];
+        if( !getDayCodes(segment, firstDay, lastDay, &firstCode, &codeSpan) ) {
+            continue;
+        }
+
+        memset(codeCounts, 0, sizeof(codeCounts));
+        if(codeSpan < ANALYTICS_SCATTER_DAYS) {
+            /* A segment usually holds one or two days, a pass per day compares whole vectors */
+            for(code = firstCode; code <= (uint32_t)firstCode + codeSpan; ++code) {
+                for(row = 0; row < segment->rowCount; row += rows) {
+                    rows = segment->rowCount - row;
+                    if(rows >= ANALYTICS_BLOCK_ROWS) {
+                        rows = ANALYTICS_BLOCK_ROWS;
+                        codeCounts[code] += countDeclinesBlock(&(segment->dayCodes[row]), &(segment->states[row]),
+                                                               ANALYTICS_BLOCK_ROWS, (uint8_t)code);
+                    } else {
+                        codeCounts[code] += countDeclinesBlock(&(segment->dayCodes[row]), &(segment->states[row]),
+                                                               rows, (uint8_t)code);
+                    }
+                }
+            }
+        } else {
+            for(row = 0; row < segment->rowCount; ++row) {
+                codeCounts[segment->dayCodes[row]] += (APPROVED != segment->states[row]);
+            }
+        }
+
+        /* Merging into the days found so far, kept ascending */
+        for(code = firstCode; code <= (uint32_t)firstCode + codeSpan; ++code) {
+            if(0 == codeCounts[code]) {
+                continue;
+            }
+
+            for(index = 0; (index < dayCount) && (days[index].day < segment->days[code]); ++index) {
+            }
+
+            if( (index < dayCount) && (days[index].day == segment->days[code]) ) {
+                days[index].count += codeCounts[code];
+            } else if(index < maxDays) {
+                if(dayCount == maxDays) {
+                    --dayCount;
+                }
+                memmove(&days[index + 1], &days[index], (dayCount - index) * sizeof(ST_dayCount_t));
+                days[index].day = segment->days[code];
+                days[index].count = codeCounts[code];
+                ++dayCount;
+            }
+        }
+    }
+
+    return dayCount;
+}
+
+EN_analyticsError_t getAmountHistogram(const DATE_t firstDay, const DATE_t lastDay, const uint32_t bucketCents,
+                                       const uint32_t bucketCount, uint64_t * const counts) {
+    const ST_analyticsSegment_t *segment = NULL;
+    uint8_t isSelected[ANALYTICS_BLOCK_ROWS];
+    int32_t cents[ANALYTICS_BLOCK_ROWS];
+    uint32_t i = 0, row = 0, rows = 0, j = 0, shift = 32;
+    uint64_t bucket = 0, inverse = 0;
+    uint8_t firstCode = 0, codeSpan = 0;
+
+    if( (NULL == counts) || (0 == bucketCents) || (0 == bucketCount) || (firstDay > lastDay) ) {
+        return ANALYTICS_QUERY_ERROR;
+    }
+
+    memset(counts, 0, bucketCount * sizeof(uint64_t));
+
+    /* Dividing by a multiplication: exact for 32 bit amounts with 32 + log2(width) bits */
+    while( (shift < 64) && ((1ull << (shift - 32)) < bucketCents) ) {
+        ++shift;
+    }
+    inverse = (shift >= 64) ? 0 : (((1ull << shift) + bucketCents - 1) / bucketCents);
+
+    for(i = 0; i < segmentCount; ++i) {
+        segment = segments[i];
+        if( !getDayCodes(segment, firstDay, lastDay, &firstCode, &codeSpan) ) {
+            continue;
+        }
+
+        for(row = 0; row < segment->rowCount; row += rows) {
+            rows = selectBlock(segment, row, firstCode, codeSpan, isSelected, cents);
+
+            for(j = 0; j < rows; ++j) {
+                if(isSelected[j]) {
+                    bucket = (cents[j] < 0) ? 0 : ((0 == inverse) ? 0 : (((uint64_t)cents[j] * inverse) >> shift));
+                    ++counts[(bucket < bucketCount) ? bucket : (bucketCount - 1)];
+                }
+            }
+        }
+    }
+
+    return ANALYTICS_OK;
+}
+
+uint32_t getTopSpenders(const DATE_t firstDay, const DATE_t lastDay, ST_spender_t * const spenders,
+                        const uint32_t maxSpenders) {
+    static int64_t accountCents[ACCOUNTS_DB_SIZE];
+    static uint64_t accountCounts[ACCOUNTS_DB_SIZE];
+    const ST_analyticsSegment_t *segment = NULL;
+    uint8_t isSelected[ANALYTICS_BLOCK_ROWS];
+    int32_t cents[ANALYTICS_BLOCK_ROWS];
+    uint32_t i = 0, row = 0, rows = 0, j = 0, account = 0, spenderCount = 0, index = 0;
+    uint8_t firstCode = 0, codeSpan = 0;
+
+    if( (NULL == spenders) || (firstDay > lastDay) ) {
+        return 0;
+    }
+
+    memset(accountCents, 0, sizeof(accountCents));
+    memset(accountCounts, 0, sizeof(accountCounts));
+
+    for(i = 0; i < segmentCount; ++i) {
+        segment = segments[i];
+        if( !getDayCodes(segment, firstDay, lastDay, &firstCode, &codeSpan) ) {
+            continue;
+        }
+
+        for(row = 0; row < segment->rowCount; row += rows) {
+            rows = selectBlock(segment, row, firstCode, codeSpan, isSelected, cents);
+
+            for(j = 0; j < rows; ++j) {
+                account = segment->accounts[row + j];
+                if(account < ACCOUNTS_DB_SIZE) {
+                    accountCents[account] += isSelected[j] ? cents[j] : 0;
+                    accountCounts[account] += isSelected[j];
+                }
+            }
+        }
+    }
+
+    /* Insertion into the top N, kept by descending amount */
+    for(account = 0; account < ACCOUNTS_DB_SIZE; ++account) {
+        if( (0 == accountCounts[account]) || (0 == maxSpenders) ) {
+            continue;
+        }
+        if( (spenderCount == maxSpenders) && (spenders[maxSpenders - 1].cents >= accountCents[account]) ) {
+            continue;
+        }
+
+        index = (spenderCount < maxSpenders) ? spenderCount++ : (maxSpenders - 1);
+        for(; (index > 0) && (spenders[index - 1].cents < accountCents[account]); --index) {
+            spenders[index] = spenders[index - 1];
+        }
+
+        spenders[index].accountIndex = (uint16_t)account;
+        spenders[index].cents = accountCents[account];
+        spenders[index].count = accountCounts[account];
+    }
+
+    return spenderCount;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PRIVATE FUNCTION DEFINITIONS                        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Encode the first records of \ref records into a new segment.
+ *              Fewer records are taken if they span more days than a segment
+ *              holds.
+ * @return      ST_analyticsSegment_t *: The segment, NULL if out of memory
+ *******************************************************************************/
+static ST_analyticsSegment_t *encodeSegment(const uint32_t recordCount) {
+    ST_analyticsSegment_t *segment = NULL;
+    uint32_t rowCount = 0, row = 0, index = 0, slot = 0;
+    int32_t maxCents = 0;
+    DATE_t lastDay = DATE_INVALID;
+    uint8_t lastCode = 0;
+
+    segment = calloc(1, sizeof(*segment));
+    if(NULL == segment) {
+        return NULL;
+    }
+
+    /* The day dictionary, sorted, ends the segment when it is full */
+    for(rowCount = 0; rowCount < recordCount; ++rowCount) {
+        if(records[rowCount].transactionDay == lastDay) {
+            continue;
+        }
+
+        lastDay = records[rowCount].transactionDay;
+        index = findDay(segment->days, segment->dayCount, lastDay);
+        if( (index < segment->dayCount) && (segment->days[index] == lastDay) ) {
+            continue;
+        }
+        if(segment->dayCount >= ANALYTICS_SEGMENT_DAYS) {
+            break;
+        }
+
+        memmove(&(segment->days[index + 1]), &(segment->days[index]), (segment->dayCount - index) * sizeof(DATE_t));
+        segment->days[index] = lastDay;
+        ++(segment->dayCount);
+    }
+
+    segment->rowCount = rowCount;
+    segment->isSealed = (ANALYTICS_SEGMENT_ROWS == rowCount) || (rowCount < recordCount);
+    segment->minDay = segment->days[0];
+    segment->maxDay = segment->days[segment->dayCount - 1];
+
+    segment->minCents = records[0].amountCents;
+    maxCents = records[0].amountCents;
+    for(row = 1; row < rowCount; ++row) {
+        segment->minCents = (records[row].amountCents < segment->minCents) ? records[row].amountCents : segment->minCents;
+        maxCents = (records[row].amountCents > maxCents) ? records[row].amountCents : maxCents;
+    }
+
+    segment->dayCodes = malloc(rowCount * sizeof(uint8_t));
+    segment->states = malloc(rowCount * sizeof(uint8_t));
+    segment->accounts = malloc(rowCount * sizeof(uint16_t));
+    segment->terminalCodes = malloc(rowCount * sizeof(uint16_t));
+    segment->terminals = malloc(rowCount * sizeof(uint32_t));
+    if((int64_t)maxCents - segment->minCents <= UINT16_MAX) {
+        segment->amounts16 = malloc(rowCount * sizeof(uint16_t));
+    } else {
+        segment->amounts32 = malloc(rowCount * sizeof(uint32_t));
+    }
+
+    if( (NULL == segment->dayCodes) || (NULL == segment->states) || (NULL == segment->accounts) ||
+        (NULL == segment->terminalCodes) || (NULL == segment->terminals) ||
+        ( (NULL == segment->amounts16) && (NULL == segment->amounts32) ) ) {
+        freeSegment(segment);
+        return NULL;
+    }
+
+    memset(terminalSlotCodes, 0, sizeof(terminalSlotCodes));
+    lastDay = DATE_INVALID;
+
+    for(row = 0; row < rowCount; ++row) {
+        if(records[row].transactionDay != lastDay) {
+            lastDay = records[row].transactionDay;
+            lastCode = (uint8_t)findDay(segment->days, segment->dayCount, lastDay);
+        }
+        segment->dayCodes[row] = lastCode;
+
+        segment->states[row] = records[row].transState;
+        segment->accounts[row] = records[row].accountIndex;
+
+        slot = (uint32_t)((records[row].terminalId * 0x9E3779B97F4A7C15ull) >> 32) & (ANALYTICS_TERMINAL_SLOTS - 1);
+        while( (0 != terminalSlotCodes[slot]) && (terminalSlotIds[slot] != records[row].terminalId) ) {
+            slot = (slot + 1) & (ANALYTICS_TERMINAL_SLOTS - 1);
+        }
+        if(0 == terminalSlotCodes[slot]) {
+            terminalSlotIds[slot] = records[row].terminalId;
+            segment->terminals[segment->terminalCount] = records[row].terminalId;
+            ++(segment->terminalCount);
+            terminalSlotCodes[slot] = segment->terminalCount;
+        }
+        segment->terminalCodes[row] = (uint16_t)(terminalSlotCodes[slot] - 1);
+
+        if(NULL != segment->amounts16) {
+            segment->amounts16[row] = (uint16_t)(records[row].amountCents - segment->minCents);
+        } else {
+            segment->amounts32[row] = (uint32_t)((int64_t)records[row].amountCents - segment->minCents);
+        }
+    }
+
+    return segment;
+}
+
+/********************************************************************************
+ * @brief       Free a segment and its columns
+ *******************************************************************************/
+static void freeSegment(ST_analyticsSegment_t * const segment) {
+
+    if(NULL == segment) {
+        return;
+    }
+
+    free(segment->dayCodes);
+    free(segment->states);
+    free(segment->accounts);
+    free(segment->terminalCodes);
+    free(segment->terminals);
+    free(segment->amounts16);
+    free(segment->amounts32);
+    free(segment);
+}
+
+/********************************************************************************
+ * @brief       Binary search of a day in an ascending dictionary
+ * @return      uint32_t: Index of the day, or where to insert it
+ *******************************************************************************/
+static uint32_t findDay(const DATE_t * const days, const uint32_t dayCount, const DATE_t day) {
+    uint32_t low = 0, high = dayCount, middle = 0;
+
+    while(low < high) {
+        middle = (low + high) / 2;
+        if(days[middle] < day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/********************************************************************************
+ * @brief       Turn a range of days into the range of codes of a segment, the
+ *              days being sorted the codes of the range are contiguous
+ * @return      BOOL_t: FALSE if no day of the segment is in the range
+ *******************************************************************************/
+static BOOL_t getDayCodes(const ST_analyticsSegment_t * const segment, const DATE_t firstDay, const DATE_t lastDay,
+                          uint8_t * const firstCode, uint8_t * const codeSpan) {
+    uint32_t first = 0, end = 0;
+
+    if( (segment->maxDay < firstDay) || (segment->minDay > lastDay) ) {
+        return FALSE;
+    }
+
+    first = findDay(segment->days, segment->dayCount, firstDay);
+    end = findDay(segment->days, segment->dayCount, lastDay);
+    if( (end < segment->dayCount) && (segment->days[end] == lastDay) ) {
+        ++end;
+    }
+    if(first >= end) {
+        return FALSE;
+    }
+
+    *firstCode = (uint8_t)first;
+    *codeSpan = (uint8_t)(end - 1 - first);
+
+    return TRUE;
+}
+
+/********************************************************************************
+ * @brief       Total the approved rows of the selected days, 16 bit amounts
+ *******************************************************************************/
+static inline void sumBlock16(const ST_analyticsSegment_t * const segment, const uint32_t first, const uint32_t rows,
+                              const uint8_t firstCode, const uint8_t codeSpan, ST_analyticsSum_t * const sum) {
+    const uint8_t * const dayCodes = &(segment->dayCodes[first]);
+    const uint8_t * const states = &(segment->states[first]);
+    const uint16_t * const amounts = &(segment->amounts16[first]);
+    uint32_t i = 0, count = 0, deltas = 0, isSelected = 0;
+
+    /* Fits: ANALYTICS_BLOCK_ROWS * UINT16_MAX < 2^32 */
+    for(i = 0; i < rows; ++i) {
+        isSelected = ((uint8_t)(dayCodes[i] - firstCode) <= codeSpan) & (APPROVED == states[i]);
+        count += isSelected;
+        deltas += amounts[i] * isSelected;
+    }
+
+    sum->count += count;
+    sum->cents += (int64_t)deltas + (int64_t)count * segment->minCents;
+}
+
+/********************************************************************************
+ * @brief       Total the approved rows of the selected days, 32 bit amounts
+ *******************************************************************************/
+static inline void sumBlock32(const ST_analyticsSegment_t * const segment, const uint32_t first, const uint32_t rows,
+                              const uint8_t firstCode, const uint8_t codeSpan, ST_analyticsSum_t * const sum) {
+    const uint8_t * const dayCodes = &(segment->dayCodes[first]);
+    const uint8_t * const states = &(segment->states[first]);
+    const uint32_t * const amounts = &(segment->amounts32[first]);
+    uint32_t i = 0, count = 0;
+    uint64_t deltas = 0, isSelected = 0;
+
+    for(i = 0; i < rows; ++i) {
+        isSelected = ((uint8_t)(dayCodes[i] - firstCode) <= codeSpan) & (APPROVED == states[i]);
+        count += (uint32_t)isSelected;
+        deltas += amounts[i] * isSelected;
+    }
+
+    sum->count += count;
+    sum->cents += (int64_t)deltas + (int64_t)count * segment->minCents;
+}
+
+/********************************************************************************
+ * @brief       Count the declined rows of a day code
+ *******************************************************************************/
+static inline uint32_t countDeclinesBlock(const uint8_t * const dayCodes, const uint8_t * const states,
+                                          const uint32_t rows, const uint8_t code) {
+    uint32_t i = 0;
+    uint16_t count = 0;
+
+    /* 16 bit counters hold a block and vectorize better than wider ones */
+    for(i = 0; i < rows; ++i) {
+        count += (code == dayCodes[i]) & (APPROVED != states[i]);
+    }
+
+    return count;
+}
+
+/********************************************************************************
+ * @brief       Flag the approved rows of the selected days of a block, and
+ *              decode their amounts
+ * @return      uint32_t: Rows of the block, ANALYTICS_BLOCK_ROWS but at the
+ *              end of the segment
+ *******************************************************************************/
+static inline uint32_t selectBlock(const ST_analyticsSegment_t * const segment, const uint32_t first,
+                                   const uint8_t firstCode, const uint8_t codeSpan,
+                                   uint8_t * const isSelected, int32_t * const cents) {
+    const uint8_t * const dayCodes = &(segment->dayCodes[first]);
+    const uint8_t * const states = &(segment->states[first]);
+    uint32_t i = 0, rows = segment->rowCount - first;
+
+    if(rows >= ANALYTICS_BLOCK_ROWS) {
+        rows = ANALYTICS_BLOCK_ROWS;
+    }
+
+    for(i = 0; i < rows; ++i) {
+        isSelected[i] = ((uint8_t)(dayCodes[i] - firstCode) <= codeSpan) & (APPROVED == states[i]);
+    }
+
+    if(NULL != segment->amounts16) {
+        for(i = 0; i < rows; ++i) {
+            cents[i] = segment->minCents + (int32_t)segment->amounts16[first + i];
+        }
+    } else {
+        for(i = 0; i < rows; ++i) {
+            cents[i] = segment->minCents + (int32_t)segment->amounts32[first + i];
+        }
+    }
+
+    return rows;
+}
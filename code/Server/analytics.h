@@ -0,0 +1,157 @@
+/********************************************************************************
+ * @file    analytics.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the transaction analytics
+ *          \ref analytics.c
+ * @details The settlement journal is materialized into column segments of up
+ *          to \ref ANALYTICS_SEGMENT_ROWS transactions: the days and terminals
+ *          are dictionary encoded, the amounts are stored as deltas from the
+ *          segment minimum on 16 bits when they fit. The queries only read the
+ *          columns they need, skip the segments outside their days using the
+ *          segment minimum and maximum day, and filter and total fixed blocks
+ *          of rows with branch free loops the compiler turns into SIMD code.
+ *          The store is not thread safe, refresh and query it from one thread.
+ *          Refreshing only reads the published part of the journal, so the
+ *          authorizations go on meanwhile.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of transactions of a segment
+ ********************************************************************************/
+#define ANALYTICS_SEGMENT_ROWS      (1u << 16)
+
+/*********************************************************************************
+ * @brief   Maximum number of segments, as many as the journal can fill
+ ********************************************************************************/
+#define ANALYTICS_MAX_SEGMENTS      ((SETTLEMENT_MAX_BLOCKS * SETTLEMENT_BLOCK_SIZE) / ANALYTICS_SEGMENT_ROWS * 2)
+
+/*********************************************************************************
+ * @brief   Maximum number of distinct days of a segment, a segment is sealed
+ *          early when its transactions span more days
+ ********************************************************************************/
+#define ANALYTICS_SEGMENT_DAYS      256
+
+/*********************************************************************************
+ * @brief   Struct for the total of the approved transactions
+ ********************************************************************************/
+typedef struct ST_analyticsSum_t {
+    uint64_t count;                 /*!< Approved transactions */
+    int64_t cents;                  /*!< Their amount, in cents */
+} ST_analyticsSum_t;
+
+/*********************************************************************************
+ * @brief   Struct for the number of declined transactions of a day
+ ********************************************************************************/
+typedef struct ST_dayCount_t {
+    DATE_t day;                     /*!< Day */
+    uint64_t count;                 /*!< Declined transactions */
+} ST_dayCount_t;
+
+/*********************************************************************************
+ * @brief   Struct for the total spent by an account
+ ********************************************************************************/
+typedef struct ST_spender_t {
+    uint16_t accountIndex;          /*!< Index in the accounts database */
+    uint64_t count;                 /*!< Approved transactions */
+    int64_t cents;                  /*!< Their amount, in cents */
+} ST_spender_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>analytics</b> module
+ ********************************************************************************/
+typedef enum EN_analyticsError_t {
+    ANALYTICS_OK,                   /*!< Done */
+    ANALYTICS_MEMORY_ERROR,         /*!< Memory allocation failed */
+    ANALYTICS_STORE_FULL,           /*!< No segment left for the journal */
+    ANALYTICS_QUERY_ERROR           /*!< Invalid arguments */
+} EN_analyticsError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Materialize the transactions journaled since the last refresh.
+ *
+ * @return      EN_analyticsError_t: ANALYTICS_OK or the error
+ ********************************************************************************/
+EN_analyticsError_t refreshAnalytics(void);
+
+/*********************************************************************************
+ * @brief       Get the number of materialized transactions.
+ ********************************************************************************/
+uint64_t getAnalyticsCount(void);
+
+/*********************************************************************************
+ * @brief       Free every segment, e.g. after \ref resetJournal.
+ ********************************************************************************/
+void resetAnalytics(void);
+
+/*********************************************************************************
+ * @brief       Total the approved transactions of a range of days.
+ *
+ * @param[in]   firstDay: First day of the range
+ * @param[in]   lastDay: Last day of the range, included
+ * @param[out]  sum: Count and amount
+ * @return      EN_analyticsError_t: ANALYTICS_OK or ANALYTICS_QUERY_ERROR
+ ********************************************************************************/
+EN_analyticsError_t sumApproved(const DATE_t firstDay, const DATE_t lastDay, ST_analyticsSum_t * const sum);
+
+/*********************************************************************************
+ * @brief       Count the declined transactions of each day of a range.
+ *
+ * @param[in]   firstDay: First day of the range
+ * @param[in]   lastDay: Last day of the range, included
+ * @param[out]  days: Days with declines, ascending
+ * @param[in]   maxDays: Size of days, later days are left out
+ * @return      uint32_t: Number of days written
+ ********************************************************************************/
+uint32_t getDeclinesPerDay(const DATE_t firstDay, const DATE_t lastDay, ST_dayCount_t * const days,
+                           const uint32_t maxDays);
+
+/*********************************************************************************
+ * @brief       Count the approved transactions of a range of days by amount.
+ *
+ * @param[in]   firstDay: First day of the range
+ * @param[in]   lastDay: Last day of the range, included
+ * @param[in]   bucketCents: Width of a bucket, bucket i counts the amounts from
+ *              i * bucketCents, the last one also counts every larger amount
+ * @param[in]   bucketCount: Number of buckets
+ * @param[out]  counts: Count of each bucket
+ * @return      EN_analyticsError_t: ANALYTICS_OK or ANALYTICS_QUERY_ERROR
+ ********************************************************************************/
+EN_analyticsError_t getAmountHistogram(const DATE_t firstDay, const DATE_t lastDay, const uint32_t bucketCents,
+                                       const uint32_t bucketCount, uint64_t * const counts);
+
+/*********************************************************************************
+ * @brief       Get the accounts that spent the most over a range of days.
+ *
+ * @param[in]   firstDay: First day of the range
+ * @param[in]   lastDay: Last day of the range, included
+ * @param[out]  spenders: Accounts by descending amount
+ * @param[in]   maxSpenders: N of the top N
+ * @return      uint32_t: Number of accounts written
+ ********************************************************************************/
+uint32_t getTopSpenders(const DATE_t firstDay, const DATE_t lastDay, ST_spender_t * const spenders,
+                        const uint32_t maxSpenders);
+
+
+#endif      /* ANALYTICS_H */
@@ -0,0 +1,278 @@
+/********************************************************************************
+ * @file    exchange.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the exchange rates module implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "reload.h"
+#include "exchange.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Struct for a rate split at the decimal point, so that converting an
+ *          amount of up to \ref EXCHANGE_MAX_CENTS never overflows
+ ********************************************************************************/
+typedef struct ST_exchangeRate_t {
+    uint32_t units;                 /*!< Integer part */
+    uint32_t fraction;              /*!< Decimals, times EXCHANGE_RATE_SCALE */
+} ST_exchangeRate_t;
+
+/********************************************************************************
+ * @brief   Struct for a rate table. Row and column 0 are the currencies of no
+ *          quote, their rates stay null so a lookup needs no bounds check.
+ ********************************************************************************/
+typedef struct ST_exchangeTable_t {
+    uint8_t slots[CURRENCY_CODES];                                                      /*!< Row and column of each currency */
+    ST_exchangeRate_t rates[EXCHANGE_MAX_CURRENCIES + 1][EXCHANGE_MAX_CURRENCIES + 1];  /*!< Rate by base and quote slot */
+} ST_exchangeTable_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The rate table read by the authorizations, none when not loaded
+ ********************************************************************************/
+static ST_reloadTable_t rateTable = RELOAD_TABLE_INITIALIZER;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Parse a rate such as "48.2515" without going through a float.
+ *
+ * @param[in]   text: Null terminated rate, at most EXCHANGE_RATE_DECIMALS
+ *              decimals
+ * @return      uint64_t: The rate times EXCHANGE_RATE_SCALE, 0 if invalid
+ ********************************************************************************/
+static uint64_t parseRate(const char * const text);
+
+/********************************************************************************
+ * @brief       Get the slot of a currency in a table being built, giving it the
+ *              next free one if it has none.
+ *
+ * @return      uint8_t: The slot, 0 if every slot is taken
+ ********************************************************************************/
+static uint8_t takeSlot(ST_exchangeTable_t * const table, const CURRENCY_t currency, uint8_t * const slotCount);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_exchangeError_t loadExchangeRates(const ST_exchangeQuote_t * const quotes, const uint32_t count) {
+    ST_exchangeTable_t *table = NULL;
+    ST_exchangeRate_t *rate = NULL;
+    uint32_t i = 0;
+    uint8_t slotCount = 0, baseSlot = 0, quoteSlot = 0;
+
+    if( (NULL == quotes) && (count > 0) ) {
+        return INVALID_EXCHANGE_QUOTES;
+    }
+
+    table = calloc(1, sizeof(*table));
+    if(NULL == table) {
+        return EXCHANGE_NO_MEMORY;
+    }
+
+    for(i = 0; i < count; ++i) {
+        if( (CURRENCY_NONE == quotes[i].baseCurrency) || (CURRENCY_NONE == quotes[i].quoteCurrency) ||
+            (quotes[i].baseCurrency >= CURRENCY_CODES) || (quotes[i].quoteCurrency >= CURRENCY_CODES) ||
+            (quotes[i].baseCurrency == quotes[i].quoteCurrency)                                      ||
+            (0 == quotes[i].rate) || (quotes[i].rate / EXCHANGE_RATE_SCALE > EXCHANGE_MAX_RATE) ) {
+            free(table);
+            return INVALID_EXCHANGE_QUOTES;
+        }
+
+        baseSlot = takeSlot(table, quotes[i].baseCurrency, &slotCount);
+        quoteSlot = takeSlot(table, quotes[i].quoteCurrency, &slotCount);
+        rate = &(table->rates[baseSlot][quoteSlot]);
+
+        /* A pair quoted twice is an error, the slots of no room are too */
+        if( (0 == baseSlot) || (0 == quoteSlot) || (0 != rate->units) || (0 != rate->fraction) ) {
+            free(table);
+            return INVALID_EXCHANGE_QUOTES;
+        }
+
+        rate->units    = (uint32_t)(quotes[i].rate / EXCHANGE_RATE_SCALE);
+        rate->fraction = (uint32_t)(quotes[i].rate % EXCHANGE_RATE_SCALE);
+    }
+
+    /* Publishing the new table, the old one is freed once the conversions in flight are done */
+    swapReloadTable(&rateTable, table);
+
+    return EXCHANGE_OK;
+}
+
+EN_exchangeError_t loadExchangeRatesFile(const char * const fileName) {
+    FILE *file = NULL;
+    ST_exchangeQuote_t *quotes = NULL;
+    uint32_t count = 0, capacity = EXCHANGE_MAX_CURRENCIES * (EXCHANGE_MAX_CURRENCIES - 1);
+    char baseText[8], quoteText[8], rateText[32], line[64];
+    EN_exchangeError_t exchangeError = EXCHANGE_OK;
+
+    if(NULL == fileName) {
+        return EXCHANGE_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return EXCHANGE_FILE_ERROR;
+    }
+
+    /* As many quotes as there are pairs of currencies */
+    quotes = malloc(capacity * sizeof(*quotes));
+
+    while( (NULL != quotes) && (EXCHANGE_OK == exchangeError) && (NULL != fgets(line, sizeof(line), file)) ) {
+        if(1 > sscanf(line, "%7s", baseText)) {
+            continue;           /* Empty line */
+        }
+
+        if( (3 != sscanf(line, "%7s %7s %31s", baseText, quoteText, rateText)) || (count == capacity) ) {
+            exchangeError = (count == capacity) ? INVALID_EXCHANGE_QUOTES : EXCHANGE_FILE_ERROR;
+            break;
+        }
+
+        quotes[count].rate = parseRate(rateText);
+        if( (TERMINAL_OK != parseCurrency((uint8_t *)baseText, &(quotes[count].baseCurrency)))   ||
+            (TERMINAL_OK != parseCurrency((uint8_t *)quoteText, &(quotes[count].quoteCurrency))) ||
+            (0 == quotes[count].rate) ) {
+            exchangeError = EXCHANGE_FILE_ERROR;
+            break;
+        }
+
+        ++count;
+    }
+
+    fclose(file);
+
+    if(NULL == quotes) {
+        return EXCHANGE_NO_MEMORY;
+    }
+
+    if(EXCHANGE_OK == exchangeError) {
+        exchangeError = loadExchangeRates(quotes, count);
+    }
+
+    free(quotes);
+
+    return exchangeError;
+}
+
+void unloadExchangeRates(void) {
+    swapReloadTable(&rateTable, NULL);
+}
+
+EN_exchangeError_t convertAmount(const int64_t cents, const CURRENCY_t baseCurrency, const CURRENCY_t quoteCurrency,
+                                 int64_t * const convertedCents) {
+    const ST_exchangeTable_t *table = NULL;
+    ST_exchangeRate_t rate = {0, 0};
+    uint32_t epoch = 0;
+
+    if(NULL == convertedCents) {
+        return EXCHANGE_NO_RATE;
+    }
+
+    if( (baseCurrency == quoteCurrency) || (CURRENCY_NONE == baseCurrency) || (CURRENCY_NONE == quoteCurrency) ) {
+        *convertedCents = cents;
+        return EXCHANGE_OK;
+    }
+
+    if( (cents < 0) || (cents > EXCHANGE_MAX_CENTS) ) {
+        return EXCHANGE_INVALID_AMOUNT;
+    }
+
+    table = enterReloadTable(&rateTable, &epoch);
+    if(NULL != table) {
+        rate = table->rates[table->slots[baseCurrency % CURRENCY_CODES]][table->slots[quoteCurrency % CURRENCY_CODES]];
+    }
+    leaveReloadTable(&rateTable, epoch);
+
+    if( (0 == rate.units) && (0 == rate.fraction) ) {
+        return EXCHANGE_NO_RATE;
+    }
+
+    /* cents * rate / scale, the division by a constant compiles to a multiplication */
+    *convertedCents = (int64_t)( (uint64_t)cents * rate.units +
+                                 ((uint64_t)cents * rate.fraction + EXCHANGE_RATE_SCALE / 2) / EXCHANGE_RATE_SCALE );
+
+    return EXCHANGE_OK;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint64_t parseRate(const char * const text) {
+    const char *digit = text;
+    uint64_t rate = 0;
+    uint8_t decimals = 0;
+    BOOL_t isFraction = FALSE;
+
+    for(digit = text; '\0' != *digit; ++digit) {
+        if( ('.' == *digit) && !isFraction ) {
+            isFraction = TRUE;
+            continue;
+        }
+
+        if( (*digit < '0') || (*digit > '9') || (decimals == EXCHANGE_RATE_DECIMALS) ) {
+            return 0;
+        }
+
+        rate = rate * 10 + (uint64_t)(*digit - '0');
+        decimals += isFraction;
+
+        /* Stopping before the scaling below can overflow */
+        if( !isFraction && (rate > EXCHANGE_MAX_RATE) ) {
+            return 0;
+        }
+    }
+
+    /* Scaling the decimals given up to EXCHANGE_RATE_DECIMALS */
+    for(; decimals < EXCHANGE_RATE_DECIMALS; ++decimals) {
+        rate *= 10;
+    }
+
+    return (rate / EXCHANGE_RATE_SCALE > EXCHANGE_MAX_RATE) ? 0 : rate;
+}
+
+static uint8_t takeSlot(ST_exchangeTable_t * const table, const CURRENCY_t currency, uint8_t * const slotCount) {
+
+    if( (0 == table->slots[currency]) && (*slotCount < EXCHANGE_MAX_CURRENCIES) ) {
+        ++(*slotCount);
+        table->slots[currency] = *slotCount;
+    }
+
+    return table->slots[currency];
+}
@@ -0,0 +1,127 @@
+/********************************************************************************
+ * @file    exchange.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the exchange rates
+ *          \ref exchange.c
+ * @details Terminals acquire in their own currency while balances are kept in
+ *          the currency of the account. The rates between them are held in a
+ *          table indexed by the packed currency codes, so converting an amount
+ *          is two loads, a multiplication and a division by a constant. Rates
+ *          are exact decimals with up to \ref EXCHANGE_RATE_DECIMALS decimals
+ *          and amounts are converted in integer cents, rounded half up. The
+ *          table is reloaded like the routing table: built aside, then swapped
+ *          in, so conversions are never blocked.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef EXCHANGE_H
+#define EXCHANGE_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Decimals of a rate, and the rate of 1 as stored in ST_exchangeQuote_t
+ ********************************************************************************/
+#define EXCHANGE_RATE_DECIMALS      8
+#define EXCHANGE_RATE_SCALE         100000000ull
+
+/*********************************************************************************
+ * @brief   Largest rate, in units of the quoted currency per unit of the base
+ ********************************************************************************/
+#define EXCHANGE_MAX_RATE           ((1ull << 27) - 1)
+
+/*********************************************************************************
+ * @brief   Largest amount converted, in cents. With \ref EXCHANGE_MAX_RATE the
+ *          product stays on 63 bits.
+ ********************************************************************************/
+#define EXCHANGE_MAX_CENTS          ((1ll << 36) - 1)
+
+/*********************************************************************************
+ * @brief   Maximum number of currencies in the rate table
+ ********************************************************************************/
+#define EXCHANGE_MAX_CURRENCIES     63
+
+/*********************************************************************************
+ * @brief   Struct for the rate of a currency pair
+ ********************************************************************************/
+typedef struct ST_exchangeQuote_t {
+    CURRENCY_t baseCurrency;        /*!< Currency converted from */
+    CURRENCY_t quoteCurrency;       /*!< Currency converted to */
+    uint64_t rate;                  /*!< Quote units per base unit, times EXCHANGE_RATE_SCALE */
+} ST_exchangeQuote_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>exchange</b> module
+ ********************************************************************************/
+typedef enum EN_exchangeError_t {
+    EXCHANGE_OK,                    /*!< Done */
+    EXCHANGE_NO_RATE,               /*!< No rate from the currency of the amount to the other */
+    EXCHANGE_INVALID_AMOUNT,        /*!< Amount negative or above EXCHANGE_MAX_CENTS */
+    INVALID_EXCHANGE_QUOTES,        /*!< Quotes repeated, of a currency to itself, of a null or too large rate, or of too many currencies */
+    EXCHANGE_NO_MEMORY,             /*!< No memory for the new rate table */
+    EXCHANGE_FILE_ERROR             /*!< Rates file cannot be read or has an invalid line */
+} EN_exchangeError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Build a rate table from quotes and make it the active one.
+ *
+ * @details     Only the quoted directions are converted, the inverse of a rate
+ *              is not exact and must be quoted on its own. Conversions running
+ *              meanwhile finish on the previous table, which is freed once
+ *              they are done, see \ref reload.h.
+ * @param[in]   quotes: Array of quotes, in any order
+ * @param[in]   count: Number of quotes
+ * @return      EN_exchangeError_t: EXCHANGE_OK, INVALID_EXCHANGE_QUOTES or
+ *              EXCHANGE_NO_MEMORY. The active table is unchanged on error.
+ ********************************************************************************/
+EN_exchangeError_t loadExchangeRates(const ST_exchangeQuote_t * const quotes, const uint32_t count);
+
+/*********************************************************************************
+ * @brief       Load the rate table from a text file, see \ref loadExchangeRates.
+ *
+ * @details     Each line holds "base quote rate", e.g. "USD EGP 48.2515" for
+ *              1 USD = 48.2515 EGP.
+ * @param[in]   fileName: Path of the rates file
+ * @return      EN_exchangeError_t: EXCHANGE_OK or the error of the load
+ ********************************************************************************/
+EN_exchangeError_t loadExchangeRatesFile(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Free the rate tables, only amounts in the same currency are
+ *              converted then.
+ ********************************************************************************/
+void unloadExchangeRates(void);
+
+/*********************************************************************************
+ * @brief       Convert an amount to another currency.
+ *
+ * @details     Amounts of the same currency, or from or to \ref CURRENCY_NONE,
+ *              are returned as they are.
+ * @param[in]   cents: Amount in cents of the base currency
+ * @param[in]   baseCurrency: Currency of the amount
+ * @param[in]   quoteCurrency: Currency to convert to
+ * @param[out]  convertedCents: Amount in cents of the quote currency
+ * @return      EN_exchangeError_t: EXCHANGE_OK, EXCHANGE_NO_RATE or
+ *              EXCHANGE_INVALID_AMOUNT
+ ********************************************************************************/
+EN_exchangeError_t convertAmount(const int64_t cents, const CURRENCY_t baseCurrency, const CURRENCY_t quoteCurrency,
+                                 int64_t * const convertedCents);
+
+
+#endif      /* EXCHANGE_H */
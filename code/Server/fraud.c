@@ -0,0 +1,206 @@
+/********************************************************************************
+ * @file    fraud.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the fraud scoring module implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "fraud.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Number of entries searched for a card, from its hash
+ ********************************************************************************/
+#define FRAUD_PROBE_LENGTH          8
+
+/********************************************************************************
+ * @brief   Weight of a new amount in the moving average of the card
+ ********************************************************************************/
+#define FRAUD_AVERAGE_WEIGHT        0.2f
+
+/********************************************************************************
+ * @brief   Transactions needed before the amount of a card is scored
+ ********************************************************************************/
+#define FRAUD_MIN_HISTORY           3
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Statistics of the cards, open addressing on the PAN hash
+ ********************************************************************************/
+static ST_cardStats_t cardStats[FRAUD_TABLE_SIZE];
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint64_t hashPan(const uint8_t * const pan);
+static ST_cardStats_t *findCardStats(const uint64_t panHash, const BOOL_t isAdding);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+void resetFraudStats(void) {
+    memset(cardStats, 0, sizeof(cardStats));
+}
+
+uint8_t scoreTransaction(const ST_transaction_t * const transData, const int64_t now) {
+    ST_cardStats_t *stats = NULL;
+    uint64_t panHash = 0, terminalBit = 0;
+    float amount = 0;
+    uint8_t score = 0, terminalCount = 0;
+
+    if(NULL == transData) {
+        return 100;
+    }
+
+    panHash = hashPan(transData->cardHolderData.primaryAccountNumber);
+    stats = findCardStats(panHash, TRUE);
+    amount = transData->terminalData.transAmount;
+    terminalBit = 1ull << (((uint64_t)transData->terminalData.terminalId * 0x9E3779B97F4A7C15ull) >> 58);
+
+    if(stats->transactionCount > 0) {
+        /* Amount far above the usual ones of the card */
+        if( (stats->transactionCount >= FRAUD_MIN_HISTORY) && (stats->averageAmount > 0) ) {
+            if(amount >= 10 * stats->averageAmount) {
+                score += 50;
+            } else if(amount >= 4 * stats->averageAmount) {
+                score += 25;
+            }
+        }
+
+        /* Transactions in quick succession */
+        if(now - stats->lastTime < 10) {
+            score += 30;
+        } else if(now - stats->lastTime < 60) {
+            score += 15;
+        }
+    }
+
+    /* Card used at many terminals */
+    terminalCount = (uint8_t)__builtin_popcountll(stats->terminalsSeen | terminalBit);
+    if(terminalCount >= 8) {
+        score += 20;
+    } else if(terminalCount >= 4) {
+        score += 10;
+    }
+
+    /* Updating the statistics, declined amounts do not move the average */
+    if(0 == stats->transactionCount) {
+        stats->averageAmount = amount;
+    } else if(score < FRAUD_DECLINE_SCORE) {
+        stats->averageAmount += FRAUD_AVERAGE_WEIGHT * (amount - stats->averageAmount);
+    }
+
+    if(stats->transactionCount < UINT32_MAX) {
+        ++(stats->transactionCount);
+    }
+    stats->lastTime = now;
+    stats->terminalsSeen |= terminalBit;
+
+    return score;
+}
+
+BOOL_t getCardStats(const uint8_t * const pan, ST_cardStats_t * const stats) {
+    const ST_cardStats_t *found = NULL;
+
+    if( (NULL == pan) || (NULL == stats) ) {
+        return FALSE;
+    }
+
+    found = findCardStats(hashPan(pan), FALSE);
+    if(NULL == found) {
+        return FALSE;
+    }
+
+    *stats = *found;
+
+    return TRUE;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       FNV-1a hash of a PAN, never 0 as 0 marks free entries
+ *******************************************************************************/
+static uint64_t hashPan(const uint8_t * const pan) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    uint8_t i = 0;
+
+    for(i = 0; (i < sizeof(((ST_cardData_t *)0)->primaryAccountNumber)) && ('\0' != pan[i]); ++i) {
+        hash = (hash ^ pan[i]) * 0x100000001B3ull;
+    }
+
+    return (0 == hash) ? 1 : hash;
+}
+
+/********************************************************************************
+ * @brief       Find the statistics of a card
+ *
+ * @param[in]   panHash: Hash of the PAN
+ * @param[in]   isAdding: TRUE to start tracking the card if it is not, in a
+ *              free entry or else in the least recently seen one
+ * @return      ST_cardStats_t*: The statistics, or NULL if not tracked and
+ *              not adding
+ *******************************************************************************/
+static ST_cardStats_t *findCardStats(const uint64_t panHash, const BOOL_t isAdding) {
+    ST_cardStats_t *entry = NULL, *oldest = NULL;
+    uint32_t i = 0, index = (uint32_t)panHash;
+
+    for(i = 0; i < FRAUD_PROBE_LENGTH; ++i) {
+        entry = &cardStats[(index + i) & (FRAUD_TABLE_SIZE - 1)];
+
+        if(panHash == entry->panHash) {
+            return entry;
+        }
+
+        if( (NULL == oldest) || (0 == entry->panHash) ||
+            ( (0 != oldest->panHash) && (entry->lastTime < oldest->lastTime) ) ) {
+            oldest = entry;
+        }
+    }
+
+    if( !isAdding ) {
+        return NULL;
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->panHash = panHash;
+
+    return oldest;
+}
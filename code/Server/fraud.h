@@ -0,0 +1,87 @@
+/********************************************************************************
+ * @file    fraud.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the fraud scoring module
+ *          \ref fraud.c
+ * @details Every card has streaming statistics updated in O(1) by each of its
+ *          transactions: the moving average of its amounts, the time of its
+ *          last transaction and the terminals it was used at. A transaction is
+ *          scored against them before it reaches the server. The statistics
+ *          live in a fixed table, scoring allocates nothing.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef FRAUD_H
+#define FRAUD_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Number of cards tracked, a power of 2. The least recently seen card
+ *          of a full neighbourhood is forgotten to track a new one.
+ ********************************************************************************/
+#define FRAUD_TABLE_SIZE            (1u << 18)
+
+/*********************************************************************************
+ * @brief   Score from which a transaction is declined, scores go from 0 to 100
+ ********************************************************************************/
+#define FRAUD_DECLINE_SCORE         70
+
+/*********************************************************************************
+ * @brief   Struct for the streaming statistics of one card
+ ********************************************************************************/
+typedef struct ST_cardStats_t {
+    uint64_t panHash;                   /*!< Hash of the PAN, 0 for a free entry */
+    float averageAmount;                /*!< Exponentially weighted moving average of the amounts */
+    uint32_t transactionCount;          /*!< Transactions scored, saturates */
+    int64_t lastTime;                   /*!< Time of the last transaction, in seconds */
+    uint64_t terminalsSeen;             /*!< One bit per hashed terminal ID */
+} ST_cardStats_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Forget the statistics of every card.
+ ********************************************************************************/
+void resetFraudStats(void);
+
+/*********************************************************************************
+ * @brief       Score a transaction against the statistics of its card, then
+ *              update them with it.
+ *
+ * @details     The score adds up the amount compared to the card average, the
+ *              time since the last transaction of the card and the number of
+ *              distinct terminals the card was used at. The average only moves
+ *              with transactions scored below \ref FRAUD_DECLINE_SCORE. Not
+ *              thread safe.
+ * @param[in]   transData: Pointer to the transaction data
+ * @param[in]   now: Time of the transaction, in seconds
+ * @return      uint8_t: Score from 0 (usual) to 100 (anomalous)
+ ********************************************************************************/
+uint8_t scoreTransaction(const ST_transaction_t * const transData, const int64_t now);
+
+/*********************************************************************************
+ * @brief       Get the statistics of a card.
+ *
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @param[out]  stats: Copy of the statistics
+ * @return      BOOL_t: TRUE, or FALSE if the card is not tracked
+ ********************************************************************************/
+BOOL_t getCardStats(const uint8_t * const pan, ST_cardStats_t * const stats);
+
+
+#endif      /* FRAUD_H */
@@ -0,0 +1,367 @@
+/********************************************************************************
+ * @file    hold.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the authorization holds implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "hold.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Index of no hold, ending the lists
+ ********************************************************************************/
+#define HOLD_NONE                   UINT32_MAX
+
+/********************************************************************************
+ * @brief   Latest expiry, relative to the current tick, the wheel can hold
+ ********************************************************************************/
+#define HOLD_MAX_LIFETIME           ((1ull << (HOLD_WHEEL_BITS * HOLD_WHEEL_LEVELS)) - 1)
+
+/********************************************************************************
+ * @brief   Struct for a hold, linked in the list of its wheel slot, or in the
+ *          free list when not in use
+ ********************************************************************************/
+typedef struct ST_hold_t {
+    uint64_t expiry;                /*!< Tick the hold expires at */
+    int64_t heldCents;              /*!< Amount held, in cents of the account currency */
+    uint32_t next;                  /*!< Next hold of the slot, or next free hold */
+    uint32_t previous;              /*!< Previous hold of the slot, HOLD_NONE for the first */
+    uint32_t generation;            /*!< Changed when the hold ends, so its ID is not found again */
+    int16_t accountIndex;           /*!< Account holding the amount, -1 when not in use */
+    uint16_t slot;                  /*!< Wheel slot of the hold, level * HOLD_WHEEL_SLOTS + index */
+} ST_hold_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The holds, NULL when not started, and the first free one
+ ********************************************************************************/
+static ST_hold_t *holds = NULL;
+static uint32_t holdsCapacity = 0;
+static uint32_t holdsCount = 0;
+static uint32_t freeHold = HOLD_NONE;
+
+/********************************************************************************
+ * @brief   First hold of each slot of the wheel, level by level, and the last
+ *          tick the wheel advanced to
+ ********************************************************************************/
+static uint32_t wheel[HOLD_WHEEL_LEVELS * HOLD_WHEEL_SLOTS];
+static uint64_t wheelTick = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Find a hold in use by its ID.
+ *
+ * @return      uint32_t: Index of the hold, HOLD_NONE if not found
+ ********************************************************************************/
+static uint32_t findHold(const uint64_t holdId);
+
+/********************************************************************************
+ * @brief       Link a hold in the slot of its expiry: the lowest level whose
+ *              span covers the ticks left.
+ ********************************************************************************/
+static void linkHold(const uint32_t index);
+
+/********************************************************************************
+ * @brief       Unlink a hold from its slot.
+ ********************************************************************************/
+static void unlinkHold(const uint32_t index);
+
+/********************************************************************************
+ * @brief       Unlink a hold and put it back in the free list.
+ ********************************************************************************/
+static void endHold(const uint32_t index);
+
+/********************************************************************************
+ * @brief       Advance the wheel by one tick: move the holds of the upper
+ *              slots reached down, then release the holds expiring.
+ *
+ * @return      uint32_t: Number of holds expired
+ ********************************************************************************/
+static uint32_t advanceTick(void);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_holdError_t startHolds(const uint32_t capacity, const uint64_t now) {
+    uint32_t i = 0;
+
+    stopHolds();
+
+    if( (0 == capacity) || (HOLD_NONE == capacity) ) {
+        return HOLD_NO_MEMORY;
+    }
+
+    holds = malloc((size_t)capacity * sizeof(*holds));
+    if(NULL == holds) {
+        return HOLD_NO_MEMORY;
+    }
+
+    for(i = 0; i < capacity; ++i) {
+        holds[i].next = (i + 1 < capacity) ? i + 1 : HOLD_NONE;
+        holds[i].generation = 1;
+        holds[i].accountIndex = -1;
+    }
+
+    for(i = 0; i < HOLD_WHEEL_LEVELS * HOLD_WHEEL_SLOTS; ++i) {
+        wheel[i] = HOLD_NONE;
+    }
+
+    holdsCapacity = capacity;
+    holdsCount = 0;
+    freeHold = 0;
+    wheelTick = now;
+
+    return HOLD_OK;
+}
+
+void stopHolds(void) {
+    uint32_t i = 0;
+
+    if(NULL == holds) {
+        return;
+    }
+
+    for(i = 0; i < holdsCapacity; ++i) {
+        if(-1 != holds[i].accountIndex) {
+            (void)releaseHeldAmount(holds[i].accountIndex, holds[i].heldCents);
+        }
+    }
+
+    free(holds);
+    holds = NULL;
+    holdsCapacity = 0;
+    holdsCount = 0;
+    freeHold = HOLD_NONE;
+}
+
+EN_holdError_t authorizeHold(ST_transaction_t * const transData, const uint32_t lifetime, uint64_t * const holdId) {
+    ST_hold_t *hold = NULL;
+    int16_t accountIndex = -1;
+    int64_t heldCents = 0;
+
+    if(NULL == holds) {
+        return HOLD_NOT_STARTED;
+    }
+
+    if( (NULL == transData) || (NULL == holdId) ) {
+        return HOLD_NOT_FOUND;
+    }
+
+    if(HOLD_NONE == freeHold) {
+        transData->transState = INTERNAL_SERVER_ERROR;
+        return HOLD_FULL;
+    }
+
+    if(APPROVED != holdTransaction(transData, &accountIndex, &heldCents)) {
+        return HOLD_OK;
+    }
+
+    hold = &(holds[freeHold]);
+    *holdId = ((uint64_t)hold->generation << 32) | freeHold;
+    hold->expiry = wheelTick + ((0 == lifetime) ? 1 : lifetime);
+    hold->heldCents = heldCents;
+    hold->accountIndex = accountIndex;
+
+    freeHold = hold->next;
+    linkHold((uint32_t)(*holdId & UINT32_MAX));
+    ++holdsCount;
+
+    return HOLD_OK;
+}
+
+EN_holdError_t captureHold(const uint64_t holdId, ST_transaction_t * const transData) {
+    uint32_t index = HOLD_NONE;
+
+    if(NULL == holds) {
+        return HOLD_NOT_STARTED;
+    }
+
+    index = findHold(holdId);
+    if( (HOLD_NONE == index) || (NULL == transData) ) {
+        return HOLD_NOT_FOUND;
+    }
+
+    /* A declined capture leaves the hold as it was */
+    if(APPROVED == captureHeldTransaction(transData, holds[index].accountIndex, holds[index].heldCents)) {
+        endHold(index);
+    }
+
+    return HOLD_OK;
+}
+
+EN_holdError_t releaseHold(const uint64_t holdId) {
+    uint32_t index = HOLD_NONE;
+    EN_serverError_t serverError = SERVER_OK;
+
+    if(NULL == holds) {
+        return HOLD_NOT_STARTED;
+    }
+
+    index = findHold(holdId);
+    if(HOLD_NONE == index) {
+        return HOLD_NOT_FOUND;
+    }
+
+    serverError = releaseHeldAmount(holds[index].accountIndex, holds[index].heldCents);
+    endHold(index);
+
+    return (SERVER_OK == serverError) ? HOLD_OK : HOLD_ACCOUNT_ERROR;
+}
+
+uint32_t advanceHolds(const uint64_t now) {
+    uint32_t expiredCount = 0;
+
+    if(NULL == holds) {
+        return 0;
+    }
+
+    while( (wheelTick < now) && (holdsCount > 0) ) {
+        expiredCount += advanceTick();
+    }
+
+    /* Nothing can expire on the ticks left */
+    if(wheelTick < now) {
+        wheelTick = now;
+    }
+
+    return expiredCount;
+}
+
+uint32_t getHoldsCount(void) {
+    return holdsCount;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint32_t findHold(const uint64_t holdId) {
+    const uint32_t index = (uint32_t)(holdId & UINT32_MAX);
+
+    if( (index >= holdsCapacity) || (-1 == holds[index].accountIndex) ||
+        (holds[index].generation != (uint32_t)(holdId >> 32)) ) {
+        return HOLD_NONE;
+    }
+
+    return index;
+}
+
+static void linkHold(const uint32_t index) {
+    ST_hold_t * const hold = &(holds[index]);
+    uint64_t ticksLeft = 0;
+    uint32_t level = 0;
+
+    /* Beyond the reach of the wheel, the hold waits at its end */
+    if(hold->expiry - wheelTick > HOLD_MAX_LIFETIME) {
+        hold->expiry = wheelTick + HOLD_MAX_LIFETIME;
+    }
+
+    ticksLeft = hold->expiry - wheelTick;
+    while( (level + 1 < HOLD_WHEEL_LEVELS) && (ticksLeft >> (HOLD_WHEEL_BITS * (level + 1))) ) {
+        ++level;
+    }
+
+    hold->slot = (uint16_t)(level * HOLD_WHEEL_SLOTS +
+                            ((hold->expiry >> (HOLD_WHEEL_BITS * level)) & (HOLD_WHEEL_SLOTS - 1)));
+    hold->previous = HOLD_NONE;
+    hold->next = wheel[hold->slot];
+    if(HOLD_NONE != hold->next) {
+        holds[hold->next].previous = index;
+    }
+    wheel[hold->slot] = index;
+}
+
+static void unlinkHold(const uint32_t index) {
+    const ST_hold_t * const hold = &(holds[index]);
+
+    if(HOLD_NONE == hold->previous) {
+        wheel[hold->slot] = hold->next;
+    } else {
+        holds[hold->previous].next = hold->next;
+    }
+
+    if(HOLD_NONE != hold->next) {
+        holds[hold->next].previous = hold->previous;
+    }
+}
+
+static void endHold(const uint32_t index) {
+
+    unlinkHold(index);
+    holds[index].accountIndex = -1;
+    ++(holds[index].generation);
+    holds[index].next = freeHold;
+    freeHold = index;
+    --holdsCount;
+}
+
+static uint32_t advanceTick(void) {
+    uint32_t level = 0, slot = 0, index = HOLD_NONE, next = HOLD_NONE, expiredCount = 0;
+
+    ++wheelTick;
+
+    /* Each time a level wraps around, the next slot of the level above moves down */
+    for(level = 1; level < HOLD_WHEEL_LEVELS; ++level) {
+        if(0 != ((wheelTick >> (HOLD_WHEEL_BITS * (level - 1))) & (HOLD_WHEEL_SLOTS - 1))) {
+            break;
+        }
+
+        slot = level * HOLD_WHEEL_SLOTS + ((wheelTick >> (HOLD_WHEEL_BITS * level)) & (HOLD_WHEEL_SLOTS - 1));
+        index = wheel[slot];
+        wheel[slot] = HOLD_NONE;
+        for(; HOLD_NONE != index; index = next) {
+            next = holds[index].next;
+            linkHold(index);
+        }
+    }
+
+    /* Every hold of the slot of this tick expires now */
+    slot = (uint32_t)(wheelTick & (HOLD_WHEEL_SLOTS - 1));
+    while(HOLD_NONE != wheel[slot]) {
+        index = wheel[slot];
+        (void)releaseHeldAmount(holds[index].accountIndex, holds[index].heldCents);
+        endHold(index);
+        ++expiredCount;
+    }
+
+    return expiredCount;
+}
@@ -0,0 +1,123 @@
+/********************************************************************************
+ * @file    hold.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the authorization holds
+ *          \ref hold.c
+ * @details A fuel pump or a hotel first authorizes an estimate, the amount is
+ *          held on the account: it is no longer available but not posted. The
+ *          hold is later captured for the final amount, which is posted, or
+ *          released. A hold not captured by its expiry is released. The
+ *          expiries are kept on a hierarchical timing wheel: each level has
+ *          \ref HOLD_WHEEL_SLOTS slots, a slot of level n spanning
+ *          HOLD_WHEEL_SLOTS^n ticks, so adding, capturing or releasing a hold
+ *          and advancing a tick cost the same whatever the number of holds,
+ *          and a hold is moved down a level at most once per level.
+ *          The holds belong to the process that authorized them, they are not
+ *          replicated nor moved with their account to another shard. The
+ *          module is used from one thread, like the server module.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef HOLD_H
+#define HOLD_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Slots of each level of the timing wheel, and the number of levels.
+ *          The wheel covers HOLD_WHEEL_SLOTS^HOLD_WHEEL_LEVELS ticks, later
+ *          expiries are brought back to its end.
+ ********************************************************************************/
+#define HOLD_WHEEL_BITS             8
+#define HOLD_WHEEL_SLOTS            (1u << HOLD_WHEEL_BITS)
+#define HOLD_WHEEL_LEVELS           4
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>hold</b> module
+ ********************************************************************************/
+typedef enum EN_holdError_t {
+    HOLD_OK,                        /*!< Done, the state of the transaction tells if it was approved */
+    HOLD_NOT_STARTED,               /*!< The holds are not started */
+    HOLD_NOT_FOUND,                 /*!< No such hold, or it was captured, released or expired */
+    HOLD_FULL,                      /*!< Every hold is taken */
+    HOLD_NO_MEMORY,                 /*!< No memory for the holds */
+    HOLD_ACCOUNT_ERROR              /*!< The account held less than the hold, which ended anyway */
+} EN_holdError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Allocate the holds and start the timing wheel.
+ *
+ * @param[in]   capacity: Maximum number of holds at a time
+ * @param[in]   now: Current tick, e.g. the time in seconds
+ * @return      EN_holdError_t: HOLD_OK or HOLD_NO_MEMORY
+ ********************************************************************************/
+EN_holdError_t startHolds(const uint32_t capacity, const uint64_t now);
+
+/*********************************************************************************
+ * @brief       Release every hold left and free them.
+ ********************************************************************************/
+void stopHolds(void);
+
+/*********************************************************************************
+ * @brief       Authorize a transaction and hold its amount on the account.
+ *
+ * @param[in,out] transData: Pointer to the transaction, its state is set
+ * @param[in]   lifetime: Ticks before the hold expires, at least 1
+ * @param[out]  holdId: ID of the hold, if approved
+ * @return      EN_holdError_t: HOLD_OK, HOLD_NOT_STARTED, HOLD_FULL, or
+ *              HOLD_NOT_FOUND if a pointer is null
+ ********************************************************************************/
+EN_holdError_t authorizeHold(ST_transaction_t * const transData, const uint32_t lifetime, uint64_t * const holdId);
+
+/*********************************************************************************
+ * @brief       Capture a hold for the final amount of its transaction, see
+ *              \ref captureHeldTransaction. The hold ends if approved.
+ *
+ * @param[in]   holdId: ID of the hold
+ * @param[in,out] transData: Pointer to the transaction with its final amount,
+ *              its state is set
+ * @return      EN_holdError_t: HOLD_OK, HOLD_NOT_STARTED or HOLD_NOT_FOUND
+ ********************************************************************************/
+EN_holdError_t captureHold(const uint64_t holdId, ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Release a hold, its amount is available again.
+ * @return      EN_holdError_t: HOLD_OK, HOLD_NOT_STARTED, HOLD_NOT_FOUND or
+ *              HOLD_ACCOUNT_ERROR, see \ref releaseHeldAmount
+ ********************************************************************************/
+EN_holdError_t releaseHold(const uint64_t holdId);
+
+/*********************************************************************************
+ * @brief       Advance the timing wheel up to a tick, releasing the holds
+ *              expiring up to it.
+ *
+ * @details     Every tick is stepped through while holds are left, an idle
+ *              wheel jumps straight to now.
+ * @param[in]   now: Current tick, ticks before the current one are ignored
+ * @return      uint32_t: Number of holds expired
+ ********************************************************************************/
+uint32_t advanceHolds(const uint64_t now);
+
+/*********************************************************************************
+ * @brief       Get the number of holds outstanding.
+ ********************************************************************************/
+uint32_t getHoldsCount(void);
+
+
+#endif      /* HOLD_H */
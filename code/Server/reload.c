@@ -0,0 +1,72 @@
+/********************************************************************************
+ * @file    reload.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the reloadable tables implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "reload.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+void *enterReloadTable(ST_reloadTable_t * const reloadTable, uint32_t * const epoch) {
+    uint32_t enteredEpoch = 0;
+
+    /* Counting the lookup in its epoch, again if a swap moved to the next epoch meanwhile */
+    enteredEpoch = __atomic_load_n(&reloadTable->epoch, __ATOMIC_SEQ_CST);
+    for(;;) {
+        __atomic_fetch_add(&reloadTable->readers[enteredEpoch & 1], 1, __ATOMIC_SEQ_CST);
+        *epoch = __atomic_load_n(&reloadTable->epoch, __ATOMIC_SEQ_CST);
+        if(*epoch == enteredEpoch) {
+            break;
+        }
+        __atomic_fetch_sub(&reloadTable->readers[enteredEpoch & 1], 1, __ATOMIC_SEQ_CST);
+        enteredEpoch = *epoch;
+    }
+
+    /* The swap waits for this counter before freeing any table it could load */
+    return __atomic_load_n(&reloadTable->table, __ATOMIC_SEQ_CST);
+}
+
+void leaveReloadTable(ST_reloadTable_t * const reloadTable, const uint32_t epoch) {
+    __atomic_fetch_sub(&reloadTable->readers[epoch & 1], 1, __ATOMIC_RELEASE);
+}
+
+void swapReloadTable(ST_reloadTable_t * const reloadTable, void * const table) {
+    void *replacedTable = NULL;
+    uint32_t epoch = 0;
+
+    while(0 != __atomic_exchange_n(&reloadTable->isSwapping, 1, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    replacedTable = __atomic_exchange_n(&reloadTable->table, table, __ATOMIC_SEQ_CST);
+
+    /* Lookups entering from now on count in the other parity and load the new table */
+    epoch = __atomic_load_n(&reloadTable->epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(&reloadTable->epoch, epoch + 1, __ATOMIC_SEQ_CST);
+
+    /* Grace period: the lookups which may still read the replaced table leave it */
+    while(0 != __atomic_load_n(&reloadTable->readers[epoch & 1], __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    free(replacedTable);
+
+    __atomic_store_n(&reloadTable->isSwapping, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,82 @@
+/********************************************************************************
+ * @file    reload.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the reloadable tables
+ *          \ref reload.c
+ * @details A table read by lookups on many threads is reloaded by publishing
+ *          a new one in its place. A lookup enters the table before reading it
+ *          and leaves it after, being counted in the reader counter of the
+ *          epoch it entered in. A swap publishes the new table, moves to the
+ *          next epoch, then waits until no reader of the previous epoch is
+ *          left before freeing the replaced table, so a lookup never reads a
+ *          freed table however long it is preempted. Lookups never wait,
+ *          swaps wait for the lookups in flight and for each other.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef RELOAD_H
+#define RELOAD_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Struct for a reloadable table, initialized by \ref RELOAD_TABLE_INITIALIZER
+ ********************************************************************************/
+typedef struct ST_reloadTable_t {
+    void *table;                    /*!< The published table, NULL when none is loaded */
+    uint32_t epoch;                 /*!< Epoch of the published table */
+    uint32_t isSwapping;            /*!< 1 while a swap is in progress */
+    uint32_t readers[2];            /*!< Lookups in flight, by the parity of the epoch they entered in */
+} ST_reloadTable_t;
+
+/*********************************************************************************
+ * @brief   Initializer of a reloadable table with no table loaded
+ ********************************************************************************/
+#define RELOAD_TABLE_INITIALIZER    {NULL, 0, 0, {0, 0}}
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Enter a reloadable table to read it, the table is not freed
+ *              until it is left by \ref leaveReloadTable
+ *
+ * @param[in]   reloadTable: The reloadable table
+ * @param[out]  epoch: The epoch entered in, to be given back to \ref leaveReloadTable
+ * @return      void *: The published table, NULL when none is loaded
+ ********************************************************************************/
+void *enterReloadTable(ST_reloadTable_t * const reloadTable, uint32_t * const epoch);
+
+/*********************************************************************************
+ * @brief       Leave a reloadable table entered by \ref enterReloadTable,
+ *              the table must not be read anymore
+ *
+ * @param[in]   reloadTable: The reloadable table
+ * @param[in]   epoch: The epoch returned by \ref enterReloadTable
+ ********************************************************************************/
+void leaveReloadTable(ST_reloadTable_t * const reloadTable, const uint32_t epoch);
+
+/*********************************************************************************
+ * @brief       Publish a new table, wait until the lookups reading the
+ *              replaced one have left it, then free the replaced table
+ *
+ * @param[in]   reloadTable: The reloadable table
+ * @param[in]   table: The new table allocated by malloc(), or NULL to unload
+ *              the table
+ ********************************************************************************/
+void swapReloadTable(ST_reloadTable_t * const reloadTable, void * const table);
+
+#endif
@@ -0,0 +1,550 @@
+/********************************************************************************
+ * @file    replication.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the hot standby replication implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "shard.h"
+#include "replication.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Enum for the records shipped to the standby
+ ********************************************************************************/
+typedef enum EN_replicationRecord_t {
+    REPLICATION_RECORD_CHANGE,      /*!< Apply the transaction and the account of the record */
+    REPLICATION_RECORD_OFFLINE_MARK,/*!< Raise the offline mark of the terminal of the transaction to its number */
+    REPLICATION_RECORD_STOP,        /*!< Stop, the primary stopped replication */
+    REPLICATION_RECORD_PROMOTE      /*!< Take over from the primary */
+} EN_replicationRecord_t;
+
+/********************************************************************************
+ * @brief   Struct for a record of the replication stream, a SOCK_STREAM socket
+ *          so the queued records are sent in batches. The standby sends the
+ *          sequence back when the primary waits for it.
+ ********************************************************************************/
+typedef struct ST_replicationRecord_t {
+    uint64_t sequence;                  /*!< Number of the record, from 1 */
+    uint32_t type;                      /*!< EN_replicationRecord_t */
+    uint8_t isTransaction;              /*!< The record holds a saved transaction */
+    uint8_t isAckRequested;             /*!< The primary waits for the sequence back */
+    int16_t accountIndex;               /*!< Index of the account changed, -1 for none */
+    ST_accountsDB_t account;            /*!< The account after the change */
+    ST_transaction_t transaction;       /*!< The transaction saved */
+} ST_replicationRecord_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Replication to the standby, its socket and the sequence of the last
+ *          record shipped
+ ********************************************************************************/
+static EN_replicationMode_t replicationMode = REPLICATION_OFF;
+static int standbySocket = -1;
+static uint64_t lastSequence = 0;
+
+/********************************************************************************
+ * @brief   Asynchronous mode: records queued by the server and sent by the
+ *          sender thread. Only the server moves the tail and only the sender
+ *          moves the head.
+ ********************************************************************************/
+static ST_replicationRecord_t *queue = NULL;
+static uint64_t queueHead = 0;
+static uint64_t queueTail = 0;
+
+/********************************************************************************
+ * @brief   Sender thread, woken up by the server when it sleeps
+ ********************************************************************************/
+static pthread_t senderThread;
+static pthread_mutex_t senderMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t senderCondition = PTHREAD_COND_INITIALIZER;
+static BOOL_t isSenderWaiting = FALSE;
+static BOOL_t isSenderStopping = FALSE;
+
+/********************************************************************************
+ * @brief   Set by the sender thread when the standby cannot be reached
+ ********************************************************************************/
+static BOOL_t isStandbyLost = FALSE;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Send a whole buffer on a stream socket.
+ *
+ * @return      BOOL_t: TRUE if sent, FALSE if the socket is closed
+ ********************************************************************************/
+static BOOL_t sendAll(const int streamSocket, const void * const data, const size_t size);
+
+/********************************************************************************
+ * @brief       Receive a whole buffer from a stream socket.
+ *
+ * @return      BOOL_t: TRUE if received, FALSE if the socket is closed first
+ ********************************************************************************/
+static BOOL_t receiveAll(const int streamSocket, void * const data, const size_t size);
+
+/********************************************************************************
+ * @brief       Send a record to the standby and wait for its sequence back if
+ *              asked.
+ *
+ * @return      EN_replicationError_t: REPLICATION_OK or REPLICATION_SOCKET_ERROR
+ ********************************************************************************/
+static EN_replicationError_t sendRecord(const ST_replicationRecord_t * const record);
+
+/********************************************************************************
+ * @brief       Fill a change record, see \ref replicateChange.
+ ********************************************************************************/
+static void fillRecord(ST_replicationRecord_t * const record, const ST_transaction_t * const transData,
+                       const int16_t accountIndex, const ST_accountsDB_t * const account);
+
+/********************************************************************************
+ * @brief       Sender thread of the asynchronous mode: send the queued records,
+ *              as many as are queued at once, until stopped with nothing left.
+ ********************************************************************************/
+static void *runSender(void *argument);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_replicationError_t runStandby(const char * const replicationPath, const char * const servingPath) {
+    static ST_replicationRecord_t record;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    EN_replicationError_t replicationError = REPLICATION_OK;
+    int listener = -1, connection = -1;
+    uint64_t appliedSequence = 0;
+    BOOL_t isCaughtUp = FALSE, isPromoting = FALSE;
+
+    if( (NULL == replicationPath) || (strlen(replicationPath) >= sizeof(address.sun_path)) ) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    strcpy(address.sun_path, replicationPath);
+    unlink(replicationPath);
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( (-1 == listener) || (0 != bind(listener, (struct sockaddr *)&address, sizeof(address))) ||
+        (0 != listen(listener, 1)) ) {
+        if(-1 != listener) {
+            close(listener);
+        }
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    /* One primary only, a second one would fork the history */
+    connection = accept(listener, NULL, NULL);
+    close(listener);
+    unlink(replicationPath);
+    if(-1 == connection) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    while(REPLICATION_OK == replicationError) {
+        /* The primary is gone: promoted, unless it left before the accounts were copied */
+        if(!receiveAll(connection, &record, sizeof(record))) {
+            isPromoting = isCaughtUp;
+            replicationError = isCaughtUp ? REPLICATION_OK : REPLICATION_SOCKET_ERROR;
+            break;
+        }
+
+        if( (record.sequence != appliedSequence + 1) ||
+            ( (REPLICATION_RECORD_CHANGE == record.type) &&
+              (SERVER_OK != applyReplicatedChange(record.isTransaction ? &(record.transaction) : NULL,
+                                                  record.accountIndex, &(record.account))) ) ||
+            ( (REPLICATION_RECORD_OFFLINE_MARK == record.type) &&
+              (SERVER_OK != setOfflineMark(record.transaction.terminalData.terminalId,
+                                           record.transaction.offlineSequenceNumber)) ) ) {
+            replicationError = REPLICATION_APPLY_ERROR;
+            break;
+        }
+        appliedSequence = record.sequence;
+
+        /* The first sequence sent back ends the copy of the accounts */
+        if(record.isAckRequested) {
+            isCaughtUp = TRUE;
+            if(!sendAll(connection, &(record.sequence), sizeof(record.sequence))) {
+                isPromoting = TRUE;
+                break;
+            }
+        }
+
+        if( (REPLICATION_RECORD_CHANGE != record.type) && (REPLICATION_RECORD_OFFLINE_MARK != record.type) ) {
+            isPromoting = (REPLICATION_RECORD_PROMOTE == record.type);
+            break;
+        }
+    }
+
+    close(connection);
+
+    if(isPromoting) {
+        return (SHARD_OK == runShard(servingPath, 0, 1)) ? REPLICATION_OK : REPLICATION_SOCKET_ERROR;
+    }
+
+    return replicationError;
+}
+
+EN_replicationError_t startReplication(const char * const socketPath, const EN_replicationMode_t mode) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    ST_replicationRecord_t record;
+    ST_accountsDB_t account;
+    ST_offlineMark_t mark;
+    EN_replicationError_t replicationError = REPLICATION_OK;
+    uint32_t i = 0;
+
+    if( (REPLICATION_OFF != replicationMode) || ( (REPLICATION_SYNC != mode) && (REPLICATION_ASYNC != mode) ) ) {
+        return REPLICATION_MODE_ERROR;
+    }
+
+    if( (NULL == socketPath) || (strlen(socketPath) >= sizeof(address.sun_path)) ) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    strcpy(address.sun_path, socketPath);
+    standbySocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( (-1 == standbySocket) || (0 != connect(standbySocket, (struct sockaddr *)&address, sizeof(address))) ) {
+        replicationError = REPLICATION_SOCKET_ERROR;
+    }
+
+    /* Copying the accounts, removed ones included so the indexes match */
+    lastSequence = 0;
+    for(i = 0; (REPLICATION_OK == replicationError) && (i < getAccountsCount()); ++i) {
+        if(SERVER_OK != getAccount((uint16_t)i, &account)) {
+            memset(&account, 0, sizeof(account));
+        }
+        fillRecord(&record, NULL, (int16_t)i, &account);
+        replicationError = sendRecord(&record);
+    }
+
+    /* And the offline marks, so the standby does not post a batch again */
+    for(i = 0; (REPLICATION_OK == replicationError) && (i < getOfflineMarksCount()); ++i) {
+        getOfflineMark(i, &mark);
+        fillRecord(&record, NULL, -1, NULL);
+        record.type = REPLICATION_RECORD_OFFLINE_MARK;
+        record.transaction.terminalData.terminalId = mark.terminalId;
+        record.transaction.offlineSequenceNumber = mark.sequenceNumber;
+        replicationError = sendRecord(&record);
+    }
+
+    /* An empty change the standby sends back once it caught up */
+    if(REPLICATION_OK == replicationError) {
+        fillRecord(&record, NULL, -1, NULL);
+        record.isAckRequested = TRUE;
+        replicationError = sendRecord(&record);
+    }
+
+    if(REPLICATION_ASYNC == mode) {
+        queue = (REPLICATION_OK == replicationError) ? malloc(REPLICATION_QUEUE_SIZE * sizeof(*queue)) : NULL;
+        if( (REPLICATION_OK == replicationError) && (NULL == queue) ) {
+            replicationError = REPLICATION_NO_MEMORY;
+        }
+
+        queueHead = 0;
+        queueTail = 0;
+        isSenderStopping = FALSE;
+        isStandbyLost = FALSE;
+        if( (REPLICATION_OK == replicationError) && (0 != pthread_create(&senderThread, NULL, runSender, NULL)) ) {
+            replicationError = REPLICATION_THREAD_ERROR;
+        }
+    }
+
+    if(REPLICATION_OK != replicationError) {
+        free(queue);
+        queue = NULL;
+        if(-1 != standbySocket) {
+            close(standbySocket);
+            standbySocket = -1;
+        }
+        return replicationError;
+    }
+
+    replicationMode = mode;
+
+    return REPLICATION_OK;
+}
+
+EN_replicationError_t startReplicationFile(const char * const fileName) {
+    FILE *file = NULL;
+    char socketPath[sizeof(((struct sockaddr_un *)NULL)->sun_path)], modeText[8];
+    int scanned = 0;
+
+    if(NULL == fileName) {
+        return REPLICATION_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return REPLICATION_FILE_ERROR;
+    }
+
+    scanned = fscanf(file, "%107s %7s", socketPath, modeText);
+    fclose(file);
+
+    if(2 != scanned) {
+        return REPLICATION_FILE_ERROR;
+    }
+
+    if(0 == strcmp(modeText, "sync")) {
+        return startReplication(socketPath, REPLICATION_SYNC);
+    }
+
+    if(0 == strcmp(modeText, "async")) {
+        return startReplication(socketPath, REPLICATION_ASYNC);
+    }
+
+    return REPLICATION_FILE_ERROR;
+}
+
+EN_replicationError_t stopReplication(const BOOL_t isPromoting) {
+    ST_replicationRecord_t record = {0};
+    EN_replicationError_t replicationError = REPLICATION_OK;
+
+    if(REPLICATION_OFF == replicationMode) {
+        return REPLICATION_NOT_STARTED;
+    }
+
+    /* The sender thread leaves once the queue is empty */
+    if(REPLICATION_ASYNC == replicationMode) {
+        pthread_mutex_lock(&senderMutex);
+        __atomic_store_n(&isSenderStopping, TRUE, __ATOMIC_SEQ_CST);
+        pthread_cond_signal(&senderCondition);
+        pthread_mutex_unlock(&senderMutex);
+
+        pthread_join(senderThread, NULL);
+        free(queue);
+        queue = NULL;
+
+        if(isStandbyLost) {
+            replicationError = REPLICATION_SOCKET_ERROR;
+        }
+    }
+
+    /* Its sequence back means the standby applied everything before it */
+    if(REPLICATION_OK == replicationError) {
+        record.sequence = ++lastSequence;
+        record.type = isPromoting ? REPLICATION_RECORD_PROMOTE : REPLICATION_RECORD_STOP;
+        record.isAckRequested = TRUE;
+        record.accountIndex = -1;
+        replicationError = sendRecord(&record);
+    }
+
+    close(standbySocket);
+    standbySocket = -1;
+    replicationMode = REPLICATION_OFF;
+
+    return replicationError;
+}
+
+EN_replicationError_t replicateChange(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                      const ST_accountsDB_t * const account) {
+    const struct timespec fullDelay = {0, 100000};
+    ST_replicationRecord_t record;
+    uint64_t tail = 0;
+
+    if(REPLICATION_OFF == replicationMode) {
+        return REPLICATION_NOT_STARTED;
+    }
+
+    if(REPLICATION_SYNC == replicationMode) {
+        fillRecord(&record, transData, accountIndex, account);
+        record.isAckRequested = TRUE;
+        if(REPLICATION_OK != sendRecord(&record)) {
+            close(standbySocket);
+            standbySocket = -1;
+            replicationMode = REPLICATION_OFF;
+            return REPLICATION_SOCKET_ERROR;
+        }
+
+        return REPLICATION_OK;
+    }
+
+    /* Waiting for room, the standby is too far behind */
+    tail = queueTail;
+    while(tail - __atomic_load_n(&queueHead, __ATOMIC_ACQUIRE) == REPLICATION_QUEUE_SIZE) {
+        if(__atomic_load_n(&isStandbyLost, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        nanosleep(&fullDelay, NULL);
+    }
+
+    if(__atomic_load_n(&isStandbyLost, __ATOMIC_ACQUIRE)) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    fillRecord(&(queue[tail % REPLICATION_QUEUE_SIZE]), transData, accountIndex, account);
+    __atomic_store_n(&queueTail, tail + 1, __ATOMIC_SEQ_CST);
+
+    /* The sender only sleeps with nothing queued */
+    if(__atomic_load_n(&isSenderWaiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&senderMutex);
+        pthread_cond_signal(&senderCondition);
+        pthread_mutex_unlock(&senderMutex);
+    }
+
+    return REPLICATION_OK;
+}
+
+EN_replicationMode_t getReplicationMode(void) {
+
+    if( (REPLICATION_ASYNC == replicationMode) && __atomic_load_n(&isStandbyLost, __ATOMIC_ACQUIRE) ) {
+        return REPLICATION_OFF;
+    }
+
+    return replicationMode;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static BOOL_t sendAll(const int streamSocket, const void * const data, const size_t size) {
+    const uint8_t *bytes = data;
+    size_t sentSize = 0;
+    ssize_t sent = 0;
+
+    while(sentSize < size) {
+        sent = send(streamSocket, bytes + sentSize, size - sentSize, MSG_NOSIGNAL);
+        if(sent <= 0) {
+            return FALSE;
+        }
+        sentSize += (size_t)sent;
+    }
+
+    return TRUE;
+}
+
+static BOOL_t receiveAll(const int streamSocket, void * const data, const size_t size) {
+    uint8_t *bytes = data;
+    size_t receivedSize = 0;
+    ssize_t received = 0;
+
+    while(receivedSize < size) {
+        received = recv(streamSocket, bytes + receivedSize, size - receivedSize, 0);
+        if(received <= 0) {
+            return FALSE;
+        }
+        receivedSize += (size_t)received;
+    }
+
+    return TRUE;
+}
+
+static EN_replicationError_t sendRecord(const ST_replicationRecord_t * const record) {
+    uint64_t sequence = 0;
+
+    if(!sendAll(standbySocket, record, sizeof(*record))) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    if( record->isAckRequested &&
+        ( !receiveAll(standbySocket, &sequence, sizeof(sequence)) || (sequence != record->sequence) ) ) {
+        return REPLICATION_SOCKET_ERROR;
+    }
+
+    return REPLICATION_OK;
+}
+
+static void fillRecord(ST_replicationRecord_t * const record, const ST_transaction_t * const transData,
+                       const int16_t accountIndex, const ST_accountsDB_t * const account) {
+
+    memset(record, 0, sizeof(*record));
+    record->sequence = ++lastSequence;
+    record->type = REPLICATION_RECORD_CHANGE;
+    record->accountIndex = (NULL == account) ? -1 : accountIndex;
+
+    if(NULL != account) {
+        record->account = *account;
+    }
+
+    if(NULL != transData) {
+        record->isTransaction = TRUE;
+        record->transaction = *transData;
+    }
+}
+
+static void *runSender(void *argument) {
+    struct timespec deadline;
+    uint64_t head = queueHead, tail = 0, count = 0;
+
+    (void)argument;
+
+    while(TRUE) {
+        tail = __atomic_load_n(&queueTail, __ATOMIC_SEQ_CST);
+
+        if(head == tail) {
+            if(__atomic_load_n(&isSenderStopping, __ATOMIC_SEQ_CST)) {
+                break;
+            }
+
+            /* Checking the queue again once flagged as waiting, so no wake up is missed */
+            pthread_mutex_lock(&senderMutex);
+            __atomic_store_n(&isSenderWaiting, TRUE, __ATOMIC_SEQ_CST);
+            if( (head == __atomic_load_n(&queueTail, __ATOMIC_SEQ_CST)) &&
+                !__atomic_load_n(&isSenderStopping, __ATOMIC_SEQ_CST) ) {
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_nsec += REPLICATION_IDLE_MS * 1000000L;
+                deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+                deadline.tv_nsec %= 1000000000L;
+                pthread_cond_timedwait(&senderCondition, &senderMutex, &deadline);
+            }
+            __atomic_store_n(&isSenderWaiting, FALSE, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&senderMutex);
+            continue;
+        }
+
+        /* Every record queued up to the end of the ring, in one send */
+        count = tail - head;
+        if(count > REPLICATION_QUEUE_SIZE - head % REPLICATION_QUEUE_SIZE) {
+            count = REPLICATION_QUEUE_SIZE - head % REPLICATION_QUEUE_SIZE;
+        }
+
+        if(!sendAll(standbySocket, &(queue[head % REPLICATION_QUEUE_SIZE]), count * sizeof(*queue))) {
+            __atomic_store_n(&isStandbyLost, TRUE, __ATOMIC_RELEASE);
+            break;
+        }
+
+        head += count;
+        __atomic_store_n(&queueHead, head, __ATOMIC_RELEASE);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,150 @@
+/********************************************************************************
+ * @file    replication.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the hot standby replication
+ *          \ref replication.c
+ * @details The server ships every change it commits, a saved transaction with
+ *          the account it changed or an account added or removed, to a standby
+ *          process on a local Unix socket. The standby applies the changes in
+ *          order to its own accounts, history and journal, so it is ready to
+ *          serve the moment the primary goes away: it is then promoted and
+ *          serves its accounts as a shard, see \ref shard.h.
+ *          In synchronous mode the server waits for the standby to apply each
+ *          change before answering the terminal, so no approved transaction is
+ *          lost with the primary. In asynchronous mode the changes are queued
+ *          and sent in batches by a thread, the primary never waits but the
+ *          last changes are lost if it dies before sending them.
+ *          The standby must run before the primary serves: the accounts and
+ *          the offline marks are copied when it connects, the earlier history
+ *          is not.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Changes queued for the standby in asynchronous mode, a power of 2.
+ *          The server waits for room when the standby falls that far behind.
+ ********************************************************************************/
+#define REPLICATION_QUEUE_SIZE      4096
+
+/*********************************************************************************
+ * @brief   Longest time the sender thread sleeps with nothing queued, in
+ *          milliseconds, a change queued meanwhile wakes it up
+ ********************************************************************************/
+#define REPLICATION_IDLE_MS         10
+
+/*********************************************************************************
+ * @brief   Enum for the replication modes
+ ********************************************************************************/
+typedef enum EN_replicationMode_t {
+    REPLICATION_OFF,                /*!< No standby */
+    REPLICATION_ASYNC,              /*!< Changes queued, the server does not wait for the standby */
+    REPLICATION_SYNC                /*!< The server waits for the standby to apply each change */
+} EN_replicationMode_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>replication</b> module
+ ********************************************************************************/
+typedef enum EN_replicationError_t {
+    REPLICATION_OK,                 /*!< Done */
+    REPLICATION_NOT_STARTED,        /*!< No standby is connected */
+    REPLICATION_MODE_ERROR,         /*!< Invalid mode, or replication already started */
+    REPLICATION_SOCKET_ERROR,       /*!< The socket cannot be opened, or the standby is lost */
+    REPLICATION_THREAD_ERROR,       /*!< The sender thread cannot be started */
+    REPLICATION_NO_MEMORY,          /*!< No memory for the queue */
+    REPLICATION_APPLY_ERROR,        /*!< The standby cannot apply a change, it stopped */
+    REPLICATION_FILE_ERROR          /*!< The standby file cannot be read */
+} EN_replicationError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Run this process as the standby of a primary server.
+ *
+ * @details     One primary is served. When it stops replication without a
+ *              promotion the standby stops too. When it asks for a promotion,
+ *              or its connection is lost, the standby is promoted: it serves
+ *              every account it holds as shard 0 of 1 on servingPath, until a
+ *              router stops it.
+ * @param[in]   replicationPath: Path of the Unix socket the primary connects
+ *              to, replaced if it exists
+ * @param[in]   servingPath: Path of the Unix socket served once promoted, e.g.
+ *              that of the primary when it was a shard
+ * @return      EN_replicationError_t: REPLICATION_OK once stopped,
+ *              REPLICATION_SOCKET_ERROR or REPLICATION_APPLY_ERROR
+ ********************************************************************************/
+EN_replicationError_t runStandby(const char * const replicationPath, const char * const servingPath);
+
+/*********************************************************************************
+ * @brief       Connect the server of this process to its standby, copy the
+ *              accounts to it, and ship it every change from now on.
+ *
+ * @param[in]   socketPath: Socket of the standby
+ * @param[in]   mode: REPLICATION_SYNC or REPLICATION_ASYNC
+ * @return      EN_replicationError_t: REPLICATION_OK, REPLICATION_MODE_ERROR,
+ *              REPLICATION_SOCKET_ERROR, REPLICATION_THREAD_ERROR or
+ *              REPLICATION_NO_MEMORY (replication is left as it was)
+ ********************************************************************************/
+EN_replicationError_t startReplication(const char * const socketPath, const EN_replicationMode_t mode);
+
+/*********************************************************************************
+ * @brief       Start replication to the standby given in a file, see
+ *              \ref startReplication.
+ *
+ * @details     The file holds one line "socketPath sync" or "socketPath async".
+ ********************************************************************************/
+EN_replicationError_t startReplicationFile(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Send the changes still queued, then stop replication.
+ *
+ * @param[in]   isPromoting: TRUE to promote the standby, a planned switchover,
+ *              FALSE to stop it
+ * @return      EN_replicationError_t: REPLICATION_OK once the standby has every
+ *              change, REPLICATION_NOT_STARTED or REPLICATION_SOCKET_ERROR
+ ********************************************************************************/
+EN_replicationError_t stopReplication(const BOOL_t isPromoting);
+
+/*********************************************************************************
+ * @brief       Ship a change committed by the server to the standby, called by
+ *              the server module.
+ *
+ * @details     In synchronous mode it returns once the standby applied the
+ *              change. A standby lost turns replication off, the server keeps
+ *              serving alone.
+ * @param[in]   transData: The transaction saved, NULL for an account change
+ *              only
+ * @param[in]   accountIndex: Index of the account changed, -1 for none
+ * @param[in]   account: The account after the change, NULL for none
+ * @return      EN_replicationError_t: REPLICATION_OK, REPLICATION_NOT_STARTED
+ *              or REPLICATION_SOCKET_ERROR
+ ********************************************************************************/
+EN_replicationError_t replicateChange(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                      const ST_accountsDB_t * const account);
+
+/*********************************************************************************
+ * @brief       Get the replication mode, REPLICATION_OFF once the standby is
+ *              lost.
+ ********************************************************************************/
+EN_replicationMode_t getReplicationMode(void);
+
+
+#endif      /* REPLICATION_H */
@@ -0,0 +1,326 @@
+/********************************************************************************
+ * @file    routing.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the BIN routing module implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "reload.h"
+#include "routing.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Number of buckets of the first level index, one per leading 4 digits
+ ********************************************************************************/
+#define BIN_BUCKET_COUNT        10000u
+
+/********************************************************************************
+ * @brief   Number of 8 digit BINs per bucket
+ ********************************************************************************/
+#define BIN_BUCKET_WIDTH        10000u
+
+/********************************************************************************
+ * @brief   Largest 8 digit BIN
+ ********************************************************************************/
+#define BIN_MAX                 99999999u
+
+/********************************************************************************
+ * @brief   Struct for a routing table, allocated in one block with its arrays
+ ********************************************************************************/
+typedef struct ST_binTable_t {
+    uint32_t count;                                 /*!< Number of ranges */
+    uint32_t bucketStart[BIN_BUCKET_COUNT + 1];     /*!< Index of the first range starting in each bucket */
+    uint32_t *lowBins;                              /*!< Sorted first BIN of each range */
+    uint32_t *highBins;                             /*!< Last BIN of each range */
+    uint16_t *routes;                               /*!< Route of each range */
+} ST_binTable_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The routing table used by lookups, none when no table is loaded
+ ********************************************************************************/
+static ST_reloadTable_t binTable = RELOAD_TABLE_INITIALIZER;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static int compareBinRanges(const void * const first, const void * const second);
+static int32_t parseBin(const char * const text, const BOOL_t isHighBin);
+static uint16_t findRoute(const ST_binTable_t * const table, const uint32_t bin);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_routingError_t loadBinRanges(const ST_binRange_t * const ranges, const uint32_t count) {
+    ST_binRange_t *sortedRanges = NULL;
+    ST_binTable_t *table = NULL;
+    uint32_t i = 0, bucket = 0;
+
+    if( ((NULL == ranges) && (0 != count)) || (count > BIN_RANGES_MAX_COUNT) ) {
+        return INVALID_BIN_RANGES;
+    }
+
+    sortedRanges = malloc((count + 1) * sizeof(*sortedRanges));
+    table = malloc(sizeof(*table) + count * (2 * sizeof(uint32_t) + sizeof(uint16_t)));
+    if( (NULL == sortedRanges) || (NULL == table) ) {
+        free(sortedRanges);
+        free(table);
+        return ROUTING_NO_MEMORY;
+    }
+
+    memcpy(sortedRanges, ranges, count * sizeof(*sortedRanges));
+    qsort(sortedRanges, count, sizeof(*sortedRanges), compareBinRanges);
+
+    /* Validating the ranges */
+    for(i = 0; i < count; ++i) {
+        if( (sortedRanges[i].lowBin > sortedRanges[i].highBin) || (sortedRanges[i].highBin > BIN_MAX) ||
+            (ROUTE_NOT_FOUND == sortedRanges[i].route)                                             ||
+            ( (i > 0) && (sortedRanges[i].lowBin <= sortedRanges[i - 1].highBin) ) ) {
+            free(sortedRanges);
+            free(table);
+            return INVALID_BIN_RANGES;
+        }
+    }
+
+    /* Laying the ranges out as arrays right after the table header */
+    table->count    = count;
+    table->lowBins  = (uint32_t *)(table + 1);
+    table->highBins = table->lowBins + count;
+    table->routes   = (uint16_t *)(table->highBins + count);
+
+    for(i = 0; i < count; ++i) {
+        table->lowBins[i]  = sortedRanges[i].lowBin;
+        table->highBins[i] = sortedRanges[i].highBin;
+        table->routes[i]   = sortedRanges[i].route;
+    }
+
+    for(bucket = 0, i = 0; bucket <= BIN_BUCKET_COUNT; ++bucket) {
+        while( (i < count) && (table->lowBins[i] < bucket * BIN_BUCKET_WIDTH) ) {
+            ++i;
+        }
+        table->bucketStart[bucket] = i;
+    }
+
+    free(sortedRanges);
+
+    /* Publishing the new table, the old one is freed once the lookups in flight are done */
+    swapReloadTable(&binTable, table);
+
+    return ROUTING_OK;
+}
+
+EN_routingError_t loadBinRangesFile(const char * const fileName) {
+    FILE *file = NULL;
+    ST_binRange_t *ranges = NULL, *grownRanges = NULL;
+    uint32_t count = 0, capacity = 1024;
+    char lowText[16], highText[16], line[64];
+    unsigned int route = 0;
+    int32_t lowBin = 0, highBin = 0;
+    EN_routingError_t routingError = ROUTING_OK;
+
+    if(NULL == fileName) {
+        return ROUTING_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return ROUTING_FILE_ERROR;
+    }
+
+    ranges = malloc(capacity * sizeof(*ranges));
+
+    while( (NULL != ranges) && (ROUTING_OK == routingError) && (NULL != fgets(line, sizeof(line), file)) ) {
+        if(1 > sscanf(line, "%15s", lowText)) {
+            continue;           /* Empty line */
+        }
+
+        if(3 != sscanf(line, "%15s %15s %u", lowText, highText, &route)) {
+            routingError = ROUTING_FILE_ERROR;
+            break;
+        }
+
+        lowBin = parseBin(lowText, FALSE);
+        highBin = parseBin(highText, TRUE);
+        if( (-1 == lowBin) || (-1 == highBin) || (route >= ROUTE_NOT_FOUND) ) {
+            routingError = ROUTING_FILE_ERROR;
+            break;
+        }
+
+        if(count == capacity) {
+            capacity *= 2;
+            grownRanges = realloc(ranges, capacity * sizeof(*ranges));
+            if(NULL == grownRanges) {
+                routingError = ROUTING_NO_MEMORY;
+                break;
+            }
+            ranges = grownRanges;
+        }
+
+        ranges[count].lowBin  = (uint32_t)lowBin;
+        ranges[count].highBin = (uint32_t)highBin;
+        ranges[count].route   = (uint16_t)route;
+        ++count;
+    }
+
+    fclose(file);
+
+    if(NULL == ranges) {
+        return ROUTING_NO_MEMORY;
+    }
+
+    if(ROUTING_OK == routingError) {
+        routingError = loadBinRanges(ranges, count);
+    }
+
+    free(ranges);
+
+    return routingError;
+}
+
+void unloadBinRanges(void) {
+    swapReloadTable(&binTable, NULL);
+}
+
+int32_t getPanBin(const uint8_t * const pan) {
+    int32_t bin = 0;
+    uint8_t i = 0, digit = 0;
+
+    if(NULL == pan) {
+        return -1;
+    }
+
+    for(i = 0; i < 8; ++i) {
+        digit = (uint8_t)(pan[i] - '0');
+        if(digit > 9) {
+            return -1;
+        }
+        bin = bin * 10 + digit;
+    }
+
+    return bin;
+}
+
+uint16_t getCardRoute(const ST_cardData_t * const cardData) {
+    const ST_binTable_t *table = NULL;
+    int32_t bin = 0;
+    uint32_t epoch = 0;
+    uint16_t route = ROUTE_NOT_FOUND;
+
+    bin = (NULL == cardData) ? -1 : getPanBin(cardData->primaryAccountNumber);
+
+    table = enterReloadTable(&binTable, &epoch);
+    if(NULL == table) {
+        route = ROUTE_DEFAULT;
+    } else if(-1 != bin) {
+        route = findRoute(table, (uint32_t)bin);
+    }
+    leaveReloadTable(&binTable, epoch);
+
+    return route;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                             PRIVATE FUNCTION DEFINITIONS                    */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Order BIN ranges by their first BIN, for qsort()
+ *******************************************************************************/
+static int compareBinRanges(const void * const first, const void * const second) {
+    const ST_binRange_t *firstRange = first, *secondRange = second;
+
+    return (firstRange->lowBin > secondRange->lowBin) - (firstRange->lowBin < secondRange->lowBin);
+}
+
+/********************************************************************************
+ * @brief       Parse a 6 or 8 digit BIN of the routing file
+ *
+ * @param[in]   text: BIN digits
+ * @param[in]   isHighBin: TRUE to extend a 6 digit BIN to its last 8 digit BIN,
+ *              FALSE to extend it to its first one
+ * @return      int32_t: The 8 digit BIN, or -1 on error
+ *******************************************************************************/
+static int32_t parseBin(const char * const text, const BOOL_t isHighBin) {
+    uint8_t buffer[9];
+    size_t length = strlen(text);
+
+    if( (6 != length) && (8 != length) ) {
+        return -1;
+    }
+
+    memcpy(buffer, text, length);
+    if(6 == length) {
+        buffer[6] = isHighBin ? '9' : '0';
+        buffer[7] = isHighBin ? '9' : '0';
+    }
+    buffer[8] = '\0';
+
+    return getPanBin(buffer);
+}
+
+/********************************************************************************
+ * @brief       Find the route of a BIN in a routing table
+ *
+ * @param[in]   table: The routing table
+ * @param[in]   bin: 8 digit BIN
+ * @return      uint16_t: The route, or ROUTE_NOT_FOUND
+ *******************************************************************************/
+static uint16_t findRoute(const ST_binTable_t * const table, const uint32_t bin) {
+    uint32_t bucket = 0, low = 0, high = 0, middle = 0;
+
+    /* Ranges starting in the BIN bucket, and the last one before it which may span into it */
+    bucket = bin / BIN_BUCKET_WIDTH;
+    low  = table->bucketStart[bucket];
+    high = table->bucketStart[bucket + 1];
+    low  = (low > 0) ? (low - 1) : 0;
+
+    /* Last range of [low, high) starting at or before the BIN */
+    while(low + 1 < high) {
+        middle = low + (high - low) / 2;
+        if(table->lowBins[middle] <= bin) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    if( (low < table->count) && (table->lowBins[low] <= bin) && (table->highBins[low] >= bin) ) {
+        return table->routes[low];
+    }
+
+    return ROUTE_NOT_FOUND;
+}
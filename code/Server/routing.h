@@ -0,0 +1,115 @@
+/********************************************************************************
+ * @file    routing.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the BIN routing module
+ *          \ref routing.c
+ * @details The routing table maps the BIN (the leading 8 digits of the PAN)
+ *          to the issuer back end that owns the card. It is a sorted array of
+ *          non overlapping BIN ranges, indexed by the leading 4 digits, so a
+ *          lookup is one index read and a short binary search.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef ROUTING_H
+#define ROUTING_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Route of every card while no routing table is loaded
+ ********************************************************************************/
+#define ROUTE_DEFAULT               ((uint16_t)0)
+
+/*********************************************************************************
+ * @brief   Route of the cards whose BIN is in no range of the loaded table
+ ********************************************************************************/
+#define ROUTE_NOT_FOUND             ((uint16_t)0xFFFF)
+
+/*********************************************************************************
+ * @brief   Maximum number of ranges in a routing table
+ ********************************************************************************/
+#define BIN_RANGES_MAX_COUNT        (1u << 22)
+
+/*********************************************************************************
+ * @brief   Struct for a BIN range, both bounds are 8 digit BINs and included
+ ********************************************************************************/
+typedef struct ST_binRange_t {
+    uint32_t lowBin;                    /*!< First BIN of the range */
+    uint32_t highBin;                   /*!< Last BIN of the range */
+    uint16_t route;                     /*!< Issuer back end of the range */
+} ST_binRange_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>routing</b> module
+ ********************************************************************************/
+typedef enum EN_routingError_t {
+    ROUTING_OK,                         /*!< Routing table loaded */
+    INVALID_BIN_RANGES,                 /*!< Ranges overlap, are reversed, too many or have an invalid route */
+    ROUTING_NO_MEMORY,                  /*!< No memory for the new routing table */
+    ROUTING_FILE_ERROR                  /*!< Routing file cannot be read or has an invalid line */
+} EN_routingError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Build a routing table from BIN ranges and make it the active one.
+ *
+ * @details     The new table is built aside and swapped in atomically, so
+ *              lookups running meanwhile keep using the previous table and are
+ *              never blocked. The replaced table is freed once those lookups
+ *              are done, see \ref reload.h, so the reload waits for them.
+ * @param[in]   ranges: Array of ranges, in any order
+ * @param[in]   count: Number of ranges
+ * @return      EN_routingError_t: ROUTING_OK, INVALID_BIN_RANGES or
+ *              ROUTING_NO_MEMORY. The active table is unchanged on error.
+ ********************************************************************************/
+EN_routingError_t loadBinRanges(const ST_binRange_t * const ranges, const uint32_t count);
+
+/*********************************************************************************
+ * @brief       Load the routing table from a text file, see \ref loadBinRanges.
+ *
+ * @details     Each line holds "lowBin highBin route". BINs have 6 or 8 digits,
+ *              a 6 digit BIN covers the 100 BINs of 8 digits starting with it.
+ * @param[in]   fileName: Path of the routing file
+ * @return      EN_routingError_t: ROUTING_OK or the error of the load
+ ********************************************************************************/
+EN_routingError_t loadBinRangesFile(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Free the routing tables, every card gets \ref ROUTE_DEFAULT again.
+ ********************************************************************************/
+void unloadBinRanges(void);
+
+/*********************************************************************************
+ * @brief       Get the 8 digit BIN of a PAN.
+ *
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @return      int32_t: The BIN, or -1 if the PAN does not start with 8 digits
+ ********************************************************************************/
+int32_t getPanBin(const uint8_t * const pan);
+
+/*********************************************************************************
+ * @brief       Get the issuer back end of a card.
+ *
+ * @param[in]   cardData: Pointer to the card data
+ * @return      uint16_t: The route of the card BIN, \ref ROUTE_DEFAULT if no
+ *              table is loaded, or \ref ROUTE_NOT_FOUND
+ ********************************************************************************/
+uint16_t getCardRoute(const ST_cardData_t * const cardData);
+
+
+#endif      /* ROUTING_H */
@@ -18,6 +18,28 @@
 #include "../Card/card.h"
 #include "../Terminal/terminal.h"
 #include "server.h"
+#include "settlement.h"
+#include "exchange.h"
+#include "replication.h"
+#include "admission.h"
+#include "vault.h"
+#include "../Log/log.h"
+#include "../Log/latency.h"
+#include "../Log/metrics.h"
+#include "../Log/trace.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Slots of the offline marks hash table, twice the terminals so probes
+ *          stay short
+ ********************************************************************************/
+#define OFFLINE_MARK_SLOTS              (2 * OFFLINE_MAX_TERMINALS)
 
 
 /*-----------------------------------------------------------------------------*/
@@ -29,29 +51,68 @@
 /********************************************************************************
  * @brief   Database of valid accounts
  ********************************************************************************/
-static ST_accountsDB_t accountsDB[255] = {
-    {.balance = 5000    , .primaryAccountNumber = "1111222233334444555"    },
-    {.balance = 10000   , .primaryAccountNumber = "1112223334445556667"   },
-    {.balance = 3000    , .primaryAccountNumber = "1122334455667788991"    },
-    {.balance = 20000   , .primaryAccountNumber = "1234567891234567891"   },
-    {.balance = 50000   , .primaryAccountNumber = "9876543219876543219"   },
+static ST_accountsDB_t accountsDB[ACCOUNTS_DB_SIZE] = {
+    {.balance = 5000    , .primaryAccountNumber = "1111222233334444554" , .currency = CURRENCY_PACK('E', 'G', 'P') },
+    {.balance = 10000   , .primaryAccountNumber = "1112223334445556661" , .currency = CURRENCY_PACK('E', 'G', 'P') },
+    {.balance = 3000    , .primaryAccountNumber = "1122334455667788990" , .currency = CURRENCY_PACK('E', 'G', 'P') },
+    {.balance = 20000   , .primaryAccountNumber = "1234567891234567890" , .currency = CURRENCY_PACK('E', 'G', 'P') },
+    {.balance = 50000   , .primaryAccountNumber = "9876543219876543210" , .currency = CURRENCY_PACK('E', 'G', 'P') },
 };
 
+/********************************************************************************
+ * @brief   Number of accounts in accountsDB
+ ********************************************************************************/
+static uint16_t accountsDBCount = 5;
+
 /********************************************************************************
  * @brief   The index of the current account being processed
  ********************************************************************************/
 static int16_t accountsDBIndex = 0;
 
+/********************************************************************************
+ * @brief   The amount of the current transaction in the currency of its account
+ ********************************************************************************/
+static float accountAmount = 0.0f;
+
+/********************************************************************************
+ * @brief   The amount of the current transaction in cents of the currency of
+ *          its account, as held by \ref holdTransaction
+ ********************************************************************************/
+static int64_t accountCents = 0;
+
 /********************************************************************************
  * @brief Database of transactions history 
  ********************************************************************************/
-static ST_transaction_t transactionDB[255] = {0};
+static ST_transactionRecord_t transactionDB[255] = {0};
 
 /********************************************************************************
  * @brief   The index of the next free memory to save the transaction
  ********************************************************************************/
 static uint8_t transDBIndex = 0;
 
+/********************************************************************************
+ * @brief   The number of transactions in transactionDB, until it is full
+ ********************************************************************************/
+static uint8_t transDBCount = 0;
+
+/********************************************************************************
+ * @brief   The offline sequence number of the last reconciled transaction of
+ *          each terminal, in the order the terminals were first seen
+ ********************************************************************************/
+static ST_offlineMark_t offlineMarks[OFFLINE_MAX_TERMINALS];
+static uint32_t offlineMarksCount = 0;
+
+/********************************************************************************
+ * @brief   Hash table of the terminals of offlineMarks, each slot holds the
+ *          index of its mark + 1, 0 when free
+ ********************************************************************************/
+static uint32_t offlineMarkSlots[OFFLINE_MARK_SLOTS];
+
+/********************************************************************************
+ * @brief   The highest offline sequence number reconciled from any terminal
+ ********************************************************************************/
+static uint32_t lastOfflineSequenceNumber = 0;
+
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
 /*                      PRIVATE FUNCTION DECLARATIONS                          */
@@ -68,6 +129,29 @@ static uint8_t transDBIndex = 0;
  ********************************************************************************/
 static int16_t getAccountIndexInDB(uint8_t * pan);
 
+/********************************************************************************
+ * @brief       Convert the amount of a transaction to the currency of an account
+ * 
+ * @param[in]   termData: Pointer to the terminal data
+ * @param[in]   account: Pointer to the account
+ * @param[out]  amount: The amount in the account currency
+ * @param[out]  cents: The amount in cents of the account currency
+ * @return      EN_serverError_t: SERVER_OK or NO_EXCHANGE_RATE
+ ********************************************************************************/
+static EN_serverError_t getAccountAmount(const ST_terminalData_t * const termData, 
+                                         const ST_accountsDB_t * const account, float * const amount,
+                                         int64_t * const cents);
+
+/********************************************************************************
+ * @brief       Find the offline mark of a terminal, adding it if asked
+ * 
+ * @param[in]   terminalId: ID of the terminal
+ * @param[in]   isAdding: Add a mark at 0 if the terminal has none
+ * @return      ST_offlineMark_t *: The mark, NULL if the terminal has none and
+ *              it is not added, or OFFLINE_MAX_TERMINALS terminals have one
+ ********************************************************************************/
+static ST_offlineMark_t *findOfflineMark(const uint32_t terminalId, const BOOL_t isAdding);
+
 
 /*-----------------------------------------------------------------------------*/
 /*                                                                             */
@@ -77,52 +161,92 @@ static int16_t getAccountIndexInDB(uint8_t * pan);
 
 EN_transState_t recieveTransactionData(ST_transaction_t * const transData) {
     EN_serverError_t serverError = SERVER_OK;
+    uint64_t stepTime = 0;
 
     /* Validating the passed address    */
     if(NULL == transData) {
         return INTERNAL_SERVER_ERROR;
     }
 
+    /* Shed before any authorization work, the terminal tries again later and nothing is saved.
+       Not traced, a flood would push every other event out of the flight recorder. */
+    if(ADMISSION_OK != admitTransaction(transData, getAdmissionTime())) {
+        transData->transState = DECLINED_TRY_LATER;
+        countMetric(METRIC_TRANS_STATE, transData->transState);
+        return transData->transState;
+    }
+
+    stepTime = LATENCY_TIME();
     accountsDBIndex = getAccountIndexInDB(transData->cardHolderData.primaryAccountNumber);
+    serverError = isValidAccount(&(transData->cardHolderData));
+    stepTime = LATENCY_SINCE(LATENCY_SERVER_ACCOUNT_LOOKUP, stepTime);
+    countMetric(METRIC_SERVER_RESULT, serverError);
+    traceEvent(TRACE_ACCOUNT_LOOKUP, serverError);
 
-    if( ACCOUNT_NOT_FOUND == isValidAccount(&(transData->cardHolderData)) ) {
+    if( ACCOUNT_NOT_FOUND == serverError ) {
 
         transData->transState = DECLINED_STOLEN_CARD;
 
-    } else if( LOW_BALANCE == isAmountAvailable(&(transData->terminalData)) ) {
-
-        transData->transState = DECLINED_INSUFFICIENT_FUND;
-
     } else {
-        transData->transState = APPROVED;
+        serverError = isAmountAvailable(&(transData->terminalData));
+        stepTime = LATENCY_SINCE(LATENCY_SERVER_BALANCE_CHECK, stepTime);
+        countMetric(METRIC_SERVER_RESULT, serverError);
+        traceEvent(TRACE_BALANCE_CHECK, serverError);
+
+        if(LOW_BALANCE == serverError) {
+            transData->transState = DECLINED_INSUFFICIENT_FUND;
+        } else if(NO_EXCHANGE_RATE == serverError) {
+            transData->transState = DECLINED_NO_EXCHANGE_RATE;
+        } else {
+            transData->transState = APPROVED;
+        }
     }
 
     serverError = saveTransaction(transData);
+    stepTime = LATENCY_SINCE(LATENCY_SERVER_SAVE, stepTime);
+    countMetric(METRIC_SERVER_RESULT, serverError);
+    traceEvent(TRACE_SAVE, serverError);
 
     /* Validating the passed address    */
     if( (SERVER_OK == serverError) && (APPROVED == transData->transState) ) {
         /* Updating the balance */
-        printf("Account balance: %.0f\n", accountsDB[accountsDBIndex].balance);
-        accountsDB[accountsDBIndex].balance -= transData->terminalData.transAmount;
-        printf("Your new balance: %.0f\n", accountsDB[accountsDBIndex].balance);
+        logEvent(LOG_ACCOUNT_BALANCE, accountsDB[accountsDBIndex].balance, 0);
+        accountsDB[accountsDBIndex].balance -= accountAmount;
+        logEvent(LOG_NEW_BALANCE, accountsDB[accountsDBIndex].balance, 0);
+        stepTime = LATENCY_SINCE(LATENCY_SERVER_BALANCE_UPDATE, stepTime);
     } else {
         if(SERVER_OK != serverError) {
             transData->transState = INTERNAL_SERVER_ERROR;
         }
     }    
 
+    /* In synchronous mode the standby holds the change before the terminal gets the answer */
+    if( (SERVER_OK == serverError) &&
+        (REPLICATION_OK == replicateChange(transData, accountsDBIndex,
+                                           (-1 == accountsDBIndex) ? NULL : &(accountsDB[accountsDBIndex]))) ) {
+        LATENCY_RECORD(LATENCY_SERVER_REPLICATION, LATENCY_TIME() - stepTime);
+    }
+
+    countMetric(METRIC_TRANS_STATE, transData->transState);
+    traceEvent(TRACE_AUTHORIZATION, transData->transState);
+
+    /* The events that led to an internal error are kept for investigation */
+    if(INTERNAL_SERVER_ERROR == transData->transState) {
+        dumpTrace("internal server error");
+    }
+
     return transData->transState;
 }
 
 EN_serverError_t isValidAccount(ST_cardData_t * const cardData) {
-    uint8_t i = 0;
+    uint16_t i = 0;
 
     /* Validating the passed address    */
     if(NULL == cardData) {
         return ACCOUNT_NOT_FOUND;
     }
 
-    for(i = 0; i < sizeof(accountsDB->primaryAccountNumber); ++i) {
+    for(i = 0; i < accountsDBCount; ++i) {
         if(0 == strcmp((char *)(cardData->primaryAccountNumber), (char *) (accountsDB[i].primaryAccountNumber) )) {
             accountsDBIndex = i;
             return SERVER_OK;
@@ -143,7 +267,12 @@ EN_serverError_t isAmountAvailable(ST_terminalData_t * const termData) {
         return LOW_BALANCE;
     }
 
-    if(accountsDB[accountsDBIndex].balance < termData->transAmount) {       
+    if(SERVER_OK != getAccountAmount(termData, &(accountsDB[accountsDBIndex]), &accountAmount, &accountCents)) {
+        return NO_EXCHANGE_RATE;
+    }
+
+    if((double)accountsDB[accountsDBIndex].balance - (double)accountsDB[accountsDBIndex].heldCents / 100.0 <
+       (double)accountAmount) {
         return LOW_BALANCE;
     }
 
@@ -151,22 +280,388 @@ EN_serverError_t isAmountAvailable(ST_terminalData_t * const termData) {
 }
 
 EN_serverError_t saveTransaction(ST_transaction_t * const transData) {
+    ST_transactionRecord_t * const record = &(transactionDB[transDBIndex]);
+    PAN_TOKEN_t panToken = PAN_TOKEN_NONE;
+    EN_vaultError_t vaultError = VAULT_OK;
+    float amount = 0.0f;
+    int64_t cents = 0;
+
+    if(NULL == transData) {
+        return SAVING_FAILED;
+    }
+
+    /* Only the cards of accounts take room in the vault, a card typed wrong or unknown is kept as none */
+    if(-1 != accountsDBIndex) {
+        vaultError = tokenizePan(transData->cardHolderData.primaryAccountNumber, &panToken);
+        if( (VAULT_OK != vaultError) && (VAULT_INVALID_PAN != vaultError) ) {
+            return SAVING_FAILED;
+        }
+    }
+
+    /* Journaled in the currency of the account: as debited if approved, else converted if there is a rate */
+    amount = transData->terminalData.transAmount;
+    if(APPROVED == transData->transState) {
+        amount = accountAmount;
+    } else if(-1 != accountsDBIndex) {
+        (void)getAccountAmount(&(transData->terminalData), &(accountsDB[accountsDBIndex]), &amount, &cents);
+    }
+
+    /* A transaction the settlement would miss is not saved */
+    if(SETTLEMENT_OK != journalTransaction(transData, accountsDBIndex, amount)) {
+        return SAVING_FAILED;
+    }
+
+    transData->transactionSequenceNumber = transDBIndex;
+    record->panToken = panToken;
+    record->terminalData = transData->terminalData;
+    record->transState = transData->transState;
+    record->transactionSequenceNumber = transDBIndex;
+    record->offlineSequenceNumber = transData->offlineSequenceNumber;
+
+    /* The database keeps the latest transactions, the oldest is overwritten */
+    transDBIndex = (transDBIndex + 1) % (sizeof(transactionDB) / sizeof(transactionDB[0]));
+    if(transDBCount < sizeof(transactionDB) / sizeof(transactionDB[0])) {
+        ++transDBCount;
+    }
+
+    return SERVER_OK;
+}
+
+EN_serverError_t saveDeclinedTransaction(ST_transaction_t * const transData) {
+    EN_serverError_t serverError = SERVER_OK;
+
+    if(NULL == transData) {
+        return SAVING_FAILED;
+    }
+
+    accountsDBIndex = getAccountIndexInDB(transData->cardHolderData.primaryAccountNumber);
+    serverError = saveTransaction(transData);
+    countMetric(METRIC_SERVER_RESULT, serverError);
+    traceEvent(TRACE_SAVE, serverError);
+
+    if(SERVER_OK == serverError) {
+        replicateChange(transData, accountsDBIndex, (-1 == accountsDBIndex) ? NULL : &(accountsDB[accountsDBIndex]));
+    } else {
+        transData->transState = INTERNAL_SERVER_ERROR;
+    }
+
+    countMetric(METRIC_TRANS_STATE, transData->transState);
+    traceEvent(TRACE_AUTHORIZATION, transData->transState);
+
+    if(INTERNAL_SERVER_ERROR == transData->transState) {
+        dumpTrace("internal server error");
+    }
+
+    return serverError;
+}
+
+EN_serverError_t reconcileOfflineBatch(const ST_transaction_t * const batch, const uint32_t count, 
+                                       uint32_t * const postedCount) {
+    ST_transaction_t transData;
+    ST_offlineMark_t *mark = NULL;
+    uint32_t i = 0;
+    int16_t index = -1;
+
+    if( (NULL == batch) || (NULL == postedCount) ) {
+        return SAVING_FAILED;
+    }
+
+    *postedCount = 0;
+
+    for(i = 0; i < count; ++i) {
+        /* A terminal the server cannot remember would have its batches posted twice */
+        mark = findOfflineMark(batch[i].terminalData.terminalId, TRUE);
+        if(NULL == mark) {
+            return SAVING_FAILED;
+        }
+
+        /* Already posted by an earlier upload of the same batch */
+        if(batch[i].offlineSequenceNumber <= mark->sequenceNumber) {
+            continue;
+        }
+
+        transData = batch[i];
+        index = getAccountIndexInDB(transData.cardHolderData.primaryAccountNumber);
+        if(-1 == index) {
+            transData.transState = DECLINED_STOLEN_CARD;
+        } else if(SERVER_OK != getAccountAmount(&(transData.terminalData), &(accountsDB[index]), &accountAmount, &accountCents)) {
+            transData.transState = DECLINED_NO_EXCHANGE_RATE;
+        } else {
+            transData.transState = APPROVED;
+        }
+        accountsDBIndex = index;
+
+        if(SERVER_OK != saveTransaction(&transData)) {
+            return SAVING_FAILED;
+        }
+
+        if(APPROVED == transData.transState) {
+            accountsDB[index].balance -= accountAmount;
+        }
+        replicateChange(&transData, index, (-1 == index) ? NULL : &(accountsDB[index]));
+
+        mark->sequenceNumber = transData.offlineSequenceNumber;
+        if(transData.offlineSequenceNumber > lastOfflineSequenceNumber) {
+            lastOfflineSequenceNumber = transData.offlineSequenceNumber;
+        }
+        ++(*postedCount);
+    }
+
+    return SERVER_OK;
+}
+
+EN_serverError_t addAccount(const ST_accountsDB_t * const account) {
+
+    /* An empty PAN is the mark of a removed account */
+    if( (NULL == account) || (accountsDBCount >= ACCOUNTS_DB_SIZE) || ('\0' == account->primaryAccountNumber[0]) ||
+        (NULL == memchr(account->primaryAccountNumber, '\0', sizeof(account->primaryAccountNumber))) ) {
+        return SAVING_FAILED;
+    }
+
+    if(-1 != getAccountIndexInDB((uint8_t *)account->primaryAccountNumber)) {
+        return SAVING_FAILED;
+    }
+
+    accountsDB[accountsDBCount] = *account;
+    ++accountsDBCount;
+    replicateChange(NULL, (int16_t)(accountsDBCount - 1), account);
+
+    return SERVER_OK;
+}
+
+uint16_t getAccountsCount(void) {
+    return accountsDBCount;
+}
+
+const uint8_t *getAccountPan(const uint16_t index) {
+
+    if(index >= accountsDBCount) {
+        return NULL;
+    }
+
+    return accountsDB[index].primaryAccountNumber;
+}
+
+EN_serverError_t getAccount(const uint16_t index, ST_accountsDB_t * const account) {
+
+    if( (NULL == account) || (index >= accountsDBCount) || ('\0' == accountsDB[index].primaryAccountNumber[0]) ) {
+        return ACCOUNT_NOT_FOUND;
+    }
+
+    *account = accountsDB[index];
+
+    return SERVER_OK;
+}
+
+EN_serverError_t removeAccount(const uint8_t * const pan, ST_accountsDB_t * const account) {
+    const ST_accountsDB_t removedAccount = {0};
+    int16_t index = -1;
+
+    if( (NULL == pan) || (NULL == account) || ('\0' == pan[0]) ) {
+        return ACCOUNT_NOT_FOUND;
+    }
+
+    index = getAccountIndexInDB((uint8_t *)pan);
+    if(-1 == index) {
+        return ACCOUNT_NOT_FOUND;
+    }
+
+    *account = accountsDB[index];
+    accountsDB[index] = removedAccount;
+    replicateChange(NULL, index, &removedAccount);
+
+    return SERVER_OK;
+}
+
+EN_transState_t holdTransaction(ST_transaction_t * const transData, int16_t * const accountIndex,
+                                int64_t * const amountCents) {
+    EN_serverError_t serverError = SERVER_OK;
+
+    if( (NULL == transData) || (NULL == accountIndex) || (NULL == amountCents) ) {
+        return INTERNAL_SERVER_ERROR;
+    }
+
+    accountsDBIndex = getAccountIndexInDB(transData->cardHolderData.primaryAccountNumber);
+    serverError = (-1 == accountsDBIndex) ? ACCOUNT_NOT_FOUND : isAmountAvailable(&(transData->terminalData));
+    countMetric(METRIC_SERVER_RESULT, serverError);
+
+    switch(serverError) {
+        case SERVER_OK:
+            transData->transState = APPROVED;
+            accountsDB[accountsDBIndex].heldCents += accountCents;
+            *accountIndex = accountsDBIndex;
+            *amountCents = accountCents;
+            replicateChange(NULL, accountsDBIndex, &(accountsDB[accountsDBIndex]));
+            break;
+        case ACCOUNT_NOT_FOUND:
+            transData->transState = DECLINED_STOLEN_CARD;
+            break;
+        case NO_EXCHANGE_RATE:
+            transData->transState = DECLINED_NO_EXCHANGE_RATE;
+            break;
+        default:
+            transData->transState = DECLINED_INSUFFICIENT_FUND;
+            break;
+    }
+
+    countMetric(METRIC_TRANS_STATE, transData->transState);
+
+    return transData->transState;
+}
+
+EN_transState_t captureHeldTransaction(ST_transaction_t * const transData, const int16_t accountIndex,
+                                       const int64_t amountCents) {
+    EN_serverError_t serverError = SERVER_OK;
 
     if(NULL == transData) {
+        return INTERNAL_SERVER_ERROR;
+    }
+
+    /* Only the card the amount was held for can capture it */
+    accountsDBIndex = getAccountIndexInDB(transData->cardHolderData.primaryAccountNumber);
+    if( (-1 == accountsDBIndex) || (accountIndex != accountsDBIndex) ) {
+        transData->transState = DECLINED_STOLEN_CARD;
+        countMetric(METRIC_TRANS_STATE, transData->transState);
+        return transData->transState;
+    }
+
+    /* More than the account holds was never held for this capture */
+    if( (amountCents < 0) || (amountCents > accountsDB[accountsDBIndex].heldCents) ) {
+        transData->transState = INTERNAL_SERVER_ERROR;
+        countMetric(METRIC_SERVER_RESULT, HELD_AMOUNT_ERROR);
+        countMetric(METRIC_TRANS_STATE, transData->transState);
+        return transData->transState;
+    }
+
+    /* The held amount is available to its own capture, and held again if it fails */
+    accountsDB[accountsDBIndex].heldCents -= amountCents;
+    serverError = isAmountAvailable(&(transData->terminalData));
+    if(SERVER_OK == serverError) {
+        serverError = saveTransaction(transData);
+    }
+
+    switch(serverError) {
+        case SERVER_OK:
+            transData->transState = APPROVED;
+            logEvent(LOG_ACCOUNT_BALANCE, accountsDB[accountsDBIndex].balance, 0);
+            accountsDB[accountsDBIndex].balance -= accountAmount;
+            logEvent(LOG_NEW_BALANCE, accountsDB[accountsDBIndex].balance, 0);
+            /* The amount no longer held goes to the standby with the new balance */
+            replicateChange(transData, accountsDBIndex, &(accountsDB[accountsDBIndex]));
+            break;
+        case NO_EXCHANGE_RATE:
+            transData->transState = DECLINED_NO_EXCHANGE_RATE;
+            break;
+        case LOW_BALANCE:
+            transData->transState = DECLINED_INSUFFICIENT_FUND;
+            break;
+        default:
+            transData->transState = INTERNAL_SERVER_ERROR;
+            break;
+    }
+
+    if(APPROVED != transData->transState) {
+        accountsDB[accountsDBIndex].heldCents += amountCents;
+    }
+
+    countMetric(METRIC_SERVER_RESULT, serverError);
+    countMetric(METRIC_TRANS_STATE, transData->transState);
+
+    return transData->transState;
+}
+
+EN_serverError_t releaseHeldAmount(const int16_t accountIndex, const int64_t amountCents) {
+
+    if( (accountIndex < 0) || (accountIndex >= accountsDBCount) ) {
+        return ACCOUNT_NOT_FOUND;
+    }
+
+    /* Released twice, or for another account: nothing is changed */
+    if( (amountCents < 0) || (amountCents > accountsDB[accountIndex].heldCents) ) {
+        return HELD_AMOUNT_ERROR;
+    }
+
+    accountsDB[accountIndex].heldCents -= amountCents;
+    replicateChange(NULL, accountIndex, &(accountsDB[accountIndex]));
+
+    return SERVER_OK;
+}
+
+EN_serverError_t applyReplicatedChange(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                       const ST_accountsDB_t * const account) {
+    ST_transaction_t savedTransaction;
+
+    if( (accountIndex >= 0) && ( (NULL == account) || (accountIndex > accountsDBCount) ||
+                                 (accountIndex >= ACCOUNTS_DB_SIZE) ) ) {
         return SAVING_FAILED;
     }
 
-    transactionDB[transDBIndex] = *transData;
-    transactionDB[transDBIndex].transactionSequenceNumber = transDBIndex;
+    /* Saved with the account the primary journaled it with */
+    if(NULL != transData) {
+        savedTransaction = *transData;
+        accountsDBIndex = accountIndex;
+        if(SERVER_OK != saveTransaction(&savedTransaction)) {
+            return SAVING_FAILED;
+        }
+
+        if( (0 != savedTransaction.offlineSequenceNumber) &&
+            (SERVER_OK != setOfflineMark(savedTransaction.terminalData.terminalId,
+                                         savedTransaction.offlineSequenceNumber)) ) {
+            return SAVING_FAILED;
+        }
+    }
+
+    if(accountIndex >= 0) {
+        accountsDB[accountIndex] = *account;
+        accountsDBCount += (accountIndex == accountsDBCount);
+    }
+
+    return SERVER_OK;
+}
+
+uint32_t getOfflineMarksCount(void) {
+    return offlineMarksCount;
+}
+
+EN_serverError_t getOfflineMark(const uint32_t index, ST_offlineMark_t * const mark) {
+
+    if( (NULL == mark) || (index >= offlineMarksCount) ) {
+        return TRANSACTION_NOT_FOUND;
+    }
+
+    *mark = offlineMarks[index];
+
+    return SERVER_OK;
+}
+
+EN_serverError_t setOfflineMark(const uint32_t terminalId, const uint32_t sequenceNumber) {
+    ST_offlineMark_t * const mark = findOfflineMark(terminalId, TRUE);
+
+    if(NULL == mark) {
+        return SAVING_FAILED;
+    }
 
-    ++transDBIndex;
+    if(sequenceNumber > mark->sequenceNumber) {
+        mark->sequenceNumber = sequenceNumber;
+    }
+    if(sequenceNumber > lastOfflineSequenceNumber) {
+        lastOfflineSequenceNumber = sequenceNumber;
+    }
 
     return SERVER_OK;
 }
 
-EN_serverError_t getTransaction(const uint32_t transactionSequenceNumber, ST_transaction_t * const transData) {
+uint32_t getLastOfflineSequenceNumber(void) {
+    return lastOfflineSequenceNumber;
+}
+
+EN_serverError_t getTransaction(const uint32_t transactionSequenceNumber, ST_transactionRecord_t * const record) {
 
+    if( (NULL == record) || (transactionSequenceNumber >= transDBCount) ) {
+        return TRANSACTION_NOT_FOUND;
+    }
 
+    *record = transactionDB[transactionSequenceNumber];
 
     return SERVER_OK;
 }
@@ -179,9 +674,9 @@ EN_serverError_t getTransaction(const uint32_t transactionSequenceNumber, ST_tra
 /*-----------------------------------------------------------------------------*/
 
 static int16_t getAccountIndexInDB(uint8_t * pan) {
-    uint8_t i = 0;
+    uint16_t i = 0;
 
-    for(i = 0; i < sizeof(accountsDB->primaryAccountNumber); ++i) {
+    for(i = 0; i < accountsDBCount; ++i) {
         if(0 == strcmp((char *)pan, (char *) (accountsDB[i].primaryAccountNumber) ) ) {
             return i;
         }
@@ -190,3 +685,48 @@ static int16_t getAccountIndexInDB(uint8_t * pan) {
     return -1;
 }
 
+
+static EN_serverError_t getAccountAmount(const ST_terminalData_t * const termData, 
+                                         const ST_accountsDB_t * const account, float * const amount,
+                                         int64_t * const cents) {
+    const double transCents = (double)termData->transAmount * 100.0;
+    int64_t convertedCents = 0;
+
+    /* Same currency: the amount is taken as it is, without rounding it to cents */
+    if( (termData->currency == account->currency) || (CURRENCY_NONE == termData->currency) ||
+        (CURRENCY_NONE == account->currency) ) {
+        *amount = termData->transAmount;
+        *cents = (int64_t)(transCents + ((transCents < 0) ? -0.5 : 0.5));
+        return SERVER_OK;
+    }
+
+    if(EXCHANGE_OK != convertAmount((int64_t)(transCents + 0.5), termData->currency, account->currency, &convertedCents)) {
+        return NO_EXCHANGE_RATE;
+    }
+
+    *amount = (float)convertedCents / 100.0f;
+    *cents = convertedCents;
+
+    return SERVER_OK;
+}
+
+static ST_offlineMark_t *findOfflineMark(const uint32_t terminalId, const BOOL_t isAdding) {
+    uint32_t slot = (uint32_t)((terminalId * 0x9E3779B97F4A7C15ull) >> 32) & (OFFLINE_MARK_SLOTS - 1);
+
+    while(0 != offlineMarkSlots[slot]) {
+        if(terminalId == offlineMarks[offlineMarkSlots[slot] - 1].terminalId) {
+            return &(offlineMarks[offlineMarkSlots[slot] - 1]);
+        }
+        slot = (slot + 1) & (OFFLINE_MARK_SLOTS - 1);
+    }
+
+    if( !isAdding || (offlineMarksCount >= OFFLINE_MAX_TERMINALS) ) {
+        return NULL;
+    }
+
+    offlineMarks[offlineMarksCount].terminalId = terminalId;
+    offlineMarks[offlineMarksCount].sequenceNumber = 0;
+    offlineMarkSlots[slot] = ++offlineMarksCount;
+
+    return &(offlineMarks[offlineMarksCount - 1]);
+}
@@ -27,7 +27,10 @@ typedef enum EN_transState_t{
     APPROVED,                       /*!< Transaction approved */
     DECLINED_INSUFFICIENT_FUND,     /*!< Transaction declined due to insufficient fund */
     DECLINED_STOLEN_CARD,           /*!< Transaction declined due to stolen card */
-    INTERNAL_SERVER_ERROR           /*!< Transaction declined due to internal server error */
+    INTERNAL_SERVER_ERROR,          /*!< Transaction declined due to internal server error */
+    DECLINED_SUSPECTED_FRAUD,       /*!< Transaction declined due to a high fraud score */
+    DECLINED_NO_EXCHANGE_RATE,      /*!< Transaction declined as its amount cannot be converted to the account currency */
+    DECLINED_TRY_LATER              /*!< Transaction not authorized as the server is overloaded, see \ref admission.h */
 } EN_transState_t;
 
 /*********************************************************************************
@@ -38,7 +41,9 @@ typedef enum EN_serverError_t{
     SAVING_FAILED,                  /*!< Failed saving transaction in the server database */
     TRANSACTION_NOT_FOUND,          /*!< Transaction not found in the server history database */
     ACCOUNT_NOT_FOUND,              /*!< Account not found in the server database */
-    LOW_BALANCE                     /*!< Account balance is lower than the transaction amount */
+    LOW_BALANCE,                    /*!< Account balance is lower than the transaction amount */
+    NO_EXCHANGE_RATE,               /*!< No rate from the terminal currency to the account currency */
+    HELD_AMOUNT_ERROR               /*!< More released or captured than held on the account */
 } EN_serverError_t;
 
 /*********************************************************************************
@@ -49,14 +54,56 @@ typedef struct ST_transaction_t {
     ST_terminalData_t terminalData;         /*!< Terminal data */
     EN_transState_t transState;             /*!< Transaction error state */
     uint32_t transactionSequenceNumber;     /*!< Transaction sequence number in the server database */
+    uint32_t offlineSequenceNumber;         /*!< Sequence number given by the terminal offline queue, 0 if approved online */
+    uint64_t deadline;                      /*!< Time the terminal stops waiting for the answer, see \ref getAdmissionTime, 0 for none */
 } ST_transaction_t;
 
+/*********************************************************************************
+ * @brief   Token standing for a PAN in the transaction history, see \ref vault.h.
+ *          \ref PAN_TOKEN_NONE is the token of no card.
+ ********************************************************************************/
+typedef uint64_t PAN_TOKEN_t;
+
+#define PAN_TOKEN_NONE                  ((PAN_TOKEN_t)0)
+
+/*********************************************************************************
+ * @brief   Struct for a transaction of the history: the card is only known by
+ *          the token of its PAN, its holder name is not kept
+ ********************************************************************************/
+typedef struct ST_transactionRecord_t {
+    PAN_TOKEN_t panToken;                   /*!< Token of the card PAN, PAN_TOKEN_NONE if it is no account */
+    ST_terminalData_t terminalData;         /*!< Terminal data */
+    EN_transState_t transState;             /*!< Transaction error state */
+    uint32_t transactionSequenceNumber;     /*!< Transaction sequence number in the server database */
+    uint32_t offlineSequenceNumber;         /*!< Sequence number given by the terminal offline queue, 0 if approved online */
+} ST_transactionRecord_t;
+
+/*********************************************************************************
+ * @brief   Maximum number of accounts in the accounts database
+ ********************************************************************************/
+#define ACCOUNTS_DB_SIZE                4096
+
+/*********************************************************************************
+ * @brief   Maximum number of terminals whose offline batches are reconciled
+ ********************************************************************************/
+#define OFFLINE_MAX_TERMINALS           65536
+
+/*********************************************************************************
+ * @brief   Struct for the last offline sequence number reconciled of a terminal
+ ********************************************************************************/
+typedef struct ST_offlineMark_t {
+    uint32_t terminalId;                    /*!< Terminal ID */
+    uint32_t sequenceNumber;                /*!< Its last offline sequence number posted */
+} ST_offlineMark_t;
+
 /*********************************************************************************
  * @brief   Struct for the account data
  ********************************************************************************/
 typedef struct {
     float balance;                          /*!< Account balance in float */
     uint8_t primaryAccountNumber[20];       /*!< Account primary number */
+    CURRENCY_t currency;                    /*!< Currency of the balance, CURRENCY_NONE for that of every terminal */
+    int64_t heldCents;                      /*!< Amount held by the holds, in cents of the currency, no longer available */
 }ST_accountsDB_t;
 
 
@@ -69,9 +116,207 @@ typedef struct {
 
 EN_transState_t recieveTransactionData(ST_transaction_t * const transData);
 EN_serverError_t isValidAccount(ST_cardData_t * const cardData);
+
+/*********************************************************************************
+ * @brief       Check if the balance of the current account covers an amount.
+ * 
+ * @details     The amount is converted from the terminal currency to the account
+ *              currency first, the converted amount is the one debited. The
+ *              amounts held on the account are not available.
+ * @param[in]   termData: Pointer to the terminal data
+ * @return      EN_serverError_t: SERVER_OK, LOW_BALANCE or NO_EXCHANGE_RATE
+ ********************************************************************************/
 EN_serverError_t isAmountAvailable(ST_terminalData_t * const termData);
+
+/*********************************************************************************
+ * @brief       Save a transaction in the history and the settlement journal.
+ * 
+ * @details     The history keeps the token of the card PAN instead of the card
+ *              data, see \ref vault.h, or PAN_TOKEN_NONE for a card of no
+ *              account, which is not tokenized.
+ * @param[in,out] transData: Pointer to the transaction, its sequence number
+ *              in the history is set
+ * @return      EN_serverError_t: SERVER_OK or SAVING_FAILED
+ ********************************************************************************/
 EN_serverError_t saveTransaction(ST_transaction_t * const transData);
-EN_serverError_t getTransaction(const uint32_t transactionSequenceNumber, ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Save a transaction declined before the authorization, such as
+ *              one with a high fraud score, like \ref recieveTransactionData
+ *              saves its declines.
+ *
+ * @details     The transaction is journaled against the account of its card if
+ *              there is one, and replicated. Its state becomes
+ *              INTERNAL_SERVER_ERROR if it cannot be saved.
+ * @param[in,out] transData: Pointer to the declined transaction, its sequence
+ *              number in the history is set
+ * @return      EN_serverError_t: SERVER_OK or SAVING_FAILED
+ ********************************************************************************/
+EN_serverError_t saveDeclinedTransaction(ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Get a transaction of the history.
+ * 
+ * @param[in]   transactionSequenceNumber: Sequence number of the transaction
+ * @param[out]  record: The transaction, its card PAN is given back by
+ *              \ref detokenizePan
+ * @return      EN_serverError_t: SERVER_OK, or TRANSACTION_NOT_FOUND if no
+ *              transaction has that number
+ ********************************************************************************/
+EN_serverError_t getTransaction(const uint32_t transactionSequenceNumber, ST_transactionRecord_t * const record);
+
+/*********************************************************************************
+ * @brief       Add an account at the end of the accounts database.
+ * 
+ * @param[in]   account: Pointer to the account, its PAN must be null terminated
+ * @return      EN_serverError_t: SERVER_OK, or SAVING_FAILED if the database
+ *              is full, the PAN is empty or already in it
+ ********************************************************************************/
+EN_serverError_t addAccount(const ST_accountsDB_t * const account);
+
+/*********************************************************************************
+ * @brief       Get the number of accounts in the accounts database.
+ ********************************************************************************/
+uint16_t getAccountsCount(void);
+
+/*********************************************************************************
+ * @brief       Get the PAN of an account of the accounts database.
+ * @param[in]   index: Index of the account
+ * @return      const uint8_t *: The null terminated PAN, NULL if there is no
+ *              account at that index
+ ********************************************************************************/
+const uint8_t *getAccountPan(const uint16_t index);
+
+/*********************************************************************************
+ * @brief       Get a copy of an account of the accounts database.
+ * @param[in]   index: Index of the account
+ * @param[out]  account: Copy of the account
+ * @return      EN_serverError_t: SERVER_OK, or ACCOUNT_NOT_FOUND if there is no
+ *              account at that index or it was removed
+ ********************************************************************************/
+EN_serverError_t getAccount(const uint16_t index, ST_accountsDB_t * const account);
+
+/*********************************************************************************
+ * @brief       Remove an account from the accounts database, e.g. when it moves
+ *              to another shard.
+ * 
+ * @details     Its slot is left empty rather than reused, so the transactions
+ *              already journaled keep the index of their account.
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @param[out]  account: The removed account
+ * @return      EN_serverError_t: SERVER_OK or ACCOUNT_NOT_FOUND
+ ********************************************************************************/
+EN_serverError_t removeAccount(const uint8_t * const pan, ST_accountsDB_t * const account);
+
+/*********************************************************************************
+ * @brief       Authorize a transaction without posting it: its amount, in the
+ *              account currency, is held on the account until captured or
+ *              released, see \ref hold.h.
+ *
+ * @details     The amount held is kept in the account, so the standby and the
+ *              shard the account migrates to keep it unavailable. The hold
+ *              itself, its ID and expiry, stays on this server.
+ * @param[in,out] transData: Pointer to the transaction, its state is set
+ * @param[out]  accountIndex: Index of the account holding the amount
+ * @param[out]  amountCents: Amount held, in cents of the account currency
+ * @return      EN_transState_t: APPROVED if the amount is held, or why not
+ ********************************************************************************/
+EN_transState_t holdTransaction(ST_transaction_t * const transData, int16_t * const accountIndex,
+                                int64_t * const amountCents);
+
+/*********************************************************************************
+ * @brief       Post a held transaction for its final amount, which replaces
+ *              the amount held.
+ *
+ * @details     The final amount may exceed the amount held if the balance covers
+ *              it. When declined the amount stays held.
+ * @param[in,out] transData: Pointer to the transaction with its final amount,
+ *              saved like \ref recieveTransactionData saves it
+ * @param[in]   accountIndex: Index of the account holding the amount
+ * @param[in]   amountCents: Amount held, in cents of the account currency
+ * @return      EN_transState_t: State of the capture, DECLINED_STOLEN_CARD if
+ *              the card is not that of the account, INTERNAL_SERVER_ERROR if
+ *              the account holds less than amountCents
+ ********************************************************************************/
+EN_transState_t captureHeldTransaction(ST_transaction_t * const transData, const int16_t accountIndex,
+                                       const int64_t amountCents);
+
+/*********************************************************************************
+ * @brief       Make an amount held available again, without posting anything.
+ *
+ * @param[in]   accountIndex: Index of the account holding the amount
+ * @param[in]   amountCents: Amount held, in cents of the account currency
+ * @return      EN_serverError_t: SERVER_OK, ACCOUNT_NOT_FOUND, or
+ *              HELD_AMOUNT_ERROR if the account holds less than amountCents,
+ *              which is then left as it is
+ ********************************************************************************/
+EN_serverError_t releaseHeldAmount(const int16_t accountIndex, const int64_t amountCents);
+
+/*********************************************************************************
+ * @brief       Apply a change committed by the primary server, on its standby.
+ *
+ * @details     The changes are applied in the order they were committed, so the
+ *              transactions get the same sequence numbers and journal records as
+ *              on the primary.
+ * @param[in]   transData: The transaction saved, NULL for an account change only
+ * @param[in]   accountIndex: Index of the account changed, -1 for none. The
+ *              index just past the last account adds it.
+ * @param[in]   account: The account after the change
+ * @return      EN_serverError_t: SERVER_OK, or SAVING_FAILED if the index is
+ *              out of the database or the transaction cannot be saved
+ ********************************************************************************/
+EN_serverError_t applyReplicatedChange(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                       const ST_accountsDB_t * const account);
+
+/*********************************************************************************
+ * @brief       Post a batch of transactions approved offline by the terminal.
+ * 
+ * @details     The batch must be in offlineSequenceNumber order, as uploaded 
+ *              from the terminal offline queue. Transactions at or below the 
+ *              last sequence number reconciled of their terminal were already
+ *              posted and are skipped, so re-uploading a batch is harmless. Found accounts 
+ *              are debited even below zero (the goods are already gone), 
+ *              unknown accounts are saved as DECLINED_STOLEN_CARD, and the
+ *              amounts that cannot be converted to the account currency as
+ *              DECLINED_NO_EXCHANGE_RATE.
+ * @param[in]   batch: Array of offline approved transactions
+ * @param[in]   count: Number of transactions in the batch
+ * @param[out]  postedCount: Number of transactions posted by this call
+ * @return      EN_serverError_t: SERVER_OK, or SAVING_FAILED if a transaction 
+ *              could not be saved or OFFLINE_MAX_TERMINALS other terminals were
+ *              reconciled (the rest of the batch is not posted)
+ ********************************************************************************/
+EN_serverError_t reconcileOfflineBatch(const ST_transaction_t * const batch, const uint32_t count, 
+                                       uint32_t * const postedCount);
+
+/*********************************************************************************
+ * @brief       Get the number of terminals with an offline mark.
+ ********************************************************************************/
+uint32_t getOfflineMarksCount(void);
+
+/*********************************************************************************
+ * @brief       Get the offline mark of a terminal, e.g. to copy it to a standby.
+ * @param[in]   index: Index of the mark, below \ref getOfflineMarksCount
+ * @param[out]  mark: Copy of the mark
+ * @return      EN_serverError_t: SERVER_OK or TRANSACTION_NOT_FOUND
+ ********************************************************************************/
+EN_serverError_t getOfflineMark(const uint32_t index, ST_offlineMark_t * const mark);
+
+/*********************************************************************************
+ * @brief       Raise the offline mark of a terminal, e.g. on a standby.
+ * @param[in]   terminalId: ID of the terminal
+ * @param[in]   sequenceNumber: Offline sequence number posted, a lower mark
+ *              is kept
+ * @return      EN_serverError_t: SERVER_OK, or SAVING_FAILED if
+ *              OFFLINE_MAX_TERMINALS other terminals have a mark
+ ********************************************************************************/
+EN_serverError_t setOfflineMark(const uint32_t terminalId, const uint32_t sequenceNumber);
+
+/*********************************************************************************
+ * @brief       Get the highest offline sequence number reconciled from any
+ *              terminal, a new offline queue numbers its transactions past it.
+ ********************************************************************************/
+uint32_t getLastOfflineSequenceNumber(void);
 
 
 #endif      /* SERVER_H */
\ No newline at end of file
@@ -0,0 +1,494 @@
+/********************************************************************************
+ * @file    settlement.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the implementation of the end of day settlement
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "settlement.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+#define CACHE_LINE_SIZE             64
+
+/*!< Slots of a terminal table, twice the terminals so probe chains stay short */
+#define SETTLEMENT_TERMINAL_SLOTS   (2u * SETTLEMENT_MAX_TERMINALS)
+
+/*!< Fewest records worth a thread, smaller journals use fewer threads */
+#define SETTLEMENT_MIN_THREAD_RECORDS   (1u << 16)
+
+/*!< Totals of a terminal in an open addressing table */
+typedef struct ST_terminalSlot_t {
+    uint32_t terminalId;
+    uint32_t isUsed;
+    ST_settlementTotal_t total;
+} ST_terminalSlot_t;
+
+/*!< Range of the journal totaled by one thread, and its private totals */
+typedef struct ST_settlementWorker_t {
+    pthread_t thread;
+    uint64_t firstRecord;                           /*!< First record of the range */
+    uint64_t endRecord;                             /*!< Record after the range */
+    DATE_t businessDay;
+    uint16_t accountCount;
+    uint64_t transactionCount;
+    ST_settlementTotal_t accounts[ACCOUNTS_DB_SIZE];
+    ST_settlementTotal_t unknownAccounts;
+    ST_terminalSlot_t *terminals;                   /*!< SETTLEMENT_TERMINAL_SLOTS slots */
+    uint32_t terminalCount;
+    BOOL_t isTerminalsFull;                         /*!< A terminal did not fit */
+} __attribute__((aligned(CACHE_LINE_SIZE))) ST_settlementWorker_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static ST_settlementRecord_t *journalBlocks[SETTLEMENT_MAX_BLOCKS];
+
+/*!< Records published, the writer stores it after the record so readers see it whole */
+static uint64_t journalCount = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static void *settlementWorker(void *argument);
+static ST_settlementTotal_t *getTerminalTotal(ST_terminalSlot_t * const slots, uint32_t * const count,
+                                              const uint32_t terminalId);
+static void addTotal(ST_settlementTotal_t * const total, const ST_settlementTotal_t * const added);
+static int compareTerminals(const void * const first, const void * const second);
+static void printCents(FILE * const file, const int64_t cents);
+static void printTotal(FILE * const file, const ST_settlementTotal_t * const total);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_settlementError_t journalTransaction(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                        const float amount) {
+    ST_settlementRecord_t *record = NULL;
+    uint64_t count = 0, block = 0;
+    double amountCents = 0;
+
+    if(NULL == transData) {
+        return SETTLEMENT_MEMORY_ERROR;
+    }
+
+    /* Only the server appends, the count is read by the settlements */
+    count = journalCount;
+    block = count / SETTLEMENT_BLOCK_SIZE;
+    if(block >= SETTLEMENT_MAX_BLOCKS) {
+        return SETTLEMENT_JOURNAL_FULL;
+    }
+
+    if(NULL == journalBlocks[block]) {
+        journalBlocks[block] = malloc(SETTLEMENT_BLOCK_SIZE * sizeof(ST_settlementRecord_t));
+        if(NULL == journalBlocks[block]) {
+            return SETTLEMENT_MEMORY_ERROR;
+        }
+    }
+
+    amountCents = (double)amount * 100.0;
+
+    record = &(journalBlocks[block][count % SETTLEMENT_BLOCK_SIZE]);
+    record->transactionDay = transData->terminalData.transactionDay;
+    record->terminalId = transData->terminalData.terminalId;
+    record->amountCents = (int32_t)(amountCents + ((amountCents < 0) ? -0.5 : 0.5));
+    record->accountIndex = (accountIndex < 0) ? SETTLEMENT_NO_ACCOUNT : (uint16_t)accountIndex;
+    record->transState = (uint8_t)transData->transState;
+    record->reserved = 0;
+
+    __atomic_store_n(&journalCount, count + 1, __ATOMIC_RELEASE);
+
+    return SETTLEMENT_OK;
+}
+
+uint64_t getJournalCount(void) {
+    return __atomic_load_n(&journalCount, __ATOMIC_ACQUIRE);
+}
+
+uint64_t readJournal(const uint64_t firstRecord, const uint64_t count, ST_settlementRecord_t * const records) {
+    uint64_t index = firstRecord, endRecord = 0, blockLast = 0;
+
+    if(NULL == records) {
+        return 0;
+    }
+
+    endRecord = getJournalCount();
+    if(firstRecord >= endRecord) {
+        return 0;
+    }
+    if(endRecord - firstRecord > count) {
+        endRecord = firstRecord + count;
+    }
+
+    while(index < endRecord) {
+        blockLast = (index / SETTLEMENT_BLOCK_SIZE + 1) * SETTLEMENT_BLOCK_SIZE;
+        if(blockLast > endRecord) {
+            blockLast = endRecord;
+        }
+        memcpy(&records[index - firstRecord], &(journalBlocks[index / SETTLEMENT_BLOCK_SIZE][index % SETTLEMENT_BLOCK_SIZE]),
+               (blockLast - index) * sizeof(ST_settlementRecord_t));
+        index = blockLast;
+    }
+
+    return endRecord - firstRecord;
+}
+
+void resetJournal(void) {
+    uint32_t block = 0;
+
+    for(block = 0; block < SETTLEMENT_MAX_BLOCKS; ++block) {
+        free(journalBlocks[block]);
+        journalBlocks[block] = NULL;
+    }
+
+    __atomic_store_n(&journalCount, 0, __ATOMIC_RELEASE);
+}
+
+EN_settlementError_t settleDay(const DATE_t businessDay, const uint8_t threadCount, ST_settlement_t * const settlement) {
+    ST_settlementWorker_t *workers[SETTLEMENT_MAX_THREADS] = {NULL};
+    ST_terminalSlot_t *merged = NULL;
+    ST_settlementTotal_t *total = NULL;
+    EN_settlementError_t settlementError = SETTLEMENT_OK;
+    uint64_t recordCount = 0;
+    uint32_t workerCount = 0, started = 0, i = 0, slot = 0, mergedCount = 0;
+    long coreCount = 0;
+
+    if(NULL == settlement) {
+        return SETTLEMENT_MEMORY_ERROR;
+    }
+
+    memset(settlement, 0, sizeof(*settlement));
+    settlement->businessDay = businessDay;
+
+    /* The snapshot: records after it are left to the next settlement */
+    recordCount = getJournalCount();
+    settlement->journalCount = recordCount;
+    settlement->accountCount = getAccountsCount();
+
+    workerCount = threadCount;
+    if(0 == workerCount) {
+        coreCount = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = (coreCount > 0) ? (uint32_t)coreCount : 1;
+    }
+    if(workerCount > SETTLEMENT_MAX_THREADS) {
+        workerCount = SETTLEMENT_MAX_THREADS;
+    }
+    if(workerCount > recordCount / SETTLEMENT_MIN_THREAD_RECORDS) {
+        workerCount = (recordCount < SETTLEMENT_MIN_THREAD_RECORDS) ? 1 : (uint32_t)(recordCount / SETTLEMENT_MIN_THREAD_RECORDS);
+    }
+
+    for(i = 0; i < workerCount; ++i) {
+        workers[i] = aligned_alloc(CACHE_LINE_SIZE, sizeof(ST_settlementWorker_t));
+        if(NULL == workers[i]) {
+            settlementError = SETTLEMENT_MEMORY_ERROR;
+            break;
+        }
+
+        memset(workers[i], 0, sizeof(ST_settlementWorker_t));
+        workers[i]->terminals = calloc(SETTLEMENT_TERMINAL_SLOTS, sizeof(ST_terminalSlot_t));
+        if(NULL == workers[i]->terminals) {
+            settlementError = SETTLEMENT_MEMORY_ERROR;
+            break;
+        }
+
+        workers[i]->firstRecord = recordCount * i / workerCount;
+        workers[i]->endRecord = recordCount * (i + 1) / workerCount;
+        workers[i]->businessDay = businessDay;
+        workers[i]->accountCount = settlement->accountCount;
+    }
+
+    /* The first range is totaled by the calling thread */
+    if(SETTLEMENT_OK == settlementError) {
+        for(started = 1; started < workerCount; ++started) {
+            if(0 != pthread_create(&(workers[started]->thread), NULL, settlementWorker, workers[started])) {
+                settlementError = SETTLEMENT_THREAD_ERROR;
+                break;
+            }
+        }
+
+        settlementWorker(workers[0]);
+
+        for(i = 1; i < started; ++i) {
+            pthread_join(workers[i]->thread, NULL);
+        }
+    }
+
+    if(SETTLEMENT_OK == settlementError) {
+        merged = calloc(SETTLEMENT_TERMINAL_SLOTS, sizeof(ST_terminalSlot_t));
+        if(NULL == merged) {
+            settlementError = SETTLEMENT_MEMORY_ERROR;
+        }
+    }
+
+    /* Merging the private totals */
+    for(i = 0; (SETTLEMENT_OK == settlementError) && (i < workerCount); ++i) {
+        if(workers[i]->isTerminalsFull) {
+            settlementError = SETTLEMENT_TERMINALS_ERROR;
+            break;
+        }
+
+        settlement->transactionCount += workers[i]->transactionCount;
+        addTotal(&(settlement->unknownAccounts), &(workers[i]->unknownAccounts));
+        for(slot = 0; slot < settlement->accountCount; ++slot) {
+            addTotal(&(settlement->accounts[slot]), &(workers[i]->accounts[slot]));
+        }
+
+        for(slot = 0; slot < SETTLEMENT_TERMINAL_SLOTS; ++slot) {
+            if(workers[i]->terminals[slot].isUsed) {
+                total = getTerminalTotal(merged, &mergedCount, workers[i]->terminals[slot].terminalId);
+                if(NULL == total) {
+                    settlementError = SETTLEMENT_TERMINALS_ERROR;
+                    break;
+                }
+                addTotal(total, &(workers[i]->terminals[slot].total));
+            }
+        }
+    }
+
+    if( (SETTLEMENT_OK == settlementError) && (mergedCount > 0) ) {
+        settlement->terminals = malloc(mergedCount * sizeof(ST_terminalSettlement_t));
+        if(NULL == settlement->terminals) {
+            settlementError = SETTLEMENT_MEMORY_ERROR;
+        }
+    }
+
+    if(SETTLEMENT_OK == settlementError) {
+        for(slot = 0; slot < SETTLEMENT_TERMINAL_SLOTS; ++slot) {
+            if(merged[slot].isUsed) {
+                settlement->terminals[settlement->terminalCount].terminalId = merged[slot].terminalId;
+                settlement->terminals[settlement->terminalCount].total = merged[slot].total;
+                ++(settlement->terminalCount);
+            }
+        }
+        qsort(settlement->terminals, settlement->terminalCount, sizeof(ST_terminalSettlement_t), compareTerminals);
+    }
+
+    free(merged);
+    for(i = 0; i < workerCount; ++i) {
+        if(NULL != workers[i]) {
+            free(workers[i]->terminals);
+            free(workers[i]);
+        }
+    }
+
+    if(SETTLEMENT_OK != settlementError) {
+        freeSettlement(settlement);
+    }
+
+    return settlementError;
+}
+
+EN_settlementError_t writeSettlementFile(const char * const fileName, const ST_settlement_t * const settlement) {
+    FILE *file = NULL;
+    const uint8_t *pan = NULL;
+    uint32_t i = 0;
+    int result = 0;
+
+    if( (NULL == fileName) || (NULL == settlement) ) {
+        return SETTLEMENT_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "w");
+    if(NULL == file) {
+        return SETTLEMENT_FILE_ERROR;
+    }
+
+    fprintf(file, "# Settlement of %02u/%02u/%04u, %llu transactions of %llu journaled\n",
+            DATE_DAY(settlement->businessDay), DATE_MONTH(settlement->businessDay), DATE_YEAR(settlement->businessDay),
+            (unsigned long long)settlement->transactionCount, (unsigned long long)settlement->journalCount);
+
+    fprintf(file, "# account pan approved_count approved_amount declined_count\n");
+    for(i = 0; i < settlement->accountCount; ++i) {
+        if( (0 == settlement->accounts[i].approvedCount) && (0 == settlement->accounts[i].declinedCount) ) {
+            continue;
+        }
+
+        pan = getAccountPan((uint16_t)i);
+        fprintf(file, "account %s ", (NULL == pan) ? "?" : (const char *)pan);
+        printTotal(file, &(settlement->accounts[i]));
+    }
+    if( (0 != settlement->unknownAccounts.approvedCount) || (0 != settlement->unknownAccounts.declinedCount) ) {
+        fprintf(file, "account unknown ");
+        printTotal(file, &(settlement->unknownAccounts));
+    }
+
+    fprintf(file, "# terminal id approved_count approved_amount declined_count\n");
+    for(i = 0; i < settlement->terminalCount; ++i) {
+        fprintf(file, "terminal %u ", settlement->terminals[i].terminalId);
+        printTotal(file, &(settlement->terminals[i].total));
+    }
+
+    result = ferror(file);
+    if( (0 != fclose(file)) || (0 != result) ) {
+        return SETTLEMENT_FILE_ERROR;
+    }
+
+    return SETTLEMENT_OK;
+}
+
+void freeSettlement(ST_settlement_t * const settlement) {
+
+    if(NULL == settlement) {
+        return;
+    }
+
+    free(settlement->terminals);
+    settlement->terminals = NULL;
+    settlement->terminalCount = 0;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PRIVATE FUNCTION DEFINITIONS                        */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Total the records of the day in the range of a worker
+ *******************************************************************************/
+static void *settlementWorker(void *argument) {
+    ST_settlementWorker_t * const worker = argument;
+    const ST_settlementRecord_t *record = NULL, *blockEnd = NULL;
+    ST_settlementTotal_t *accountTotal = NULL, *terminalTotal = NULL;
+    uint64_t index = worker->firstRecord, blockLast = 0;
+    uint32_t lastTerminalId = 0;
+    uint64_t isApproved = 0;
+
+    while(index < worker->endRecord) {
+        /* Blocks are contiguous, the inner loop is a plain array scan */
+        blockLast = (index / SETTLEMENT_BLOCK_SIZE + 1) * SETTLEMENT_BLOCK_SIZE;
+        if(blockLast > worker->endRecord) {
+            blockLast = worker->endRecord;
+        }
+        record = &(journalBlocks[index / SETTLEMENT_BLOCK_SIZE][index % SETTLEMENT_BLOCK_SIZE]);
+        blockEnd = record + (blockLast - index);
+        index = blockLast;
+
+        for(; record < blockEnd; ++record) {
+            if(worker->businessDay != record->transactionDay) {
+                continue;
+            }
+
+            ++(worker->transactionCount);
+
+            accountTotal = (record->accountIndex < worker->accountCount) ?
+                           &(worker->accounts[record->accountIndex]) : &(worker->unknownAccounts);
+
+            /* A terminal usually sends many transactions in a row */
+            if( (NULL == terminalTotal) || (record->terminalId != lastTerminalId) ) {
+                terminalTotal = getTerminalTotal(worker->terminals, &(worker->terminalCount), record->terminalId);
+                lastTerminalId = record->terminalId;
+                if(NULL == terminalTotal) {
+                    worker->isTerminalsFull = TRUE;
+                    return NULL;
+                }
+            }
+
+            isApproved = (APPROVED == record->transState);
+            accountTotal->approvedCount += isApproved;
+            accountTotal->approvedCents += isApproved ? record->amountCents : 0;
+            accountTotal->declinedCount += !isApproved;
+            terminalTotal->approvedCount += isApproved;
+            terminalTotal->approvedCents += isApproved ? record->amountCents : 0;
+            terminalTotal->declinedCount += !isApproved;
+        }
+    }
+
+    return NULL;
+}
+
+/********************************************************************************
+ * @brief       Find or add the totals of a terminal in a table
+ * @return      ST_settlementTotal_t *: The totals, NULL if the table is full
+ *******************************************************************************/
+static ST_settlementTotal_t *getTerminalTotal(ST_terminalSlot_t * const slots, uint32_t * const count,
+                                              const uint32_t terminalId) {
+    uint32_t slot = (uint32_t)((terminalId * 0x9E3779B97F4A7C15ull) >> 32) & (SETTLEMENT_TERMINAL_SLOTS - 1);
+
+    while(slots[slot].isUsed) {
+        if(terminalId == slots[slot].terminalId) {
+            return &(slots[slot].total);
+        }
+        slot = (slot + 1) & (SETTLEMENT_TERMINAL_SLOTS - 1);
+    }
+
+    if(*count >= SETTLEMENT_MAX_TERMINALS) {
+        return NULL;
+    }
+
+    ++(*count);
+    slots[slot].isUsed = TRUE;
+    slots[slot].terminalId = terminalId;
+
+    return &(slots[slot].total);
+}
+
+/********************************************************************************
+ * @brief       Add totals to others
+ *******************************************************************************/
+static void addTotal(ST_settlementTotal_t * const total, const ST_settlementTotal_t * const added) {
+    total->approvedCount += added->approvedCount;
+    total->approvedCents += added->approvedCents;
+    total->declinedCount += added->declinedCount;
+}
+
+/********************************************************************************
+ * @brief       Order terminals by ID, for qsort()
+ *******************************************************************************/
+static int compareTerminals(const void * const first, const void * const second) {
+    const ST_terminalSettlement_t *firstTerminal = first, *secondTerminal = second;
+
+    return (firstTerminal->terminalId > secondTerminal->terminalId) - (firstTerminal->terminalId < secondTerminal->terminalId);
+}
+
+/********************************************************************************
+ * @brief       Print an amount in cents with two decimals
+ *******************************************************************************/
+static void printCents(FILE * const file, const int64_t cents) {
+    const uint64_t magnitude = (cents < 0) ? (uint64_t)(-cents) : (uint64_t)cents;
+
+    fprintf(file, "%s%llu.%02u", (cents < 0) ? "-" : "",
+            (unsigned long long)(magnitude / 100), (uint32_t)(magnitude % 100));
+}
+
+/********************************************************************************
+ * @brief       Print the totals of an account or a terminal, ending the line
+ *******************************************************************************/
+static void printTotal(FILE * const file, const ST_settlementTotal_t * const total) {
+    fprintf(file, "%llu ", (unsigned long long)total->approvedCount);
+    printCents(file, total->approvedCents);
+    fprintf(file, " %llu\n", (unsigned long long)total->declinedCount);
+}
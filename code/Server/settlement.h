@@ -0,0 +1,183 @@
+/********************************************************************************
+ * @file    settlement.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the end of day settlement
+ *          \ref settlement.c
+ * @details Every saved transaction is also appended to a settlement journal of
+ *          compact records, which is only ever appended to. A settlement takes
+ *          the number of records journaled so far as its snapshot, so the
+ *          authorizations go on while it runs. The snapshot is split into one
+ *          range per thread, each thread totals its range per account and per
+ *          terminal in private tables, then the tables are merged.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef SETTLEMENT_H
+#define SETTLEMENT_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Records per block of the journal, a power of 2. Blocks are never
+ *          moved, so a settlement reads them while new records are appended.
+ ********************************************************************************/
+#define SETTLEMENT_BLOCK_SIZE       (1u << 20)
+
+/*********************************************************************************
+ * @brief   Maximum number of blocks of the journal, i.e. of records per day
+ *          divided by \ref SETTLEMENT_BLOCK_SIZE
+ ********************************************************************************/
+#define SETTLEMENT_MAX_BLOCKS       1024
+
+/*********************************************************************************
+ * @brief   Maximum number of threads of a settlement
+ ********************************************************************************/
+#define SETTLEMENT_MAX_THREADS      64
+
+/*********************************************************************************
+ * @brief   Maximum number of distinct terminals settled in a day
+ ********************************************************************************/
+#define SETTLEMENT_MAX_TERMINALS    65536
+
+/*********************************************************************************
+ * @brief   Account index of a record whose PAN is not in the accounts database
+ ********************************************************************************/
+#define SETTLEMENT_NO_ACCOUNT       0xFFFF
+
+/*********************************************************************************
+ * @brief   Struct for a transaction in the journal, only what is settled
+ ********************************************************************************/
+typedef struct ST_settlementRecord_t {
+    DATE_t transactionDay;          /*!< Business day of the transaction */
+    uint32_t terminalId;            /*!< Terminal of the transaction */
+    int32_t amountCents;            /*!< Amount in cents, in the currency of the account */
+    uint16_t accountIndex;          /*!< Index in the accounts database, or SETTLEMENT_NO_ACCOUNT */
+    uint8_t transState;             /*!< EN_transState_t */
+    uint8_t reserved;               /*!< Zero */
+} ST_settlementRecord_t;
+
+/*********************************************************************************
+ * @brief   Struct for the totals of an account or a terminal
+ ********************************************************************************/
+typedef struct ST_settlementTotal_t {
+    uint64_t approvedCount;         /*!< Approved transactions */
+    int64_t approvedCents;          /*!< Net amount of the approved transactions, in cents */
+    uint64_t declinedCount;         /*!< Declined transactions */
+} ST_settlementTotal_t;
+
+/*********************************************************************************
+ * @brief   Struct for the totals of a terminal
+ ********************************************************************************/
+typedef struct ST_terminalSettlement_t {
+    uint32_t terminalId;            /*!< Terminal ID */
+    ST_settlementTotal_t total;     /*!< Totals of the terminal */
+} ST_terminalSettlement_t;
+
+/*********************************************************************************
+ * @brief   Struct for the settlement of a business day
+ ********************************************************************************/
+typedef struct ST_settlement_t {
+    DATE_t businessDay;                             /*!< Day settled */
+    uint64_t journalCount;                          /*!< Records of the journal in the snapshot */
+    uint64_t transactionCount;                      /*!< Records of the day */
+    uint16_t accountCount;                          /*!< Accounts in the database at the snapshot */
+    ST_settlementTotal_t accounts[ACCOUNTS_DB_SIZE];/*!< Totals by index in the accounts database */
+    ST_settlementTotal_t unknownAccounts;           /*!< Totals of the cards of no account */
+    uint32_t terminalCount;                         /*!< Terminals with transactions that day */
+    ST_terminalSettlement_t *terminals;             /*!< Totals of each terminal by ascending ID */
+} ST_settlement_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>settlement</b> module
+ ********************************************************************************/
+typedef enum EN_settlementError_t {
+    SETTLEMENT_OK,                  /*!< Done */
+    SETTLEMENT_JOURNAL_FULL,        /*!< The journal cannot hold another record */
+    SETTLEMENT_MEMORY_ERROR,        /*!< Memory allocation failed */
+    SETTLEMENT_THREAD_ERROR,        /*!< A thread cannot be started */
+    SETTLEMENT_TERMINALS_ERROR,     /*!< More than SETTLEMENT_MAX_TERMINALS terminals in the day */
+    SETTLEMENT_FILE_ERROR           /*!< The settlement file cannot be written */
+} EN_settlementError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Append a saved transaction to the journal.
+ *
+ * @details     Called by the server only, one thread at a time.
+ * @param[in]   transData: Pointer to the transaction
+ * @param[in]   accountIndex: Index of its account in the accounts database, -1
+ *              if none
+ * @param[in]   amount: Amount of the transaction in the currency of its account,
+ *              so the totals of an account add up
+ * @return      EN_settlementError_t: SETTLEMENT_OK, SETTLEMENT_JOURNAL_FULL or
+ *              SETTLEMENT_MEMORY_ERROR
+ ********************************************************************************/
+EN_settlementError_t journalTransaction(const ST_transaction_t * const transData, const int16_t accountIndex,
+                                        const float amount);
+
+/*********************************************************************************
+ * @brief       Get the number of records in the journal.
+ ********************************************************************************/
+uint64_t getJournalCount(void);
+
+/*********************************************************************************
+ * @brief       Copy records of the journal, e.g. to materialize them elsewhere.
+ *
+ * @param[in]   firstRecord: Index of the first record to copy
+ * @param[in]   count: Number of records to copy
+ * @param[out]  records: Copied records
+ * @return      uint64_t: Number of records copied, fewer than count if the
+ *              journal ends before
+ ********************************************************************************/
+uint64_t readJournal(const uint64_t firstRecord, const uint64_t count, ST_settlementRecord_t * const records);
+
+/*********************************************************************************
+ * @brief       Empty the journal, e.g. once a day is settled.
+ *
+ * @details     No transaction may be saved or settled meanwhile.
+ ********************************************************************************/
+void resetJournal(void);
+
+/*********************************************************************************
+ * @brief       Total the journaled transactions of a business day, per account
+ *              and per terminal.
+ *
+ * @param[in]   businessDay: Day to settle
+ * @param[in]   threadCount: Threads totaling the journal, 0 for one per core
+ * @param[out]  settlement: Totals, free them with \ref freeSettlement
+ * @return      EN_settlementError_t: SETTLEMENT_OK or the error
+ ********************************************************************************/
+EN_settlementError_t settleDay(const DATE_t businessDay, const uint8_t threadCount, ST_settlement_t * const settlement);
+
+/*********************************************************************************
+ * @brief       Write a settlement as text, one line per account and terminal
+ *              with transactions that day.
+ *
+ * @param[in]   fileName: Path of the settlement file, it is overwritten
+ * @param[in]   settlement: Totals of \ref settleDay
+ * @return      EN_settlementError_t: SETTLEMENT_OK or SETTLEMENT_FILE_ERROR
+ ********************************************************************************/
+EN_settlementError_t writeSettlementFile(const char * const fileName, const ST_settlement_t * const settlement);
+
+/*********************************************************************************
+ * @brief       Free the terminal totals of a settlement.
+ ********************************************************************************/
+void freeSettlement(ST_settlement_t * const settlement);
+
+
+#endif      /* SETTLEMENT_H */
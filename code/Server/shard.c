@@ -0,0 +1,620 @@
+/********************************************************************************
+ * @file    shard.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the account shards implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "shard.h"
+#include "../Log/metrics.h"
+#include "../Log/trace.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Enum for the requests of the router to a shard
+ ********************************************************************************/
+typedef enum EN_shardRequest_t {
+    SHARD_REQUEST_AUTHORIZE,        /*!< Authorize the transaction, the reply holds it updated */
+    SHARD_REQUEST_EXPORT,           /*!< Copy the next accounts moving to the added shard */
+    SHARD_REQUEST_IMPORT,           /*!< Add the accounts, all of them or none, replacing those here */
+    SHARD_REQUEST_REMOVE,           /*!< Remove the accounts, once imported by the added shard */
+    SHARD_REQUEST_STOP              /*!< Stop serving */
+} EN_shardRequest_t;
+
+/********************************************************************************
+ * @brief   Struct for a request and its reply, one packet of a SOCK_SEQPACKET
+ *          socket. Only the accounts in use are sent.
+ ********************************************************************************/
+typedef struct ST_shardMessage_t {
+    uint32_t request;                                   /*!< EN_shardRequest_t */
+    uint32_t accountCount;                              /*!< Accounts in the message */
+    uint64_t fromHash;                                  /*!< Export: lowest PAN hash to move */
+    uint8_t shardCount;                                 /*!< Export: shards of the ring moved to */
+    uint8_t serverError;                                /*!< Reply: EN_serverError_t of an import */
+    ST_transaction_t transaction;                       /*!< Authorize: the transaction */
+    ST_accountsDB_t accounts[SHARD_MIGRATION_BATCH];    /*!< Export, import and remove: the accounts */
+} ST_shardMessage_t;
+
+#define SHARD_MESSAGE_SIZE(accountCount)    (offsetof(ST_shardMessage_t, accounts) + \
+                                             (accountCount) * sizeof(ST_accountsDB_t))
+
+/********************************************************************************
+ * @brief   Struct for a point of the ring while it is sorted
+ ********************************************************************************/
+typedef struct ST_ringPoint_t {
+    uint64_t point;                 /*!< Position on the ring */
+    uint8_t shard;                  /*!< Shard of the point */
+} ST_ringPoint_t;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Sockets of the shards connected to the router, by shard ID, the
+ *          shard being added last
+ ********************************************************************************/
+static int shardSockets[SHARD_MAX_COUNT];
+static uint8_t socketCount = 0;
+
+/********************************************************************************
+ * @brief   Ring the transactions are routed with, no shard when disconnected
+ ********************************************************************************/
+static ST_shardRing_t ring = {0};
+
+/********************************************************************************
+ * @brief   Migration to the added shard: ring with it, shard being drained and
+ *          the PAN hash under which its moving accounts already moved. Shards
+ *          below drainingShard are drained.
+ ********************************************************************************/
+static ST_shardRing_t nextRing = {0};
+static BOOL_t isMigrating = FALSE;
+static uint8_t drainingShard = 0;
+static uint64_t movedBelow = 0;
+
+/********************************************************************************
+ * @brief   Transactions routed, a batch of accounts moves every
+ *          SHARD_MIGRATION_PERIOD of them
+ ********************************************************************************/
+static uint32_t routedCount = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Mix the bits of a 64 bit value (splitmix64 finalizer)
+ ********************************************************************************/
+static uint64_t mixBits(uint64_t value);
+
+/********************************************************************************
+ * @brief       Order ring points by position, for qsort()
+ ********************************************************************************/
+static int compareRingPoints(const void * const first, const void * const second);
+
+/********************************************************************************
+ * @brief       Open a Unix socket connected to a shard.
+ *
+ * @return      int: The socket, -1 on error
+ ********************************************************************************/
+static int connectShard(const char * const socketPath);
+
+/********************************************************************************
+ * @brief       Send a request to a shard and wait for its reply.
+ *
+ * @param[in]   shardSocket: Socket of the shard
+ * @param[in,out] message: The request, then the reply
+ * @return      EN_shardError_t: SHARD_OK or SHARD_SOCKET_ERROR
+ ********************************************************************************/
+static EN_shardError_t askShard(const int shardSocket, ST_shardMessage_t * const message);
+
+/********************************************************************************
+ * @brief       Serve one request of the router, the message becomes the reply.
+ *
+ * @param[in]   shardRing: Ring of the shard, rebuilt for the exports
+ * @param[in,out] message: The request, then the reply
+ ********************************************************************************/
+static void serveRequest(ST_shardRing_t * const shardRing, ST_shardMessage_t * const message);
+
+/********************************************************************************
+ * @brief       Copy the accounts of the lowest PAN hashes from message->fromHash
+ *              that move to the last shard of the ring of message->shardCount.
+ ********************************************************************************/
+static void exportAccounts(ST_shardRing_t * const shardRing, ST_shardMessage_t * const message);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+uint64_t hashPan(const uint8_t * const pan) {
+    const uint8_t *digit = pan;
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    /* FNV-1a over the digits, mixed so close PANs land far apart */
+    for(digit = pan; (NULL != digit) && ('\0' != *digit); ++digit) {
+        hash = (hash ^ *digit) * 0x100000001B3ull;
+    }
+
+    return mixBits(hash);
+}
+
+EN_shardError_t buildShardRing(ST_shardRing_t * const ring, const uint8_t shardCount) {
+    static ST_ringPoint_t ringPoints[SHARD_MAX_COUNT * SHARD_RING_POINTS];
+    uint32_t i = 0, pointCount = 0;
+
+    if( (NULL == ring) || (0 == shardCount) || (shardCount > SHARD_MAX_COUNT) ) {
+        return SHARD_COUNT_ERROR;
+    }
+
+    /* The points of a shard do not depend on the number of shards, so one more
+       shard only takes over the ring segments ending at its own points */
+    pointCount = (uint32_t)shardCount * SHARD_RING_POINTS;
+    for(i = 0; i < pointCount; ++i) {
+        ringPoints[i].shard = (uint8_t)(i / SHARD_RING_POINTS);
+        ringPoints[i].point = mixBits(((uint64_t)ringPoints[i].shard << 32) | (i % SHARD_RING_POINTS));
+    }
+    qsort(ringPoints, pointCount, sizeof(ringPoints[0]), compareRingPoints);
+
+    ring->shardCount = shardCount;
+    for(i = 0; i < pointCount; ++i) {
+        ring->points[i] = ringPoints[i].point;
+        ring->shards[i] = ringPoints[i].shard;
+    }
+
+    return SHARD_OK;
+}
+
+uint8_t getHashShard(const ST_shardRing_t * const ring, const uint64_t hash) {
+    uint32_t low = 0, high = (uint32_t)ring->shardCount * SHARD_RING_POINTS, middle = 0;
+
+    /* First point at or after the hash, the ring wraps to the first point */
+    while(low < high) {
+        middle = (low + high) / 2;
+        if(ring->points[middle] < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return (low == (uint32_t)ring->shardCount * SHARD_RING_POINTS) ? ring->shards[0] : ring->shards[low];
+}
+
+EN_shardError_t runShard(const char * const socketPath, const uint8_t shardId, const uint8_t shardCount) {
+    static ST_shardRing_t shardRing;
+    static ST_shardMessage_t message;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    ST_accountsDB_t account;
+    int listener = -1, connection = -1;
+    ssize_t received = 0;
+    uint16_t i = 0;
+    BOOL_t isStopping = FALSE;
+
+    /* shardId equal to shardCount is the shard to add, it owns nothing on the ring yet */
+    if( (SHARD_OK != buildShardRing(&shardRing, shardCount)) || (shardId > shardCount) ) {
+        return SHARD_COUNT_ERROR;
+    }
+
+    if( (NULL == socketPath) || (strlen(socketPath) >= sizeof(address.sun_path)) ) {
+        return SHARD_SOCKET_ERROR;
+    }
+
+    /* Keeping the accounts of this shard only */
+    for(i = 0; i < getAccountsCount(); ++i) {
+        if( (SERVER_OK == getAccount(i, &account)) &&
+            (shardId != getHashShard(&shardRing, hashPan(account.primaryAccountNumber))) ) {
+            removeAccount(account.primaryAccountNumber, &account);
+        }
+    }
+
+    strcpy(address.sun_path, socketPath);
+    unlink(socketPath);
+    listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if( (-1 == listener) || (0 != bind(listener, (struct sockaddr *)&address, sizeof(address))) ||
+        (0 != listen(listener, 1)) ) {
+        if(-1 != listener) {
+            close(listener);
+        }
+        return SHARD_SOCKET_ERROR;
+    }
+
+    while( !isStopping ) {
+        connection = accept(listener, NULL, NULL);
+        if(-1 == connection) {
+            continue;
+        }
+
+        /* One router at a time, until it disconnects */
+        while( !isStopping ) {
+            received = recv(connection, &message, sizeof(message), 0);
+            if( (received < (ssize_t)SHARD_MESSAGE_SIZE(0)) ||
+                (received < (ssize_t)SHARD_MESSAGE_SIZE(message.accountCount)) ) {
+                break;
+            }
+
+            isStopping = (SHARD_REQUEST_STOP == message.request);
+            serveRequest(&shardRing, &message);
+            if(send(connection, &message, SHARD_MESSAGE_SIZE(message.accountCount), MSG_NOSIGNAL) < 0) {
+                break;
+            }
+        }
+
+        close(connection);
+    }
+
+    close(listener);
+    unlink(socketPath);
+
+    return SHARD_OK;
+}
+
+EN_shardError_t connectShards(const char * const * const socketPaths, const uint8_t shardCount) {
+    EN_shardError_t shardError = SHARD_OK;
+
+    disconnectShards(FALSE);
+
+    if( (NULL == socketPaths) || (SHARD_OK != buildShardRing(&nextRing, shardCount)) ) {
+        return SHARD_COUNT_ERROR;
+    }
+
+    for(socketCount = 0; socketCount < shardCount; ++socketCount) {
+        shardSockets[socketCount] = connectShard(socketPaths[socketCount]);
+        if(-1 == shardSockets[socketCount]) {
+            shardError = SHARD_SOCKET_ERROR;
+            break;
+        }
+    }
+
+    if(SHARD_OK != shardError) {
+        disconnectShards(FALSE);
+        return shardError;
+    }
+
+    ring = nextRing;
+
+    return SHARD_OK;
+}
+
+EN_shardError_t connectShardsFile(const char * const fileName) {
+    FILE *file = NULL;
+    char paths[SHARD_MAX_COUNT][128], path[128], line[128];
+    const char *socketPaths[SHARD_MAX_COUNT];
+    uint8_t count = 0;
+
+    if(NULL == fileName) {
+        return SHARD_FILE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return SHARD_FILE_ERROR;
+    }
+
+    while(NULL != fgets(line, sizeof(line), file)) {
+        if(1 > sscanf(line, "%127s", path)) {
+            continue;           /* Empty line */
+        }
+
+        if(count == SHARD_MAX_COUNT) {
+            fclose(file);
+            return SHARD_COUNT_ERROR;
+        }
+
+        strcpy(paths[count], path);
+        socketPaths[count] = paths[count];
+        ++count;
+    }
+
+    fclose(file);
+
+    return connectShards(socketPaths, count);
+}
+
+void disconnectShards(const BOOL_t isStopping) {
+    ST_shardMessage_t message = {.request = SHARD_REQUEST_STOP};
+    uint8_t i = 0;
+
+    for(i = 0; i < socketCount; ++i) {
+        if(isStopping) {
+            askShard(shardSockets[i], &message);
+        }
+        close(shardSockets[i]);
+    }
+
+    socketCount = 0;
+    ring.shardCount = 0;
+    isMigrating = FALSE;
+}
+
+EN_transState_t routeTransaction(ST_transaction_t * const transData) {
+    static ST_shardMessage_t message;
+    uint64_t hash = 0;
+    uint8_t shard = 0, nextShard = 0;
+
+    if( (NULL == transData) || (0 == ring.shardCount) ) {
+        return recieveTransactionData(transData);
+    }
+
+    hash = hashPan(transData->cardHolderData.primaryAccountNumber);
+    shard = getHashShard(&ring, hash);
+
+    /* An account moving to the added shard is there once its batch moved */
+    if(isMigrating) {
+        nextShard = getHashShard(&nextRing, hash);
+        if( (nextShard != shard) &&
+            ( (shard < drainingShard) || ( (shard == drainingShard) && (hash < movedBelow) ) ) ) {
+            shard = nextShard;
+        }
+    }
+
+    message.request = SHARD_REQUEST_AUTHORIZE;
+    message.accountCount = 0;
+    message.transaction = *transData;
+
+    if(SHARD_OK == askShard(shardSockets[shard], &message)) {
+        *transData = message.transaction;
+    } else {
+        transData->transState = INTERNAL_SERVER_ERROR;
+    }
+
+    countMetric(METRIC_TRANS_STATE, transData->transState);
+    traceEvent(TRACE_AUTHORIZATION, transData->transState);
+
+    /* The accounts move along with the traffic */
+    if( isMigrating && (0 == (++routedCount % SHARD_MIGRATION_PERIOD)) ) {
+        migrateAccounts(1);
+    }
+
+    return transData->transState;
+}
+
+EN_shardError_t addShard(const char * const socketPath) {
+
+    if( (0 == ring.shardCount) || isMigrating || (socketCount == SHARD_MAX_COUNT) ) {
+        return SHARD_COUNT_ERROR;
+    }
+
+    shardSockets[socketCount] = connectShard(socketPath);
+    if(-1 == shardSockets[socketCount]) {
+        return SHARD_SOCKET_ERROR;
+    }
+
+    ++socketCount;
+    buildShardRing(&nextRing, socketCount);
+    drainingShard = 0;
+    movedBelow = 0;
+    isMigrating = TRUE;
+
+    return SHARD_MIGRATING;
+}
+
+EN_shardError_t migrateAccounts(const uint32_t maxBatches) {
+    static ST_shardMessage_t message;
+    uint64_t lastHash = 0;
+    uint32_t batch = 0, count = 0;
+
+    for(batch = 0; isMigrating && (batch < maxBatches); ++batch) {
+        message.request = SHARD_REQUEST_EXPORT;
+        message.accountCount = 0;
+        message.fromHash = movedBelow;
+        message.shardCount = nextRing.shardCount;
+        if( (SHARD_OK != askShard(shardSockets[drainingShard], &message)) ||
+            (message.accountCount > SHARD_MIGRATION_BATCH) ) {
+            return SHARD_SOCKET_ERROR;
+        }
+
+        /* Added first then removed, the transactions are routed meanwhile */
+        count = message.accountCount;
+        if(count > 0) {
+            message.request = SHARD_REQUEST_IMPORT;
+            if(SHARD_OK != askShard(shardSockets[nextRing.shardCount - 1], &message)) {
+                return SHARD_SOCKET_ERROR;
+            }
+            if(SERVER_OK != message.serverError) {
+                return SHARD_ACCOUNTS_ERROR;
+            }
+
+            message.request = SHARD_REQUEST_REMOVE;
+            if(SHARD_OK != askShard(shardSockets[drainingShard], &message)) {
+                return SHARD_SOCKET_ERROR;
+            }
+
+            lastHash = hashPan(message.accounts[count - 1].primaryAccountNumber);
+        }
+
+        if( (count < SHARD_MIGRATION_BATCH) || (UINT64_MAX == lastHash) ) {
+            ++drainingShard;
+            movedBelow = 0;
+        } else {
+            movedBelow = lastHash + 1;
+        }
+
+        /* Every shard drained, the added one joins the ring */
+        if(drainingShard == ring.shardCount) {
+            ring = nextRing;
+            isMigrating = FALSE;
+        }
+    }
+
+    return isMigrating ? SHARD_MIGRATING : SHARD_OK;
+}
+
+uint8_t getShardCount(void) {
+    return ring.shardCount;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint64_t mixBits(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+
+    return value ^ (value >> 31);
+}
+
+static int compareRingPoints(const void * const first, const void * const second) {
+    const ST_ringPoint_t *firstPoint = first, *secondPoint = second;
+
+    /* Equal points are ordered by shard, so every process sorts them alike */
+    if(firstPoint->point != secondPoint->point) {
+        return (firstPoint->point > secondPoint->point) ? 1 : -1;
+    }
+
+    return (int)firstPoint->shard - (int)secondPoint->shard;
+}
+
+static int connectShard(const char * const socketPath) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    int shardSocket = -1;
+
+    if( (NULL == socketPath) || (strlen(socketPath) >= sizeof(address.sun_path)) ) {
+        return -1;
+    }
+
+    strcpy(address.sun_path, socketPath);
+    shardSocket = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if( (-1 != shardSocket) && (0 != connect(shardSocket, (struct sockaddr *)&address, sizeof(address))) ) {
+        close(shardSocket);
+        shardSocket = -1;
+    }
+
+    return shardSocket;
+}
+
+static EN_shardError_t askShard(const int shardSocket, ST_shardMessage_t * const message) {
+    ssize_t received = 0;
+
+    if(send(shardSocket, message, SHARD_MESSAGE_SIZE(message->accountCount), MSG_NOSIGNAL) < 0) {
+        return SHARD_SOCKET_ERROR;
+    }
+
+    received = recv(shardSocket, message, sizeof(*message), 0);
+    if( (received < (ssize_t)SHARD_MESSAGE_SIZE(0)) || (message->accountCount > SHARD_MIGRATION_BATCH) ||
+        (received < (ssize_t)SHARD_MESSAGE_SIZE(message->accountCount)) ) {
+        return SHARD_SOCKET_ERROR;
+    }
+
+    return SHARD_OK;
+}
+
+static void serveRequest(ST_shardRing_t * const shardRing, ST_shardMessage_t * const message) {
+    ST_accountsDB_t account;
+    uint32_t i = 0, addedCount = 0;
+
+    switch(message->request) {
+        case SHARD_REQUEST_AUTHORIZE:
+            message->accountCount = 0;
+            recieveTransactionData(&(message->transaction));
+            break;
+
+        case SHARD_REQUEST_EXPORT:
+            exportAccounts(shardRing, message);
+            break;
+
+        case SHARD_REQUEST_IMPORT:
+            /* All of the accounts or none, the router keeps them on their shard otherwise */
+            message->serverError = SAVING_FAILED;
+            if(getAccountsCount() + message->accountCount <= ACCOUNTS_DB_SIZE) {
+                /* An account already here was imported before and not removed from its shard,
+                   which kept authorizing it: its exported copy replaces it, so a retry goes through */
+                for(i = 0; i < message->accountCount; ++i) {
+                    removeAccount(message->accounts[i].primaryAccountNumber, &account);
+                }
+                for(addedCount = 0; addedCount < message->accountCount; ++addedCount) {
+                    if(SERVER_OK != addAccount(&(message->accounts[addedCount]))) {
+                        break;
+                    }
+                }
+                for(i = 0; (addedCount < message->accountCount) && (i < addedCount); ++i) {
+                    removeAccount(message->accounts[i].primaryAccountNumber, &account);
+                }
+                message->serverError = (addedCount == message->accountCount) ? SERVER_OK : SAVING_FAILED;
+            }
+            break;
+
+        case SHARD_REQUEST_REMOVE:
+            for(i = 0; i < message->accountCount; ++i) {
+                removeAccount(message->accounts[i].primaryAccountNumber, &account);
+            }
+            break;
+
+        default:
+            message->accountCount = 0;
+            break;
+    }
+}
+
+static void exportAccounts(ST_shardRing_t * const shardRing, ST_shardMessage_t * const message) {
+    uint64_t hashes[SHARD_MIGRATION_BATCH], hash = 0;
+    ST_accountsDB_t account;
+    uint32_t count = 0, position = 0;
+    uint16_t i = 0;
+
+    if( (shardRing->shardCount != message->shardCount) &&
+        (SHARD_OK != buildShardRing(shardRing, message->shardCount)) ) {
+        message->accountCount = 0;
+        return;
+    }
+
+    /* Keeping the lowest hashes in order, by insertion */
+    for(i = 0; i < getAccountsCount(); ++i) {
+        if(SERVER_OK != getAccount(i, &account)) {
+            continue;
+        }
+
+        hash = hashPan(account.primaryAccountNumber);
+        if( (hash < message->fromHash) || (getHashShard(shardRing, hash) != message->shardCount - 1) ||
+            ( (SHARD_MIGRATION_BATCH == count) && (hash >= hashes[count - 1]) ) ) {
+            continue;
+        }
+
+        position = (SHARD_MIGRATION_BATCH == count) ? count - 1 : count++;
+        for(; (position > 0) && (hashes[position - 1] > hash); --position) {
+            hashes[position] = hashes[position - 1];
+            message->accounts[position] = message->accounts[position - 1];
+        }
+        hashes[position] = hash;
+        message->accounts[position] = account;
+    }
+
+    message->accountCount = count;
+}
@@ -0,0 +1,191 @@
+/********************************************************************************
+ * @file    shard.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the account shards
+ *          \ref shard.c
+ * @details The accounts can be split across several server processes, the
+ *          shards, each serving the accounts of its part of a consistent hash
+ *          ring of the PANs on a local Unix socket. The router forwards every
+ *          transaction to the shard owning its PAN. A shard is added while the
+ *          transactions flow: the ring of one more shard only moves the
+ *          accounts the new shard takes, and the router moves them a small
+ *          batch at a time, draining the shards one after the other in the
+ *          order of the PAN hashes, so it always knows where each account is.
+ *          The router is used from one thread, like the server module.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef SHARD_H
+#define SHARD_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of shards
+ ********************************************************************************/
+#define SHARD_MAX_COUNT             16
+
+/*********************************************************************************
+ * @brief   Points of each shard on the hash ring, more points even out the
+ *          share of the accounts of each shard
+ ********************************************************************************/
+#define SHARD_RING_POINTS           128
+
+/*********************************************************************************
+ * @brief   Accounts moved at once when a shard is added
+ ********************************************************************************/
+#define SHARD_MIGRATION_BATCH       16
+
+/*********************************************************************************
+ * @brief   Transactions routed between two batches of accounts moved, so the
+ *          migration adds three round trips to one transaction in so many
+ ********************************************************************************/
+#define SHARD_MIGRATION_PERIOD      64
+
+/*********************************************************************************
+ * @brief   Struct for a consistent hash ring of shards 0 to shardCount - 1
+ ********************************************************************************/
+typedef struct ST_shardRing_t {
+    uint8_t shardCount;                                         /*!< Shards on the ring */
+    uint64_t points[SHARD_MAX_COUNT * SHARD_RING_POINTS];       /*!< Sorted points */
+    uint8_t shards[SHARD_MAX_COUNT * SHARD_RING_POINTS];        /*!< Shard of each point */
+} ST_shardRing_t;
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>shard</b> module
+ ********************************************************************************/
+typedef enum EN_shardError_t {
+    SHARD_OK,                       /*!< Done */
+    SHARD_MIGRATING,                /*!< Accounts are left to move to the added shard */
+    SHARD_COUNT_ERROR,              /*!< No shard, or more than SHARD_MAX_COUNT */
+    SHARD_SOCKET_ERROR,             /*!< A shard socket cannot be opened, or a message sent or received */
+    SHARD_ACCOUNTS_ERROR,           /*!< A shard refused the accounts moved to it */
+    SHARD_FILE_ERROR                /*!< The shards file cannot be read */
+} EN_shardError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Hash a PAN to its position on the ring.
+ *
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @return      uint64_t: The hash
+ ********************************************************************************/
+uint64_t hashPan(const uint8_t * const pan);
+
+/*********************************************************************************
+ * @brief       Build the ring of a number of shards. Every process builds the
+ *              same ring for the same number.
+ *
+ * @param[out]  ring: The ring
+ * @param[in]   shardCount: Number of shards, up to SHARD_MAX_COUNT
+ * @return      EN_shardError_t: SHARD_OK or SHARD_COUNT_ERROR
+ ********************************************************************************/
+EN_shardError_t buildShardRing(ST_shardRing_t * const ring, const uint8_t shardCount);
+
+/*********************************************************************************
+ * @brief       Get the shard owning a PAN hash, the one of the first point at or
+ *              after it on the ring.
+ ********************************************************************************/
+uint8_t getHashShard(const ST_shardRing_t * const ring, const uint64_t hash);
+
+/*********************************************************************************
+ * @brief       Serve the accounts database of this process as a shard, until a
+ *              router stops it.
+ *
+ * @details     The accounts the shard does not own on the ring of shardCount
+ *              shards are removed first, a shard started with shardId equal to
+ *              shardCount starts empty and waits for the router to add it. One
+ *              router is served at a time.
+ * @param[in]   socketPath: Path of the Unix socket, replaced if it exists
+ * @param[in]   shardId: ID of this shard
+ * @param[in]   shardCount: Number of shards of the ring at start
+ * @return      EN_shardError_t: SHARD_OK once stopped, SHARD_COUNT_ERROR or
+ *              SHARD_SOCKET_ERROR
+ ********************************************************************************/
+EN_shardError_t runShard(const char * const socketPath, const uint8_t shardId, const uint8_t shardCount);
+
+/*********************************************************************************
+ * @brief       Connect the router to running shards.
+ *
+ * @param[in]   socketPaths: Socket of each shard, by shard ID
+ * @param[in]   shardCount: Number of shards
+ * @return      EN_shardError_t: SHARD_OK, SHARD_COUNT_ERROR or
+ *              SHARD_SOCKET_ERROR (the router is left disconnected)
+ ********************************************************************************/
+EN_shardError_t connectShards(const char * const * const socketPaths, const uint8_t shardCount);
+
+/*********************************************************************************
+ * @brief       Connect the router to the shards listed in a file, one socket
+ *              path per line by shard ID, see \ref connectShards.
+ ********************************************************************************/
+EN_shardError_t connectShardsFile(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Disconnect the router, the transactions are authorized by this
+ *              process again.
+ *
+ * @param[in]   isStopping: TRUE to stop the shards too
+ ********************************************************************************/
+void disconnectShards(const BOOL_t isStopping);
+
+/*********************************************************************************
+ * @brief       Authorize a transaction on the shard owning its PAN.
+ *
+ * @details     Without shards the transaction goes to \ref recieveTransactionData
+ *              of this process. While a shard is being added, a batch of
+ *              accounts is moved after every SHARD_MIGRATION_PERIOD
+ *              transactions.
+ * @param[in]   transData: Pointer to the transaction, updated by the shard
+ * @return      EN_transState_t: State of the transaction, INTERNAL_SERVER_ERROR
+ *              if the shard cannot be reached
+ ********************************************************************************/
+EN_transState_t routeTransaction(ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Add a running shard, started empty, and start moving its
+ *              accounts to it.
+ *
+ * @param[in]   socketPath: Socket of the shard, its ID is the current number of
+ *              shards
+ * @return      EN_shardError_t: SHARD_MIGRATING, SHARD_COUNT_ERROR (also while
+ *              the previous shard is still being added) or SHARD_SOCKET_ERROR
+ ********************************************************************************/
+EN_shardError_t addShard(const char * const socketPath);
+
+/*********************************************************************************
+ * @brief       Move accounts to the shard being added.
+ *
+ * @param[in]   maxBatches: Batches of SHARD_MIGRATION_BATCH accounts to move at
+ *              most
+ * @details     A batch is imported by the added shard then removed from its
+ *              shard. After an error the next call moves the same batch again,
+ *              the copies already imported are replaced.
+ * @return      EN_shardError_t: SHARD_OK once every account moved (the new
+ *              shard is then on the ring), SHARD_MIGRATING, or the error that
+ *              stopped the migration
+ ********************************************************************************/
+EN_shardError_t migrateAccounts(const uint32_t maxBatches);
+
+/*********************************************************************************
+ * @brief       Get the number of shards on the ring the router uses, 0 when it
+ *              is not connected.
+ ********************************************************************************/
+uint8_t getShardCount(void);
+
+
+#endif      /* SHARD_H */
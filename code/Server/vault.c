@@ -0,0 +1,333 @@
+/********************************************************************************
+ * @file    vault.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the PAN token vault implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Terminal/terminal.h"
+#include "server.h"
+#include "vault.h"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE TYPES                                  */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   Odd multipliers scrambling the card indexes into tokens, their
+ *          inverses modulo 2^64 unscramble them
+ ********************************************************************************/
+#define VAULT_MULTIPLIER_FIRST      0xBF58476D1CE4E5B9ull
+#define VAULT_MULTIPLIER_SECOND     0x94D049BB133111EBull
+
+/********************************************************************************
+ * @brief   Source of the keys, the clock is used without it
+ ********************************************************************************/
+#define VAULT_RANDOM_FILE           "/dev/urandom"
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                              PRIVATE VARIABLES                              */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief   The PANs of the cards by index, NULL when the vault is not started.
+ *          A PAN is packed in bijective base 10, its digits counting 1 to 10,
+ *          so leading zeros are kept and 19 digits fit in a word.
+ ********************************************************************************/
+static uint64_t *panCodes = NULL;
+static uint32_t cardsCount = 0;
+static uint32_t cardsCapacity = 0;
+
+/********************************************************************************
+ * @brief   Hash table of the PANs, each slot holds the index of its card + 1,
+ *          0 when free. It has a third more slots than cards.
+ ********************************************************************************/
+static uint32_t *slots = NULL;
+static uint32_t slotsBits = 0;
+
+/********************************************************************************
+ * @brief   Keys of the tokens, and the inverses of the multipliers
+ ********************************************************************************/
+static uint64_t firstKey = 0, secondKey = 0;
+static uint64_t firstInverse = 0, secondInverse = 0;
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                      PRIVATE FUNCTION DECLARATIONS                          */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Pack a PAN in a word.
+ *
+ * @return      uint64_t: The packed PAN, 0 if the PAN is invalid
+ ********************************************************************************/
+static uint64_t packPan(const uint8_t * const pan);
+
+/********************************************************************************
+ * @brief       Find the slot of a packed PAN, or the free slot it would take.
+ ********************************************************************************/
+static uint32_t findSlot(const uint64_t code);
+
+/********************************************************************************
+ * @brief       Size the cards and the hash table for a capacity, the cards are
+ *              kept and hashed again.
+ *
+ * @return      EN_vaultError_t: VAULT_OK or VAULT_NO_MEMORY, the vault is
+ *              unchanged on error
+ ********************************************************************************/
+static EN_vaultError_t resizeVault(const uint32_t capacity);
+
+/********************************************************************************
+ * @brief       Scramble a card index into its token, and back.
+ ********************************************************************************/
+static PAN_TOKEN_t scrambleIndex(const uint64_t index);
+static uint64_t unscrambleToken(const PAN_TOKEN_t token);
+
+/********************************************************************************
+ * @brief       Inverse of an odd number modulo 2^64, by Newton's iteration
+ ********************************************************************************/
+static uint64_t invertMultiplier(const uint64_t multiplier);
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                         PUBLIC FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+EN_vaultError_t startVault(const uint32_t capacity) {
+    FILE *file = NULL;
+    uint64_t keys[2] = {0};
+    EN_vaultError_t vaultError = VAULT_OK;
+
+    if(capacity > VAULT_MAX_CARDS) {
+        return VAULT_FULL;
+    }
+
+    stopVault();
+
+    vaultError = resizeVault((0 == capacity) ? 1 : capacity);
+    if(VAULT_OK != vaultError) {
+        return vaultError;
+    }
+
+    file = fopen(VAULT_RANDOM_FILE, "rb");
+    if( (NULL == file) || (1 != fread(keys, sizeof(keys), 1, file)) ) {
+        keys[0] = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ull;
+        keys[1] = (uint64_t)clock() * VAULT_MULTIPLIER_FIRST ^ (uint64_t)(uintptr_t)&cardsCount;
+    }
+    if(NULL != file) {
+        fclose(file);
+    }
+
+    firstInverse = invertMultiplier(VAULT_MULTIPLIER_FIRST);
+    secondInverse = invertMultiplier(VAULT_MULTIPLIER_SECOND);
+    firstKey = keys[0];
+    secondKey = keys[1];
+
+    /* The token of no card must stay PAN_TOKEN_NONE */
+    while(unscrambleToken(PAN_TOKEN_NONE) < VAULT_MAX_CARDS) {
+        secondKey = secondKey * 6364136223846793005ull + 1442695040888963407ull;
+    }
+
+    return VAULT_OK;
+}
+
+void stopVault(void) {
+    free(panCodes);
+    free(slots);
+    panCodes = NULL;
+    slots = NULL;
+    cardsCount = 0;
+    cardsCapacity = 0;
+    slotsBits = 0;
+}
+
+EN_vaultError_t tokenizePan(const uint8_t * const pan, PAN_TOKEN_t * const token) {
+    EN_vaultError_t vaultError = VAULT_OK;
+    uint64_t code = 0;
+    uint32_t slot = 0;
+
+    if( (NULL == pan) || (NULL == token) ) {
+        return VAULT_INVALID_PAN;
+    }
+
+    code = packPan(pan);
+    if(0 == code) {
+        return VAULT_INVALID_PAN;
+    }
+
+    if( (NULL == slots) && (VAULT_OK != (vaultError = startVault(VAULT_INITIAL_CAPACITY))) ) {
+        return vaultError;
+    }
+
+    slot = findSlot(code);
+    if(0 == slots[slot]) {
+        if(cardsCount == cardsCapacity) {
+            if(VAULT_MAX_CARDS == cardsCapacity) {
+                return VAULT_FULL;
+            }
+
+            vaultError = resizeVault( (cardsCapacity > VAULT_MAX_CARDS / 2) ? VAULT_MAX_CARDS : 2 * cardsCapacity );
+            if(VAULT_OK != vaultError) {
+                return vaultError;
+            }
+            slot = findSlot(code);
+        }
+
+        panCodes[cardsCount] = code;
+        slots[slot] = ++cardsCount;
+    }
+
+    *token = scrambleIndex(slots[slot] - 1);
+
+    return VAULT_OK;
+}
+
+EN_vaultError_t detokenizePan(const PAN_TOKEN_t token, uint8_t * const pan) {
+    uint8_t digits[VAULT_MAX_PAN_LENGTH];
+    uint64_t index = 0, code = 0;
+    uint8_t length = 0;
+
+    if( (NULL == slots) || (NULL == pan) ) {
+        return VAULT_TOKEN_NOT_FOUND;
+    }
+
+    index = unscrambleToken(token);
+    if(index >= cardsCount) {
+        return VAULT_TOKEN_NOT_FOUND;
+    }
+
+    /* The digits come out from the last one */
+    for(code = panCodes[index]; 0 != code; code = (code - 1) / 10) {
+        digits[VAULT_MAX_PAN_LENGTH - ++length] = (uint8_t)('0' + (code - 1) % 10);
+    }
+    memcpy(pan, &digits[VAULT_MAX_PAN_LENGTH - length], length);
+    pan[length] = '\0';
+
+    return VAULT_OK;
+}
+
+uint32_t getVaultCount(void) {
+    return cardsCount;
+}
+
+
+/*-----------------------------------------------------------------------------*/
+/*                                                                             */
+/*                        PRIVATE FUNCTION DEFINITIONS                         */
+/*                                                                             */
+/*-----------------------------------------------------------------------------*/
+
+static uint64_t packPan(const uint8_t * const pan) {
+    uint64_t code = 0;
+    uint8_t length = 0;
+
+    for(length = 0; '\0' != pan[length]; ++length) {
+        if( (length == VAULT_MAX_PAN_LENGTH) || (pan[length] < '0') || (pan[length] > '9') ) {
+            return 0;
+        }
+        code = code * 10 + (uint64_t)(pan[length] - '0') + 1;
+    }
+
+    return code;
+}
+
+static uint32_t findSlot(const uint64_t code) {
+    const uint32_t mask = (uint32_t)((1ull << slotsBits) - 1);
+    uint32_t slot = (uint32_t)((code * 0x9E3779B97F4A7C15ull) >> (64 - slotsBits));
+
+    while( (0 != slots[slot]) && (code != panCodes[slots[slot] - 1]) ) {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static EN_vaultError_t resizeVault(const uint32_t capacity) {
+    uint64_t *newCodes = NULL;
+    uint32_t *newSlots = NULL;
+    uint32_t newBits = 1, i = 0;
+
+    while((1ull << newBits) < (uint64_t)capacity + capacity / 3) {
+        ++newBits;
+    }
+
+    newSlots = calloc((size_t)1 << newBits, sizeof(*newSlots));
+    if(NULL == newSlots) {
+        return VAULT_NO_MEMORY;
+    }
+
+    newCodes = realloc(panCodes, (size_t)capacity * sizeof(*newCodes));
+    if(NULL == newCodes) {
+        free(newSlots);
+        return VAULT_NO_MEMORY;
+    }
+
+    free(slots);
+    panCodes = newCodes;
+    slots = newSlots;
+    slotsBits = newBits;
+    for(i = 0; i < cardsCount; ++i) {
+        slots[findSlot(panCodes[i])] = i + 1;
+    }
+
+    cardsCapacity = capacity;
+
+    return VAULT_OK;
+}
+
+static PAN_TOKEN_t scrambleIndex(const uint64_t index) {
+    uint64_t token = index ^ firstKey;
+
+    token *= VAULT_MULTIPLIER_FIRST;
+    token ^= token >> 32;
+    token *= VAULT_MULTIPLIER_SECOND;
+    token ^= token >> 32;
+
+    return token ^ secondKey;
+}
+
+static uint64_t unscrambleToken(const PAN_TOKEN_t token) {
+    uint64_t index = token ^ secondKey;
+
+    /* A shift by half the word or more is its own inverse */
+    index ^= index >> 32;
+    index *= secondInverse;
+    index ^= index >> 32;
+    index *= firstInverse;
+
+    return index ^ firstKey;
+}
+
+static uint64_t invertMultiplier(const uint64_t multiplier) {
+    uint64_t inverse = multiplier;
+    uint8_t i = 0;
+
+    /* Each step doubles the correct low bits, from 3 */
+    for(i = 0; i < 5; ++i) {
+        inverse *= 2 - multiplier * inverse;
+    }
+
+    return inverse;
+}
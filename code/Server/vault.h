@@ -0,0 +1,111 @@
+/********************************************************************************
+ * @file    vault.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the PAN token vault
+ *          \ref vault.c
+ * @details The transaction history of the server keeps a token in place of
+ *          the card number and holder name, the PAN is only found again
+ *          through \ref detokenizePan. Each PAN gets one token, the same every
+ *          time it is tokenized. PANs are packed in a word each, indexed by a
+ *          hash table, so tokenizing is one lookup. A token is the index of
+ *          its PAN scrambled with a key drawn when the vault starts, so
+ *          detokenizing needs no lookup and tokens tell nothing about the PAN
+ *          or the order cards were seen in. The scrambling is not a
+ *          cipher: the vault and its key are what must be protected.
+ *          The tokens belong to the process that issued them, a standby or
+ *          another shard issues its own. The module is used from one thread,
+ *          like the server module.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef VAULT_H
+#define VAULT_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Cards the vault holds when it is started by the first tokenization,
+ *          it doubles whenever it is full
+ ********************************************************************************/
+#define VAULT_INITIAL_CAPACITY      4096
+
+/*********************************************************************************
+ * @brief   Maximum number of cards in the vault
+ ********************************************************************************/
+#define VAULT_MAX_CARDS             (1u << 31)
+
+/*********************************************************************************
+ * @brief   Longest PAN tokenized, in digits
+ ********************************************************************************/
+#define VAULT_MAX_PAN_LENGTH        19
+
+/*********************************************************************************
+ * @brief   Enum for the different errors of the <b>vault</b> module
+ ********************************************************************************/
+typedef enum EN_vaultError_t {
+    VAULT_OK,                       /*!< Done */
+    VAULT_INVALID_PAN,              /*!< PAN empty, longer than VAULT_MAX_PAN_LENGTH or not only digits */
+    VAULT_TOKEN_NOT_FOUND,          /*!< No card has this token */
+    VAULT_FULL,                     /*!< VAULT_MAX_CARDS cards are already in the vault */
+    VAULT_NO_MEMORY                 /*!< No memory for the vault */
+} EN_vaultError_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Start an empty vault sized for a number of cards, with a new key.
+ *
+ * @details     The tokens issued before are no longer found. The first
+ *              tokenization starts the vault if it is not started.
+ * @param[in]   capacity: Cards expected, the vault grows beyond
+ * @return      EN_vaultError_t: VAULT_OK, VAULT_FULL if above VAULT_MAX_CARDS,
+ *              or VAULT_NO_MEMORY
+ ********************************************************************************/
+EN_vaultError_t startVault(const uint32_t capacity);
+
+/*********************************************************************************
+ * @brief       Free the vault, every token issued is lost.
+ ********************************************************************************/
+void stopVault(void);
+
+/*********************************************************************************
+ * @brief       Get the token of a PAN, adding the card to the vault if needed.
+ *
+ * @param[in]   pan: Null terminated PAN
+ * @param[out]  token: The token, never PAN_TOKEN_NONE
+ * @return      EN_vaultError_t: VAULT_OK, VAULT_INVALID_PAN, VAULT_FULL or
+ *              VAULT_NO_MEMORY
+ ********************************************************************************/
+EN_vaultError_t tokenizePan(const uint8_t * const pan, PAN_TOKEN_t * const token);
+
+/*********************************************************************************
+ * @brief       Get the PAN of a token, the only way back to the card number.
+ *
+ * @param[in]   token: Token issued by \ref tokenizePan
+ * @param[out]  pan: The null terminated PAN, at least VAULT_MAX_PAN_LENGTH + 1
+ *              bytes
+ * @return      EN_vaultError_t: VAULT_OK or VAULT_TOKEN_NOT_FOUND
+ ********************************************************************************/
+EN_vaultError_t detokenizePan(const PAN_TOKEN_t token, uint8_t * const pan);
+
+/*********************************************************************************
+ * @brief       Get the number of cards in the vault.
+ ********************************************************************************/
+uint32_t getVaultCount(void);
+
+
+#endif      /* VAULT_H */
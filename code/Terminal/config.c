@@ -0,0 +1,176 @@
+/********************************************************************************
+ * @file    config.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the terminal configuration registry
+ *          implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "../Server/reload.h"
+#include "terminal.h"
+#include "config.h"
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                            PRIVATE TYPES                             */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Struct for a registry, allocated in one block with its entries
+ ********************************************************************************/
+typedef struct ST_configTable_t {
+    uint32_t count;                     /*!< Number of terminals */
+    ST_terminalConfig_t configs[];      /*!< Configurations sorted by terminal ID */
+} ST_configTable_t;
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                          PRIVATE VARIABLES                           */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   The registry read by the authorization path, none when not loaded
+ ********************************************************************************/
+static ST_reloadTable_t configTable = RELOAD_TABLE_INITIALIZER;
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PRIVATE FUNCTIONS PROTOTYPES                     */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+static int compareTerminalIds(const void * const first, const void * const second);
+
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PUBLIC FUNCTIONS DEFINITIONS                     */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+EN_terminalError_t loadTerminalConfig(const char * const fileName) {
+    FILE *file = NULL;
+    ST_configTable_t *table = NULL;
+    ST_terminalConfig_t *config = NULL;
+    char line[96], currency[4];
+    unsigned long terminalId = 0, burst = 0;
+    uint32_t i = 0;
+    int fieldCount = 0;
+    BOOL_t isValid = TRUE;
+
+    if(NULL == fileName) {
+        return CONFIG_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return CONFIG_ERROR;
+    }
+
+    table = malloc(sizeof(*table) + TERMINAL_CONFIG_MAX_COUNT * sizeof(table->configs[0]));
+    if(NULL == table) {
+        fclose(file);
+        return CONFIG_ERROR;
+    }
+    table->count = 0;
+
+    while( isValid && (NULL != fgets(line, sizeof(line), file)) ) {
+        if(1 > sscanf(line, "%3s", currency)) {
+            continue;           /* Empty line */
+        }
+
+        config = &(table->configs[table->count]);
+        config->ratePerSecond = 0;
+        burst = 1;
+        fieldCount = (table->count < TERMINAL_CONFIG_MAX_COUNT) ?
+                     sscanf(line, "%lu %f %f %3s %f %lu", &terminalId, &(config->maxTransAmount),
+                            &(config->floorLimit), currency, &(config->ratePerSecond), &burst) : 0;
+
+        /* The rate limit is optional, but comes with its burst */
+        isValid = ( (4 == fieldCount) || (6 == fieldCount) )                                       &&
+                  (config->ratePerSecond >= 0) && (burst >= 1) && (burst <= UINT32_MAX)            &&
+                  (terminalId <= UINT32_MAX) && (config->maxTransAmount > 0)                       &&
+                  (config->floorLimit >= 0) && (config->floorLimit <= config->maxTransAmount)      &&
+                  (TERMINAL_OK == parseCurrency((uint8_t *)currency, &(config->currency)));
+
+        if(isValid) {
+            config->terminalId = (uint32_t)terminalId;
+            config->burst = (uint32_t)burst;
+            ++(table->count);
+        }
+    }
+
+    fclose(file);
+
+    /* Sorting by terminal ID, a terminal configured twice is an error */
+    qsort(table->configs, table->count, sizeof(table->configs[0]), compareTerminalIds);
+    for(i = 1; isValid && (i < table->count); ++i) {
+        isValid = (table->configs[i].terminalId != table->configs[i - 1].terminalId);
+    }
+
+    if( !isValid ) {
+        free(table);
+        return CONFIG_ERROR;
+    }
+
+    /* Publishing the new registry, the old one is freed once the readers in flight are done */
+    swapReloadTable(&configTable, table);
+
+    return TERMINAL_OK;
+}
+
+void unloadTerminalConfig(void) {
+    swapReloadTable(&configTable, NULL);
+}
+
+EN_terminalError_t getTerminalConfig(const uint32_t terminalId, ST_terminalConfig_t * const config) {
+    const ST_configTable_t *table = NULL;
+    const ST_terminalConfig_t *found = NULL;
+    ST_terminalConfig_t key;
+    uint32_t epoch = 0;
+
+    if(NULL == config) {
+        return CONFIG_ERROR;
+    }
+
+    key.terminalId = terminalId;
+
+    table = enterReloadTable(&configTable, &epoch);
+    if(NULL != table) {
+        found = bsearch(&key, table->configs, table->count, sizeof(table->configs[0]), compareTerminalIds);
+        if(NULL != found) {
+            *config = *found;
+        }
+    }
+    leaveReloadTable(&configTable, epoch);
+
+    return (NULL == found) ? CONFIG_ERROR : TERMINAL_OK;
+}
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PRIVATE FUNCTIONS DEFINITIONS                    */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Order terminal configurations by ID, for qsort() and bsearch()
+ *******************************************************************************/
+static int compareTerminalIds(const void * const first, const void * const second) {
+    const ST_terminalConfig_t *firstConfig = first, *secondConfig = second;
+
+    return (firstConfig->terminalId > secondConfig->terminalId) -
+           (firstConfig->terminalId < secondConfig->terminalId);
+}
@@ -0,0 +1,81 @@
+/********************************************************************************
+ * @file    config.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the terminal configuration
+ *          registry \ref config.c
+ * @details The registry holds the limits of every terminal, keyed by terminal
+ *          ID. It is loaded once from a file and can be reloaded at any time,
+ *          the authorization path reads it without locks.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of terminals in the registry
+ ********************************************************************************/
+#define TERMINAL_CONFIG_MAX_COUNT       65536
+
+/*********************************************************************************
+ * @brief   Struct for the configuration of one terminal
+ ********************************************************************************/
+typedef struct ST_terminalConfig_t {
+    uint32_t terminalId;                /*!< Terminal ID */
+    float maxTransAmount;               /*!< Maximum transaction amount */
+    float floorLimit;                   /*!< Maximum amount approved offline, 0 to disable */
+    CURRENCY_t currency;                /*!< Currency of the terminal amounts, e.g. "EGP" */
+    float ratePerSecond;                /*!< Authorizations per second let through, 0 for the default of \ref admission.h */
+    uint32_t burst;                     /*!< Authorizations let through at once after an idle time */
+} ST_terminalConfig_t;
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Load the registry from a text file and make it the active one.
+ *
+ * @details     Each line holds "terminalId maxAmount floorLimit currency",
+ *              optionally followed by "ratePerSecond burst", the limit of the
+ *              authorizations of the terminal. The new registry is built aside
+ *              and swapped in, so readers are never blocked. The replaced
+ *              registry is freed once the readers in flight are done, see
+ *              \ref reload.h.
+ * @param[in]   fileName: Path of the configuration file
+ * @return      EN_terminalError_t: TERMINAL_OK, or CONFIG_ERROR if the file
+ *              cannot be read or is invalid (the active registry is unchanged)
+ ********************************************************************************/
+EN_terminalError_t loadTerminalConfig(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Free the registry, every terminal is then unconfigured.
+ ********************************************************************************/
+void unloadTerminalConfig(void);
+
+/*********************************************************************************
+ * @brief       Get the configuration of a terminal.
+ *
+ * @param[in]   terminalId: Terminal ID
+ * @param[out]  config: Copy of the terminal configuration
+ * @return      EN_terminalError_t: TERMINAL_OK, or CONFIG_ERROR if the terminal
+ *              is not configured
+ ********************************************************************************/
+EN_terminalError_t getTerminalConfig(const uint32_t terminalId, ST_terminalConfig_t * const config);
+
+
+#endif      /* CONFIG_H */
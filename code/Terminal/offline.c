@@ -0,0 +1,317 @@
+/********************************************************************************
+ * @file    offline.c
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the terminal offline mode implementation.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../macros.h"
+#include "../Card/card.h"
+#include "terminal.h"
+#include "config.h"
+#include "../Server/server.h"
+#include "offline.h"
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                          PRIVATE VARIABLES                           */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum amount approved offline by terminals without configuration,
+ *          0 when offline mode is disabled
+ ********************************************************************************/
+static float offlineFloorLimit = 0.0f;
+
+/*********************************************************************************
+ * @brief   Sorted PANs of the cards that must never be approved offline
+ ********************************************************************************/
+static uint8_t hotCards[HOT_CARD_LIST_SIZE][20];
+
+/*********************************************************************************
+ * @brief   Number of PANs in the hot card list
+ ********************************************************************************/
+static uint32_t hotCardsCount = 0;
+
+/*********************************************************************************
+ * @brief   Whether a hot card list was loaded, no card is approved offline 
+ *          until then
+ ********************************************************************************/
+static BOOL_t isHotCardListLoaded = FALSE;
+
+/*********************************************************************************
+ * @brief   The queue file, laid out as the next offline sequence number
+ *          (uint32_t) followed by the queued ST_transaction_t records
+ ********************************************************************************/
+static FILE *queueFile = NULL;
+
+/*********************************************************************************
+ * @brief   Path of the queue file, kept to empty it after an upload
+ ********************************************************************************/
+static char queueFileName[FILENAME_MAX] = {0};
+
+/*********************************************************************************
+ * @brief   Number of transactions in the queue file
+ ********************************************************************************/
+static uint32_t queueCount = 0;
+
+/*********************************************************************************
+ * @brief   Sequence number given to the next offline approval
+ ********************************************************************************/
+static uint32_t nextOfflineSequenceNumber = 1;
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PRIVATE FUNCTIONS PROTOTYPES                     */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+static int comparePan(const void * const first, const void * const second);
+static long getRecordOffset(const uint32_t index);
+static BOOL_t writeQueueHeader(void);
+
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PUBLIC FUNCTIONS DEFINITIONS                     */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+void setFloorLimit(const float floorLimit) {
+    offlineFloorLimit = (floorLimit > 0) ? floorLimit : 0.0f;
+}
+
+EN_terminalError_t loadHotCardList(const char * const fileName) {
+    FILE *file = NULL;
+    char line[32];
+    uint8_t length = 0;
+
+    hotCardsCount = 0;
+    isHotCardListLoaded = FALSE;
+
+    if(NULL == fileName) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    file = fopen(fileName, "r");
+    if(NULL == file) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    while( (hotCardsCount < HOT_CARD_LIST_SIZE) && (NULL != fgets(line, sizeof(line), file)) ) {
+        length = strcspn(line, "\r\n");
+        if( (0 == length) || (length >= sizeof(hotCards[0])) ) {
+            continue;
+        }
+
+        memcpy(hotCards[hotCardsCount], line, length);
+        hotCards[hotCardsCount][length] = '\0';
+        ++hotCardsCount;
+    }
+
+    fclose(file);
+
+    qsort(hotCards, hotCardsCount, sizeof(hotCards[0]), comparePan);
+    isHotCardListLoaded = TRUE;
+
+    return TERMINAL_OK;
+}
+
+EN_terminalError_t openOfflineQueue(const char * const fileName) {
+    ST_transaction_t lastRecord;
+    long size = 0;
+
+    if( (NULL == fileName) || (strlen(fileName) >= sizeof(queueFileName)) ) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    closeOfflineQueue();
+    strcpy(queueFileName, fileName);
+
+    queueFile = fopen(queueFileName, "rb+");
+    if(NULL == queueFile) {
+        /* First run, creating an empty queue numbered past what the server posted */
+        nextOfflineSequenceNumber = getLastOfflineSequenceNumber() + 1;
+        queueFile = fopen(queueFileName, "wb+");
+        if( (NULL == queueFile) || !writeQueueHeader() ) {
+            closeOfflineQueue();
+            return OFFLINE_QUEUE_ERROR;
+        }
+        return TERMINAL_OK;
+    }
+
+    if( (1 != fread(&nextOfflineSequenceNumber, sizeof(nextOfflineSequenceNumber), 1, queueFile)) ||
+        (0 != fseek(queueFile, 0, SEEK_END)) ) {
+        closeOfflineQueue();
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    /* A record cut by a crash is ignored, and overwritten by the next one */
+    size = ftell(queueFile);
+    queueCount = (uint32_t)((size - getRecordOffset(0)) / (long)sizeof(ST_transaction_t));
+
+    /* A damaged header is caught up with the last record */
+    if(queueCount) {
+        fseek(queueFile, getRecordOffset(queueCount - 1), SEEK_SET);
+        if( (1 == fread(&lastRecord, sizeof(lastRecord), 1, queueFile)) &&
+            (lastRecord.offlineSequenceNumber >= nextOfflineSequenceNumber) ) {
+            nextOfflineSequenceNumber = lastRecord.offlineSequenceNumber + 1;
+        }
+    }
+
+    return TERMINAL_OK;
+}
+
+void closeOfflineQueue(void) {
+    if(NULL != queueFile) {
+        fclose(queueFile);
+        queueFile = NULL;
+    }
+
+    queueCount = 0;
+}
+
+EN_terminalError_t isOfflineApprovable(const ST_transaction_t * const transData) {
+    ST_terminalConfig_t config;
+    float floorLimit = 0.0f;
+
+    if(NULL == transData) {
+        return EXCEED_FLOOR_LIMIT;
+    }
+
+    if(TERMINAL_OK == getTerminalConfig(transData->terminalData.terminalId, &config)) {
+        floorLimit = config.floorLimit;
+    } else {
+        floorLimit = offlineFloorLimit;
+    }
+
+    if(transData->terminalData.transAmount > floorLimit) {
+        return EXCEED_FLOOR_LIMIT;
+    }
+
+    if( !isHotCardListLoaded ) {
+        return HOT_CARD;
+    }
+
+    if(NULL != bsearch(transData->cardHolderData.primaryAccountNumber, hotCards, hotCardsCount,
+                       sizeof(hotCards[0]), comparePan)) {
+        return HOT_CARD;
+    }
+
+    return TERMINAL_OK;
+}
+
+EN_terminalError_t approveOffline(ST_transaction_t * const transData) {
+    EN_terminalError_t termError = TERMINAL_OK;
+    ST_transaction_t record;
+
+    termError = isOfflineApprovable(transData);
+    if(TERMINAL_OK != termError) {
+        return termError;
+    }
+
+    if( (NULL == queueFile) || (queueCount >= OFFLINE_QUEUE_SIZE) ) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    record = *transData;
+    record.transState = APPROVED;
+    record.offlineSequenceNumber = nextOfflineSequenceNumber;
+
+    /* Moving the header past the number first, a failed write only leaves a gap */
+    ++nextOfflineSequenceNumber;
+    if( !writeQueueHeader() ) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    if( (0 != fseek(queueFile, getRecordOffset(queueCount), SEEK_SET))    ||
+        (1 != fwrite(&record, sizeof(record), 1, queueFile))               ||
+        (0 != fflush(queueFile)) ) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    ++queueCount;
+
+    transData->transState = record.transState;
+    transData->offlineSequenceNumber = record.offlineSequenceNumber;
+
+    return TERMINAL_OK;
+}
+
+uint32_t getOfflineQueueCount(void) {
+    return queueCount;
+}
+
+EN_terminalError_t uploadOfflineQueue(void) {
+    ST_transaction_t batch[OFFLINE_BATCH_SIZE];
+    uint32_t i = 0, batchCount = 0, postedCount = 0;
+
+    if(NULL == queueFile) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    for(i = 0; i < queueCount; i += batchCount) {
+        batchCount = ( (queueCount - i) < OFFLINE_BATCH_SIZE ) ? (queueCount - i) : OFFLINE_BATCH_SIZE;
+
+        if( (0 != fseek(queueFile, getRecordOffset(i), SEEK_SET))                     ||
+            (batchCount != fread(batch, sizeof(batch[0]), batchCount, queueFile))     ||
+            (SERVER_OK != reconcileOfflineBatch(batch, batchCount, &postedCount)) ) {
+            return OFFLINE_QUEUE_ERROR;
+        }
+    }
+
+    /* Every record is posted, emptying the queue */
+    fclose(queueFile);
+    queueCount = 0;
+    queueFile = fopen(queueFileName, "wb+");
+    if( (NULL == queueFile) || !writeQueueHeader() ) {
+        return OFFLINE_QUEUE_ERROR;
+    }
+
+    return TERMINAL_OK;
+}
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                     PRIVATE FUNCTIONS DEFINITIONS                    */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/********************************************************************************
+ * @brief       Compare two null terminated PANs, for qsort() and bsearch()
+ *******************************************************************************/
+static int comparePan(const void * const first, const void * const second) {
+    return strcmp((const char *)first, (const char *)second);
+}
+
+/********************************************************************************
+ * @brief       Get the position of a queued record in the queue file
+ *******************************************************************************/
+static long getRecordOffset(const uint32_t index) {
+    return (long)sizeof(nextOfflineSequenceNumber) + (long)index * (long)sizeof(ST_transaction_t);
+}
+
+/********************************************************************************
+ * @brief       Write the next offline sequence number at the start of the
+ *              queue file and flush it
+ *
+ * @return      BOOL_t: TRUE on success, FALSE otherwise
+ *******************************************************************************/
+static BOOL_t writeQueueHeader(void) {
+    BOOL_t isWritten = FALSE;
+
+    isWritten = (0 == fseek(queueFile, 0, SEEK_SET))                                                      &&
+                (1 == fwrite(&nextOfflineSequenceNumber, sizeof(nextOfflineSequenceNumber), 1, queueFile)) &&
+                (0 == fflush(queueFile));
+
+    return isWritten;
+}
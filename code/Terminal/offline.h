@@ -0,0 +1,122 @@
+/********************************************************************************
+ * @file    offline.h
+ * @author  Mahmoud Karam Emara (ma.karam272@gmail.com)
+ * @brief   This file contains the interfaces for the terminal offline mode
+ *          \ref offline.c
+ * @details Transactions at or below the floor limit, with a card that is not
+ *          in the hot card list, are approved by the terminal without calling
+ *          the server. They are appended to a local queue file that is
+ *          uploaded later to the server in batches.
+ * @version 1.0.0
+ * @date    2026-10-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ ********************************************************************************/
+
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                              TYPE DEFINITIONS                                */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Maximum number of PANs in the hot card list
+ ********************************************************************************/
+#define HOT_CARD_LIST_SIZE          1024
+
+/*********************************************************************************
+ * @brief   Maximum number of transactions waiting in the offline queue
+ ********************************************************************************/
+#define OFFLINE_QUEUE_SIZE          255
+
+/*********************************************************************************
+ * @brief   Number of transactions sent to the server per reconciliation call
+ ********************************************************************************/
+#define OFFLINE_BATCH_SIZE          16
+
+
+/*------------------------------------------------------------------------------*/
+/*                                                                              */
+/*                           PUBLIC FUNCTION DECLARATIONS                       */
+/*                                                                              */
+/*------------------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief       Set the maximum amount approved offline by terminals that have
+ *              no configuration (see \ref getTerminalConfig).
+ *
+ * @param[in]   floorLimit: Floor limit, 0 disables offline approvals
+ ********************************************************************************/
+void setFloorLimit(const float floorLimit);
+
+/*********************************************************************************
+ * @brief       Load the hot card list, one PAN per line, replacing the cached one.
+ *
+ * @param[in]   fileName: Path of the hot card list file
+ * @return      EN_terminalError_t: TERMINAL_OK, or OFFLINE_QUEUE_ERROR if the
+ *              file cannot be read. Offline approvals are refused until a list
+ *              is loaded.
+ ********************************************************************************/
+EN_terminalError_t loadHotCardList(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Open the offline queue file, keeping the transactions already
+ *              queued by a previous run.
+ *
+ * @param[in]   fileName: Path of the offline queue file
+ * @return      EN_terminalError_t: TERMINAL_OK or OFFLINE_QUEUE_ERROR
+ ********************************************************************************/
+EN_terminalError_t openOfflineQueue(const char * const fileName);
+
+/*********************************************************************************
+ * @brief       Close the offline queue file.
+ ********************************************************************************/
+void closeOfflineQueue(void);
+
+/*********************************************************************************
+ * @brief       Check if a transaction may be approved offline.
+ *
+ * @param[in]   transData: Pointer to the transaction data
+ * @return      EN_terminalError_t:
+ *              * TERMINAL_OK: The transaction may be approved offline
+ *              * EXCEED_FLOOR_LIMIT: The amount is above the floor limit
+ *              * HOT_CARD: The card is in the hot card list, or no list 
+ *                is loaded
+ ********************************************************************************/
+EN_terminalError_t isOfflineApprovable(const ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Approve a transaction offline and append it to the queue file.
+ *
+ * @details     The record is flushed to the file before returning, so an
+ *              approval given to the customer survives a terminal restart.
+ * @param[in,out] transData: Pointer to the transaction data, its state and
+ *              offline sequence number are set on success
+ * @return      EN_terminalError_t: TERMINAL_OK, the error of
+ *              \ref isOfflineApprovable, or OFFLINE_QUEUE_ERROR
+ ********************************************************************************/
+EN_terminalError_t approveOffline(ST_transaction_t * const transData);
+
+/*********************************************************************************
+ * @brief       Get the number of transactions waiting in the offline queue.
+ ********************************************************************************/
+uint32_t getOfflineQueueCount(void);
+
+/*********************************************************************************
+ * @brief       Upload the offline queue to the server in batches of
+ *              \ref OFFLINE_BATCH_SIZE and empty it.
+ *
+ * @details     The queue is only emptied once every batch is accepted. If the
+ *              upload stops half way, the next upload sends the whole queue
+ *              again and the server skips what it already posted.
+ * @return      EN_terminalError_t: TERMINAL_OK or OFFLINE_QUEUE_ERROR
+ ********************************************************************************/
+EN_terminalError_t uploadOfflineQueue(void);
+
+
+#endif      /* OFFLINE_H */
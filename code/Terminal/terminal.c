@@ -17,6 +17,54 @@
 #include "../macros.h"
 #include "../Card/card.h"
 #include "terminal.h"
+#include "config.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*----------------------------------------------------------------------*/
+/*                                                                      */
+/*                          PRIVATE VARIABLES                           */
+/*                                                                      */
+/*----------------------------------------------------------------------*/
+
+/*********************************************************************************
+ * @brief   Luhn contribution of a digit, indexed by [isDoubled][digit].
+ *          Row 1 holds the digit sum of (2 * digit), so the kernel never
+ *          branches on the "> 9" case.
+ ********************************************************************************/
+static const uint8_t luhnTable[2][10] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9},
+    {0, 2, 4, 6, 8, 1, 3, 5, 7, 9}
+};
+
+/*********************************************************************************
+ * @brief   Minimum and maximum number of digits of a valid PAN
+ ********************************************************************************/
+#define PAN_MIN_LENGTH      16
+#define PAN_MAX_LENGTH      19
+
+/*********************************************************************************
+ * @brief   Size of the buffer used to read a line typed by the user
+ ********************************************************************************/
+#define TERMINAL_INPUT_LINE_SIZE    64
+
+/*********************************************************************************
+ * @brief   Stream the user input is read from, NULL for stdin
+ ********************************************************************************/
+static FILE *inputStream = NULL;
+
+/*********************************************************************************
+ * @brief   Range of years accepted in the transaction date
+ ********************************************************************************/
+#define DATE_MIN_YEAR       2000
+#define DATE_MAX_YEAR       2099
+
+/*********************************************************************************
+ * @brief   Number of days in each month of a non leap year (index 1 = January)
+ ********************************************************************************/
+static const uint8_t daysInMonth[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
 /*----------------------------------------------------------------------*/
 /*                                                                      */
@@ -24,11 +72,12 @@
 /*                                                                      */
 /*----------------------------------------------------------------------*/
 static BOOL_t isLeapYear(const uint16_t year);
-static BOOL_t isValidCurrentDate(const ST_terminalData_t * const termData);
-static BOOL_t isValidDateFormat(const ST_terminalData_t * const termData);
-static int8_t getCurrentYear(const ST_terminalData_t * const termData);
-static int8_t getCurrentMonth(const ST_terminalData_t * const termData);
-static int8_t getCurrentDay(const ST_terminalData_t * const termData);
+static BOOL_t readInputLine(uint8_t * const line, const uint8_t size);
+static uint8_t getPanLength(const uint8_t * const pan);
+static BOOL_t isLuhnValid(const uint8_t * const pan);
+#if defined(__SSE2__)
+static BOOL_t isLuhnValidSimd(const uint8_t * const pan);
+#endif
 
 
 /*----------------------------------------------------------------------*/
@@ -37,9 +86,12 @@ static int8_t getCurrentDay(const ST_terminalData_t * const termData);
 /*                                                                      */
 /*----------------------------------------------------------------------*/
 
+void setTerminalInputStream(FILE * const stream) {
+    inputStream = stream;
+}
+
 EN_terminalError_t getTransactionDate(ST_terminalData_t * const termData) {
-    BOOL_t  isValidLength = TRUE;
-    uint8_t length = 0;
+    uint8_t line[TERMINAL_INPUT_LINE_SIZE];
 
     if(NULL == termData) {
         return WRONG_DATE;
@@ -47,84 +99,157 @@ EN_terminalError_t getTransactionDate(ST_terminalData_t * const termData) {
 
     /* Getting current date  */
     printf("\nEnter Current Date (10 characters): ");
-    fgets((char *)termData->transactionDate, sizeof(termData->transactionDate), stdin);    
-    length = strlen((char *)termData->transactionDate);
-    isValidLength = ( (sizeof(termData->transactionDate) - 1) == length);
-
-    /* Validating the length of data    */
-    if(length && ('\n' == termData->transactionDate[length - 1]) ) {
-        isValidLength = FALSE;
-    } else {
-        if(isValidLength && ('\n' == getchar()) ) {
-            isValidLength = TRUE;
-        } else {
-            isValidLength = FALSE;
+    if( !readInputLine(line, sizeof(line)) ) {
+        termData->transactionDate[0] = '\0';
+        termData->transactionDay = DATE_INVALID;
+        return WRONG_DATE;
+    }
 
-            /* Flush stdin */
-            while('\n' != getchar());
+    return parseTransactionDate(termData, line);
+}
 
-            /* Setting the first character to '\0' */
-            termData->transactionDate[0] = '\0';
-        }
-    }
+EN_terminalError_t parseTransactionDate(ST_terminalData_t * const termData, const uint8_t * const input) {
 
-    if( !isValidLength ) {
+    if( (NULL == termData) || (NULL == input) ) {
         return WRONG_DATE;
     }
-    
-    /* Validating the date  */
-    if( !isValidCurrentDate(termData) ) {
+
+    /* Validating the length of data    */
+    if( (sizeof(termData->transactionDate) - 1) != strlen((const char *)input) ) {
+        /* Setting the first character to '\0' */
+        termData->transactionDate[0] = '\0';
+        termData->transactionDay = DATE_INVALID;
         return WRONG_DATE;
     }
 
-    return TERMINAL_OK;
+    memcpy(termData->transactionDate, input, sizeof(termData->transactionDate));
+    
+    /* Validating and parsing the date once for all later checks */
+    return parseDate(termData->transactionDate, &(termData->transactionDay));
 }
 
-EN_terminalError_t isCardExpired(ST_cardData_t cardData, ST_terminalData_t termData) {
-    int8_t cardYear = 0, cardMonth = 0, currentYear = 0, currentMonth = 0;
+EN_terminalError_t isCardExpired(const ST_cardData_t * const cardData, const ST_terminalData_t * const termData) {
+    DATE_t currentDate = DATE_INVALID;
+    int16_t expiryMonths = 0;
 
-    if( !isValidCurrentDate(&termData)) {
+    if( (NULL == cardData) || (NULL == termData) ) {
         return EXPIRED_CARD;
     }
-    
-    /* Getting Current Months, Year   */
-    currentMonth = getCurrentMonth(&termData);
-    currentYear = getCurrentYear(&termData);
 
-    /* Getting Card Months, Year   */
-    cardMonth = getCardExpiryMonth(&cardData);
-    cardYear = getCardExpiryYear(&cardData);
+    /* Dates not entered through getTransactionDate() are parsed here */
+    currentDate = termData->transactionDay;
+    if( (DATE_INVALID == currentDate) && 
+        (TERMINAL_OK != parseDate(termData->transactionDate, &currentDate)) ) {
+        return EXPIRED_CARD;
+    }
 
-    /*! No need to validate months and years because they are validated in 
-        the isValidCurrentDate() check above */
+    /* Cards not entered through getCardExpiryDate() are encoded here */
+    expiryMonths = (int16_t)cardData->expiryMonths;
+    if(0 == expiryMonths) {
+        expiryMonths = getCardExpiryMonths(cardData);
+    }
 
-    /* Validating Expiration    */
-    if(currentYear >= cardYear) {
-        if( (currentYear > cardYear) || (currentMonth > cardMonth) ) {
-            return EXPIRED_CARD;
-        }
+    if(-1 == expiryMonths) {
+        return EXPIRED_CARD;
+    }
+
+    /* The card is valid until the end of its expiry month */
+    if(expiryMonths < (int16_t)DATE_EXPIRY_MONTHS(currentDate)) {
+        return EXPIRED_CARD;
     }
 
     return TERMINAL_OK;
 }
 
+uint32_t isCardExpiredBatch(const uint16_t * const expiryMonths, const uint32_t count, 
+                            const DATE_t transactionDay, BOOL_t * const isExpired) {
+    uint32_t i = 0, expiredCount = 0;
+    const uint16_t currentMonths = DATE_EXPIRY_MONTHS(transactionDay);
+#if defined(__SSE2__)
+    const __m128i current = _mm_set1_epi16((int16_t)currentMonths);
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i expired;
+#endif
+
+    if( (NULL == expiryMonths) || (NULL == isExpired) || (DATE_INVALID == transactionDay) ) {
+        return 0;
+    }
+
+#if defined(__SSE2__)
+    /* Encoded dates are below 1200, so signed 16 bit compares are exact */
+    for(; (i + 8) <= count; i += 8) {
+        expired = _mm_cmplt_epi16(_mm_loadu_si128((const __m128i *)(expiryMonths + i)), current);
+        expired = _mm_packs_epi16(expired, expired);
+        _mm_storel_epi64((__m128i *)(isExpired + i), _mm_and_si128(expired, one));
+        expiredCount += (uint32_t)__builtin_popcount((uint32_t)_mm_movemask_epi8(expired) & 0xFF);
+    }
+#endif
+
+    for(; i < count; ++i) {
+        isExpired[i] = (BOOL_t)(expiryMonths[i] < currentMonths);
+        expiredCount += isExpired[i];
+    }
+
+    return expiredCount;
+}
+
 EN_terminalError_t isValidCardPAN(ST_cardData_t *cardData) {
 
+    if(NULL == cardData) {
+        return INVALID_CARD;
+    }
 
+    if( !isLuhnValid(cardData->primaryAccountNumber) ) {
+        return INVALID_CARD;
+    }
 
     return TERMINAL_OK;
 }
 
+uint32_t isValidCardPANBatch(const ST_cardData_t * const cardsData, const uint32_t count, 
+                             EN_terminalError_t * const results) {
+    uint32_t i = 0, validCount = 0;
+    BOOL_t isValid = FALSE;
+
+    if( (NULL == cardsData) || (NULL == results) ) {
+        return 0;
+    }
+
+    for(i = 0; i < count; ++i) {
+#if defined(__SSE2__)
+        isValid = isLuhnValidSimd(cardsData[i].primaryAccountNumber);
+#else
+        isValid = isLuhnValid(cardsData[i].primaryAccountNumber);
+#endif
+        results[i] = isValid ? TERMINAL_OK : INVALID_CARD;
+        validCount += isValid;
+    }
+
+    return validCount;
+}
+
 EN_terminalError_t getTransactionAmount(ST_terminalData_t * const termData) {
+    uint8_t line[TERMINAL_INPUT_LINE_SIZE];
 
     if(NULL == termData) {
         return INVALID_AMOUNT;
     }
 
+    printf("\nEnter the required amount: ");
+    readInputLine(line, sizeof(line));
+
+    return parseTransactionAmount(termData, line);
+}
+
+EN_terminalError_t parseTransactionAmount(ST_terminalData_t * const termData, const uint8_t * const input) {
+
+    if( (NULL == termData) || (NULL == input) ) {
+        return INVALID_AMOUNT;
+    }
+
     termData->transAmount = 0.0f;
 
-    printf("\nEnter the required amount: ");
-    scanf("%f", &(termData->transAmount));  
+    sscanf((const char *)input, "%f", &(termData->transAmount));  
     termData->transAmount = (int64_t)termData->transAmount;  
 
     /* Validating the amount    */
@@ -136,12 +261,21 @@ EN_terminalError_t getTransactionAmount(ST_terminalData_t * const termData) {
 }
 
 EN_terminalError_t isBelowMaxAmount(const ST_terminalData_t * const termData) {
+    ST_terminalConfig_t config;
+    float maxTransAmount = 0.0f;
 
     if(NULL == termData) {
         return EXCEED_MAX_AMOUNT;
     }
 
-    if(termData->transAmount > termData->maxTransAmount) {
+    /* The configured limit wins over the one entered at the terminal */
+    if(TERMINAL_OK == getTerminalConfig(termData->terminalId, &config)) {
+        maxTransAmount = config.maxTransAmount;
+    } else {
+        maxTransAmount = termData->maxTransAmount;
+    }
+
+    if(termData->transAmount > maxTransAmount) {
         return EXCEED_MAX_AMOUNT;
     }
 
@@ -149,15 +283,27 @@ EN_terminalError_t isBelowMaxAmount(const ST_terminalData_t * const termData) {
 }
 
 EN_terminalError_t setMaxAmount(ST_terminalData_t * const termData) {
+    uint8_t line[TERMINAL_INPUT_LINE_SIZE];
 
     if(NULL == termData) {
         return INVALID_MAX_AMOUNT;
     }
 
+    printf("\nEnter the maximum amount: ");
+    readInputLine(line, sizeof(line));
+
+    return parseMaxAmount(termData, line);
+}
+
+EN_terminalError_t parseMaxAmount(ST_terminalData_t * const termData, const uint8_t * const input) {
+
+    if( (NULL == termData) || (NULL == input) ) {
+        return INVALID_MAX_AMOUNT;
+    }
+
     termData->maxTransAmount = 0.0f;
     
-    printf("\nEnter the maximum amount: ");
-    scanf("%f", &(termData->maxTransAmount));  
+    sscanf((const char *)input, "%f", &(termData->maxTransAmount));  
     termData->maxTransAmount = (int64_t)termData->maxTransAmount;  
     
     /* Validating the amount    */
@@ -168,6 +314,91 @@ EN_terminalError_t setMaxAmount(ST_terminalData_t * const termData) {
     return TERMINAL_OK;
 }
 
+EN_terminalError_t parseDate(const uint8_t * const dateString, DATE_t * const date) {
+    static const uint8_t digitIndex[8] = {0, 1, 3, 4, 6, 7, 8, 9};
+    uint8_t digits[8];
+    uint8_t i = 0, day = 0, month = 0, maxDay = 0;
+    uint16_t year = 0;
+
+    if(NULL == date) {
+        return WRONG_DATE;
+    }
+
+    *date = DATE_INVALID;
+
+    if(NULL == dateString) {
+        return WRONG_DATE;
+    }
+
+    /* Format DD/MM/YYYY */
+    if( ('/' != dateString[2]) || ('/' != dateString[5]) ) {
+        return WRONG_DATE;
+    }
+
+    for(i = 0; i < sizeof(digitIndex); ++i) {
+        digits[i] = (uint8_t)(dateString[digitIndex[i]] - '0');
+        if(digits[i] > 9) {
+            return WRONG_DATE;
+        }
+    }
+
+    day   = digits[0] * 10 + digits[1];
+    month = digits[2] * 10 + digits[3];
+    year  = digits[4] * 1000 + digits[5] * 100 + digits[6] * 10 + digits[7];
+
+    /* Range of the fields */
+    if( (year < DATE_MIN_YEAR) || (year > DATE_MAX_YEAR) || (month < 1) || (month > 12) ) {
+        return WRONG_DATE;
+    }
+
+    maxDay = daysInMonth[month] + ( (2 == month) && isLeapYear(year) );
+    if( (day < 1) || (day > maxDay) ) {
+        return WRONG_DATE;
+    }
+
+    *date = DATE_PACK(year, month, day);
+
+    return TERMINAL_OK;
+}
+
+uint32_t parseDateBatch(const uint8_t * const records, const uint32_t count, 
+                        const uint32_t stride, DATE_t * const dates) {
+    uint32_t i = 0, validCount = 0;
+
+    if( (NULL == records) || (NULL == dates) ) {
+        return 0;
+    }
+
+    for(i = 0; i < count; ++i) {
+        validCount += (TERMINAL_OK == parseDate(records + (size_t)i * stride, &dates[i]));
+    }
+
+    return validCount;
+}
+
+BOOL_t isDateInRange(const DATE_t date, const DATE_t from, const DATE_t to) {
+    return (BOOL_t)( (DATE_INVALID != date) && (date >= from) && (date <= to) );
+}
+
+EN_terminalError_t parseCurrency(const uint8_t * const code, CURRENCY_t * const currency) {
+
+    if(NULL == currency) {
+        return CONFIG_ERROR;
+    }
+
+    *currency = CURRENCY_NONE;
+
+    /* Checked one by one, the null terminator stops at the first failing letter */
+    if( (NULL == code) || (code[0] < 'A') || (code[0] > 'Z') || (code[1] < 'A') || (code[1] > 'Z') ||
+        (code[2] < 'A') || (code[2] > 'Z') || ('\0' != code[3]) ) {
+        return CONFIG_ERROR;
+    }
+
+    *currency = CURRENCY_PACK(code[0], code[1], code[2]);
+
+    return TERMINAL_OK;
+}
+
 /*----------------------------------------------------------------------*/
 /*                                                                      */
 /*                     PRIVATE FUNCTIONS DEFINITIONS                    */
@@ -199,143 +430,135 @@ static BOOL_t isLeapYear(const uint16_t year) {
     return (BOOL_t)isLeap;
 }
 
-static BOOL_t isValidCurrentDate(const ST_terminalData_t * const termData) {
-    uint8_t day = 0, month = 0, year = 0;
-
-    if(NULL == termData) {
+/********************************************************************************
+ * @brief       Read a line from the input stream without its newline
+ * 
+ * @param[out]  line: Buffer receiving the null terminated line
+ * @param[in]   size: Size of the buffer
+ * @return      BOOL_t: TRUE if a whole line was read, FALSE on end of input or
+ *              if the line was too long (the rest of it is then flushed)
+ *******************************************************************************/
+static BOOL_t readInputLine(uint8_t * const line, const uint8_t size) {
+    FILE * const stream = (NULL == inputStream) ? stdin : inputStream;
+    size_t length = 0;
+    int character = 0;
+
+    if(NULL == fgets((char *)line, size, stream)) {
+        line[0] = '\0';
         return FALSE;
     }
 
-    if( !isValidDateFormat(termData) ) {
-        return FALSE;
+    length = strlen((char *)line);
+    if( length && ('\n' == line[length - 1]) ) {
+        line[length - 1] = '\0';
+        return TRUE;
     }
 
-    /* Getting Month and Year*/
-    day = getCurrentDay(termData);
-    month = getCurrentMonth(termData);
-    year = getCurrentYear(termData);
+    /* Flush the rest of the line */
+    do {
+        character = getc(stream);
+    } while( ('\n' != character) && (EOF != character) );
 
-    /* Validating the date */
-    if( (year == -1) || (month == -1) || (-1 == day)) {
-        return FALSE;
-    }
+    line[0] = '\0';
 
-    switch(month) {
-        case 1: case 3: case 5: case 7: case 8: case 10: case 12:
-            if( (day > 31) || (day < 1) ) {
-                return FALSE;
-            }
-            break;
-        case 4: case 6: case 9: case 11:
-            if( (day > 30) || (day < 1) ) {
-                return FALSE;
-            }
-            break;
-        case 2:
-            if(isLeapYear(year)) {
-                if( (day > 29) || (day < 1) ) {
-                    return FALSE;
-                }
-            } else {
-                if( (day > 28) || (day < 1) ) {
-                    return FALSE;
-                }
-            }
-            break;
-        
-        default:
-            return FALSE;
-            break;
-    }
-
-    return TRUE;
+    return FALSE;
 }
 
-static BOOL_t isValidDateFormat(const ST_terminalData_t * const termData) {
-    BOOL_t isValidFormat = FALSE;
-    
-    if(NULL == termData) {
-        return -1;
-    }
-
-    isValidFormat = isdigit(termData->transactionDate[0]) && 
-                    isdigit(termData->transactionDate[1]) &&
-                    (termData->transactionDate[2] == '/') &&
-                    isdigit(termData->transactionDate[3]) &&
-                    isdigit(termData->transactionDate[4]) &&
-                    (termData->transactionDate[5] == '/') &&
-                    isdigit(termData->transactionDate[6]) &&
-                    isdigit(termData->transactionDate[7]) &&
-                    isdigit(termData->transactionDate[8]) &&
-                    isdigit(termData->transactionDate[9]) ;
-    
-    if(!isValidFormat) {
-        return FALSE;
+/********************************************************************************
+ * @brief       Get the number of characters of the PAN, bounded by the size of
+ *              the PAN field so an unterminated buffer is never over-read.
+ *******************************************************************************/
+static uint8_t getPanLength(const uint8_t * const pan) {
+    uint8_t length = 0;
+
+    while( (length <= PAN_MAX_LENGTH) && ('\0' != pan[length]) ) {
+        length++;
     }
 
-    return TRUE;
+    return length;
 }
 
-static int8_t getCurrentYear(const ST_terminalData_t * const termData) {
-    uint16_t year = 0;
-
-    if(NULL == termData) {
-        return -1;
-    }
-
-    if( !isValidDateFormat(termData) ) {
-        return -1;
+/********************************************************************************
+ * @brief       Table-driven Luhn (mod 10) check of a null terminated PAN.
+ * 
+ * @details     Walks the digits from the right, adding luhnTable[isDoubled][digit]
+ *              so every digit costs one load and one add.
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @return      BOOL_t: TRUE if the PAN is 16-19 digits and passes the Luhn 
+ *              check, FALSE otherwise
+ *******************************************************************************/
+static BOOL_t isLuhnValid(const uint8_t * const pan) {
+    uint8_t length = 0, digit = 0, isDoubled = 0;
+    uint16_t sum = 0;
+
+    length = getPanLength(pan);
+    if( (length < PAN_MIN_LENGTH) || (length > PAN_MAX_LENGTH) ) {
+        return FALSE;
     }
 
-    /* Getting Year */
-    year    = (termData->transactionDate[6] - '0') * 1000   + 
-              (termData->transactionDate[7] - '0') * 100    + 
-              (termData->transactionDate[8] - '0') * 10     + 
-              (termData->transactionDate[9] - '0');
-
-    year -= 2000;
+    while(length) {
+        digit = (uint8_t)(pan[length - 1] - '0');
+        if(digit > 9) {
+            return FALSE;
+        }
 
-    if( (year >= 0) && (year <= 99) ) {
-        return year;
-    } else {
-        return -1;
+        sum += luhnTable[isDoubled][digit];
+        isDoubled ^= 1;
+        length--;
     }
-}
-
-static int8_t getCurrentMonth(const ST_terminalData_t * const termData) {
-    uint8_t month = 0;
 
-    if(NULL == termData) {
-        return -1;
-    }
+    return (BOOL_t)(0 == (sum % 10));
+}
 
-    if( !isValidDateFormat(termData) ) {
-        return -1;
+#if defined(__SSE2__)
+/********************************************************************************
+ * @brief       SSE2 version of \ref isLuhnValid used by the batch API.
+ * 
+ * @details     The PAN is right aligned into a 32 byte buffer padded with '0',
+ *              so the check digit always sits at index 31 and the doubled 
+ *              digits at the even indices. Both halves are then validated,
+ *              doubled and summed 16 digits at a time.
+ * @param[in]   pan: Pointer to the null terminated PAN
+ * @return      BOOL_t: TRUE if the PAN is 16-19 digits and passes the Luhn 
+ *              check, FALSE otherwise
+ *******************************************************************************/
+static BOOL_t isLuhnValidSimd(const uint8_t * const pan) {
+    uint8_t buffer[32];
+    uint8_t length = 0, half = 0;
+    uint32_t sum = 0;
+    const __m128i zero      = _mm_setzero_si128();
+    const __m128i charZero  = _mm_set1_epi8('0');
+    const __m128i four      = _mm_set1_epi8(4);
+    const __m128i nine      = _mm_set1_epi8(9);
+    const __m128i evenMask  = _mm_set1_epi16(0x00FF);
+    __m128i digits, doubled, invalid, total = zero;
+
+    length = getPanLength(pan);
+    if( (length < PAN_MIN_LENGTH) || (length > PAN_MAX_LENGTH) ) {
+        return FALSE;
     }
 
-    /* Getting month */
-    month = (termData->transactionDate[3] - '0') * 10     + 
-            (termData->transactionDate[4] - '0');
+    memset(buffer, '0', sizeof(buffer));
+    memcpy(buffer + sizeof(buffer) - length, pan, length);
 
-    return month;
-}
-
-static int8_t getCurrentDay(const ST_terminalData_t * const termData) {
-    uint8_t day = 0;
+    for(half = 0; half < 2; ++half) {
+        digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16 * half)), charZero);
 
-    if(NULL == termData) {
-        return -1;
-    }
+        /* Any byte outside 0..9 (as a signed byte) is not a digit */
+        invalid = _mm_or_si128(_mm_cmpgt_epi8(digits, nine), _mm_cmplt_epi8(digits, zero));
+        if(_mm_movemask_epi8(invalid)) {
+            return FALSE;
+        }
 
-    if( !isValidDateFormat(termData) ) {
-        return -1;
+        /* 2 * digit, minus 9 when the result has two digits */
+        doubled = _mm_sub_epi8(_mm_add_epi8(digits, digits), 
+                               _mm_and_si128(_mm_cmpgt_epi8(digits, four), nine));
+        digits  = _mm_or_si128(_mm_and_si128(evenMask, doubled), _mm_andnot_si128(evenMask, digits));
+        total   = _mm_add_epi64(total, _mm_sad_epu8(digits, zero));
     }
 
-    /* Getting day */
-    day = (termData->transactionDate[0] - '0') * 10     + 
-          (termData->transactionDate[1] - '0'); 
+    sum = (uint32_t)_mm_cvtsi128_si32(total) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(total, 8));
 
-    return day;
+    return (BOOL_t)(0 == (sum % 10));
 }
-
-
+#endif
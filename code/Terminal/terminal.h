@@ -20,13 +20,52 @@
 /*                                                                              */
 /*------------------------------------------------------------------------------*/
 
+/*********************************************************************************
+ * @brief   Date packed as (year << 9) | (month << 5) | day.
+ * @details Packed dates compare in calendar order, so range queries are plain
+ *          integer compares. \ref DATE_INVALID is never a valid date.
+ ********************************************************************************/
+typedef uint32_t DATE_t;
+
+#define DATE_INVALID                ((DATE_t)0)
+#define DATE_PACK(year, month, day) ( ((DATE_t)(year) << 9) | ((DATE_t)(month) << 5) | (DATE_t)(day) )
+#define DATE_YEAR(date)             ( (uint16_t)((date) >> 9) )
+#define DATE_MONTH(date)            ( (uint8_t)(((date) >> 5) & 0x0F) )
+#define DATE_DAY(date)              ( (uint8_t)((date) & 0x1F) )
+
+/*********************************************************************************
+ * @brief   Months elapsed between 01/2000 and the month of a packed date, same
+ *          encoding as ST_cardData_t::expiryMonths.
+ ********************************************************************************/
+#define DATE_EXPIRY_MONTHS(date)    ( (uint16_t)((DATE_YEAR(date) - CARD_EXPIRY_BASE_YEAR) * 12 + DATE_MONTH(date) - 1) )
+
+/*********************************************************************************
+ * @brief   ISO 4217 currency code packed as 5 bits per letter.
+ * @details \ref CURRENCY_NONE is the currency of an unconfigured terminal or of
+ *          an account opened without one, amounts are not converted from or to
+ *          it. Every packed code is below \ref CURRENCY_CODES.
+ ********************************************************************************/
+typedef uint16_t CURRENCY_t;
+
+#define CURRENCY_NONE               ((CURRENCY_t)0)
+#define CURRENCY_CODES              (1u << 15)
+#define CURRENCY_PACK(first, second, third)                                         \
+    ( (CURRENCY_t)( (((first) - '@') << 10) | (((second) - '@') << 5) | ((third) - '@') ) )
+
 /*********************************************************************************
  * @brief   Struct for the terminal data
+ * @details transactionDay caches transactionDate, it is kept by the terminal
+ *          setters. Code writing transactionDate directly must reset it to
+ *          DATE_INVALID or parse it again, \ref isCardExpired trusts it when
+ *          valid.
  ********************************************************************************/
 typedef struct ST_terminalData_t {
+    uint32_t terminalId;                /*!< Terminal ID, key of the terminal configuration */
     float transAmount;                  /*!< Transaction amount in float */
     float maxTransAmount;               /*!< Maximum transaction amount in float */
     uint8_t transactionDate[11];        /*!< Transaction date DD/MM/YYYY */
+    DATE_t transactionDay;              /*!< Transaction date parsed by \ref getTransactionDate */
+    CURRENCY_t currency;                /*!< Currency of the amounts, from the terminal configuration */
 } ST_terminalData_t;
 
 /*********************************************************************************
@@ -39,7 +78,11 @@ typedef enum EN_terminalError_t {
     INVALID_CARD,                       /*!< Card is invalid */
     INVALID_AMOUNT,                     /*!< Transaction amount is invalid */
     EXCEED_MAX_AMOUNT,                  /*!< Transaction amount is greater than the maximum amount */
-    INVALID_MAX_AMOUNT                  /*!< Maximum transaction amount is invalid */
+    INVALID_MAX_AMOUNT,                 /*!< Maximum transaction amount is invalid */
+    EXCEED_FLOOR_LIMIT,                 /*!< Transaction amount is greater than the offline floor limit */
+    HOT_CARD,                           /*!< Card is in the hot card list, it cannot be approved offline */
+    OFFLINE_QUEUE_ERROR,                /*!< Offline queue is not open, full or cannot be written */
+    CONFIG_ERROR                        /*!< Terminal configuration is missing or invalid */
 }EN_terminalError_t ;
 
 
@@ -50,13 +93,124 @@ typedef enum EN_terminalError_t {
 /*                                                                              */
 /*------------------------------------------------------------------------------*/
 
+/********************************************************************************
+ * @brief       Set the stream the get* functions read the user input from.
+ *
+ * @param[in]   stream: Input stream, NULL for stdin
+ *******************************************************************************/
+void setTerminalInputStream(FILE * const stream);
+
 EN_terminalError_t getTransactionDate(ST_terminalData_t * const termData);
-EN_terminalError_t isCardExpired(ST_cardData_t cardData, ST_terminalData_t termData);
+EN_terminalError_t isCardExpired(const ST_cardData_t * const cardData, const ST_terminalData_t * const termData);
 EN_terminalError_t isValidCardPAN(ST_cardData_t *cardData);
 EN_terminalError_t getTransactionAmount(ST_terminalData_t * const termData);
 EN_terminalError_t isBelowMaxAmount(const ST_terminalData_t * const termData);
 EN_terminalError_t setMaxAmount(ST_terminalData_t * const termData);
 
+/*********************************************************************************
+ * @brief       Validate and store a transaction date (DD/MM/YYYY) already read
+ *              from the user.
+ * 
+ * @details     \ref getTransactionDate reads the date from stdin then calls this
+ *              function, callers getting their input elsewhere call it directly.
+ * @param[out]  termData: Pointer to the terminal data
+ * @param[in]   input: Null terminated date, without newline
+ * @return      EN_terminalError_t: TERMINAL_OK or WRONG_DATE
+ ********************************************************************************/
+EN_terminalError_t parseTransactionDate(ST_terminalData_t * const termData, const uint8_t * const input);
+
+/*********************************************************************************
+ * @brief       Validate and store a transaction amount already read from the 
+ *              user, see \ref parseTransactionDate.
+ * 
+ * @param[out]  termData: Pointer to the terminal data
+ * @param[in]   input: Null terminated amount, without newline
+ * @return      EN_terminalError_t: TERMINAL_OK or INVALID_AMOUNT
+ ********************************************************************************/
+EN_terminalError_t parseTransactionAmount(ST_terminalData_t * const termData, const uint8_t * const input);
+
+/*********************************************************************************
+ * @brief       Validate and store a maximum transaction amount already read 
+ *              from the user, see \ref parseTransactionDate.
+ * 
+ * @param[out]  termData: Pointer to the terminal data
+ * @param[in]   input: Null terminated amount, without newline
+ * @return      EN_terminalError_t: TERMINAL_OK or INVALID_MAX_AMOUNT
+ ********************************************************************************/
+EN_terminalError_t parseMaxAmount(ST_terminalData_t * const termData, const uint8_t * const input);
+
+/*********************************************************************************
+ * @brief       Validate the PANs of many cards at once using the Luhn check.
+ * 
+ * @details     Uses SSE2 to process the digits of each PAN when available, and
+ *              the same table-driven kernel as \ref isValidCardPAN otherwise.
+ * @param[in]   cardsData: Array of cards to validate
+ * @param[in]   count: Number of cards in the array
+ * @param[out]  results: Array of at least \p count entries receiving 
+ *              TERMINAL_OK or INVALID_CARD for each card
+ * @return      uint32_t: Number of valid PANs
+ ********************************************************************************/
+uint32_t isValidCardPANBatch(const ST_cardData_t * const cardsData, const uint32_t count, 
+                             EN_terminalError_t * const results);
+
+/*********************************************************************************
+ * @brief       Flag the expired cards of a card base in one vectorized pass.
+ * 
+ * @details     Works on the compact expiry column (ST_cardData_t::expiryMonths of
+ *              every card), comparing 8 cards per SSE2 instruction when 
+ *              available. A card expires after the last day of its expiry month.
+ * @param[in]   expiryMonths: Array of encoded expiry dates
+ * @param[in]   count: Number of cards
+ * @param[in]   transactionDay: Date to check the cards against
+ * @param[out]  isExpired: Array of at least \p count entries receiving TRUE for
+ *              the expired cards and FALSE for the others
+ * @return      uint32_t: Number of expired cards
+ ********************************************************************************/
+uint32_t isCardExpiredBatch(const uint16_t * const expiryMonths, const uint32_t count, 
+                            const DATE_t transactionDay, BOOL_t * const isExpired);
+
+/*********************************************************************************
+ * @brief       Validate and parse a DD/MM/YYYY date in a single pass.
+ * 
+ * @details     The date is valid if it has the DD/MM/YYYY format, the year is
+ *              between 2000 and 2099 and the day exists in that month 
+ *              (leap years included).
+ * @param[in]   dateString: Pointer to the (at least 10 characters) date string
+ * @param[out]  date: Parsed date, \ref DATE_INVALID on error
+ * @return      EN_terminalError_t: TERMINAL_OK or WRONG_DATE
+ ********************************************************************************/
+EN_terminalError_t parseDate(const uint8_t * const dateString, DATE_t * const date);
+
+/*********************************************************************************
+ * @brief       Parse many fixed-width DD/MM/YYYY records, such as the lines of
+ *              a bulk input file or the transactionDate of terminal records.
+ * 
+ * @param[in]   records: Pointer to the first date string
+ * @param[in]   count: Number of records
+ * @param[in]   stride: Distance in bytes between two consecutive records
+ * @param[out]  dates: Array of at least \p count entries receiving the parsed
+ *              dates, \ref DATE_INVALID for the invalid ones
+ * @return      uint32_t: Number of valid dates
+ ********************************************************************************/
+uint32_t parseDateBatch(const uint8_t * const records, const uint32_t count, 
+                        const uint32_t stride, DATE_t * const dates);
+
+/*********************************************************************************
+ * @brief       Validate and pack an ISO 4217 currency code, e.g. "EGP".
+ * 
+ * @param[in]   code: Null terminated code of 3 upper case letters
+ * @param[out]  currency: Packed code, \ref CURRENCY_NONE on error
+ * @return      EN_terminalError_t: TERMINAL_OK or CONFIG_ERROR
+ ********************************************************************************/
+EN_terminalError_t parseCurrency(const uint8_t * const code, CURRENCY_t * const currency);
+
+/*********************************************************************************
+ * @brief       Check if a parsed date is within [from, to] (both included).
+ * 
+ * @return      BOOL_t: TRUE if the date is in the range, FALSE otherwise
+ ********************************************************************************/
+BOOL_t isDateInRange(const DATE_t date, const DATE_t from, const DATE_t to);
+
 
 
 #endif      /* TERMINAL_H */
\ No newline at end of file